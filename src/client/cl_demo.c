@@ -22,8 +22,94 @@
 #include "cl_local.h"
 
 /**
- * @brief Writes `server_data`, `config_strings`, and baselines once a non-delta
- * compressed frame arrives from the server.
+ * @brief A keyframe index entry, as written to the demo's trailing index.
+ */
+typedef struct {
+  int32_t time;
+  int32_t offset;
+} cl_demo_keyframe_t;
+
+/**
+ * @brief The demo recorder. Frames are re-encoded against the previously recorded frame,
+ * rather than the frame the server happened to delta from, so that playback may resume
+ * from any keyframe.
+ */
+static struct {
+
+  /**
+   * @brief The most recently recorded frame number, or -1 if none has been recorded.
+   */
+  int32_t frame_num;
+
+  /**
+   * @brief The player state of the most recently recorded frame.
+   */
+  player_state_t ps;
+
+  /**
+   * @brief The entity states of the most recently recorded frame, sorted by number.
+   */
+  entity_state_t *entities;
+  int32_t num_entities;
+
+  /**
+   * @brief The keyframes written so far, as `cl_demo_keyframe_t`.
+   */
+  GArray *keyframes;
+
+  /**
+   * @brief The server time of the most recent keyframe.
+   */
+  uint32_t keyframe_time;
+} cl_demo;
+
+/**
+ * @brief Writes the specified message to the demo file as a single record. Keyframe records
+ * are prefixed with `DEMO_KEYFRAME` and the current frame's time.
+ */
+static void Cl_WriteDemoRecord(const mem_buf_t *msg, bool keyframe) {
+
+  if (keyframe) {
+    const int32_t header[] = { LittleLong(DEMO_KEYFRAME), LittleLong((int32_t) cl.frame.time) };
+    Fs_Write(cls.demo_file, header, sizeof(header), 1);
+  }
+
+  const int32_t len = LittleLong((int32_t) msg->size);
+
+  Fs_Write(cls.demo_file, &len, sizeof(len), 1);
+  Fs_Write(cls.demo_file, msg->data, msg->size, 1);
+}
+
+/**
+ * @brief Writes the config strings which are set, and those which may be cleared during
+ * play, so that a keyframe restores them regardless of where playback resumed from.
+ */
+static void Cl_WriteDemoConfigStrings(mem_buf_t *msg, bool keyframe) {
+
+  for (int32_t i = 0; i < MAX_CONFIG_STRINGS; i++) {
+
+    if (*cl.config_strings[i] == '\0') {
+      if (!keyframe) {
+        continue;
+      }
+      if (!(i >= CS_CLIENTS && i < CS_ENTITIES) && i < CS_GAME) {
+        continue;
+      }
+    }
+
+    if (msg->size + strlen(cl.config_strings[i]) + 32 > msg->max_size) { // write it out
+      Cl_WriteDemoRecord(msg, keyframe);
+      Mem_ClearBuffer(msg);
+    }
+
+    Net_WriteByte(msg, SV_CMD_CONFIG_STRING);
+    Net_WriteShort(msg, i);
+    Net_WriteString(msg, cl.config_strings[i]);
+  }
+}
+
+/**
+ * @brief Writes `server_data`, `config_strings`, and baselines when recording begins.
  */
 static void Cl_WriteDemoHeader(void) {
   static entity_state_t null_state;
@@ -42,20 +128,7 @@ static void Cl_WriteDemoHeader(void) {
   Net_WriteString(&msg, cl.config_strings[CS_NAME]);
 
   // and config_strings
-  for (int32_t i = 0; i < MAX_CONFIG_STRINGS; i++) {
-    if (*cl.config_strings[i] != '\0') {
-      if (msg.size + strlen(cl.config_strings[i]) + 32 > msg.max_size) { // write it out
-        const int32_t len = LittleLong((int32_t) msg.size);
-        Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-        Fs_Write(cls.demo_file, msg.data, msg.size, 1);
-        msg.size = 0;
-      }
-
-      Net_WriteByte(&msg, SV_CMD_CONFIG_STRING);
-      Net_WriteShort(&msg, i);
-      Net_WriteString(&msg, cl.config_strings[i]);
-    }
-  }
+  Cl_WriteDemoConfigStrings(&msg, false);
 
   // and baselines
   for (size_t i = 0; i < lengthof(cl.entities); i++) {
@@ -65,10 +138,8 @@ static void Cl_WriteDemoHeader(void) {
     }
 
     if (msg.size + 64 > msg.max_size) { // write it out
-      const int32_t len = LittleLong((int32_t) msg.size);
-      Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-      Fs_Write(cls.demo_file, msg.data, msg.size, 1);
-      msg.size = 0;
+      Cl_WriteDemoRecord(&msg, false);
+      Mem_ClearBuffer(&msg);
     }
 
     Net_WriteByte(&msg, SV_CMD_BASELINE);
@@ -79,46 +150,196 @@ static void Cl_WriteDemoHeader(void) {
   Net_WriteString(&msg, "precache 0\n");
 
   // write it to the demo file
-
-  const int32_t len = LittleLong((int32_t) msg.size);
-
-  Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-  Fs_Write(cls.demo_file, msg.data, msg.size, 1);
+  Cl_WriteDemoRecord(&msg, false);
 
   Com_Debug(DEBUG_CLIENT, "Demo started\n");
   // the rest of the demo file will be individual frames
 }
 
 /**
- * @brief Dumps the current net message, prefixed by the length.
+ * @return The entity state at the specified index of the current frame.
+ */
+static const entity_state_t *Cl_DemoFrameEntity(int32_t index) {
+  return &cl.entity_states[(cl.frame.entity_state + index) & ENTITY_STATE_MASK];
+}
+
+/**
+ * @brief Writes the current frame, delta compressed against the most recently recorded
+ * frame, or uncompressed for keyframes. This mirrors `Sv_WriteClientFrame`.
+ */
+static void Cl_WriteDemoFrame(mem_buf_t *msg, bool keyframe) {
+  static player_state_t null_state;
+
+  const bool delta = !keyframe && cl_demo.frame_num > 0 && cl_demo.frame_num < cl.frame.frame_num;
+
+  Net_WriteByte(msg, SV_CMD_FRAME);
+  Net_WriteLong(msg, cl.frame.frame_num);
+  Net_WriteLong(msg, delta ? cl_demo.frame_num : -1);
+
+  Net_WriteDeltaPlayerState(msg, delta ? &cl_demo.ps : &null_state, &cl.frame.ps);
+
+  const int32_t from_num_entities = delta ? cl_demo.num_entities : 0;
+
+  int32_t old_index = 0, new_index = 0;
+  while (new_index < cl.frame.num_entities || old_index < from_num_entities) {
+
+    const entity_state_t *new_state = NULL, *old_state = NULL;
+    int16_t new_num = INT16_MAX, old_num = INT16_MAX;
+
+    if (new_index < cl.frame.num_entities) {
+      new_state = Cl_DemoFrameEntity(new_index);
+      new_num = new_state->number;
+    }
+
+    if (old_index < from_num_entities) {
+      old_state = &cl_demo.entities[old_index];
+      old_num = old_state->number;
+    }
+
+    if (new_num == old_num) { // delta update from old position
+      Net_WriteDeltaEntity(msg, old_state, new_state, false);
+      old_index++;
+      new_index++;
+    } else if (new_num < old_num) { // this is a new entity, send it from the baseline
+      Net_WriteDeltaEntity(msg, &cl.entities[new_num].baseline, new_state, true);
+      new_index++;
+    } else { // the old entity isn't present in the new frame
+      Net_WriteEntityNumber(msg, old_num);
+      Net_WriteVarInt(msg, U_REMOVE);
+      old_index++;
+    }
+  }
+
+  Net_WriteEntityNumber(msg, -1); // end of entities
+}
+
+/**
+ * @brief Writes a keyframe, from which playback may resume: the config strings, and the
+ * current frame, uncompressed. The keyframe is added to the index.
  */
-void Cl_WriteDemoMessage(void) {
+static void Cl_WriteDemoKeyframe(void) {
+  mem_buf_t msg, frame;
+  byte buffer[MAX_MSG_SIZE], frame_buffer[MAX_MSG_SIZE];
+
+  Mem_InitBuffer(&frame, frame_buffer, sizeof(frame_buffer));
+  frame.allow_overflow = true;
+
+  Cl_WriteDemoFrame(&frame, true);
+
+  if (frame.overflowed) {
+    Com_Warn("Keyframe exceeds MAX_MSG_SIZE\n");
+    return;
+  }
+
+  const cl_demo_keyframe_t keyframe = {
+    .time = (int32_t) cl.frame.time,
+    .offset = (int32_t) Fs_Tell(cls.demo_file)
+  };
+
+  Mem_InitBuffer(&msg, buffer, sizeof(buffer));
+
+  Cl_WriteDemoConfigStrings(&msg, true);
+
+  if (msg.size + frame.size > msg.max_size) {
+    Cl_WriteDemoRecord(&msg, true);
+    Mem_ClearBuffer(&msg);
+  }
+
+  Mem_WriteBuffer(&msg, frame.data, frame.size);
+  Cl_WriteDemoRecord(&msg, true);
+
+  g_array_append_val(cl_demo.keyframes, keyframe);
+  cl_demo.keyframe_time = cl.frame.time;
+}
+
+/**
+ * @brief Appends `len` bytes to the message, first writing it out if it is full.
+ */
+static void Cl_WriteDemoMessageData(mem_buf_t *msg, const void *data, size_t len) {
+
+  if (msg->size + len > msg->max_size) {
+    Cl_WriteDemoRecord(msg, false);
+    Mem_ClearBuffer(msg);
+  }
+
+  Mem_WriteBuffer(msg, data, len);
+}
+
+/**
+ * @brief Dumps the current net message. The frame it contains, which spans `frame_start`
+ * to `frame_end`, is re-encoded against the most recently recorded frame, and keyframes
+ * are written at regular intervals.
+ */
+void Cl_WriteDemoMessage(size_t frame_start, size_t frame_end) {
 
   if (!cls.demo_file) {
     return;
   }
 
   if (!Fs_Tell(cls.demo_file)) {
-    if (cl.frame.delta_frame_num < 0) {
-      Com_Debug(DEBUG_CLIENT, "Received uncompressed frame, writing demo header..\n");
+    if (cls.state == CL_ACTIVE && cl.frame.valid) {
+      Com_Debug(DEBUG_CLIENT, "Writing demo header..\n");
       Cl_WriteDemoHeader();
     } else {
-      return; // wait for an uncompressed packet
+      return; // wait for the first frame
     }
   }
 
+  mem_buf_t msg;
+  byte buffer[MAX_MSG_SIZE];
+
+  Mem_InitBuffer(&msg, buffer, sizeof(buffer));
+
   // the first eight bytes are just packet sequencing stuff
-  const int32_t len = LittleLong((int32_t) (net_message.size - 8));
+  if (frame_end == 0) {
+    Cl_WriteDemoMessageData(&msg, net_message.data + 8, net_message.size - 8);
+    Cl_WriteDemoRecord(&msg, false);
 
-  Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-  Fs_Write(cls.demo_file, net_message.data + 8, len, 1);
+    if (cls.state != CL_ACTIVE) { // the server is loading a new level
+      cl_demo.frame_num = -1;
+    }
+    return;
+  }
+
+  mem_buf_t frame;
+  byte frame_buffer[MAX_MSG_SIZE];
+
+  Mem_InitBuffer(&frame, frame_buffer, sizeof(frame_buffer));
+  frame.allow_overflow = true;
+
+  Cl_WriteDemoFrame(&frame, false);
+
+  if (frame.overflowed) {
+    Com_Warn("Frame exceeds MAX_MSG_SIZE, stopping demo\n");
+    Cl_Stop_f();
+    return;
+  }
+
+  Cl_WriteDemoMessageData(&msg, net_message.data + 8, frame_start - 8);
+  Cl_WriteDemoMessageData(&msg, frame.data, frame.size);
+  Cl_WriteDemoMessageData(&msg, net_message.data + frame_end, net_message.size - frame_end);
+  Cl_WriteDemoRecord(&msg, false);
+
+  // retain the frame for the next delta
+  cl_demo.frame_num = cl.frame.frame_num;
+  cl_demo.ps = cl.frame.ps;
+  cl_demo.num_entities = cl.frame.num_entities;
+
+  for (int32_t i = 0; i < cl.frame.num_entities; i++) {
+    cl_demo.entities[i] = *Cl_DemoFrameEntity(i);
+  }
+
+  if (cl_demo.keyframes->len == 0 ||
+      cl.frame.time < cl_demo.keyframe_time ||
+      cl.frame.time - cl_demo.keyframe_time >= DEMO_KEYFRAME_INTERVAL) {
+    Cl_WriteDemoKeyframe();
+  }
 }
 
 /**
- * @brief Stop recording a demo
+ * @brief Stop recording a demo, writing the keyframe index.
  */
 void Cl_Stop_f(void) {
-  int32_t len = -1;
 
   if (!cls.demo_file) {
     Com_Print("Not recording a demo\n");
@@ -126,17 +347,40 @@ void Cl_Stop_f(void) {
   }
 
   // finish up
-  Fs_Write(cls.demo_file, &len, sizeof(len), 1);
-  Fs_Close(cls.demo_file);
+  const int32_t end = -1;
+  Fs_Write(cls.demo_file, &end, sizeof(end), 1);
+
+  // and write the index, followed by its offset, so that it can be found from the end
+  const int32_t offset = LittleLong((int32_t) Fs_Tell(cls.demo_file));
+  const int32_t count = LittleLong((int32_t) cl_demo.keyframes->len);
+
+  Fs_Write(cls.demo_file, &count, sizeof(count), 1);
+
+  for (guint i = 0; i < cl_demo.keyframes->len; i++) {
+    const cl_demo_keyframe_t *keyframe = &g_array_index(cl_demo.keyframes, cl_demo_keyframe_t, i);
+    const int32_t entry[] = { LittleLong(keyframe->time), LittleLong(keyframe->offset) };
+    Fs_Write(cls.demo_file, entry, sizeof(entry), 1);
+  }
+
+  const int32_t trailer[] = { offset, LittleLong(DEMO_INDEX_MAGIC) };
+  Fs_Write(cls.demo_file, trailer, sizeof(trailer), 1);
 
+  Fs_Close(cls.demo_file);
   cls.demo_file = NULL;
-  Com_Print("Stopped demo\n");
+
+  Com_Print("Stopped demo, %u keyframes\n", cl_demo.keyframes->len);
+
+  g_array_free(cl_demo.keyframes, true);
+  Mem_Free(cl_demo.entities);
+
+  memset(&cl_demo, 0, sizeof(cl_demo));
 }
 
 /**
  * @brief record <demo name>
  *
- * Begin recording a demo from the current frame until `stop` is issued.
+ * Begin recording a demo from the current frame until `stop` is issued. Demos
+ * recorded during demo playback gain keyframes, and become seekable.
  */
 void Cl_Record_f(void) {
 
@@ -172,6 +416,10 @@ void Cl_Record_f(void) {
     return;
   }
 
+  cl_demo.frame_num = -1;
+  cl_demo.entities = Mem_Malloc(MAX_ENTITIES * sizeof(entity_state_t));
+  cl_demo.keyframes = g_array_new(false, false, sizeof(cl_demo_keyframe_t));
+
   Com_Print("Recording to %s\n", cls.demo_filename);
 }
 
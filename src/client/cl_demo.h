@@ -24,7 +24,7 @@
 #include "cl_types.h"
 
 #if defined(__CL_LOCAL_H__)
-void Cl_WriteDemoMessage(void);
+void Cl_WriteDemoMessage(size_t frame_start, size_t frame_end);
 void Cl_Record_f(void);
 void Cl_Stop_f(void);
 void Cl_FastForward_f(void);
@@ -150,7 +150,7 @@ static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame) {
   
   while (true) {
 
-    const int16_t number = Net_ReadShort(&net_message);
+    const int16_t number = Net_ReadEntityNumber(&net_message);
 
     if (number == -1) {
       break;
@@ -184,7 +184,7 @@ static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame) {
     }
 
     // now deal with the new entity
-    const uint16_t bits = Net_ReadShort(&net_message);
+    const uint16_t bits = Net_ReadVarInt(&net_message);
 
     if (bits & U_REMOVE) { // remove it, no delta
 
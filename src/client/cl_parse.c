@@ -23,36 +23,9 @@
 #include "net/net_http.h"
 
 #include <SDL3/SDL_atomic.h>
+#include <SDL3/SDL_thread.h>
 #include <SDL3/SDL_timer.h>
 
-/**
- * @brief State for an in-progress async HTTP download.
- */
-static struct {
-	SDL_AtomicInt complete;
-	int32_t status;
-	void *data;
-	size_t length;
-} cl_download;
-
-/**
- * @brief `Net_HttpCallback` for `Cl_CheckOrDownloadFile`.
- */
-static void Cl_DownloadComplete(int32_t status, void *body, size_t length, void *user_data) {
-
-	if (body && length) {
-		cl_download.data = Mem_Malloc(length);
-		memcpy(cl_download.data, body, length);
-		cl_download.length = length;
-	} else {
-		cl_download.data = NULL;
-		cl_download.length = 0;
-	}
-
-	cl_download.status = status;
-	SDL_SetAtomicInt(&cl_download.complete, 1);
-}
-
 static char *sv_cmd_names[32] = {
   "SV_CMD_BAD",
   "SV_CMD_BASELINE",
@@ -73,7 +46,480 @@ static char *sv_cmd_names[32] = {
 #define MAX_DOWNLOAD_SIZE (128 * 1024 * 1024)
 
 /**
- * @brief If the file does not exist locally, download it from the server via HTTP.
+ * @brief The size of the first segment of a new download, fetched before the file size is known.
+ */
+#define DOWNLOAD_FIRST_SEGMENT_SIZE (1 << 20)
+
+/**
+ * @brief The minimum size of subsequent segments, so that small files are fetched serially.
+ */
+#define DOWNLOAD_MIN_SEGMENT_SIZE (4 << 20)
+
+/**
+ * @brief The maximum number of segments in a download, each fetched by its own connection.
+ */
+#define MAX_DOWNLOAD_SEGMENTS 4
+
+/**
+ * @brief The number of consecutive attempts without progress before a download is suspended.
+ */
+#define MAX_DOWNLOAD_ATTEMPTS 3
+
+/**
+ * @brief A byte range of a download, fetched by its own thread into its own part file.
+ */
+typedef struct {
+
+  /**
+   * @brief The offset of this segment within the file.
+   */
+  int64_t offset;
+
+  /**
+   * @brief The length of this segment in bytes.
+   */
+  int64_t length;
+
+  /**
+   * @brief The number of bytes written to the part file.
+   */
+  int64_t received;
+
+  /**
+   * @brief The part file, open while the segment is being fetched.
+   */
+  file_t *file;
+
+  /**
+   * @brief The most recent response.
+   */
+  net_http_response_t response;
+
+  /**
+   * @brief True if the file changed on the server since this segment was begun.
+   */
+  bool changed;
+
+  /**
+   * @brief The thread fetching this segment.
+   */
+  SDL_Thread *thread;
+} cl_download_segment_t;
+
+/**
+ * @brief The in-progress download. Its state is saved alongside its part files, so that an
+ * interrupted download is resumed, rather than restarted, by a subsequent attempt.
+ */
+static struct {
+
+  /**
+   * @brief The file being downloaded.
+   */
+  char filename[MAX_OS_PATH];
+
+  /**
+   * @brief The server address.
+   */
+  net_addr_t addr;
+
+  /**
+   * @brief The entity tag of the file, which validates resumed segments.
+   */
+  char etag[NET_HTTP_ETAG_SIZE];
+
+  /**
+   * @brief The file size in bytes, or -1 until it is known.
+   */
+  int64_t size;
+
+  /**
+   * @brief The segments.
+   */
+  cl_download_segment_t segments[MAX_DOWNLOAD_SEGMENTS];
+  int32_t num_segments;
+
+  /**
+   * @brief The number of bytes received across all segments, for progress.
+   */
+  SDL_AtomicInt received;
+
+  /**
+   * @brief Set to abort all segments.
+   */
+  SDL_AtomicInt abort;
+} cl_download;
+
+/**
+ * @brief Resolves the path of the part file for the specified segment.
+ */
+static void Cl_DownloadPartPath(int32_t segment, char *path, size_t size) {
+  g_snprintf(path, size, "%s.%d.part", cl_download.filename, segment);
+}
+
+/**
+ * @brief Resolves the path of the saved state of the download.
+ */
+static void Cl_DownloadStatePath(char *path, size_t size) {
+  g_snprintf(path, size, "%s.part", cl_download.filename);
+}
+
+/**
+ * @brief Resets the download to a single segment, fetching the beginning of the file.
+ */
+static void Cl_ResetDownload(void) {
+
+  cl_download.etag[0] = '\0';
+  cl_download.size = -1;
+
+  memset(cl_download.segments, 0, sizeof(cl_download.segments));
+
+  cl_download.segments[0].length = DOWNLOAD_FIRST_SEGMENT_SIZE;
+  cl_download.num_segments = 1;
+
+  SDL_SetAtomicInt(&cl_download.received, 0);
+}
+
+/**
+ * @brief Deletes the part files and saved state of the download.
+ */
+static void Cl_DeleteDownload(void) {
+  char path[MAX_OS_PATH];
+
+  for (int32_t i = 0; i < cl_download.num_segments; i++) {
+    Cl_DownloadPartPath(i, path, sizeof(path));
+    Fs_Delete(path);
+  }
+
+  Cl_DownloadStatePath(path, sizeof(path));
+  Fs_Delete(path);
+}
+
+/**
+ * @brief Saves the state of the download, so that it may be resumed.
+ */
+static void Cl_SaveDownload(void) {
+  char path[MAX_OS_PATH];
+
+  Cl_DownloadStatePath(path, sizeof(path));
+
+  file_t *file = Fs_OpenWrite(path);
+  if (file == NULL) {
+    Com_Warn("Failed to open %s for writing\n", path);
+    return;
+  }
+
+  Fs_Print(file, "%s %" PRId64 " %d\n", cl_download.etag[0] ? cl_download.etag : "-", cl_download.size, cl_download.num_segments);
+
+  for (int32_t i = 0; i < cl_download.num_segments; i++) {
+    const cl_download_segment_t *seg = &cl_download.segments[i];
+    Fs_Print(file, "%" PRId64 " %" PRId64 "\n", seg->offset, seg->length);
+  }
+
+  Fs_Close(file);
+}
+
+/**
+ * @brief Loads the saved state of an interrupted download, and the progress of its segments
+ * from the lengths of their part files.
+ * @return True if the download may be resumed.
+ */
+static bool Cl_LoadDownload(void) {
+  char path[MAX_OS_PATH];
+  void *buffer;
+
+  Cl_DownloadStatePath(path, sizeof(path));
+
+  if (Fs_Load(path, &buffer) == -1) {
+    return false;
+  }
+
+  gchar **lines = g_strsplit((const char *) buffer, "\n", -1);
+  Fs_Free(buffer);
+
+  bool valid = sscanf(lines[0], "%63s %" SCNd64 " %d", cl_download.etag, &cl_download.size, &cl_download.num_segments) == 3 &&
+               cl_download.size > 0 && cl_download.size <= MAX_DOWNLOAD_SIZE &&
+               cl_download.num_segments > 0 && cl_download.num_segments <= MAX_DOWNLOAD_SEGMENTS;
+
+  if (!strcmp(cl_download.etag, "-")) {
+    cl_download.etag[0] = '\0';
+  }
+
+  int64_t received = 0;
+
+  for (int32_t i = 0; valid && i < cl_download.num_segments; i++) {
+    cl_download_segment_t *seg = &cl_download.segments[i];
+
+    memset(seg, 0, sizeof(*seg));
+
+    if (lines[i + 1] == NULL || sscanf(lines[i + 1], "%" SCNd64 " %" SCNd64, &seg->offset, &seg->length) != 2) {
+      valid = false;
+      break;
+    }
+
+    Cl_DownloadPartPath(i, path, sizeof(path));
+
+    file_t *file = Fs_OpenRead(path);
+    if (file) {
+      seg->received = Fs_FileLength(file);
+      Fs_Close(file);
+    }
+
+    if (seg->received < 0 || seg->received > seg->length) {
+      valid = false;
+      break;
+    }
+
+    received += seg->received;
+  }
+
+  g_strfreev(lines);
+
+  if (valid) {
+    SDL_SetAtomicInt(&cl_download.received, (int32_t) received);
+  } else {
+    Com_Debug(DEBUG_CLIENT, "Discarding invalid download state for %s\n", cl_download.filename);
+  }
+
+  return valid;
+}
+
+/**
+ * @brief Splits the remainder of the file, following the first segment, into segments which
+ * are fetched in parallel.
+ */
+static void Cl_PlanDownload(void) {
+
+  cl_download_segment_t *first = &cl_download.segments[0];
+
+  if (first->response.status == 200 || first->length > cl_download.size) {
+    first->length = cl_download.size; // the server sent the whole file
+  }
+
+  const int64_t remaining = cl_download.size - first->length;
+  if (remaining == 0) {
+    return;
+  }
+
+  int64_t count = remaining / DOWNLOAD_MIN_SEGMENT_SIZE;
+  if (count < 1) {
+    count = 1;
+  } else if (count > MAX_DOWNLOAD_SEGMENTS - 1) {
+    count = MAX_DOWNLOAD_SEGMENTS - 1;
+  }
+
+  const int64_t length = remaining / count;
+
+  int64_t offset = first->length;
+
+  for (int32_t i = 1; i <= count; i++) {
+    cl_download_segment_t *seg = &cl_download.segments[i];
+
+    memset(seg, 0, sizeof(*seg));
+
+    seg->offset = offset;
+    seg->length = i == count ? cl_download.size - offset : length;
+
+    offset += seg->length;
+  }
+
+  cl_download.num_segments = (int32_t) count + 1;
+
+  Com_Debug(DEBUG_CLIENT, "Fetching %s in %d segments\n", cl_download.filename, cl_download.num_segments);
+}
+
+/**
+ * @return True if all segments of the download have been received.
+ */
+static bool Cl_DownloadIsComplete(void) {
+
+  if (cl_download.size == -1) {
+    return false;
+  }
+
+  for (int32_t i = 0; i < cl_download.num_segments; i++) {
+    const cl_download_segment_t *seg = &cl_download.segments[i];
+    if (seg->received < seg->length) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief `Net_HttpWriteFunc` for download segments. Called on the segment's thread.
+ */
+static bool Cl_DownloadWrite(const net_http_response_t *response, const void *data, size_t length, void *user_data) {
+
+  cl_download_segment_t *seg = user_data;
+
+  if (SDL_GetAtomicInt(&cl_download.abort)) {
+    return false;
+  }
+
+  // a response from elsewhere in the file, or for another entity, means the file has changed
+  if (response->offset != seg->offset + seg->received ||
+      (cl_download.etag[0] && strcmp(response->etag, cl_download.etag))) {
+    seg->changed = true;
+    return false;
+  }
+
+  if (seg->offset + seg->received + (int64_t) length > MAX_DOWNLOAD_SIZE) {
+    return false;
+  }
+
+  if (Fs_Write(seg->file, data, 1, length) != (int64_t) length) {
+    return false;
+  }
+
+  seg->received += length;
+
+  SDL_AddAtomicInt(&cl_download.received, (int32_t) length);
+  return true;
+}
+
+/**
+ * @brief Fetches the remainder of the specified segment. This is the segment's thread.
+ */
+static int32_t Cl_DownloadSegment(void *data) {
+
+  cl_download_segment_t *seg = data;
+
+  Net_HttpGetRange(&cl_download.addr,
+                   cl_download.filename,
+                   seg->offset + seg->received,
+                   seg->length - seg->received,
+                   cl_download.etag,
+                   Cl_DownloadWrite,
+                   seg,
+                   &seg->response);
+
+  return 0;
+}
+
+/**
+ * @brief Fetches all incomplete segments in parallel, and waits for them to finish.
+ * @return False if the client disconnected, true otherwise.
+ */
+static bool Cl_DownloadSegments(void) {
+  char path[MAX_OS_PATH];
+
+  for (int32_t i = 0; i < cl_download.num_segments; i++) {
+    cl_download_segment_t *seg = &cl_download.segments[i];
+
+    if (seg->received == seg->length) {
+      continue;
+    }
+
+    Cl_DownloadPartPath(i, path, sizeof(path));
+
+    seg->file = seg->received ? Fs_OpenAppend(path) : Fs_OpenWrite(path);
+    if (seg->file == NULL) {
+      Com_Warn("Failed to open %s for writing\n", path);
+      continue;
+    }
+
+    seg->changed = false;
+    seg->thread = SDL_CreateThread(Cl_DownloadSegment, __func__, seg);
+  }
+
+  const char *base = Basename(cl_download.filename);
+
+  bool finished = false;
+  while (!finished) {
+
+    finished = true;
+    for (int32_t i = 0; i < cl_download.num_segments; i++) {
+      const cl_download_segment_t *seg = &cl_download.segments[i];
+      if (seg->thread && SDL_GetThreadState(seg->thread) != SDL_THREAD_COMPLETE) {
+        finished = false;
+      }
+    }
+
+    if (cls.state == CL_DISCONNECTED) {
+      SDL_SetAtomicInt(&cl_download.abort, 1);
+      break;
+    }
+
+    if (cl_download.size > 0) {
+      const int64_t received = SDL_GetAtomicInt(&cl_download.received);
+      Cl_LoadingProgress(-1, va("Downloading %s (%d%%)", base, (int32_t) (received * 100 / cl_download.size)));
+    } else {
+      Cl_LoadingProgress(-1, va("Downloading %s", base));
+    }
+
+    if (!finished) {
+      SDL_Delay(16);
+    }
+  }
+
+  for (int32_t i = 0; i < cl_download.num_segments; i++) {
+    cl_download_segment_t *seg = &cl_download.segments[i];
+
+    if (seg->thread) {
+      SDL_WaitThread(seg->thread, NULL);
+      seg->thread = NULL;
+    }
+
+    if (seg->file) {
+      Fs_Close(seg->file);
+      seg->file = NULL;
+    }
+  }
+
+  return !SDL_GetAtomicInt(&cl_download.abort);
+}
+
+/**
+ * @brief Joins the part files of a complete download, and moves the result into place.
+ * @return True if the file was moved into place.
+ */
+static bool Cl_FinishDownload(void) {
+  char first[MAX_OS_PATH], path[MAX_OS_PATH];
+
+  Cl_DownloadPartPath(0, first, sizeof(first));
+
+  if (cl_download.num_segments > 1) {
+
+    file_t *out = Fs_OpenAppend(first);
+    if (out == NULL) {
+      Com_Warn("Failed to open %s for writing\n", first);
+      return false;
+    }
+
+    for (int32_t i = 1; i < cl_download.num_segments; i++) {
+      Cl_DownloadPartPath(i, path, sizeof(path));
+
+      file_t *in = Fs_OpenRead(path);
+      if (in == NULL) {
+        Com_Warn("Failed to open %s\n", path);
+        Fs_Close(out);
+        return false;
+      }
+
+      byte buffer[0x8000];
+      int64_t len;
+
+      while ((len = Fs_Read(in, buffer, 1, sizeof(buffer))) > 0) {
+        Fs_Write(out, buffer, 1, len);
+      }
+
+      Fs_Close(in);
+      Fs_Delete(path);
+    }
+
+    Fs_Close(out);
+  }
+
+  Cl_DownloadStatePath(path, sizeof(path));
+  Fs_Delete(path);
+
+  return Fs_Rename(first, cl_download.filename);
+}
+
+/**
+ * @brief If the file does not exist locally, download it from the server via HTTP. Large
+ * files are fetched in parallel segments, and interrupted downloads are resumed.
  */
 void Cl_CheckOrDownloadFile(const char *filename) {
 
@@ -93,69 +539,89 @@ void Cl_CheckOrDownloadFile(const char *filename) {
     return;
   }
 
-  // derive the download URL from the server address we're connected to
-  char url[MAX_OS_PATH];
-  Net_HttpUrl(&cls.net_chan.remote_address, filename, url, sizeof(url));
+  memset(&cl_download, 0, sizeof(cl_download));
 
-  Com_Print("Downloading %s...\n", filename);
+  g_strlcpy(cl_download.filename, filename, sizeof(cl_download.filename));
+  cl_download.addr = cls.net_chan.remote_address;
 
-  SDL_SetAtomicInt(&cl_download.complete, 0);
-  cl_download.status = 0;
-  cl_download.data = NULL;
-  cl_download.length = 0;
+  if (Cl_LoadDownload()) {
+    Com_Print("Resuming %s...\n", filename);
+  } else {
+    Com_Print("Downloading %s...\n", filename);
+    Cl_ResetDownload();
+  }
 
-  Net_HttpGetAsync(url, Cl_DownloadComplete, NULL);
+  bool restarted = false;
+  int32_t attempts = 0;
 
-  const char *base = Basename(filename);
-  while (!SDL_GetAtomicInt(&cl_download.complete)) {
+  while (!Cl_DownloadIsComplete()) {
 
-    if (cls.state == CL_DISCONNECTED) {
+    const int32_t received = SDL_GetAtomicInt(&cl_download.received);
+
+    if (!Cl_DownloadSegments()) {
       Com_Warn("Disconnected during download of %s\n", filename);
+      Cl_SaveDownload();
       return;
     }
 
-    Cl_LoadingProgress(-1, va("Downloading %s", base));
-    SDL_Delay(16);
-  }
+    bool changed = false;
+    for (int32_t i = 0; i < cl_download.num_segments; i++) {
+      changed |= cl_download.segments[i].changed;
+    }
+
+    if (changed) {
+      if (restarted) {
+        Com_Warn("Failed to download %s (changed during download)\n", filename);
+        Cl_DeleteDownload();
+        return;
+      }
 
-  if (cl_download.status != 200 || !cl_download.data || !cl_download.length) {
-    Com_Warn("Failed to download %s (HTTP %d)\n", filename, cl_download.status);
-    if (cl_download.data) {
-      Mem_Free(cl_download.data);
+      Com_Print("%s changed on the server, restarting download\n", filename);
+      Cl_DeleteDownload();
+      Cl_ResetDownload();
+      restarted = true;
+      continue;
     }
-    return;
-  }
 
-  if (cl_download.length > MAX_DOWNLOAD_SIZE) {
-    Com_Warn("Download %s exceeds maximum size (%zu bytes)\n", filename, cl_download.length);
-    Mem_Free(cl_download.data);
-    return;
-  }
+    if (cl_download.size == -1) {
+      const net_http_response_t *response = &cl_download.segments[0].response;
 
-  // write to a temp file, then rename
-  char tempname[MAX_OS_PATH];
-  StripExtension(filename, tempname);
-  g_strlcat(tempname, ".tmp", sizeof(tempname));
+      if (response->size == -1) {
+        Com_Warn("Failed to download %s (HTTP %d)\n", filename, response->status);
+        Cl_DeleteDownload();
+        return;
+      }
 
-  file_t *file = Fs_OpenWrite(tempname);
-  if (!file) {
-    Com_Warn("Failed to open %s for writing\n", tempname);
-    Mem_Free(cl_download.data);
-    return;
-  }
+      cl_download.size = response->size;
+      g_strlcpy(cl_download.etag, response->etag, sizeof(cl_download.etag));
 
-  Fs_Write(file, cl_download.data, 1, cl_download.length);
-  Fs_Close(file);
-  Mem_Free(cl_download.data);
+      Cl_PlanDownload();
+    }
+
+    if (cl_download.size > MAX_DOWNLOAD_SIZE) {
+      Com_Warn("Download %s exceeds maximum size (%" PRId64 " bytes)\n", filename, cl_download.size);
+      Cl_DeleteDownload();
+      return;
+    }
+
+    Cl_SaveDownload();
+
+    if (SDL_GetAtomicInt(&cl_download.received) > received) {
+      attempts = 0;
+    } else if (++attempts == MAX_DOWNLOAD_ATTEMPTS) {
+      Com_Warn("Failed to download %s, it will be resumed on the next attempt\n", filename);
+      return;
+    }
+  }
 
-  if (Fs_Rename(tempname, filename)) {
-    Com_Print("Downloaded %s (%zu bytes)\n", filename, cl_download.length);
+  if (Cl_FinishDownload()) {
+    Com_Print("Downloaded %s (%" PRId64 " bytes)\n", filename, cl_download.size);
 
     if (strstr(filename, ".pk3")) {
       Fs_AddToSearchPath(filename);
     }
   } else {
-    Com_Error(ERROR_DROP, "Failed to rename %s\n", tempname);
+    Com_Error(ERROR_DROP, "Failed to rename %s\n", filename);
   }
 }
 
@@ -196,8 +662,8 @@ void Cl_Precache_f(void) {
 static void Cl_ParseBaseline(void) {
   static entity_state_t null_state;
 
-  const int16_t number = Net_ReadShort(&net_message);
-  const uint16_t bits = Net_ReadShort(&net_message);
+  const int16_t number = Net_ReadEntityNumber(&net_message);
+  const uint16_t bits = Net_ReadVarInt(&net_message);
 
   if (number < 0 || number >= MAX_ENTITIES) {
     Com_Error(ERROR_DROP, "Invalid entity number: %d\n", number);
@@ -368,6 +834,7 @@ static void Cl_ShowNet(const char *s) {
  */
 void Cl_ParseServerMessage(void) {
   int32_t cmd, old_cmd;
+  size_t frame_start = 0, frame_end = 0;
 
   if (cl_draw_net_messages->integer == 1) {
     Com_Print("%u ", (uint32_t) net_message.size);
@@ -419,7 +886,9 @@ void Cl_ParseServerMessage(void) {
         Com_Error(ERROR_DROP, "Server dropped connection\n");
 
       case SV_CMD_FRAME:
+        frame_start = net_message.read - 1;
         Cl_ParseFrame();
+        frame_end = net_message.read;
         break;
 
       case SV_CMD_PRINT:
@@ -456,5 +925,5 @@ void Cl_ParseServerMessage(void) {
 
   Cl_AddNetGraph();
 
-  Cl_WriteDemoMessage();
+  Cl_WriteDemoMessage(frame_start, frame_end);
 }
@@ -293,7 +293,7 @@ static void Cl_DrawSoundStats(void) {
   R_Draw2DString(x, y, "Sound:", color_magenta);
   y += ch;
 
-  R_Draw2DString(x, y, va("%d channels  reverb %.2f", s_context.num_active_channels, s_context.reverb), color_magenta);
+  R_Draw2DString(x, y, va("%d channels  %d AL calls  reverb %.2f", s_context.num_active_channels, s_context.num_al_calls, s_context.reverb), color_magenta);
   y += ch;
 
   for (int32_t i = 0; i < MAX_CHANNELS; i++) {
@@ -671,7 +671,8 @@ static void R_LoadBspModel(r_model_t *mod, void *buffer) {
   mod->bsp = Mem_LinkMalloc(sizeof(r_bsp_model_t), mod);
   mod->bsp->cm = Cm_Bsp();
 
-  Bsp_LoadLumps(header, mod->bsp->cm->file, R_BSP_LUMPS);
+  // the lumps are unloaded before the buffer is released, so they may alias it
+  Bsp_AliasLumps(header, mod->bsp->cm->file, R_BSP_LUMPS);
 
   R_LoadBspPlanes(mod->bsp);
   R_LoadBspMaterials(mod);
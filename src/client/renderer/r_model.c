@@ -88,11 +88,19 @@ r_model_t *R_LoadModel(const char *name) {
 
     void *buf = NULL;
 
-    Fs_Load(path, &buf);
+    // BSP lumps are aliased rather than copied, so map the file where possible
+    const bool mapped = format->type == MODEL_BSP && Fs_Map(path, &buf) != -1;
+    if (!mapped) {
+      Fs_Load(path, &buf);
+    }
 
     format->Load(mod, buf);
 
-    Fs_Free(buf);
+    if (mapped) {
+      Fs_Unmap(buf);
+    } else {
+      Fs_Free(buf);
+    }
 
     mod->radius = Box3_Radius(mod->bounds);
 
@@ -34,6 +34,8 @@ cvar_t *s_effects;
 cvar_t *s_effects_volume;
 cvar_t *s_hrtf;
 cvar_t *s_rate;
+cvar_t *s_resample;
+cvar_t *s_resample_cache;
 cvar_t *s_volume;
 
 /**
@@ -279,6 +281,8 @@ static void S_InitLocal(void) {
   s_effects_volume = Cvar_Add("s_effects_volume", "1", CVAR_ARCHIVE, "Effects sound volume.");
   s_hrtf = Cvar_Add("s_hrtf", "0", CVAR_ARCHIVE | CVAR_S_DEVICE, "Enables HRTF sound spatialization. Recommended for headphones.");
   s_rate = Cvar_Add("s_rate", "44100", CVAR_ARCHIVE | CVAR_S_DEVICE, "Sound sample rate in Hz.");
+  s_resample = Cvar_Add("s_resample", "2", CVAR_ARCHIVE | CVAR_S_MEDIA, "Sound resampling quality: 0 nearest, 1 linear, 2 windowed sinc.");
+  s_resample_cache = Cvar_Add("s_resample_cache", "1", CVAR_ARCHIVE, "Cache resampled sounds on disk.");
   s_volume = Cvar_Add("s_volume", "1", CVAR_ARCHIVE, "Master sound volume level.");
 
   Cvar_ClearAll(CVAR_S_MASK);
@@ -420,9 +424,12 @@ void S_Init(void) {
 
   S_InitMedia();
 
+  S_PruneSampleCache();
+
   S_InitMusic();
 
-  s_context.resample_buffer = Mem_TagMalloc(sizeof(int16_t) * 2048, MEM_TAG_SOUND);
+  s_context.resample_buffer = Mem_TagMalloc(sizeof(float) * 2048, MEM_TAG_SOUND);
+  s_context.resample_buffer_size = sizeof(float) * 2048;
 }
 
 /**
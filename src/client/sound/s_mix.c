@@ -22,6 +22,14 @@
 #include "s_local.h"
 #include "collision/cm_voxel.h"
 
+/**
+ * @brief Makes the specified OpenAL call, counting it in `s_context.num_al_calls`.
+ */
+#define S_AL(...) { \
+  __VA_ARGS__; \
+  s_context.num_al_calls++; \
+}
+
 /**
  * @brief Returns effective gain for non-ambient samples.
  */
@@ -56,8 +64,8 @@ int32_t S_AllocChannel(void) {
  */
 void S_FreeChannel(int32_t c) {
 
-  alSourceStop(s_context.sources[c]);
-  alSourcei(s_context.sources[c], AL_BUFFER, 0);
+  S_AL(alSourceStop(s_context.sources[c]));
+  S_AL(alSourcei(s_context.sources[c], AL_BUFFER, 0));
 
   const ALuint filter = s_context.channels[c].filter;
   memset(&s_context.channels[c], 0, sizeof(s_context.channels[c]));
@@ -123,16 +131,115 @@ static bool S_SpatializeChannel(const s_stage_t *stage, s_channel_t *ch) {
       ch->occlusion = Clampf(ch->occlusion + (target > ch->occlusion ? step : -step), 0.f, 1.f);
     }
 
+  }
+
+  return true;
+}
+
+/**
+ * @brief Resolves the source parameters for the specified channel, after spatialization.
+ */
+static s_channel_state_t S_ChannelState(const s_channel_t *ch) {
+
+  s_channel_state_t state = {
+    .origin = ch->play.origin,
+    .velocity = s_doppler->value ? ch->play.velocity : Vec3_Zero(),
+    .gain = ch->gain * ((ch->play.flags & S_PLAY_AMBIENT) ? S_AmbientGain() : S_EffectsGain()),
+    .pitch = ch->pitch,
+  };
+
+  if (s_context.effects.loaded) {
+
     // Combine both into a single filter by multiplying gains; only one AL_DIRECT_FILTER slot exists per source.
-    {
-      const float gain   = Mixf(1.f, 0.66f,  ch->underwater) * Mixf(1.f, 0.33f, ch->occlusion);
-      const float gainhf = Mixf(1.f, 0.33f,  ch->underwater) * Mixf(1.f, 0.88f, ch->occlusion);
-      alFilterf(ch->filter, AL_LOWPASS_GAIN,   gain);
-      alFilterf(ch->filter, AL_LOWPASS_GAINHF, gainhf);
+    state.lowpass_gain   = Mixf(1.f, 0.66f,  ch->underwater) * Mixf(1.f, 0.33f, ch->occlusion);
+    state.lowpass_gainhf = Mixf(1.f, 0.33f,  ch->underwater) * Mixf(1.f, 0.88f, ch->occlusion);
+
+    state.send = (ch->play.flags & S_PLAY_UI) ? AL_EFFECTSLOT_NULL : (ALuint) s_context.effects.reverb_slot;
+  }
+
+  return state;
+}
+
+/**
+ * @brief Submits the parameters of `state` which differ from those last submitted for the
+ * channel, or which are otherwise dirty, to its source.
+ */
+static void S_CommitChannel(ALuint src, s_channel_t *ch, const s_channel_state_t *state) {
+
+  uint32_t dirty = ch->dirty;
+
+  if (!Vec3_Equal(state->origin, ch->state.origin)) {
+    dirty |= S_CHANNEL_ORIGIN;
+  }
+  if (!Vec3_Equal(state->velocity, ch->state.velocity)) {
+    dirty |= S_CHANNEL_VELOCITY;
+  }
+  if (state->gain != ch->state.gain) {
+    dirty |= S_CHANNEL_GAIN;
+  }
+  if (state->pitch != ch->state.pitch) {
+    dirty |= S_CHANNEL_PITCH;
+  }
+  if (state->lowpass_gain != ch->state.lowpass_gain || state->lowpass_gainhf != ch->state.lowpass_gainhf) {
+    dirty |= S_CHANNEL_FILTER;
+  }
+  if (state->send != ch->state.send) {
+    dirty |= S_CHANNEL_SEND;
+  }
+
+  if (dirty & S_CHANNEL_ORIGIN) {
+    S_AL(alSourcefv(src, AL_POSITION, state->origin.xyz));
+  }
+
+  if (dirty & S_CHANNEL_VELOCITY) {
+    S_AL(alSourcefv(src, AL_VELOCITY, state->velocity.xyz));
+  }
+
+  if (dirty & S_CHANNEL_GAIN) {
+    S_AL(alSourcef(src, AL_GAIN, state->gain));
+  }
+
+  if (dirty & S_CHANNEL_PITCH) {
+    S_AL(alSourcef(src, AL_PITCH, state->pitch));
+  }
+
+  if (s_context.effects.loaded) {
+
+    // the source copies the filter's parameters when it is attached, so reattach it
+    if (dirty & S_CHANNEL_FILTER) {
+      S_AL(alFilterf(ch->filter, AL_LOWPASS_GAIN,   state->lowpass_gain));
+      S_AL(alFilterf(ch->filter, AL_LOWPASS_GAINHF, state->lowpass_gainhf));
+      S_AL(alSourcei(src, AL_DIRECT_FILTER, (ALint) ch->filter));
+    }
+
+    if (dirty & S_CHANNEL_SEND) {
+      S_AL(alSource3i(src, AL_AUXILIARY_SEND_FILTER, (ALint) state->send, 0, AL_FILTER_NULL));
     }
   }
 
-  return true;
+  ch->state = *state;
+  ch->dirty = 0;
+}
+
+/**
+ * @brief The interval, in milliseconds, at which channels that may have finished are polled.
+ */
+#define S_POLL_INTERVAL 50
+
+/**
+ * @return The ticks at which the specified channel, started at `ticks`, is expected to finish.
+ * Looping channels finish only when freed, and are polled at `S_POLL_INTERVAL`.
+ */
+static uint32_t S_ChannelPollTicks(const s_channel_t *ch, uint32_t ticks) {
+
+  if (ch->play.flags & S_PLAY_LOOP) {
+    return ticks + S_POLL_INTERVAL;
+  }
+
+  const size_t frames = ch->play.sample->num_samples / (ch->play.sample->stereo ? 2 : 1);
+  const float duration = frames * 1000.f / (s_rate->integer * Maxf(ch->pitch, .01f));
+
+  return ticks + (uint32_t) duration;
 }
 
 /**
@@ -140,21 +247,23 @@ static bool S_SpatializeChannel(const s_stage_t *stage, s_channel_t *ch) {
  */
 void S_MixChannels(const s_stage_t *stage) {
 
+  s_context.num_al_calls = 0;
+
   if (s_doppler->modified) {
-    alDopplerFactor(.05f * s_doppler->value);
+    S_AL(alDopplerFactor(.05f * s_doppler->value));
   }
 
-  alListenerfv(AL_POSITION, stage->origin.xyz);
+  S_AL(alListenerfv(AL_POSITION, stage->origin.xyz));
 
-  alListenerfv(AL_ORIENTATION, (float []) {
+  S_AL(alListenerfv(AL_ORIENTATION, (float []) {
     stage->forward.x, stage->forward.y, stage->forward.z,
     stage->up.x, stage->up.y, stage->up.z
-  });
+  }));
 
   if (s_doppler->value) {
-    alListenerfv(AL_VELOCITY, stage->velocity.xyz);
+    S_AL(alListenerfv(AL_VELOCITY, stage->velocity.xyz));
   } else {
-    alListenerfv(AL_VELOCITY, Vec3_Zero().xyz);
+    S_AL(alListenerfv(AL_VELOCITY, Vec3_Zero().xyz));
   }
 
   if (s_context.effects.loaded) {
@@ -163,17 +272,17 @@ void S_MixChannels(const s_stage_t *stage) {
     if (r != s_context.reverb) {
       s_context.reverb = r;
       ALenum type;
-      alGetEffecti(s_context.effects.reverb, AL_EFFECT_TYPE, &type);
+      S_AL(alGetEffecti(s_context.effects.reverb, AL_EFFECT_TYPE, &type));
       if (type == AL_EFFECT_EAXREVERB) {
-        alEffectf(s_context.effects.reverb, AL_EAXREVERB_GAIN, 0.32f * r);
-        alEffectf(s_context.effects.reverb, AL_EAXREVERB_DECAY_TIME, 0.1f + 2.4f * r);
-        alEffectf(s_context.effects.reverb, AL_EAXREVERB_ROOM_ROLLOFF_FACTOR, r);
+        S_AL(alEffectf(s_context.effects.reverb, AL_EAXREVERB_GAIN, 0.32f * r));
+        S_AL(alEffectf(s_context.effects.reverb, AL_EAXREVERB_DECAY_TIME, 0.1f + 2.4f * r));
+        S_AL(alEffectf(s_context.effects.reverb, AL_EAXREVERB_ROOM_ROLLOFF_FACTOR, r));
       } else {
-        alEffectf(s_context.effects.reverb, AL_REVERB_GAIN, 0.32f * r);
-        alEffectf(s_context.effects.reverb, AL_REVERB_DECAY_TIME, 0.1f + 2.4f * r);
-        alEffectf(s_context.effects.reverb, AL_REVERB_ROOM_ROLLOFF_FACTOR, r);
+        S_AL(alEffectf(s_context.effects.reverb, AL_REVERB_GAIN, 0.32f * r));
+        S_AL(alEffectf(s_context.effects.reverb, AL_REVERB_DECAY_TIME, 0.1f + 2.4f * r));
+        S_AL(alEffectf(s_context.effects.reverb, AL_REVERB_ROOM_ROLLOFF_FACTOR, r));
       }
-      alAuxiliaryEffectSloti(s_context.effects.reverb_slot, AL_EFFECTSLOT_EFFECT, (ALint) s_context.effects.reverb);
+      S_AL(alAuxiliaryEffectSloti(s_context.effects.reverb_slot, AL_EFFECTSLOT_EFFECT, (ALint) s_context.effects.reverb));
     }
   }
 
@@ -200,66 +309,58 @@ void S_MixChannels(const s_stage_t *stage) {
       continue;
     }
 
-    alSourcefv(src, AL_POSITION, ch->play.origin.xyz);
-
-    if (s_doppler->value) {
-      alSourcefv(src, AL_VELOCITY, ch->play.velocity.xyz);
-    } else {
-      alSourcefv(src, AL_VELOCITY, Vec3_Zero().xyz);
-    }
-
-    float volume;
-    if (ch->play.flags & S_PLAY_AMBIENT) {
-      volume = S_AmbientGain();
-    } else {
-      volume = S_EffectsGain();
+    // a newly started channel inherits its source from another, so submit everything
+    if (ch->start_time == 0) {
+      ch->dirty = S_CHANNEL_ALL;
     }
 
-    alSourcef(src, AL_GAIN, ch->gain * volume);
-    alSourcef(src, AL_PITCH, ch->pitch);
-
-    if (s_context.effects.loaded) {
-      alSourcei(src, AL_DIRECT_FILTER, (ALint) ch->filter);
-      alSourcef(src, AL_AIR_ABSORPTION_FACTOR, 0.025f); // 0.05 dB/m × (1 m / 40 units)
-      const ALuint send = (ch->play.flags & S_PLAY_UI) ? AL_EFFECTSLOT_NULL : (ALuint) s_context.effects.reverb_slot;
-      alSource3i(src, AL_AUXILIARY_SEND_FILTER, (ALint) send, 0, AL_FILTER_NULL);
-    }
+    const s_channel_state_t state = S_ChannelState(ch);
+    S_CommitChannel(src, ch, &state);
 
     if (ch->start_time == 0) {
       ch->start_time = stage->ticks;
+      ch->poll_ticks = S_ChannelPollTicks(ch, stage->ticks);
 
-      alSourcei(src, AL_BUFFER, ch->play.sample->buffer);
+      if (s_context.effects.loaded) {
+        S_AL(alSourcef(src, AL_AIR_ABSORPTION_FACTOR, 0.025f)); // 0.05 dB/m × (1 m / 40 units)
+      }
+
+      S_AL(alSourcei(src, AL_BUFFER, ch->play.sample->buffer));
 
       if (ch->play.flags & (S_PLAY_UI | S_PLAY_RELATIVE)) {
-        alSourcei(src, AL_SOURCE_RELATIVE, 1);
+        S_AL(alSourcei(src, AL_SOURCE_RELATIVE, 1));
       } else {
-        alSourcei(src, AL_SOURCE_RELATIVE, 0);
+        S_AL(alSourcei(src, AL_SOURCE_RELATIVE, 0));
       }
 
-      alSourcef(src, AL_ROLLOFF_FACTOR, 0.5f);
-      alSourcef(src, AL_REFERENCE_DISTANCE, 128.f);
-      alSourcef(src, AL_MAX_DISTANCE, MAX_WORLD_DIST);
+      S_AL(alSourcef(src, AL_ROLLOFF_FACTOR, 0.5f));
+      S_AL(alSourcef(src, AL_REFERENCE_DISTANCE, 128.f));
+      S_AL(alSourcef(src, AL_MAX_DISTANCE, MAX_WORLD_DIST));
 
       if (ch->play.flags & S_PLAY_LOOP) {
-        alSourcei(src, AL_LOOPING, 1);
+        S_AL(alSourcei(src, AL_LOOPING, 1));
       } else {
-        alSourcei(src, AL_LOOPING, 0);
+        S_AL(alSourcei(src, AL_LOOPING, 0));
       }
 
       if (ch->play.flags & S_PLAY_AMBIENT) {
-        alSourcei(src, AL_SAMPLE_OFFSET, Randomf() * (int32_t) ch->play.sample->num_samples);
+        S_AL(alSourcei(src, AL_SAMPLE_OFFSET, Randomf() * (int32_t) ch->play.sample->num_samples));
       }
 
-      alSourcePlay(src);
+      S_AL(alSourcePlay(src));
 
-    } else {
-      ALenum state;
-      alGetSourcei(src, AL_SOURCE_STATE, &state);
+    } else if ((int32_t) (stage->ticks - ch->poll_ticks) >= 0) {
 
-      if (state != AL_PLAYING) {
+      // only poll channels which may have finished, rather than every channel every frame
+      ALenum source_state;
+      S_AL(alGetSourcei(src, AL_SOURCE_STATE, &source_state));
+
+      if (source_state != AL_PLAYING) {
         S_FreeChannel(i);
         continue;
       }
+
+      ch->poll_ticks = stage->ticks + S_POLL_INTERVAL;
     }
 
     S_GetError(ch->play.sample->media.name);
@@ -300,17 +401,19 @@ void S_PlaySample(s_sample_t *sample) {
   s_context.channels[c].gain = 1.f;
   s_context.channels[c].pitch = 1.f;
   s_context.channels[c].start_time = (uint32_t) SDL_GetTicks();
+  s_context.channels[c].poll_ticks = S_ChannelPollTicks(&s_context.channels[c], s_context.channels[c].start_time);
+  s_context.channels[c].dirty = S_CHANNEL_ALL;
 
   const ALuint src = s_context.sources[c];
-  alSourcef(src, AL_GAIN, S_EffectsGain());
-  alSourcef(src, AL_PITCH, 1.f);
-  alSourcei(src, AL_SOURCE_RELATIVE, 1);
-  alSourcei(src, AL_LOOPING, 0);
-  alSourcei(src, AL_BUFFER, sample->buffer);
+  S_AL(alSourcef(src, AL_GAIN, S_EffectsGain()));
+  S_AL(alSourcef(src, AL_PITCH, 1.f));
+  S_AL(alSourcei(src, AL_SOURCE_RELATIVE, 1));
+  S_AL(alSourcei(src, AL_LOOPING, 0));
+  S_AL(alSourcei(src, AL_BUFFER, sample->buffer));
   if (s_context.effects.loaded) {
-    alSourcei(src, AL_DIRECT_FILTER, AL_FILTER_NULL);
+    S_AL(alSourcei(src, AL_DIRECT_FILTER, AL_FILTER_NULL));
   }
-  alSourcePlay(src);
+  S_AL(alSourcePlay(src));
 }
 
 /**
@@ -32,9 +32,10 @@ static struct {
   ALuint source;
   ALuint music_buffers[MUSIC_BUFFERS];
   float *raw_frame_buffer;
+  size_t frame_buffer_size;
   int16_t *frame_buffer;
   size_t resample_frame_buffer_size;
-  int16_t *resample_frame_buffer;
+  float *resample_frame_buffer;
   uint32_t next_buffer;
   s_music_t *default_music;
   s_music_t *current_music;
@@ -228,21 +229,25 @@ static void S_BufferMusic(s_music_t *music, bool setup_buffers) {
       break;
     }
     
-    S_ConvertSamples(s_music_state.raw_frame_buffer, frames, &s_music_state.frame_buffer, NULL);
-
-    const int16_t *frame_buffer = s_music_state.frame_buffer;
+    const float *raw_frame_buffer = s_music_state.raw_frame_buffer;
 
+    // each buffer is resampled independently, so the filter can not span buffers
     if (music->info.samplerate != s_rate->integer) {
       frames = S_Resample(music->info.channels,
                           music->info.samplerate,
                           s_rate->integer,
+                          s_resample->integer > S_RESAMPLE_NEAREST ? S_RESAMPLE_LINEAR : S_RESAMPLE_NEAREST,
                           frames,
-                          s_music_state.frame_buffer,
+                          raw_frame_buffer,
                           &s_music_state.resample_frame_buffer,
                           &s_music_state.resample_frame_buffer_size);
-      frame_buffer = s_music_state.resample_frame_buffer;
+      raw_frame_buffer = s_music_state.resample_frame_buffer;
     }
 
+    S_ConvertSamples(raw_frame_buffer, frames, &s_music_state.frame_buffer, &s_music_state.frame_buffer_size);
+
+    const int16_t *frame_buffer = s_music_state.frame_buffer;
+
     ALuint buffer;
 
     if (setup_buffers) {
@@ -473,6 +478,7 @@ void S_InitMusic(void) {
 
   s_music_state.raw_frame_buffer = Mem_TagMalloc(sizeof(float) * MUSIC_BUFFER_SIZE, MEM_TAG_SOUND);
   s_music_state.frame_buffer = Mem_TagMalloc(sizeof(int16_t) * MUSIC_BUFFER_SIZE, MEM_TAG_SOUND);
+  s_music_state.frame_buffer_size = sizeof(int16_t) * MUSIC_BUFFER_SIZE;
   s_music_state.resample_frame_buffer = NULL;
 
   Cmd_Add("s_next_track", S_NextTrack_f, CMD_SOUND, "Play the next music track.");
@@ -21,45 +21,166 @@
 
 #include "s_local.h"
 
-#define NearestMultiple(n, align)  ((n) == 0 ? 0 : ((n) - 1 - ((n) - 1) % (align) + (align)))
+/**
+ * @brief The number of fractional positions (phases) tabulated by the sinc filter.
+ */
+#define S_SINC_PHASES 256
+
+/**
+ * @brief The number of zero crossings of the sinc kernel on each side of its center.
+ */
+#define S_SINC_ZEROS 8
 
 /**
- * @brief Resample audio. outdata will be realloc'd to the size required to handle this operation,
- * so be sure to initialize to `NULL` before calling if it's first time!
+ * @brief The maximum number of filter taps, reached when downsampling by large factors.
  */
-size_t S_Resample(const int32_t channels, const int32_t source_rate, const int32_t dest_rate, const size_t num_frames, const int16_t *in_frames, int16_t **out_frames, size_t *out_size) {
-  
-  const float stepscale = (float) source_rate / (float) dest_rate;
-  const size_t outcount = NearestMultiple((size_t) (num_frames / stepscale), channels);
-  const size_t size = outcount * sizeof(int16_t);
+#define S_SINC_MAX_TAPS 64
+
+/**
+ * @brief Builds the polyphase windowed-sinc filter for resampling between the given rates.
+ * Each phase holds `taps` weights, normalized to unity gain. When downsampling, the cutoff
+ * is lowered to the destination's Nyquist frequency, and the kernel widened to match.
+ */
+static void S_InitSinc(const int32_t source_rate, const int32_t dest_rate) {
+
+  s_sinc_t *sinc = &s_context.sinc;
+
+  if (sinc->source_rate == source_rate && sinc->dest_rate == dest_rate) {
+    return;
+  }
+
+  const double cutoff = fmin(1.0, (double) dest_rate / (double) source_rate);
+  const int32_t taps = Mini(2 * (int32_t) ceil(S_SINC_ZEROS / cutoff), S_SINC_MAX_TAPS);
+
+  Mem_Free(sinc->weights);
+
+  sinc->weights = Mem_TagMalloc(sizeof(float) * S_SINC_PHASES * taps, MEM_TAG_SOUND);
+  sinc->source_rate = source_rate;
+  sinc->dest_rate = dest_rate;
+  sinc->taps = taps;
+
+  const int32_t half = taps / 2;
+
+  for (int32_t p = 0; p < S_SINC_PHASES; p++) {
+    float *w = sinc->weights + p * taps;
+    const double frac = p / (double) S_SINC_PHASES;
+
+    double sum = 0.0;
+    for (int32_t k = 0; k < taps; k++) {
+
+      // distance from the output position to the source frame of this tap
+      const double x = (k - half + 1) - frac;
+      const double y = fabs(x) < 1e-9 ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+
+      // Blackman window over the full kernel width
+      const double n = (x + half) / (double) taps;
+      const double window = 0.42 - 0.5 * cos(2.0 * M_PI * n) + 0.08 * cos(4.0 * M_PI * n);
+
+      w[k] = (float) (y * fmax(window, 0.0));
+      sum += w[k];
+    }
+
+    for (int32_t k = 0; k < taps; k++) {
+      w[k] = (float) (w[k] / sum);
+    }
+  }
+}
+
+/**
+ * @brief Resample interleaved floating-point audio to `dest_rate`. `out_samples` will be
+ * realloc'd to the size required to handle this operation, so be sure to initialize it to
+ * `NULL` before calling if it's the first time! Each channel is deinterleaved into a padded
+ * scratch buffer, so that the inner loops are branch-free and contiguous, and may be
+ * vectorized by the compiler.
+ * @return The number of resampled samples (frames times channels).
+ */
+size_t S_Resample(const int32_t channels, const int32_t source_rate, const int32_t dest_rate, const s_resample_t quality,
+                  const size_t num_samples, const float *in_samples, float **out_samples, size_t *out_size) {
+
+  const size_t in_frames = num_samples / channels;
+  const size_t out_frames = (size_t) (((uint64_t) in_frames * dest_rate) / source_rate);
+  const size_t size = out_frames * channels * sizeof(float);
 
   if (out_size && *out_size < size) {
-    *out_frames = Mem_Realloc(*out_frames, size);
+    *out_samples = Mem_Realloc(*out_samples, size);
     *out_size = size;
   }
 
-  int32_t samplefrac = 0;
-  const float fracstep = stepscale * 256.0;
+  if (out_frames == 0) {
+    return 0;
+  }
 
-  for (size_t i = 0; i < outcount; ) {
-    for (int32_t c = 0; c < channels; c++, i++) {
-      int32_t srcsample = NearestMultiple(samplefrac >> 8, channels) + c;
-      if (srcsample >= (int32_t)(num_frames * channels)) {
-        srcsample = (int32_t)(num_frames * channels) - channels + c;
-      }
+  if (quality >= S_RESAMPLE_SINC) {
+    S_InitSinc(source_rate, dest_rate);
+  }
+
+  const int32_t taps = quality >= S_RESAMPLE_SINC ? s_context.sinc.taps : 2;
+  const int32_t half = taps / 2;
+
+  // the source position of each output frame, in 32.32 fixed point
+  const uint64_t step = ((uint64_t) source_rate << 32) / (uint64_t) dest_rate;
+
+  const size_t padded_frames = in_frames + taps;
+  float *padded = Mem_TagMalloc(padded_frames * sizeof(float), MEM_TAG_SOUND);
 
-      samplefrac += fracstep;
-      (*out_frames)[i] = LittleShort(in_frames[srcsample]);
+  for (int32_t c = 0; c < channels; c++) {
+
+    // deinterleave this channel, with silence before and after it
+    const float *in = in_samples + c;
+    for (size_t i = 0; i < in_frames; i++, in += channels) {
+      padded[half + i] = *in;
+    }
+
+    float *out = *out_samples + c;
+    uint64_t pos = 0;
+
+    switch (quality) {
+      case S_RESAMPLE_NEAREST:
+        for (size_t i = 0; i < out_frames; i++, out += channels, pos += step) {
+          *out = padded[half + (pos >> 32)];
+        }
+        break;
+
+      case S_RESAMPLE_LINEAR:
+        // the final frame holds its value, rather than fading into the padding
+        padded[half + in_frames] = padded[half + in_frames - 1];
+
+        for (size_t i = 0; i < out_frames; i++, out += channels, pos += step) {
+          const float *src = padded + half + (pos >> 32);
+          const float frac = (pos & 0xffffffff) * (1.f / 4294967296.f);
+          *out = src[0] + (src[1] - src[0]) * frac;
+        }
+        break;
+
+      default:
+        for (size_t i = 0; i < out_frames; i++, out += channels, pos += step) {
+          const float *restrict src = padded + (pos >> 32) + 1;
+          const float *restrict w = s_context.sinc.weights + (((pos & 0xffffffff) * S_SINC_PHASES) >> 32) * taps;
+
+          float sum = 0.f;
+          for (int32_t k = 0; k < taps; k++) {
+            sum += src[k] * w[k];
+          }
+          *out = sum;
+        }
+        break;
     }
+
+    // the padding is overwritten only at its edges
+    memset(padded, 0, half * sizeof(float));
+    memset(padded + half + in_frames, 0, (padded_frames - half - in_frames) * sizeof(float));
   }
 
-  return outcount;
+  Mem_Free(padded);
+
+  return out_frames * channels;
 }
 
 /**
- * @brief Converts floating-point audio samples to 16-bit signed integers.
+ * @brief Converts floating-point audio samples to 16-bit signed integers. The loop is free
+ * of calls and branches, so that it may be vectorized by the compiler.
  */
-void S_ConvertSamples(const float *input_samples, const sf_count_t num_samples, int16_t **out_samples, size_t *out_size) {
+void S_ConvertSamples(const float *restrict input_samples, const sf_count_t num_samples, int16_t **out_samples, size_t *out_size) {
   const size_t size = sizeof(int16_t) * num_samples;
 
   if (out_size && *out_size < size) {
@@ -67,16 +188,247 @@ void S_ConvertSamples(const float *input_samples, const sf_count_t num_samples,
     *out_size = size;
   }
 
+  int16_t *restrict out = *out_samples;
+
   for (sf_count_t i = 0; i < num_samples; i++) {
-    (*out_samples)[i] = (int16_t) Clampf(input_samples[i] * 32768.0f, INT16_MIN, INT16_MAX);
+    float s = input_samples[i] * 32768.f;
+    s = s < (float) INT16_MIN ? (float) INT16_MIN : s;
+    s = s > (float) INT16_MAX ? (float) INT16_MAX : s;
+    out[i] = (int16_t) s;
+  }
+}
+
+/**
+ * @brief Identifies resampled sounds cached on disk.
+ */
+#define S_SAMPLE_CACHE_IDENT (('M' << 24) + ('C' << 16) + ('S' << 8) + 'Q') // "QSCM"
+
+/**
+ * @brief The version of resampled sounds cached on disk.
+ */
+#define S_SAMPLE_CACHE_VERSION 2
+
+/**
+ * @brief The header of a resampled sound cached on disk, followed by its 16 bit samples.
+ * The cache is local to the machine, and so is written in native byte order; a cache from
+ * a machine of different endianness simply fails to verify, and is regenerated. The source
+ * path is recorded too, so that a cache is never loaded for the wrong sound.
+ */
+typedef struct {
+  int32_t ident;
+  int32_t version;
+  char path[MAX_QPATH];
+  int64_t mod_time;
+  int32_t rate;
+  int32_t quality;
+  int32_t channels;
+  int32_t num_samples;
+} s_sample_cache_t;
+
+/**
+ * @return The configured resampling quality.
+ */
+static s_resample_t S_ResampleQuality(void) {
+  return (s_resample_t) Maxi(S_RESAMPLE_NEAREST, Mini(s_resample->integer, S_RESAMPLE_SINC));
+}
+
+/**
+ * @brief Resolves the cache path for the given sound file at the current `s_rate`.
+ */
+static void S_SampleCachePath(const char *path, char *cache_path, size_t size) {
+  g_snprintf(cache_path, size, "cache/%s.%d.pcm", path, s_rate->integer);
+}
+
+/**
+ * @return True if the cache header is current for the given sound file, at the current rate
+ * and resampling quality, and describes a cache of `len` bytes.
+ */
+static bool S_SampleCacheValid(const s_sample_cache_t *header, const char *path, const int64_t len) {
+
+  return header->ident == S_SAMPLE_CACHE_IDENT &&
+         header->version == S_SAMPLE_CACHE_VERSION &&
+         !strncmp(header->path, path, sizeof(header->path)) &&
+         header->mod_time == Fs_LastModTime(path) &&
+         header->rate == s_rate->integer &&
+         header->quality == (int32_t) S_ResampleQuality() &&
+         (header->channels == 1 || header->channels == 2) &&
+         header->num_samples > 0 &&
+         len == (int64_t) (sizeof(*header) + header->num_samples * sizeof(int16_t));
+}
+
+/**
+ * @brief Uploads the given 16 bit samples to a new OpenAL buffer for the sample.
+ */
+static void S_BufferSample(s_sample_t *sample, const int32_t channels, const int16_t *samples, const size_t num_samples) {
+
+  sample->stereo = channels != 1;
+  sample->num_samples = num_samples;
+
+  assert(sample->num_samples);
+
+  alGenBuffers(1, &sample->buffer);
+
+  const ALenum format = channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+  const ALsizei size = (ALsizei) (num_samples * sizeof(int16_t));
+
+  alBufferData(sample->buffer, format, samples, size, s_rate->integer);
+
+  S_GetError(NULL);
+}
+
+/**
+ * @brief Attempts to load the resampled sound for the given file from the disk cache. The
+ * cache is only valid for the source file's modification time, and the current rate and
+ * resampling quality.
+ * @return True if the cached sound was loaded, false if it must be decoded and resampled.
+ */
+static bool S_LoadCachedSample(s_sample_t *sample, const char *path) {
+
+  if (!s_resample_cache->integer) {
+    return false;
+  }
+
+  char cache_path[MAX_OS_PATH];
+  S_SampleCachePath(path, cache_path, sizeof(cache_path));
+
+  if (!Fs_Exists(cache_path)) {
+    return false;
+  }
+
+  void *buf;
+  const int64_t len = Fs_Load(cache_path, &buf);
+
+  if (len < (int64_t) sizeof(s_sample_cache_t)) {
+    Fs_Free(buf);
+    return false;
+  }
+
+  const s_sample_cache_t *header = (s_sample_cache_t *) buf;
+
+  const bool valid = S_SampleCacheValid(header, path, len);
+
+  if (valid) {
+    S_BufferSample(sample, header->channels, (const int16_t *) (header + 1), header->num_samples);
+    Com_Debug(DEBUG_SOUND, "Loaded %s from %s\n", path, cache_path);
+  } else {
+    Com_Debug(DEBUG_SOUND, "Stale cache %s for %s\n", cache_path, path);
+  }
+
+  Fs_Free(buf);
+  return valid;
+}
+
+/**
+ * @brief Writes the resampled sound for the given file to the disk cache.
+ */
+static void S_WriteCachedSample(const char *path, const int32_t channels, const int16_t *samples, const size_t num_samples) {
+
+  char cache_path[MAX_OS_PATH];
+  S_SampleCachePath(path, cache_path, sizeof(cache_path));
+
+  file_t *file = Fs_OpenWrite(cache_path);
+  if (!file) {
+    Com_Warn("Failed to write %s\n", cache_path);
+    return;
+  }
+
+  s_sample_cache_t header = {
+    .ident = S_SAMPLE_CACHE_IDENT,
+    .version = S_SAMPLE_CACHE_VERSION,
+    .mod_time = Fs_LastModTime(path),
+    .rate = s_rate->integer,
+    .quality = (int32_t) S_ResampleQuality(),
+    .channels = channels,
+    .num_samples = (int32_t) num_samples
+  };
+
+  g_strlcpy(header.path, path, sizeof(header.path));
+
+  Fs_Write(file, &header, sizeof(header), 1);
+  Fs_Write(file, samples, sizeof(int16_t), num_samples);
+
+  Fs_Close(file);
+}
+
+/**
+ * @brief Fs_Enumerator for S_PruneSampleCache. Descends into directories, and deletes the
+ * cached sounds which could not be loaded: those of another rate or resampling quality,
+ * those whose source has changed or been removed, and those which are corrupt.
+ */
+static void S_PruneSampleCache_enumerate(const char *path, void *data) {
+  int32_t *count = data;
+
+  if (!g_str_has_suffix(path, ".pcm")) {
+    char pattern[MAX_OS_PATH];
+    g_snprintf(pattern, sizeof(pattern), "%s/*", path);
+
+    Fs_Enumerate(pattern, S_PruneSampleCache_enumerate, data);
+    return;
+  }
+
+  file_t *file = Fs_OpenRead(path);
+  if (!file) {
+    return;
+  }
+
+  s_sample_cache_t header;
+  const bool read = Fs_Read(file, &header, sizeof(header), 1) == 1;
+  const int64_t len = Fs_FileLength(file);
+
+  Fs_Close(file);
+
+  if (read) {
+    header.path[sizeof(header.path) - 1] = '\0';
+
+    char cache_path[MAX_OS_PATH];
+    S_SampleCachePath(header.path, cache_path, sizeof(cache_path));
+
+    if (!g_strcmp0(path, cache_path) && Fs_Exists(header.path) && S_SampleCacheValid(&header, header.path, len)) {
+      return;
+    }
+  }
+
+  Fs_Delete(path);
+
+  if (!Fs_Exists(path)) {
+    Com_Debug(DEBUG_SOUND, "Pruned %s\n", path);
+    (*count)++;
+  }
+}
+
+/**
+ * @brief Deletes the stale sounds from the disk cache, which would otherwise accumulate
+ * with every change of rate, and every sound removed from the game.
+ */
+void S_PruneSampleCache(void) {
+
+  if (!s_resample_cache->integer) {
+    return;
+  }
+
+  int32_t count = 0;
+  Fs_Enumerate("cache/*", S_PruneSampleCache_enumerate, &count);
+
+  if (count) {
+    Com_Debug(DEBUG_SOUND, "Pruned %d cached sounds\n", count);
   }
 }
 
 /**
  * @brief Attempts to load a sample's audio data from the given file path into an OpenAL buffer.
+ * Sounds which must be resampled are cached on disk, so that subsequent loads skip both the
+ * decoding and the resampling.
  */
 static int32_t S_LoadSampleBuffer_(s_sample_t *sample, char *path) {
 
+  if (!Fs_Exists(path)) {
+    return sample->buffer;
+  }
+
+  if (S_LoadCachedSample(sample, path)) {
+    return sample->buffer;
+  }
+
   void *buf;
   const int64_t len = Fs_Load(path, &buf);
 
@@ -99,28 +451,22 @@ static int32_t S_LoadSampleBuffer_(s_sample_t *sample, char *path) {
 
       sf_count_t count = sf_readf_float(snd, s_context.raw_sample_buffer, info.frames) * info.channels;
 
-      S_ConvertSamples(s_context.raw_sample_buffer, count, &s_context.converted_sample_buffer, &s_context.converted_sample_buffer_size);
-
-      const int16_t *buffer = s_context.converted_sample_buffer;
+      const float *samples = s_context.raw_sample_buffer;
 
-      if (info.samplerate != s_rate->integer) {
-        count = S_Resample(info.channels, info.samplerate, s_rate->integer, count, buffer, &s_context.resample_buffer, &s_context.resample_buffer_size);
-        buffer = s_context.resample_buffer;
+      // resample in floating point, so that the result is only quantized once
+      const bool resample = info.samplerate != s_rate->integer;
+      if (resample) {
+        count = S_Resample(info.channels, info.samplerate, s_rate->integer, S_ResampleQuality(), count, samples, &s_context.resample_buffer, &s_context.resample_buffer_size);
+        samples = s_context.resample_buffer;
       }
 
-      sample->stereo = info.channels != 1;
-      sample->num_samples = count;
+      S_ConvertSamples(samples, count, &s_context.converted_sample_buffer, &s_context.converted_sample_buffer_size);
 
-      assert(sample->num_samples);
+      S_BufferSample(sample, info.channels, s_context.converted_sample_buffer, count);
 
-      alGenBuffers(1, &sample->buffer);
-
-      const ALenum format = info.channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
-      const ALsizei size = (ALsizei) count * sizeof(int16_t);
-
-      alBufferData(sample->buffer, format, buffer, size, s_rate->integer);
-
-      S_GetError(NULL);
+      if (resample && s_resample_cache->integer) {
+        S_WriteCachedSample(path, info.channels, s_context.converted_sample_buffer, count);
+      }
     } else {
       Com_Warn("%s: %s\n", path, sf_strerror(snd));
     }
@@ -25,6 +25,8 @@ s_sample_t *S_LoadSample(const char *name);
 s_sample_t *S_LoadClientModelSample(const char *model, const char *name);
 
 #if defined(__S_LOCAL_H__)
-size_t S_Resample(const int32_t channels, const int32_t source_rate, const int32_t dest_rate, const size_t num_frames, const int16_t *in_frames, int16_t **out_frames, size_t *out_size);
+size_t S_Resample(const int32_t channels, const int32_t source_rate, const int32_t dest_rate, const s_resample_t quality,
+                  const size_t num_samples, const float *in_samples, float **out_samples, size_t *out_size);
 void S_ConvertSamples(const float *input_samples, const sf_count_t num_samples, int16_t **out_samples, size_t *out_size);
+void S_PruneSampleCache(void);
 #endif /* __S_LOCAL_H__ */
@@ -104,6 +104,27 @@ typedef struct {
   bool stereo;
 } s_sample_t;
 
+/**
+ * @brief Resampling quality levels, used when a sound's rate differs from `s_rate`.
+ */
+typedef enum {
+  /**
+   * @brief Nearest-neighbor: fastest, with pronounced aliasing.
+   */
+  S_RESAMPLE_NEAREST,
+
+  /**
+   * @brief Linear interpolation between adjacent frames. Requires no history, and so is
+   * suitable for audio that is resampled in independent chunks, such as streamed music.
+   */
+  S_RESAMPLE_LINEAR,
+
+  /**
+   * @brief Polyphase windowed-sinc filtering, band-limited to the lower of the two rates.
+   */
+  S_RESAMPLE_SINC,
+} s_resample_t;
+
 #define S_PLAY_AMBIENT      0x1 // this is an ambient sound and may be culled by the user
 #define S_PLAY_LOOP         0x2 // loop the sound continuously
 #define S_PLAY_FRAME        0x4 // cull the sound if it is not added at each frame
@@ -173,6 +194,50 @@ typedef struct s_play_sample_s {
   PlaySampleThink Think;
 } s_play_sample_t;
 
+/**
+ * @brief The source parameters most recently submitted to OpenAL for a channel.
+ */
+typedef struct {
+
+  /**
+   * @brief The source position.
+   */
+  vec3_t origin;
+
+  /**
+   * @brief The source velocity, for Doppler.
+   */
+  vec3_t velocity;
+
+  /**
+   * @brief The source gain, including volume.
+   */
+  float gain;
+
+  /**
+   * @brief The source pitch.
+   */
+  float pitch;
+
+  /**
+   * @brief The direct lowpass filter gains.
+   */
+  float lowpass_gain, lowpass_gainhf;
+
+  /**
+   * @brief The auxiliary effect slot the source sends to.
+   */
+  ALuint send;
+} s_channel_state_t;
+
+#define S_CHANNEL_ORIGIN    0x1
+#define S_CHANNEL_VELOCITY  0x2
+#define S_CHANNEL_GAIN      0x4
+#define S_CHANNEL_PITCH     0x8
+#define S_CHANNEL_FILTER    0x10
+#define S_CHANNEL_SEND      0x20
+#define S_CHANNEL_ALL       0x3f
+
 /**
  * @brief Samples are collected into channels that are spatialized and played back.
  */
@@ -217,6 +282,23 @@ typedef struct {
    * @brief Underwater mix fraction, smoothly interpolated [0, 1].
    */
   float underwater;
+
+  /**
+   * @brief The parameters most recently submitted to the source, so that only changes
+   * are submitted each frame.
+   */
+  s_channel_state_t state;
+
+  /**
+   * @brief The `S_CHANNEL_*` parameters to submit regardless of `state`, e.g. because the
+   * source was just reassigned.
+   */
+  uint32_t dirty;
+
+  /**
+   * @brief The ticks at which the source should next be polled for completion.
+   */
+  uint32_t poll_ticks;
 } s_channel_t;
 
 #define MAX_CHANNELS 128
@@ -252,6 +334,27 @@ typedef struct {
   bool eof;
 } s_music_t;
 
+/**
+ * @brief The polyphase windowed-sinc filter for the most recently used pair of rates.
+ */
+typedef struct {
+
+  /**
+   * @brief The source and destination rates of this filter.
+   */
+  int32_t source_rate, dest_rate;
+
+  /**
+   * @brief The number of weights per phase.
+   */
+  int32_t taps;
+
+  /**
+   * @brief The weights, `taps` for each of `S_SINC_PHASES` phases.
+   */
+  float *weights;
+} s_sinc_t;
+
 /**
  * @brief Filters and effects used by the sound system if `s_effects` is enabled & supported.
  */
@@ -331,7 +434,13 @@ typedef struct {
   /**
    * @brief Scratch buffer for resampled audio data.
    */
-  int16_t *resample_buffer;
+  float *resample_buffer;
+
+  /**
+   * @brief The sinc filter for `S_RESAMPLE_SINC`. Samples are loaded on the main thread,
+   * and streamed music resamples linearly, so a single filter suffices.
+   */
+  s_sinc_t sinc;
 
   /**
    * @brief The mixed channels.
@@ -343,6 +452,11 @@ typedef struct {
    */
   int32_t num_active_channels;
 
+  /**
+   * @brief The number of OpenAL calls made by the most recent mix.
+   */
+  int32_t num_al_calls;
+
   /**
    * @brief The OpenAL sound sources.
    */
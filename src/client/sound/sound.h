@@ -39,6 +39,8 @@ extern cvar_t *s_effects;
 extern cvar_t *s_effects_volume;
 extern cvar_t *s_hrtf;
 extern cvar_t *s_rate;
+extern cvar_t *s_resample;
+extern cvar_t *s_resample_cache;
 extern cvar_t *s_volume;
 
 #endif /* __SOUND_H__ */
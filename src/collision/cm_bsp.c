@@ -521,15 +521,18 @@ void Bsp_UnloadLump(bsp_file_t *bsp, const bsp_lump_id_t lump_id) {
     return;
   }
 
-  // free memory
+  // free memory, unless it belongs to the file
   if (*lump_data) {
-    Mem_Free(*lump_data);
+    if (!(bsp->aliased_lumps & (bsp_lump_id_t) (1 << lump_id))) {
+      Mem_Free(*lump_data);
+    }
     *lump_data = NULL;
   }
 
   *lump_count = 0;
 
   bsp->loaded_lumps &= ~((bsp_lump_id_t) (1 << lump_id));
+  bsp->aliased_lumps &= ~((bsp_lump_id_t) (1 << lump_id));
 }
 
 /**
@@ -545,10 +548,11 @@ void Bsp_UnloadLumps(bsp_file_t *bsp, const bsp_lump_id_t lump_bits) {
 }
 
 /**
- * @brief Load a lump into memory from the specified BSP file. Returns false
- * if an error occured during the load that is recoverable.
+ * @brief Load a lump into memory from the specified BSP file, optionally aliasing the
+ * file's data rather than copying it. Returns false if an error occured during the load
+ * that is recoverable.
  */
-bool Bsp_LoadLump(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t lump_id) {
+static bool Bsp_LoadLump_(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t lump_id, bool alias) {
 
   int32_t *lump_count;
   void **lump_data;
@@ -588,16 +592,30 @@ bool Bsp_LoadLump(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t
               bsp_lump_meta[lump_id].max_count);
   }
 
+#if SDL_BYTEORDER != SDL_LIL_ENDIAN
+  alias = false;
+#endif
+
+  // the entity string is parsed and edited in place, so it is always copied
+  if (lump_id == BSP_LUMP_ENTITIES) {
+    alias = false;
+  }
+
   if (*lump_count) {
-    *lump_data = Mem_TagMalloc(lump.file_len, MEM_TAG_BSP | (lump_id << 16));
+    const byte *src = ((const byte *) file) + lump.file_ofs;
 
-    // blit the data into memory
-    if (lump.file_ofs && lump.file_len) {
-      const byte *src = ((const byte *) file) + lump.file_ofs;
+    if (alias && lump.file_ofs && ((uintptr_t) src & 3) == 0) {
+      *lump_data = (void *) src;
+      bsp->aliased_lumps |= (bsp_lump_id_t) (1 << lump_id);
+    } else {
+      *lump_data = Mem_TagMalloc(lump.file_len, MEM_TAG_BSP | (lump_id << 16));
 
-      memcpy(*lump_data, src, lump.file_len);
+      // blit the data into memory
+      if (lump.file_ofs && lump.file_len) {
+        memcpy(*lump_data, src, lump.file_len);
 
-      Bsp_SwapLump(lump_id, *lump_data, *lump_count);
+        Bsp_SwapLump(lump_id, *lump_data, *lump_count);
+      }
     }
   }
 
@@ -606,6 +624,14 @@ bool Bsp_LoadLump(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t
   return true;
 }
 
+/**
+ * @brief Load a lump into memory from the specified BSP file. Returns false
+ * if an error occured during the load that is recoverable.
+ */
+bool Bsp_LoadLump(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t lump_id) {
+  return Bsp_LoadLump_(file, bsp, lump_id, false);
+}
+
 /**
  * @brief Loads the specified lumps into memory. If a failure occurs at any point during
  * loading, it will stop trying to load more and return false.
@@ -623,6 +649,24 @@ bool Bsp_LoadLumps(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_
   return true;
 }
 
+/**
+ * @brief Loads the specified lumps, aliasing the file's data wherever possible. If a
+ * failure occurs at any point during loading, it will stop trying to load more and
+ * return false.
+ */
+bool Bsp_AliasLumps(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t lump_bits) {
+
+  for (bsp_lump_id_t lump = BSP_LUMP_FIRST; lump < BSP_LUMP_LAST; lump++) {
+    if (lump_bits & (bsp_lump_id_t) (1 << lump)) {
+      if (!Bsp_LoadLump_(file, bsp, lump, true)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
 /**
  * @brief Allocates data for the specified lump in the BSP. If the lump is already loaded,
  * the data will either be expanded or truncated to the specified count. Note that `count`
@@ -654,6 +698,16 @@ void Bsp_AllocLump(bsp_file_t *bsp, const bsp_lump_id_t lump_id, const size_t co
   // calculate size
   const size_t lump_type_size = bsp_lump_meta[lump_id].type_size;
 
+  // aliased lumps can not be reallocated, so copy them first
+  if (bsp->aliased_lumps & (bsp_lump_id_t) (1 << lump_id)) {
+    void *data = Mem_TagMalloc(lump_type_size * count, MEM_TAG_BSP | (lump_id << 16));
+    memcpy(data, *lump_data, lump_type_size * Mini(*lump_count, (int32_t) count));
+
+    *lump_data = data;
+    bsp->aliased_lumps &= ~((bsp_lump_id_t) (1 << lump_id));
+    return;
+  }
+
   *lump_data = Mem_Realloc(*lump_data, lump_type_size * count);
 }
 
@@ -714,6 +768,15 @@ void Bsp_Write(file_t *file, const bsp_file_t *bsp) {
 #endif
 
     current_position += lump_size;
+
+    // pad each lump to a 4 byte boundary, so that it may be aliased when mapped
+    const int32_t pad = (int32_t) (-current_position & 3);
+    if (pad) {
+      const byte zero[4] = { 0 };
+      Fs_Write(file, zero, 1, pad);
+
+      current_position += pad;
+    }
   }
 
   // go back and write the finished header
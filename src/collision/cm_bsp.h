@@ -857,6 +857,12 @@ typedef struct bsp_file_s {
    * @brief Bitmask of loaded lump identifiers.
    */
   bsp_lump_id_t loaded_lumps;
+
+  /**
+   * @brief Bitmask of loaded lump identifiers whose data aliases the BSP file itself,
+   * rather than a private copy. Such lumps are valid only as long as the file is.
+   */
+  bsp_lump_id_t aliased_lumps;
 } bsp_file_t;
 
 /**
@@ -896,6 +902,14 @@ bool Bsp_LoadLump(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t
  */
 bool Bsp_LoadLumps(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t lump_bits);
 
+/**
+ * @brief Loads all lumps matching the given bitmask from the BSP file, aliasing the file's
+ * data in place wherever its byte order and alignment allow, and copying it otherwise. The
+ * file must outlive the aliased lumps, and so is typically memory mapped (`Fs_Map`).
+ * @return true on success, false on failure.
+ */
+bool Bsp_AliasLumps(const bsp_header_t *file, bsp_file_t *bsp, const bsp_lump_id_t lump_bits);
+
 /**
  * @brief Allocates memory for the specified lump in the BSP with the given element count.
  */
@@ -49,7 +49,7 @@ static void Cm_LoadBspPlanes(cm_bsp_t *bsp) {
   bsp->num_planes = bsp->file->num_planes;
   const bsp_plane_t *in = bsp->file->planes;
 
-  cm_bsp_plane_t *out = bsp->planes = Mem_TagMalloc(sizeof(cm_bsp_plane_t) * (bsp->num_planes + 12), MEM_TAG_COLLISION); // extra for box hull
+  cm_bsp_plane_t *out = bsp->planes = Mem_TagMalloc(sizeof(cm_bsp_plane_t) * (bsp->num_planes + 12 * CM_BOX_HULLS), MEM_TAG_COLLISION); // extra for box hulls
 
   for (int32_t i = 0; i < bsp->num_planes; i++, in++, out++) {
     *out = Cm_Plane(in->normal, in->dist);
@@ -64,7 +64,7 @@ static void Cm_LoadBspNodes(cm_bsp_t *bsp) {
   bsp->num_nodes = bsp->file->num_nodes;
   const bsp_node_t *in = bsp->file->nodes;
 
-  cm_bsp_node_t *out = bsp->nodes = Mem_TagMalloc(sizeof(cm_bsp_node_t) * (bsp->num_nodes + 6), MEM_TAG_COLLISION); // extra for box hull
+  cm_bsp_node_t *out = bsp->nodes = Mem_TagMalloc(sizeof(cm_bsp_node_t) * (bsp->num_nodes + 6 * CM_BOX_HULLS), MEM_TAG_COLLISION); // extra for box hulls
 
   for (int32_t i = 0; i < bsp->num_nodes; i++, in++, out++) {
 
@@ -85,7 +85,7 @@ static void Cm_LoadBspLeafs(cm_bsp_t *bsp) {
   bsp->num_leafs = bsp->file->num_leafs;
   const bsp_leaf_t *in = bsp->file->leafs;
 
-  cm_bsp_leaf_t *out = bsp->leafs = Mem_TagMalloc(sizeof(cm_bsp_leaf_t) * (bsp->num_leafs + 1), MEM_TAG_COLLISION); // extra for box hull
+  cm_bsp_leaf_t *out = bsp->leafs = Mem_TagMalloc(sizeof(cm_bsp_leaf_t) * (bsp->num_leafs + CM_BOX_HULLS), MEM_TAG_COLLISION); // extra for box hulls
 
   for (int32_t i = 0; i < bsp->num_leafs; i++, in++, out++) {
     out->contents = in->contents;
@@ -102,7 +102,7 @@ static void Cm_LoadBspLeafBrushes(cm_bsp_t *bsp) {
   bsp->num_leaf_brushes = bsp->file->num_leaf_brushes;
   const int32_t *in = bsp->file->leaf_brushes;
 
-  int32_t *out = bsp->leaf_brushes = Mem_TagMalloc(sizeof(int32_t) * (bsp->num_leaf_brushes + 1), MEM_TAG_COLLISION); // extra for box hull
+  int32_t *out = bsp->leaf_brushes = Mem_TagMalloc(sizeof(int32_t) * (bsp->num_leaf_brushes + CM_BOX_HULLS), MEM_TAG_COLLISION); // extra for box hulls
 
   for (int32_t i = 0; i < bsp->num_leaf_brushes; i++, in++, out++) {
     *out = *in;
@@ -118,7 +118,7 @@ static void Cm_LoadBspBrushSides(cm_bsp_t *bsp) {
   const bsp_brush_side_t *in = bsp->file->brush_sides;
 
   cm_bsp_brush_side_t *out = bsp->brush_sides = Mem_TagMalloc(sizeof(cm_bsp_brush_side_t) *
-        (bsp->num_brush_sides + 6), MEM_TAG_COLLISION); // extra for box hull
+        (bsp->num_brush_sides + 6 * CM_BOX_HULLS), MEM_TAG_COLLISION); // extra for box hulls
 
   for (int32_t i = 0; i < bsp->num_brush_sides; i++, in++, out++) {
 
@@ -152,7 +152,7 @@ static void Cm_LoadBspBrushes(cm_bsp_t *bsp) {
   bsp->num_brushes = bsp->file->num_brushes;
   const bsp_brush_t *in = bsp->file->brushes;
 
-  cm_bsp_brush_t *out = bsp->brushes = Mem_TagMalloc(sizeof(cm_bsp_brush_t) * (bsp->num_brushes + 1), MEM_TAG_COLLISION); // extra for box hull
+  cm_bsp_brush_t *out = bsp->brushes = Mem_TagMalloc(sizeof(cm_bsp_brush_t) * (bsp->num_brushes + CM_BOX_HULLS), MEM_TAG_COLLISION); // extra for box hulls
 
   for (int32_t i = 0; i < bsp->num_brushes; i++, in++, out++) {
 
@@ -271,7 +271,11 @@ static void Cm_LoadBspVoxels(cm_bsp_t *bsp) {
 /**
  * @brief Loads in the BSP and all sub-models for collision detection. This
  * function can also be used to initialize or clean up the collision model by
- * invoking with `NULL`.
+ * invoking with `NULL`. Where possible, the BSP is memory mapped and its lumps
+ * alias the mapping while the collision structures are built from them. The
+ * mapping is released before returning, so that the file may then be rewritten
+ * or truncated (e.g. by quemap) without faulting; only the entity string, which
+ * is always copied, is retained.
  */
 cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
   static bsp_file_t file;
@@ -302,19 +306,42 @@ cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
   }
 
   // load the common BSP structure and the lumps we need
-  bsp_header_t *header;
+  bsp_header_t *header, *mapped = NULL;
 
-  if (Fs_Load(name, (void **) &header) == -1) {
-    Com_Error(ERROR_DROP, "Failed to load %s\n", name);
+  const int64_t len = Fs_Map(name, (void **) &header);
+  if (len == -1) {
+    if (Fs_Load(name, (void **) &header) == -1) {
+      Com_Error(ERROR_DROP, "Failed to load %s\n", name);
+    }
+  } else if (len < (int64_t) sizeof(bsp_header_t)) {
+    Fs_Unmap(header);
+    Com_Error(ERROR_DROP, "Failed to verify %s\n", name);
+  } else {
+    mapped = header;
   }
 
   if (Bsp_Verify(header) == -1) {
-    Fs_Free(header);
+    if (mapped) {
+      Fs_Unmap(mapped);
+      mapped = NULL;
+    } else {
+      Fs_Free(header);
+    }
     Com_Error(ERROR_DROP, "Failed to verify %s\n", name);
   }
 
-  if (!Bsp_LoadLumps(header, &file, CM_BSP_LUMPS)) {
-    Fs_Free(header);
+  const bool loaded = mapped ?
+    Bsp_AliasLumps(header, &file, CM_BSP_LUMPS) :
+    Bsp_LoadLumps(header, &file, CM_BSP_LUMPS);
+
+  if (!loaded) {
+    Bsp_UnloadLumps(&file, BSP_LUMPS_ALL);
+    if (mapped) {
+      Fs_Unmap(mapped);
+      mapped = NULL;
+    } else {
+      Fs_Free(header);
+    }
     Com_Error(ERROR_DROP, "Lump error loading %s\n", name);
   }
 
@@ -327,8 +354,6 @@ cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
 
   g_strlcpy(cm_bsp.name, name, sizeof(cm_bsp.name));
 
-  Fs_Free(header);
-
   Cm_LoadBspMaterials(&cm_bsp);
   Cm_LoadBspEntities(&cm_bsp);
   Cm_LoadBspPlanes(&cm_bsp);
@@ -342,6 +367,15 @@ cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
 
   Cm_InitBoxHull(&cm_bsp);
 
+  // the lumps have all been copied into the structures above, so release the file
+  Bsp_UnloadLumps(&file, BSP_LUMPS_ALL & ~(1 << BSP_LUMP_ENTITIES));
+
+  if (mapped) {
+    Fs_Unmap(mapped);
+  } else {
+    Fs_Free(header);
+  }
+
   return &cm_bsp.models[0];
 }
 
@@ -367,7 +401,7 @@ cm_bsp_model_t *Cm_Model(const char *name) {
  * @brief Returns the number of inline BSP models in the loaded BSP file.
  */
 int32_t Cm_NumModels(void) {
-  return cm_bsp.file->num_models;
+  return cm_bsp.num_models;
 }
 
 /**
@@ -209,118 +209,137 @@ typedef struct {
   cm_bsp_leaf_t *leaf;
 } cm_box_t;
 
-static cm_box_t cm_box;
+/**
+ * @brief The box hulls, indexed by `thread_index`: one for the main thread, and one for
+ * each thread in the pool.
+ */
+static cm_box_t cm_boxes[CM_BOX_HULLS];
 
 /**
- * @brief Appends a brush (6 nodes, 12 planes) opaquely to the primary BSP
- * structure to represent the bounding box used for `Cm_BoxLeafnums`. This brush
- * is never tested by the rest of the collision detection code, as it resides
+ * @brief Appends brushes (6 nodes, 12 planes each) opaquely to the primary BSP
+ * structure to represent the bounding boxes used for `Cm_BoxLeafnums`. These brushes
+ * are never tested by the rest of the collision detection code, as they reside
  * just beyond the parsed size of the map.
  */
 void Cm_InitBoxHull(cm_bsp_t *bsp) {
 
-  if (bsp->num_planes + 12 > MAX_BSP_PLANES) {
+  if (bsp->num_planes + 12 * CM_BOX_HULLS > MAX_BSP_PLANES) {
     Com_Error(ERROR_DROP, "MAX_BSP_PLANES\n");
   }
 
-  if (bsp->num_nodes + 6 > MAX_BSP_NODES) {
+  if (bsp->num_nodes + 6 * CM_BOX_HULLS > MAX_BSP_NODES) {
     Com_Error(ERROR_DROP, "MAX_BSP_NODES\n");
   }
 
-  if (bsp->num_leafs + 1 > MAX_BSP_LEAFS) {
+  if (bsp->num_leafs + CM_BOX_HULLS > MAX_BSP_LEAFS) {
     Com_Error(ERROR_DROP, "MAX_BSP_LEAFS\n");
   }
 
-  if (bsp->num_leaf_brushes + 1 > MAX_BSP_LEAF_BRUSHES) {
+  if (bsp->num_leaf_brushes + CM_BOX_HULLS > MAX_BSP_LEAF_BRUSHES) {
     Com_Error(ERROR_DROP, "MAX_BSP_LEAF_BRUSHES\n");
   }
 
-  if (bsp->num_brushes + 1 > MAX_BSP_BRUSHES) {
+  if (bsp->num_brushes + CM_BOX_HULLS > MAX_BSP_BRUSHES) {
     Com_Error(ERROR_DROP, "MAX_BSP_BRUSHES\n");
   }
 
-  if (bsp->num_brush_sides + 6 > MAX_BSP_BRUSH_SIDES) {
+  if (bsp->num_brush_sides + 6 * CM_BOX_HULLS > MAX_BSP_BRUSH_SIDES) {
     Com_Error(ERROR_DROP, "MAX_BSP_BRUSH_SIDES\n");
   }
 
-  // head node
-  cm_box.head_node = bsp->num_nodes;
-
-  // planes
-  cm_box.planes = &bsp->planes[bsp->num_planes];
-
-  // leaf
-  cm_box.leaf = &bsp->leafs[bsp->num_leafs];
-  cm_box.leaf->contents = CONTENTS_MONSTER;
-  cm_box.leaf->first_leaf_brush = bsp->num_leaf_brushes;
-  cm_box.leaf->num_leaf_brushes = 1;
-
-  // leaf brush
-  bsp->leaf_brushes[bsp->num_leaf_brushes] = bsp->num_brushes;
-
-  // brush
-  cm_box.brush = &bsp->brushes[bsp->num_brushes];
-  cm_box.brush->num_brush_sides = 6;
-  cm_box.brush->brush_sides = bsp->brush_sides + bsp->num_brush_sides;
-  cm_box.brush->contents = CONTENTS_MONSTER;
-
-  for (int32_t i = 0; i < 6; i++) {
-
-    // fill in planes, two per side
-    cm_bsp_plane_t *plane = &cm_box.planes[i * 2];
-    plane->normal = Vec3_Zero();
-    plane->normal.xyz[i >> 1] = 1.f;
-    plane->sign_bits = Cm_SignBitsForNormal(plane->normal);
-    plane->type = Cm_PlaneTypeForNormal(plane->normal);
-
-    plane = &cm_box.planes[i * 2 + 1];
-    plane->normal = Vec3_Zero();
-    plane->normal.xyz[i >> 1] = -1.f;
-    plane->sign_bits = Cm_SignBitsForNormal(plane->normal);
-    plane->type = Cm_PlaneTypeForNormal(plane->normal);
-
-    const int32_t s = i & 1;
-
-    // fill in nodes, one per side
-    cm_bsp_node_t *node = &bsp->nodes[cm_box.head_node + i];
-    node->plane = bsp->planes + (bsp->num_planes + i * 2);
-    node->children[s] = -1 - bsp->num_leafs;
-    if (i != 5) {
-      node->children[s ^ 1] = cm_box.head_node + i + 1;
-    } else {
-      node->children[s ^ 1] = -1 - bsp->num_leafs;
-    }
+  for (int32_t b = 0; b < CM_BOX_HULLS; b++) {
+
+    cm_box_t *box = &cm_boxes[b];
+
+    const int32_t first_plane = bsp->num_planes + b * 12;
+    const int32_t first_brush_side = bsp->num_brush_sides + b * 6;
+    const int32_t leaf_num = bsp->num_leafs + b;
+
+    // head node
+    box->head_node = bsp->num_nodes + b * 6;
+
+    // planes
+    box->planes = &bsp->planes[first_plane];
+
+    // leaf
+    box->leaf = &bsp->leafs[leaf_num];
+    box->leaf->contents = CONTENTS_MONSTER;
+    box->leaf->first_leaf_brush = bsp->num_leaf_brushes + b;
+    box->leaf->num_leaf_brushes = 1;
+
+    // leaf brush
+    bsp->leaf_brushes[bsp->num_leaf_brushes + b] = bsp->num_brushes + b;
 
-    // fill in brush sides, one per side
-    cm_bsp_brush_side_t *side = &bsp->brush_sides[bsp->num_brush_sides + i];
-    side->plane = bsp->planes + (bsp->num_planes + i * 2 + s);
+    // brush
+    box->brush = &bsp->brushes[bsp->num_brushes + b];
+    box->brush->num_brush_sides = 6;
+    box->brush->brush_sides = bsp->brush_sides + first_brush_side;
+    box->brush->contents = CONTENTS_MONSTER;
+
+    for (int32_t i = 0; i < 6; i++) {
+
+      // fill in planes, two per side
+      cm_bsp_plane_t *plane = &box->planes[i * 2];
+      plane->normal = Vec3_Zero();
+      plane->normal.xyz[i >> 1] = 1.f;
+      plane->sign_bits = Cm_SignBitsForNormal(plane->normal);
+      plane->type = Cm_PlaneTypeForNormal(plane->normal);
+
+      plane = &box->planes[i * 2 + 1];
+      plane->normal = Vec3_Zero();
+      plane->normal.xyz[i >> 1] = -1.f;
+      plane->sign_bits = Cm_SignBitsForNormal(plane->normal);
+      plane->type = Cm_PlaneTypeForNormal(plane->normal);
+
+      const int32_t s = i & 1;
+
+      // fill in nodes, one per side
+      cm_bsp_node_t *node = &bsp->nodes[box->head_node + i];
+      node->plane = bsp->planes + (first_plane + i * 2);
+      node->children[s] = -1 - leaf_num;
+      if (i != 5) {
+        node->children[s ^ 1] = box->head_node + i + 1;
+      } else {
+        node->children[s ^ 1] = -1 - leaf_num;
+      }
+
+      // fill in brush sides, one per side
+      cm_bsp_brush_side_t *side = &bsp->brush_sides[first_brush_side + i];
+      side->plane = bsp->planes + (first_plane + i * 2 + s);
+    }
   }
 }
 
 /**
- * @brief Initializes the box hull for the specified bounds, returning the
- * head node for the resulting box hull tree.
+ * @brief Initializes the calling thread's box hull for the specified bounds, returning
+ * the head node for the resulting box hull tree.
  */
 int32_t Cm_SetBoxHull(const box3_t bounds, const int32_t contents) {
 
-  cm_box.brush->bounds = bounds;
+  // threads outside of the pool would share the main thread's box hull
+  assert(thread_index > 0 || thread_main == 0 || SDL_GetCurrentThreadID() == thread_main);
+  assert(thread_index < CM_BOX_HULLS);
+
+  cm_box_t *box = &cm_boxes[thread_index];
+
+  box->brush->bounds = bounds;
 
-  cm_box.planes[0].dist = bounds.maxs.x;
-  cm_box.planes[1].dist = -bounds.maxs.x;
-  cm_box.planes[2].dist = bounds.mins.x;
-  cm_box.planes[3].dist = -bounds.mins.x;
-  cm_box.planes[4].dist = bounds.maxs.y;
-  cm_box.planes[5].dist = -bounds.maxs.y;
-  cm_box.planes[6].dist = bounds.mins.y;
-  cm_box.planes[7].dist = -bounds.mins.y;
-  cm_box.planes[8].dist = bounds.maxs.z;
-  cm_box.planes[9].dist = -bounds.maxs.z;
-  cm_box.planes[10].dist = bounds.mins.z;
-  cm_box.planes[11].dist = -bounds.mins.z;
+  box->planes[0].dist = bounds.maxs.x;
+  box->planes[1].dist = -bounds.maxs.x;
+  box->planes[2].dist = bounds.mins.x;
+  box->planes[3].dist = -bounds.mins.x;
+  box->planes[4].dist = bounds.maxs.y;
+  box->planes[5].dist = -bounds.maxs.y;
+  box->planes[6].dist = bounds.mins.y;
+  box->planes[7].dist = -bounds.mins.y;
+  box->planes[8].dist = bounds.maxs.z;
+  box->planes[9].dist = -bounds.maxs.z;
+  box->planes[10].dist = bounds.mins.z;
+  box->planes[11].dist = -bounds.mins.z;
 
-  cm_box.leaf->contents = cm_box.brush->contents = contents;
+  box->leaf->contents = box->brush->contents = contents;
 
-  return cm_box.head_node;
+  return box->head_node;
 }
 
 /**
@@ -67,7 +67,14 @@ int32_t Cm_BoxOnPlaneSide(const box3_t bounds, const cm_bsp_plane_t *plane);
 bool Cm_PointInsideBrush(const vec3_t point, const cm_bsp_brush_t *brush);
 
 /**
- * @brief Allocates a temporary hull for the given axis-aligned bounding box.
+ * @brief The count of box hulls appended to the BSP: one for the main thread, and one for
+ * each thread in the pool, so that traces may run concurrently from the thread pool.
+ */
+#define CM_BOX_HULLS (MAX_THREADS + 1)
+
+/**
+ * @brief Allocates a temporary hull for the given axis-aligned bounding box. The hull
+ * is private to the calling thread, and is valid until that thread sets another.
  * @return The head node number for the box hull.
  */
 int32_t Cm_SetBoxHull(const box3_t bounds, const int32_t contents);
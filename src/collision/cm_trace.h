@@ -35,6 +35,25 @@ __attribute__ ((warn_unused_result))
 cm_trace_t Cm_BoxTrace(const vec3_t start, const vec3_t end, const box3_t bounds, int32_t head_node,
              int32_t contents);
 
+/**
+ * @brief The number of traces `Cm_BoxTraceBatch` sends down the tree together.
+ */
+#define CM_TRACE_BATCH_SIZE 16
+
+/** @brief Performs many box sweep traces of the same bounds, visiting each BSP node once
+ * per batch rather than once per trace. Each trace is split at every node exactly as
+ * `Cm_BoxTrace` splits it, so the results are identical.
+ * @param starts The trace start points.
+ * @param ends The trace end points.
+ * @param count The number of traces.
+ * @param bounds The AABB shared by all traces.
+ * @param head_node The BSP head node to trace against.
+ * @param contents The contents mask; only brush sides with matching contents are tested.
+ * @param traces The results, one per start and end point.
+ */
+void Cm_BoxTraceBatch(const vec3_t *starts, const vec3_t *ends, size_t count, const box3_t bounds,
+                      int32_t head_node, int32_t contents, cm_trace_t *traces);
+
 /** @brief Traces a point ray from `start` to `end` against a single brush.
  * @param start The trace start point.
  * @param end The trace end point.
@@ -53,6 +72,63 @@ __attribute__ ((warn_unused_result))
 cm_trace_t Cm_TransformedBoxTrace(const vec3_t start, const vec3_t end, const box3_t bounds, int32_t head_node,
                         int32_t contents, const mat4_t matrix, const mat4_t inverse_matrix);
 
+/**
+ * @brief World-space planes of a transformed inline model. Tracing against the cache
+ * avoids transforming every brush side on every trace.
+ */
+typedef struct {
+
+  /**
+   * @brief The head node of the inline model.
+   */
+  int32_t head_node;
+
+  /**
+   * @brief The transform the planes were built with.
+   */
+  mat4_t matrix;
+
+  /**
+   * @brief The inverse transform, used to bring traces into model space for node tests.
+   */
+  mat4_t inverse_matrix;
+
+  /**
+   * @brief The range of brush numbers covered by the cache.
+   */
+  int32_t first_brush, num_brushes;
+
+  /**
+   * @brief The index of each brush's first plane.
+   */
+  int32_t *first_plane;
+
+  /**
+   * @brief The world-space planes, one per brush side.
+   */
+  cm_bsp_plane_t *planes;
+  int32_t num_planes;
+} cm_plane_cache_t;
+
+/** @brief Rebuilds the plane cache if the head node or transform has changed.
+ * @param head_node The head node of the inline model.
+ * @param matrix The forward transform of the entity.
+ * @param inverse_matrix The inverse transform of the entity.
+ * @return True if the cache was rebuilt, false if it was already current.
+ */
+bool Cm_UpdatePlaneCache(cm_plane_cache_t *cache, int32_t head_node, const mat4_t matrix, const mat4_t inverse_matrix);
+
+/** @brief Frees the plane cache, leaving it empty.
+ */
+void Cm_FreePlaneCache(cm_plane_cache_t *cache);
+
+/** @brief Like Cm_TransformedBoxTrace, but tests the cache's world-space planes.
+ * @param cache A plane cache, updated for the entity's current transform.
+ */
+__attribute__ ((warn_unused_result))
+cm_trace_t Cm_CachedBoxTrace(const vec3_t start, const vec3_t end, const box3_t bounds, int32_t contents,
+                             const cm_plane_cache_t *cache);
+
 /** @brief Returns the world-space AABB for the given solid type and model transform.
  * @param solid The solid type constant.
  * @param matrix The entity's current world transform.
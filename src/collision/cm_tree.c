@@ -0,0 +1,407 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "cm_local.h"
+
+/**
+ * @brief The maximum traversal stack depth for queries. Balanced trees of several
+ * thousand leafs are well under 32 nodes tall.
+ */
+#define CM_TREE_STACK 256
+
+/**
+ * @return The surface area heuristic cost of the given bounds.
+ */
+static float Cm_TreeCost(const box3_t bounds) {
+
+  const vec3_t size = Box3_Size(bounds);
+
+  return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+/**
+ * @return True if the specified node is a leaf.
+ */
+static inline bool Cm_TreeIsLeaf(const cm_tree_node_t *node) {
+  return node->children[0] == CM_TREE_NULL;
+}
+
+/**
+ * @brief Allocates a node from the free list, growing the node array as needed.
+ */
+static int32_t Cm_AllocTreeNode(cm_tree_t *tree) {
+
+  if (tree->free_node == CM_TREE_NULL) {
+
+    const int32_t max_nodes = tree->max_nodes ? tree->max_nodes * 2 : 64;
+    tree->nodes = Mem_Realloc(tree->nodes, max_nodes * sizeof(cm_tree_node_t));
+
+    for (int32_t i = tree->max_nodes; i < max_nodes; i++) {
+      tree->nodes[i].parent = i + 1 < max_nodes ? i + 1 : CM_TREE_NULL;
+      tree->nodes[i].height = -1;
+    }
+
+    tree->free_node = tree->max_nodes;
+    tree->max_nodes = max_nodes;
+  }
+
+  const int32_t index = tree->free_node;
+  cm_tree_node_t *node = &tree->nodes[index];
+
+  tree->free_node = node->parent;
+
+  node->parent = CM_TREE_NULL;
+  node->children[0] = node->children[1] = CM_TREE_NULL;
+  node->height = 0;
+  node->data = NULL;
+
+  tree->num_nodes++;
+  return index;
+}
+
+/**
+ * @brief Returns the specified node to the free list.
+ */
+static void Cm_FreeTreeNode(cm_tree_t *tree, int32_t index) {
+
+  cm_tree_node_t *node = &tree->nodes[index];
+
+  node->parent = tree->free_node;
+  node->height = -1;
+  node->data = NULL;
+
+  tree->free_node = index;
+  tree->num_nodes--;
+}
+
+/**
+ * @brief Replaces `child` with `replacement` in the children of `parent`, or as the root.
+ */
+static void Cm_ReplaceTreeChild(cm_tree_t *tree, int32_t parent, int32_t child, int32_t replacement) {
+
+  if (parent == CM_TREE_NULL) {
+    tree->root = replacement;
+  } else if (tree->nodes[parent].children[0] == child) {
+    tree->nodes[parent].children[0] = replacement;
+  } else {
+    tree->nodes[parent].children[1] = replacement;
+  }
+}
+
+/**
+ * @brief If the subtree rooted at `a` is imbalanced, rotates its taller child up.
+ * @return The root of the subtree after rotation.
+ */
+static int32_t Cm_BalanceTree(cm_tree_t *tree, int32_t a) {
+
+  cm_tree_node_t *nodes = tree->nodes;
+  cm_tree_node_t *A = &nodes[a];
+
+  if (Cm_TreeIsLeaf(A) || A->height < 2) {
+    return a;
+  }
+
+  const int32_t balance = nodes[A->children[1]].height - nodes[A->children[0]].height;
+  if (balance >= -1 && balance <= 1) {
+    return a;
+  }
+
+  // the taller child, `b`, is rotated up to replace `a`, which adopts one of its children
+  const int32_t side = balance > 1 ? 1 : 0;
+
+  const int32_t b = A->children[side];
+  const int32_t c = A->children[side ^ 1];
+
+  cm_tree_node_t *B = &nodes[b];
+  cm_tree_node_t *C = &nodes[c];
+
+  const int32_t d = B->children[0];
+  const int32_t e = B->children[1];
+
+  cm_tree_node_t *D = &nodes[d];
+  cm_tree_node_t *E = &nodes[e];
+
+  B->children[0] = a;
+  B->parent = A->parent;
+  A->parent = b;
+
+  Cm_ReplaceTreeChild(tree, B->parent, a, b);
+
+  // B keeps its taller child, and A adopts the shorter one
+  int32_t keep, give;
+  if (D->height > E->height) {
+    keep = d;
+    give = e;
+  } else {
+    keep = e;
+    give = d;
+  }
+
+  B->children[1] = keep;
+  A->children[side] = give;
+  nodes[give].parent = a;
+
+  A->bounds = Box3_Union(C->bounds, nodes[give].bounds);
+  A->height = 1 + Maxi(C->height, nodes[give].height);
+
+  B->bounds = Box3_Union(A->bounds, nodes[keep].bounds);
+  B->height = 1 + Maxi(A->height, nodes[keep].height);
+
+  return b;
+}
+
+/**
+ * @brief Walks up the tree from `index`, rebalancing and refitting each ancestor.
+ */
+static void Cm_RefitTree(cm_tree_t *tree, int32_t index) {
+
+  while (index != CM_TREE_NULL) {
+
+    index = Cm_BalanceTree(tree, index);
+
+    cm_tree_node_t *node = &tree->nodes[index];
+
+    const cm_tree_node_t *a = &tree->nodes[node->children[0]];
+    const cm_tree_node_t *b = &tree->nodes[node->children[1]];
+
+    node->bounds = Box3_Union(a->bounds, b->bounds);
+    node->height = 1 + Maxi(a->height, b->height);
+
+    index = node->parent;
+  }
+}
+
+/**
+ * @brief Inserts the specified leaf, pairing it with the sibling that minimizes the
+ * increase in surface area of the tree.
+ */
+static void Cm_InsertTreeLeaf(cm_tree_t *tree, int32_t leaf) {
+
+  if (tree->root == CM_TREE_NULL) {
+    tree->root = leaf;
+    tree->nodes[leaf].parent = CM_TREE_NULL;
+    return;
+  }
+
+  const box3_t bounds = tree->nodes[leaf].bounds;
+
+  int32_t index = tree->root;
+  while (!Cm_TreeIsLeaf(&tree->nodes[index])) {
+
+    const cm_tree_node_t *node = &tree->nodes[index];
+
+    const float area = Cm_TreeCost(node->bounds);
+    const float combined = Cm_TreeCost(Box3_Union(node->bounds, bounds));
+
+    // the cost of pairing the leaf with this node
+    const float cost = 2.f * combined;
+
+    // the minimum cost of pushing the leaf further down the tree
+    const float inheritance = 2.f * (combined - area);
+
+    float child_cost[2];
+    for (int32_t i = 0; i < 2; i++) {
+      const cm_tree_node_t *child = &tree->nodes[node->children[i]];
+
+      child_cost[i] = Cm_TreeCost(Box3_Union(child->bounds, bounds)) + inheritance;
+      if (!Cm_TreeIsLeaf(child)) {
+        child_cost[i] -= Cm_TreeCost(child->bounds);
+      }
+    }
+
+    if (cost < child_cost[0] && cost < child_cost[1]) {
+      break;
+    }
+
+    index = child_cost[0] < child_cost[1] ? node->children[0] : node->children[1];
+  }
+
+  const int32_t sibling = index;
+  const int32_t parent = Cm_AllocTreeNode(tree);
+
+  cm_tree_node_t *nodes = tree->nodes;
+
+  nodes[parent].parent = nodes[sibling].parent;
+  nodes[parent].bounds = Box3_Union(nodes[sibling].bounds, bounds);
+  nodes[parent].height = nodes[sibling].height + 1;
+  nodes[parent].children[0] = sibling;
+  nodes[parent].children[1] = leaf;
+
+  Cm_ReplaceTreeChild(tree, nodes[sibling].parent, sibling, parent);
+
+  nodes[sibling].parent = parent;
+  nodes[leaf].parent = parent;
+
+  Cm_RefitTree(tree, parent);
+}
+
+/**
+ * @brief Removes the specified leaf, collapsing its parent into its sibling.
+ */
+static void Cm_RemoveTreeLeaf(cm_tree_t *tree, int32_t leaf) {
+
+  if (leaf == tree->root) {
+    tree->root = CM_TREE_NULL;
+    return;
+  }
+
+  cm_tree_node_t *nodes = tree->nodes;
+
+  const int32_t parent = nodes[leaf].parent;
+  const int32_t grandparent = nodes[parent].parent;
+
+  const int32_t sibling = nodes[parent].children[0] == leaf ? nodes[parent].children[1] : nodes[parent].children[0];
+
+  Cm_ReplaceTreeChild(tree, grandparent, parent, sibling);
+  nodes[sibling].parent = grandparent;
+
+  Cm_FreeTreeNode(tree, parent);
+
+  Cm_RefitTree(tree, grandparent);
+}
+
+/**
+ * @brief Initializes the tree, with the given leaf margin.
+ */
+void Cm_InitTree(cm_tree_t *tree, float margin) {
+
+  memset(tree, 0, sizeof(*tree));
+
+  tree->root = CM_TREE_NULL;
+  tree->free_node = CM_TREE_NULL;
+  tree->margin = margin;
+}
+
+/**
+ * @brief Frees all nodes of the tree, leaving it empty.
+ */
+void Cm_FreeTree(cm_tree_t *tree) {
+
+  if (tree->nodes) {
+    Mem_Free(tree->nodes);
+  }
+
+  Cm_InitTree(tree, tree->margin);
+}
+
+/**
+ * @brief Inserts a leaf for the given bounds and data.
+ * @return The leaf index.
+ */
+int32_t Cm_TreeInsert(cm_tree_t *tree, const box3_t bounds, void *data) {
+
+  const int32_t leaf = Cm_AllocTreeNode(tree);
+
+  tree->nodes[leaf].bounds = Box3_Expand(bounds, tree->margin);
+  tree->nodes[leaf].data = data;
+
+  Cm_InsertTreeLeaf(tree, leaf);
+
+  return leaf;
+}
+
+/**
+ * @brief Removes the specified leaf, returning it to the free list.
+ */
+void Cm_TreeRemove(cm_tree_t *tree, int32_t leaf) {
+
+  assert(leaf >= 0 && leaf < tree->max_nodes);
+  assert(Cm_TreeIsLeaf(&tree->nodes[leaf]));
+
+  Cm_RemoveTreeLeaf(tree, leaf);
+  Cm_FreeTreeNode(tree, leaf);
+}
+
+/**
+ * @brief Reinserts the specified leaf if its bounds have escaped (or are much smaller
+ * than) its inflated bounds.
+ * @return True if the leaf was reinserted.
+ */
+bool Cm_TreeMove(cm_tree_t *tree, int32_t leaf, const box3_t bounds) {
+
+  assert(leaf >= 0 && leaf < tree->max_nodes);
+  assert(Cm_TreeIsLeaf(&tree->nodes[leaf]));
+
+  cm_tree_node_t *node = &tree->nodes[leaf];
+
+  if (Box3_Contains(node->bounds, bounds)) {
+
+    // shrinking entities, e.g. crouching players, should not keep excessive bounds
+    const box3_t large = Box3_Expand(bounds, 4.f * tree->margin);
+    if (Box3_Contains(large, node->bounds)) {
+      return false;
+    }
+  }
+
+  Cm_RemoveTreeLeaf(tree, leaf);
+
+  tree->nodes[leaf].bounds = Box3_Expand(bounds, tree->margin);
+
+  Cm_InsertTreeLeaf(tree, leaf);
+
+  return true;
+}
+
+/**
+ * @brief Traverses the tree with an explicit stack, so that concurrent queries share no state.
+ */
+void Cm_TreeQuery(const cm_tree_t *tree, const box3_t bounds, Cm_TreeQueryFunc func, void *context) {
+
+  if (tree->root == CM_TREE_NULL) {
+    return;
+  }
+
+  int32_t stack[CM_TREE_STACK];
+  int32_t depth = 0;
+
+  stack[depth++] = tree->root;
+
+  while (depth) {
+    const cm_tree_node_t *node = &tree->nodes[stack[--depth]];
+
+    if (!Box3_Intersects(node->bounds, bounds)) {
+      continue;
+    }
+
+    if (Cm_TreeIsLeaf(node)) {
+      if (!func(node->data, context)) {
+        return;
+      }
+    } else {
+      assert(depth + 2 <= CM_TREE_STACK);
+
+      stack[depth++] = node->children[1];
+      stack[depth++] = node->children[0];
+    }
+  }
+}
+
+/**
+ * @return The height of the tree, or -1 if it is empty.
+ */
+int32_t Cm_TreeHeight(const cm_tree_t *tree) {
+
+  if (tree->root == CM_TREE_NULL) {
+    return -1;
+  }
+
+  return tree->nodes[tree->root].height;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#pragma once
+
+#include "cm_types.h"
+
+/**
+ * @brief The null node index.
+ */
+#define CM_TREE_NULL -1
+
+/**
+ * @brief A node in a dynamic bounding volume tree. Leafs hold user data, and their
+ * bounds are inflated by the tree's margin, so that small movements do not require
+ * the tree to be updated.
+ */
+typedef struct {
+
+  /**
+   * @brief The bounds of this node, enclosing both children.
+   */
+  box3_t bounds;
+
+  /**
+   * @brief The parent node, or the next free node if this node is free.
+   */
+  int32_t parent;
+
+  /**
+   * @brief The child nodes, or `CM_TREE_NULL` for leafs.
+   */
+  int32_t children[2];
+
+  /**
+   * @brief The height of this node; 0 for leafs, -1 for free nodes.
+   */
+  int32_t height;
+
+  /**
+   * @brief The user data for leafs.
+   */
+  void *data;
+} cm_tree_node_t;
+
+/**
+ * @brief A dynamic bounding volume tree, kept balanced with AVL rotations. All nodes
+ * reside in a single contiguous array, and are recycled through a free list. Queries
+ * do not modify the tree, and may run concurrently with one another, but not with
+ * insertions, removals or moves.
+ */
+typedef struct {
+
+  /**
+   * @brief The nodes.
+   */
+  cm_tree_node_t *nodes;
+
+  /**
+   * @brief The count of nodes in use.
+   */
+  int32_t num_nodes;
+
+  /**
+   * @brief The count of nodes allocated.
+   */
+  int32_t max_nodes;
+
+  /**
+   * @brief The root node, or `CM_TREE_NULL` if the tree is empty.
+   */
+  int32_t root;
+
+  /**
+   * @brief The head of the free list.
+   */
+  int32_t free_node;
+
+  /**
+   * @brief The distance by which leaf bounds are inflated.
+   */
+  float margin;
+} cm_tree_t;
+
+/**
+ * @brief The query callback, invoked for each leaf whose bounds intersect the query.
+ * @return False to terminate the query.
+ */
+typedef bool (*Cm_TreeQueryFunc)(void *data, void *context);
+
+/**
+ * @brief Initializes the tree, with the given leaf margin.
+ */
+void Cm_InitTree(cm_tree_t *tree, float margin);
+
+/**
+ * @brief Frees all memory associated with the tree.
+ */
+void Cm_FreeTree(cm_tree_t *tree);
+
+/**
+ * @brief Inserts a leaf for the given bounds and data.
+ * @return The leaf, which identifies it for subsequent moves and removals.
+ */
+int32_t Cm_TreeInsert(cm_tree_t *tree, const box3_t bounds, void *data);
+
+/**
+ * @brief Removes the specified leaf.
+ */
+void Cm_TreeRemove(cm_tree_t *tree, int32_t leaf);
+
+/**
+ * @brief Updates the bounds of the specified leaf. The tree is only updated if the new
+ * bounds escape the leaf's inflated bounds, or are much smaller than them.
+ * @return True if the leaf was reinserted, false if the tree was not modified.
+ */
+bool Cm_TreeMove(cm_tree_t *tree, int32_t leaf, const box3_t bounds);
+
+/**
+ * @brief Invokes `func` for every leaf whose inflated bounds intersect `bounds`.
+ */
+void Cm_TreeQuery(const cm_tree_t *tree, const box3_t bounds, Cm_TreeQueryFunc func, void *context);
+
+/**
+ * @return The height of the tree, or -1 if it is empty.
+ */
+int32_t Cm_TreeHeight(const cm_tree_t *tree);
@@ -0,0 +1,192 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "cm_local.h"
+
+/**
+ * @brief The calling thread's pending statistics are published after this many visits.
+ */
+#define CM_BRUSH_VISIT_FLUSH 0x10000
+
+/**
+ * @brief The brush visit state of a single thread.
+ */
+typedef struct {
+
+  /**
+   * @brief The brush stamps.
+   */
+  cm_brush_stamp_t *stamps;
+
+  /**
+   * @brief The number of brushes the stamps can accommodate.
+   */
+  int32_t num_stamps;
+
+  /**
+   * @brief The current generation.
+   */
+  uint32_t generation;
+
+  /**
+   * @brief The statistics not yet published.
+   */
+  cm_brush_visit_stats_t pending;
+} cm_brush_visit_state_t;
+
+/**
+ * @brief The published brush visit statistics, of all threads.
+ */
+static struct {
+  SDL_SpinLock lock;
+  cm_brush_visit_stats_t stats;
+} cm_brush_visits;
+
+/**
+ * @brief Publishes the pending statistics of the given thread state.
+ */
+static void Cm_FlushBrushVisitStats(cm_brush_visit_state_t *state) {
+
+  SDL_LockSpinlock(&cm_brush_visits.lock);
+
+  cm_brush_visits.stats.visited += state->pending.visited;
+  cm_brush_visits.stats.avoided += state->pending.avoided;
+
+  SDL_UnlockSpinlock(&cm_brush_visits.lock);
+
+  state->pending = (cm_brush_visit_stats_t) { 0 };
+}
+
+/**
+ * @brief Frees the brush visit state of an exiting thread.
+ */
+static void Cm_FreeBrushVisitState(gpointer data) {
+
+  cm_brush_visit_state_t *state = data;
+
+  Cm_FlushBrushVisitStats(state);
+
+  g_free(state->stamps);
+  g_free(state);
+}
+
+static GPrivate cm_brush_visit_state = G_PRIVATE_INIT(Cm_FreeBrushVisitState);
+
+/**
+ * @return The calling thread's brush visit state.
+ */
+static cm_brush_visit_state_t *Cm_BrushVisitState(void) {
+
+  cm_brush_visit_state_t *state = g_private_get(&cm_brush_visit_state);
+  if (state == NULL) {
+    state = g_new0(cm_brush_visit_state_t, 1);
+    g_private_set(&cm_brush_visit_state, state);
+  }
+
+  return state;
+}
+
+/**
+ * @brief Begins a new generation of brush visits on the calling thread.
+ */
+cm_brush_visits_t Cm_BeginBrushVisits(int32_t num_brushes) {
+
+  cm_brush_visit_state_t *state = Cm_BrushVisitState();
+
+  if (state->num_stamps < num_brushes) {
+    state->stamps = g_renew(cm_brush_stamp_t, state->stamps, num_brushes);
+
+    memset(state->stamps + state->num_stamps, 0, (num_brushes - state->num_stamps) * sizeof(cm_brush_stamp_t));
+    state->num_stamps = num_brushes;
+  }
+
+  state->generation++;
+
+  if (state->generation == 0) { // wrapped, so reset all stamps
+    memset(state->stamps, 0, state->num_stamps * sizeof(cm_brush_stamp_t));
+    state->generation = 1;
+  }
+
+  return (cm_brush_visits_t) {
+    .stamps = state->stamps,
+    .generation = state->generation,
+    .lane = 1
+  };
+}
+
+/**
+ * @brief Resolves the brush visits for another lane of the same generation.
+ */
+cm_brush_visits_t Cm_BrushVisitLane(const cm_brush_visits_t *visits, int32_t lane) {
+
+  assert(lane >= 0 && lane < CM_BRUSH_VISIT_LANES);
+
+  return (cm_brush_visits_t) {
+    .stamps = visits->stamps,
+    .generation = visits->generation,
+    .lane = 1u << lane
+  };
+}
+
+/**
+ * @brief Accumulates the statistics of the given brush visits.
+ */
+void Cm_EndBrushVisits(const cm_brush_visits_t *visits) {
+
+  cm_brush_visit_state_t *state = Cm_BrushVisitState();
+
+  state->pending.visited += visits->visited;
+  state->pending.avoided += visits->avoided;
+
+  if (state->pending.visited + state->pending.avoided >= CM_BRUSH_VISIT_FLUSH) {
+    Cm_FlushBrushVisitStats(state);
+  }
+}
+
+/**
+ * @brief Publishes the calling thread's pending statistics, and returns the totals.
+ */
+cm_brush_visit_stats_t Cm_BrushVisitStats(void) {
+
+  Cm_FlushBrushVisitStats(Cm_BrushVisitState());
+
+  SDL_LockSpinlock(&cm_brush_visits.lock);
+
+  const cm_brush_visit_stats_t stats = cm_brush_visits.stats;
+
+  SDL_UnlockSpinlock(&cm_brush_visits.lock);
+
+  return stats;
+}
+
+/**
+ * @brief Resets the brush visit statistics, including the calling thread's pending ones.
+ */
+void Cm_ResetBrushVisitStats(void) {
+
+  Cm_BrushVisitState()->pending = (cm_brush_visit_stats_t) { 0 };
+
+  SDL_LockSpinlock(&cm_brush_visits.lock);
+
+  cm_brush_visits.stats = (cm_brush_visit_stats_t) { 0 };
+
+  SDL_UnlockSpinlock(&cm_brush_visits.lock);
+}
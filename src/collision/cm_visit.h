@@ -0,0 +1,132 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#pragma once
+
+#include "cm_types.h"
+
+/**
+ * @brief The maximum number of traces that may share a single generation of brush visits.
+ */
+#define CM_BRUSH_VISIT_LANES 32
+
+/**
+ * @brief The visit stamp of a single brush. A brush has been visited by a trace if its
+ * generation matches the trace's, and the trace's lane is set.
+ */
+typedef struct {
+  uint32_t generation;
+  uint32_t lanes;
+} cm_brush_stamp_t;
+
+/**
+ * @brief The brushes visited by a single trace. Visits are stamped in the calling thread's
+ * array of brush stamps, so that each brush is tested at most once per trace, and a new
+ * trace may begin without clearing anything. Traces that run together as a batch share
+ * a generation, and are told apart by their lanes.
+ */
+typedef struct {
+
+  /**
+   * @brief The calling thread's brush stamps.
+   */
+  cm_brush_stamp_t *stamps;
+
+  /**
+   * @brief The generation of this trace, or batch of traces.
+   */
+  uint32_t generation;
+
+  /**
+   * @brief The lane bit of this trace within its batch.
+   */
+  uint32_t lane;
+
+  /**
+   * @brief The number of brushes visited, and the number of repeat visits avoided.
+   */
+  uint32_t visited, avoided;
+} cm_brush_visits_t;
+
+/**
+ * @brief Brush visit statistics, accumulated across all threads.
+ */
+typedef struct {
+
+  /**
+   * @brief The number of brushes visited by all traces.
+   */
+  uint64_t visited;
+
+  /**
+   * @brief The number of brush tests avoided, because the brush was already visited.
+   */
+  uint64_t avoided;
+} cm_brush_visit_stats_t;
+
+/**
+ * @brief Begins a new generation of brush visits on the calling thread, for brushes
+ * numbered below `num_brushes`.
+ * @return The brush visits for the first lane of the new generation.
+ */
+cm_brush_visits_t Cm_BeginBrushVisits(int32_t num_brushes);
+
+/**
+ * @return The brush visits for the given lane of the same generation as `visits`.
+ */
+cm_brush_visits_t Cm_BrushVisitLane(const cm_brush_visits_t *visits, int32_t lane);
+
+/**
+ * @brief Ends the brush visits of a trace, accumulating its statistics.
+ */
+void Cm_EndBrushVisits(const cm_brush_visits_t *visits);
+
+/**
+ * @return The brush visit statistics since the last reset.
+ */
+cm_brush_visit_stats_t Cm_BrushVisitStats(void);
+
+/**
+ * @brief Resets the brush visit statistics.
+ */
+void Cm_ResetBrushVisitStats(void);
+
+/**
+ * @brief Marks the given brush as visited.
+ * @return True if the brush was already visited by this trace, false otherwise.
+ */
+static inline bool Cm_BrushVisited(cm_brush_visits_t *visits, int32_t brush_num) {
+
+  cm_brush_stamp_t *stamp = &visits->stamps[brush_num];
+
+  if (stamp->generation != visits->generation) {
+    stamp->generation = visits->generation;
+    stamp->lanes = visits->lane;
+  } else if (stamp->lanes & visits->lane) {
+    visits->avoided++;
+    return true;
+  } else {
+    stamp->lanes |= visits->lane;
+  }
+
+  visits->visited++;
+  return false;
+}
@@ -31,4 +31,6 @@
 #include "cm_polylib.h"
 #include "cm_test.h"
 #include "cm_trace.h"
+#include "cm_tree.h"
 #include "cm_types.h"
+#include "cm_visit.h"
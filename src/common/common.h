@@ -46,7 +46,7 @@
  * of core net messages or serialized data types change. The game and client
  * game maintain `PROTOCOL_MINOR` as well.
  */
-#define PROTOCOL_MAJOR 2027
+#define PROTOCOL_MAJOR 2028
 
 /**
  * @brief The IP address of the master server, where the authoritative list of
@@ -78,6 +78,17 @@
 #define PACKET_BACKUP 128
 #define PACKET_MASK   (PACKET_BACKUP - 1)
 
+/**
+ * @brief Demos are a stream of little-endian, length-prefixed server messages, terminated
+ * by -1. Keyframe records are prefixed by `DEMO_KEYFRAME` and their server time. They hold
+ * the config strings and an uncompressed frame, from which playback may resume, and are
+ * skipped otherwise. A trailing index of keyframe times and offsets ends with its own
+ * offset and `DEMO_INDEX_MAGIC`.
+ */
+#define DEMO_KEYFRAME -2
+#define DEMO_KEYFRAME_INTERVAL 10000
+#define DEMO_INDEX_MAGIC (('Q' << 0) | ('D' << 8) | ('I' << 16) | ('X' << 24))
+
 /**
  * @brief Disallow dangerous downloads for both the client and server.
  */
@@ -68,6 +68,16 @@ typedef struct {
    * they are freed (`Fs_Free`) in all code paths.
    */
   GHashTable *loaded_files;
+
+  /**
+   * @brief Mapped files (`Fs_Map`), and the `GMappedFile` backing each.
+   */
+  GHashTable *mapped_files;
+
+  /**
+   * @brief Guards `mapped_files`, as files may be mapped from any thread.
+   */
+  SDL_Mutex *mapped_files_lock;
 } fs_state_t;
 
 static fs_state_t fs_state;
@@ -155,7 +165,7 @@ bool Fs_Mkdir(const char *dir) {
  * @brief Opens the specified file for appending.
  */
 file_t *Fs_OpenAppend(const char *filename) {
-  char dir[MAX_QPATH];
+  char dir[MAX_OS_PATH];
   PHYSFS_File *file;
 
   Dirname(filename, dir);
@@ -189,7 +199,7 @@ file_t *Fs_OpenRead(const char *filename) {
  * @brief Opens the specified file for writing.
  */
 file_t *Fs_OpenWrite(const char *filename) {
-  char dir[MAX_QPATH];
+  char dir[MAX_OS_PATH];
   PHYSFS_File *file;
 
   if (PHYSFS_isInit() == 0) {
@@ -418,6 +428,18 @@ int64_t Fs_LastModTime(const char *filename) {
   return stat.modtime;
 }
 
+/**
+ * @brief Fetch the size in bytes of the specified file, without opening it.
+ * @return The file size, or -1 if the file could not be found.
+ */
+int64_t Fs_FileSize(const char *filename) {
+  PHYSFS_Stat stat;
+  if (!PHYSFS_stat(filename, &stat)) {
+    return -1;
+  }
+  return stat.filesize;
+}
+
 
 /**
  * @brief Unlinks (deletes) the specified file.
@@ -435,7 +457,7 @@ bool Fs_Unlink(const char *filename) {
  * @brief `Fs_Enumerate` context.
  */
 typedef struct {
-  char dir[MAX_QPATH];
+  char dir[MAX_OS_PATH];
   const char *pattern;
   Fs_Enumerator function;
   void *data;
@@ -447,7 +469,7 @@ typedef struct {
 static int32_t Fs_Enumerate_(void *data, const char *dir, const char *filename) {
   const fs_enumerate_t *enumerator = data;
 
-  char path[MAX_QPATH];
+  char path[MAX_OS_PATH];
   g_snprintf(path, sizeof(path), "%s%s", dir, filename);
 
   if (GlobMatch(enumerator->pattern, path, GLOB_FLAGS_NONE)) {
@@ -686,6 +708,185 @@ const char *Fs_RealPath(const char *path) {
   return real_path;
 }
 
+/**
+ * @return The little-endian 16 bit integer at `p`.
+ */
+static uint16_t Fs_ZipShort(const byte *p) {
+  return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+/**
+ * @return The little-endian 32 bit integer at `p`.
+ */
+static uint32_t Fs_ZipLong(const byte *p) {
+  return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/**
+ * @brief Resolves the data of the specified entry within a mapped zip archive, provided that
+ * the entry is stored without compression or encryption.
+ * @return The entry data, or NULL if the entry was not found or is not stored.
+ */
+static const byte *Fs_MapArchiveEntry(const byte *archive, size_t len, const char *filename, int64_t *entry_len) {
+
+  const size_t eocd_len = 22;
+
+  if (len < eocd_len) {
+    return NULL;
+  }
+
+  // find the end of central directory record, which may be followed by a comment
+  const byte *eocd = NULL;
+  const size_t min_ofs = len > eocd_len + 0xffff ? len - eocd_len - 0xffff : 0;
+
+  for (size_t ofs = len - eocd_len + 1; ofs-- > min_ofs;) {
+    if (Fs_ZipLong(archive + ofs) == 0x06054b50) {
+      eocd = archive + ofs;
+      break;
+    }
+  }
+
+  if (eocd == NULL) {
+    return NULL;
+  }
+
+  const uint32_t num_entries = Fs_ZipShort(eocd + 10);
+  const uint32_t central_ofs = Fs_ZipLong(eocd + 16);
+
+  if (central_ofs >= len) {
+    return NULL; // zip64, or corrupt
+  }
+
+  const size_t filename_len = strlen(filename);
+
+  const byte *entry = archive + central_ofs;
+  for (uint32_t i = 0; i < num_entries; i++) {
+
+    if ((size_t) (entry - archive) + 46 > len || Fs_ZipLong(entry) != 0x02014b50) {
+      return NULL;
+    }
+
+    const uint16_t flags = Fs_ZipShort(entry + 8);
+    const uint16_t method = Fs_ZipShort(entry + 10);
+    const uint32_t compressed_len = Fs_ZipLong(entry + 20);
+    const uint32_t uncompressed_len = Fs_ZipLong(entry + 24);
+    const uint16_t name_len = Fs_ZipShort(entry + 28);
+    const uint16_t extra_len = Fs_ZipShort(entry + 30);
+    const uint16_t comment_len = Fs_ZipShort(entry + 32);
+    const uint32_t local_ofs = Fs_ZipLong(entry + 42);
+
+    if ((size_t) (entry - archive) + 46 + name_len > len) {
+      return NULL;
+    }
+
+    const char *name = (const char *) entry + 46;
+
+    if (name_len == filename_len && !strncmp(name, filename, filename_len)) {
+
+      if (method != 0 || (flags & 1) || compressed_len != uncompressed_len) {
+        return NULL; // compressed or encrypted
+      }
+
+      if ((size_t) local_ofs + 30 > len || Fs_ZipLong(archive + local_ofs) != 0x04034b50) {
+        return NULL;
+      }
+
+      const byte *local = archive + local_ofs;
+
+      const size_t data_ofs = (size_t) local_ofs + 30 + Fs_ZipShort(local + 26) + Fs_ZipShort(local + 28);
+      if (data_ofs + uncompressed_len > len) {
+        return NULL;
+      }
+
+      *entry_len = uncompressed_len;
+      return archive + data_ofs;
+    }
+
+    entry += 46 + name_len + extra_len + comment_len;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Maps the specified file into memory without reading or copying it. This is possible
+ * for files residing directly in a search path directory, and for files stored without
+ * compression in zip archives. The mapping is private, so the contents may be modified without
+ * affecting the file. It is not a snapshot, however: if the file is truncated or rewritten in
+ * place while mapped, reads fault (`SIGBUS`) or see the new contents. Hold mappings only for
+ * the duration of a load, and release the buffer with `Fs_Unmap`.
+ *
+ * @param filename The file to map.
+ * @param buffer The mapped contents, or NULL if the file could not be mapped.
+ *
+ * @return The length of the file, or -1 if it could not be mapped. The caller may then
+ * fall back to `Fs_Load`.
+ */
+int64_t Fs_Map(const char *filename, void **buffer) {
+
+  *buffer = NULL;
+
+  const char *real_dir = Fs_RealDir(filename);
+  if (real_dir == NULL) {
+    return -1;
+  }
+
+  const bool is_dir = g_file_test(real_dir, G_FILE_TEST_IS_DIR);
+
+  gchar *path = is_dir ? g_build_filename(real_dir, filename, NULL) : g_strdup(real_dir);
+
+  GMappedFile *mapped = g_mapped_file_new(path, true, NULL);
+
+  g_free(path);
+
+  if (mapped == NULL) {
+    return -1;
+  }
+
+  byte *contents = (byte *) g_mapped_file_get_contents(mapped);
+  const size_t len = g_mapped_file_get_length(mapped);
+
+  int64_t file_len = -1;
+
+  if (contents) {
+    if (is_dir) {
+      *buffer = contents;
+      file_len = (int64_t) len;
+    } else {
+      *buffer = (void *) Fs_MapArchiveEntry(contents, len, filename, &file_len);
+    }
+  }
+
+  if (*buffer == NULL || file_len <= 0) {
+    g_mapped_file_unref(mapped);
+    *buffer = NULL;
+    return -1;
+  }
+
+  SDL_LockMutex(fs_state.mapped_files_lock);
+  g_hash_table_insert(fs_state.mapped_files, *buffer, mapped);
+  SDL_UnlockMutex(fs_state.mapped_files_lock);
+
+  Com_Debug(DEBUG_FILESYSTEM, "Mapped %s (%" PRId64 " bytes)\n", filename, file_len);
+  return file_len;
+}
+
+/**
+ * @brief Releases the specified buffer mapped by `Fs_Map`.
+ */
+void Fs_Unmap(void *buffer) {
+
+  if (buffer) {
+    SDL_LockMutex(fs_state.mapped_files_lock);
+    const bool removed = g_hash_table_remove(fs_state.mapped_files, buffer);
+    SDL_UnlockMutex(fs_state.mapped_files_lock);
+
+    if (!removed) {
+      Com_Warn("Invalid buffer\n");
+    }
+  }
+}
+
 /**
  * @brief Initializes the file subsystem.
  */
@@ -815,6 +1016,8 @@ void Fs_Init(const uint32_t flags) {
   fs_state.base_search_paths = PHYSFS_getSearchPath();
 
   fs_state.loaded_files = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, Mem_Free);
+  fs_state.mapped_files = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_mapped_file_unref);
+  fs_state.mapped_files_lock = SDL_CreateMutex();
 }
 
 /**
@@ -835,6 +1038,8 @@ void Fs_Shutdown(void) {
 
   g_hash_table_foreach(fs_state.loaded_files, Fs_LoadedFiles_, NULL);
   g_hash_table_destroy(fs_state.loaded_files);
+  g_hash_table_destroy(fs_state.mapped_files);
+  SDL_DestroyMutex(fs_state.mapped_files_lock);
 
   PHYSFS_freeList(fs_state.base_search_paths);
 
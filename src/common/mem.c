@@ -20,6 +20,7 @@
  */
 
 #include <signal.h>
+#include <SDL3/SDL_atomic.h>
 #include <SDL3/SDL_thread.h>
 
 #include "mem.h"
@@ -29,7 +30,8 @@ typedef uint32_t mem_magic_t;
 
 typedef struct mem_block_s {
   mem_magic_t magic;
-  mem_tag_t tag; // for group free
+  int16_t tag; // for group free
+  uint16_t shard; // shared by all blocks in a hierarchy
   struct mem_block_s *parent;
   GSList *children;
   size_t size;
@@ -39,14 +41,115 @@ typedef struct {
   mem_magic_t magic;
 } mem_footer_t;
 
+/**
+ * @brief The number of block registry shards. Each thread allocates from its own shard, so that
+ * threads do not contend for a single lock.
+ */
+#define MEM_SHARDS 32
+
+/**
+ * @brief A block registry shard. The lock guards the root blocks, and the children and parent
+ * links of every block in the shard.
+ */
 typedef struct {
   GHashTable *blocks;
   size_t size;
   SDL_SpinLock lock;
+} mem_shard_t;
+
+typedef struct {
+  mem_shard_t shards[MEM_SHARDS];
+  SDL_AtomicInt next_shard;
 } mem_state_t;
 
 static mem_state_t mem_state;
 
+/**
+ * @brief The shard this thread allocates new block hierarchies from.
+ */
+static _Thread_local int32_t mem_thread_shard = -1;
+
+/**
+ * @brief Returns the shard index for new allocations on the calling thread.
+ */
+static inline uint16_t Mem_ThreadShard(void) {
+
+  if (mem_thread_shard == -1) {
+    mem_thread_shard = (SDL_AddAtomicInt(&mem_state.next_shard, 1) & INT32_MAX) % MEM_SHARDS;
+  }
+
+  return (uint16_t) mem_thread_shard;
+}
+
+/**
+ * @brief Acquires the locks of two shards in a consistent order.
+ */
+static void Mem_LockShards(uint16_t a, uint16_t b) {
+
+  if (a == b) {
+    SDL_LockSpinlock(&mem_state.shards[a].lock);
+  } else {
+    SDL_LockSpinlock(&mem_state.shards[a < b ? a : b].lock);
+    SDL_LockSpinlock(&mem_state.shards[a < b ? b : a].lock);
+  }
+}
+
+/**
+ * @brief Releases the locks acquired with `Mem_LockShards`.
+ */
+static void Mem_UnlockShards(uint16_t a, uint16_t b) {
+
+  SDL_UnlockSpinlock(&mem_state.shards[a].lock);
+
+  if (a != b) {
+    SDL_UnlockSpinlock(&mem_state.shards[b].lock);
+  }
+}
+
+/**
+ * @brief Acquires the lock of the shard that owns the specified block. A concurrent
+ * `Mem_Link` may move the block to another shard before the lock is held, so the shard
+ * is read again once it is, until it is stable.
+ *
+ * @return The index of the locked shard.
+ */
+static uint16_t Mem_LockBlock(const mem_block_t *b) {
+
+  while (true) {
+    const uint16_t shard = b->shard;
+
+    SDL_LockSpinlock(&mem_state.shards[shard].lock);
+
+    if (b->shard == shard) {
+      return shard;
+    }
+
+    SDL_UnlockSpinlock(&mem_state.shards[shard].lock);
+  }
+}
+
+/**
+ * @brief Acquires the locks of the shards that own the specified blocks, retrying until
+ * neither block has been moved to another shard.
+ *
+ * @see Mem_LockBlock
+ */
+static void Mem_LockBlocks(const mem_block_t *a, const mem_block_t *b, uint16_t *a_shard, uint16_t *b_shard) {
+
+  while (true) {
+    *a_shard = a->shard;
+    *b_shard = b->shard;
+
+    Mem_LockShards(*a_shard, *b_shard);
+
+    if (a->shard == *a_shard && b->shard == *b_shard) {
+      return;
+    }
+
+    Mem_UnlockShards(*a_shard, *b_shard);
+  }
+}
+
 /**
  * @brief Returns a properly aligned pointer to the footer for a data block.
  */
@@ -132,7 +235,7 @@ static void Mem_Free_(mem_block_t *b) {
   }
 
   // decrement the pool size and free the memory
-  mem_state.size -= b->size;
+  mem_state.shards[b->shard].size -= b->size;
 
   free(b);
 }
@@ -145,17 +248,17 @@ void Mem_Free(void *p) {
   if (p) {
     mem_block_t *b = Mem_CheckMagic(p);
 
-    SDL_LockSpinlock(&mem_state.lock);
+    mem_shard_t *shard = &mem_state.shards[Mem_LockBlock(b)];
 
     if (b->parent) {
       b->parent->children = g_slist_remove(b->parent->children, b);
     } else {
-      g_hash_table_remove(mem_state.blocks, (gconstpointer) b);
+      g_hash_table_remove(shard->blocks, (gconstpointer) b);
     }
 
     Mem_Free_(b);
 
-    SDL_UnlockSpinlock(&mem_state.lock);
+    SDL_UnlockSpinlock(&shard->lock);
   }
 }
 
@@ -166,20 +269,24 @@ void Mem_FreeTag(mem_tag_t tag) {
   GHashTableIter it;
   gpointer key, value;
 
-  SDL_LockSpinlock(&mem_state.lock);
+  for (int32_t i = 0; i < MEM_SHARDS; i++) {
+    mem_shard_t *shard = &mem_state.shards[i];
+
+    SDL_LockSpinlock(&shard->lock);
 
-  g_hash_table_iter_init(&it, mem_state.blocks);
+    g_hash_table_iter_init(&it, shard->blocks);
 
-  while (g_hash_table_iter_next(&it, &key, &value)) {
-    mem_block_t *b = (mem_block_t *) key;
+    while (g_hash_table_iter_next(&it, &key, &value)) {
+      mem_block_t *b = (mem_block_t *) key;
 
-    if (tag == MEM_TAG_ALL || b->tag == tag) {
-      g_hash_table_iter_remove(&it);
-      Mem_Free_(b);
+      if (tag == MEM_TAG_ALL || b->tag == tag) {
+        g_hash_table_iter_remove(&it);
+        Mem_Free_(b);
+      }
     }
-  }
 
-  SDL_UnlockSpinlock(&mem_state.lock);
+    SDL_UnlockSpinlock(&shard->lock);
+  }
 }
 
 /**
@@ -214,7 +321,7 @@ static void *Mem_Malloc_(size_t size, mem_tag_t tag, void *parent) {
   }
 
   b->magic = MEM_MAGIC;
-  b->tag = tag;
+  b->tag = (int16_t) tag;
   b->parent = p;
   b->size = size;
 
@@ -223,18 +330,25 @@ static void *Mem_Malloc_(size_t size, mem_tag_t tag, void *parent) {
   mem_footer_t *footer = Mem_Footer(data, size);
   footer->magic = (mem_magic_t) (MEM_MAGIC + b->size);
 
-  // insert it into the managed memory structures
-  SDL_LockSpinlock(&mem_state.lock);
+  // insert it into the managed memory structures, in our parent's shard if we have one
+  if (p) {
+    b->shard = Mem_LockBlock(p);
+  } else {
+    b->shard = Mem_ThreadShard();
+    SDL_LockSpinlock(&mem_state.shards[b->shard].lock);
+  }
+
+  mem_shard_t *shard = &mem_state.shards[b->shard];
 
   if (b->parent) {
     b->parent->children = g_slist_prepend(b->parent->children, b);
   } else {
-    g_hash_table_add(mem_state.blocks, b);
+    g_hash_table_add(shard->blocks, b);
   }
 
-  mem_state.size += size;
+  shard->size += size;
 
-  SDL_UnlockSpinlock(&mem_state.lock);
+  SDL_UnlockSpinlock(&shard->lock);
 
   // return the address in front of the block
   return data;
@@ -300,13 +414,13 @@ void *Mem_Realloc(void *p, size_t size) {
   const size_t old_size = b->size;
   const size_t s = Mem_BlockSize(size);
 
-  SDL_LockSpinlock(&mem_state.lock);
+  mem_shard_t *shard = &mem_state.shards[Mem_LockBlock(b)];
 
   // remove the old block while b is still a valid pointer
   if (b->parent) {
     b->parent->children = g_slist_remove(b->parent->children, b);
   } else {
-    g_hash_table_remove(mem_state.blocks, b);
+    g_hash_table_remove(shard->blocks, b);
   }
 
   b->size = size;
@@ -322,11 +436,11 @@ void *Mem_Realloc(void *p, size_t size) {
   mem_footer_t *footer = Mem_Footer(data, size);
   footer->magic = (mem_magic_t) (MEM_MAGIC + new_b->size);
 
-  // re-seat us in our parent or in global hash list
+  // re-seat us in our parent or in our shard's hash list
   if (new_b->parent) {
     new_b->parent->children = g_slist_prepend(new_b->parent->children, new_b);
   } else {
-    g_hash_table_add(mem_state.blocks, new_b);
+    g_hash_table_add(shard->blocks, new_b);
   }
 
   // change our childrens' parent pointers
@@ -337,14 +451,40 @@ void *Mem_Realloc(void *p, size_t size) {
     }
   }
 
-  mem_state.size -= old_size;
-  mem_state.size += size;
+  shard->size -= old_size;
+  shard->size += size;
 
-  SDL_UnlockSpinlock(&mem_state.lock);
+  SDL_UnlockSpinlock(&shard->lock);
 
   return data;
 }
 
+/**
+ * @brief Recursively calculates the total allocated size of a block, including all child blocks.
+ */
+static size_t Mem_CalculateBlockSize(const mem_block_t *b) {
+
+  size_t size = b->size;
+
+  for (GSList *child = b->children; child; child = child->next) {
+    size += Mem_CalculateBlockSize((const mem_block_t *) child->data);
+  }
+
+  return size;
+}
+
+/**
+ * @brief Recursively moves a block and all of its child blocks to the specified shard.
+ */
+static void Mem_SetShard(mem_block_t *b, uint16_t shard) {
+
+  b->shard = shard;
+
+  for (GSList *child = b->children; child; child = child->next) {
+    Mem_SetShard((mem_block_t *) child->data, shard);
+  }
+}
+
 /**
  * @brief Links the specified child to the given parent. The child will
  * subsequently be freed with the parent.
@@ -358,18 +498,29 @@ void *Mem_Link(void *child, void *parent) {
   mem_block_t *c = Mem_CheckMagic(child);
   mem_block_t *p = Mem_CheckMagic(parent);
 
-  SDL_LockSpinlock(&mem_state.lock);
+  uint16_t c_shard, p_shard;
+
+  Mem_LockBlocks(c, p, &c_shard, &p_shard);
 
   if (c->parent) {
     c->parent->children = g_slist_remove(c->parent->children, c);
   } else {
-    g_hash_table_remove(mem_state.blocks, c);
+    g_hash_table_remove(mem_state.shards[c_shard].blocks, c);
+  }
+
+  if (c_shard != p_shard) {
+    const size_t size = Mem_CalculateBlockSize(c);
+
+    mem_state.shards[c_shard].size -= size;
+    mem_state.shards[p_shard].size += size;
+
+    Mem_SetShard(c, p_shard);
   }
 
   c->parent = p;
   p->children = g_slist_prepend(p->children, c);
 
-  SDL_UnlockSpinlock(&mem_state.lock);
+  Mem_UnlockShards(c_shard, p_shard);
 
   return child;
 }
@@ -378,7 +529,14 @@ void *Mem_Link(void *child, void *parent) {
  * @return The current size (user bytes) of the zone allocation pool.
  */
 size_t Mem_Size(void) {
-  return mem_state.size;
+
+  size_t size = 0;
+
+  for (int32_t i = 0; i < MEM_SHARDS; i++) {
+    size += mem_state.shards[i].size;
+  }
+
+  return size;
 }
 
 /**
@@ -407,20 +565,6 @@ static gint Mem_Stats_Sort(gconstpointer a, gconstpointer b) {
   return (gint) (((const mem_stat_t *) b)->size - ((const mem_stat_t *) a)->size);
 }
 
-/**
- * @brief Recursively calculates the total allocated size of a block, including all child blocks.
- */
-static size_t Mem_CalculateBlockSize(const mem_block_t *b) {
-
-  size_t size = b->size;
-
-  for (GSList *child = b->children; child; child = child->next) {
-    size += Mem_CalculateBlockSize((const mem_block_t *) child->data);
-  }
-
-  return size;
-}
-
 /**
  * @brief Fetches stats about allocated memory to the console.
  */
@@ -429,45 +573,49 @@ GArray *Mem_Stats(void) {
   GHashTableIter it;
   gpointer key, value;
 
-  SDL_LockSpinlock(&mem_state.lock);
-
   GArray *stat_array = g_array_new(false, true, sizeof(mem_stat_t));
 
   stat_array = g_array_append_vals(stat_array, &(const mem_stat_t) {
     .tag = -1,
-    .size = mem_state.size,
+    .size = Mem_Size(),
     .count = 0
   }, 1);
 
-  g_hash_table_iter_init(&it, mem_state.blocks);
+  for (int32_t i = 0; i < MEM_SHARDS; i++) {
+    mem_shard_t *shard = &mem_state.shards[i];
+
+    SDL_LockSpinlock(&shard->lock);
+
+    g_hash_table_iter_init(&it, shard->blocks);
 
-  while (g_hash_table_iter_next(&it, &key, &value)) {
-    const mem_block_t *b = (const mem_block_t *) key;
-    mem_stat_t *stats = NULL;
+    while (g_hash_table_iter_next(&it, &key, &value)) {
+      const mem_block_t *b = (const mem_block_t *) key;
+      mem_stat_t *stats = NULL;
 
-    for (size_t i = 0; i < stat_array->len; i++) {
+      for (size_t j = 0; j < stat_array->len; j++) {
 
-      mem_stat_t *stat_i = &g_array_index(stat_array, mem_stat_t, i);
+        mem_stat_t *stat_j = &g_array_index(stat_array, mem_stat_t, j);
 
-      if (stat_i->tag == b->tag) {
-        stats = stat_i;
-        break;
+        if (stat_j->tag == b->tag) {
+          stats = stat_j;
+          break;
+        }
       }
-    }
 
-    if (stats == NULL) {
-      stat_array = g_array_append_vals(stat_array, &(const mem_stat_t) {
-        .tag = b->tag,
-        .size = Mem_CalculateBlockSize(b),
-        .count = 1
-      }, 1);
-    } else {
-      stats->size += Mem_CalculateBlockSize(b);
-      stats->count++;
+      if (stats == NULL) {
+        stat_array = g_array_append_vals(stat_array, &(const mem_stat_t) {
+          .tag = b->tag,
+          .size = Mem_CalculateBlockSize(b),
+          .count = 1
+        }, 1);
+      } else {
+        stats->size += Mem_CalculateBlockSize(b);
+        stats->count++;
+      }
     }
-  }
 
-  SDL_UnlockSpinlock(&mem_state.lock);
+    SDL_UnlockSpinlock(&shard->lock);
+  }
 
   g_array_sort(stat_array, Mem_Stats_Sort);
 
@@ -482,7 +630,9 @@ void Mem_Init(void) {
 
   memset(&mem_state, 0, sizeof(mem_state));
 
-  mem_state.blocks = g_hash_table_new(NULL, NULL);
+  for (int32_t i = 0; i < MEM_SHARDS; i++) {
+    mem_state.shards[i].blocks = g_hash_table_new(NULL, NULL);
+  }
 }
 
 /**
@@ -493,5 +643,7 @@ void Mem_Shutdown(void) {
 
   Mem_FreeTag(MEM_TAG_ALL);
 
-  g_hash_table_destroy(mem_state.blocks);
+  for (int32_t i = 0; i < MEM_SHARDS; i++) {
+    g_hash_table_destroy(mem_state.shards[i].blocks);
+  }
 }
@@ -65,6 +65,12 @@ SDL_ThreadID thread_main;
  */
 _Thread_local SDL_ThreadID thread_id;
 
+/**
+ * @brief The current thread's index in the thread pool plus one, or 0 for threads outside
+ * of the pool. Indexes are stable across `Thread_Shutdown` and `Thread_Init`.
+ */
+_Thread_local int32_t thread_index;
+
 /**
  * @brief Wrap the user's function in our own for introspection.
  */
@@ -72,6 +78,7 @@ static int32_t Thread_Run(void *data) {
   thread_t *t = (thread_t *) data;
 
   thread_id = SDL_GetCurrentThreadID();
+  thread_index = (int32_t) (t - thread_pool.threads) + 1;
 
   while (t->Run != ThreadTerminate) {
 
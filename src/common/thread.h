@@ -64,3 +64,4 @@ void Thread_Shutdown(void);
 
 extern SDL_ThreadID thread_main;
 extern _Thread_local SDL_ThreadID thread_id;
+extern _Thread_local int32_t thread_index;
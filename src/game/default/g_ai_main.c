@@ -24,6 +24,7 @@
 
 cvar_t *g_ai_no_target;
 cvar_t *g_ai_node_dev;
+cvar_t *g_ai_path_cache_size;
 
 /**
  * @brief Linear interpolation between a and b by fraction t (0.0 to 1.0).
@@ -94,9 +95,16 @@ static bool G_Ai_ShouldRetreat(const g_client_t *cl) {
 }
 
 /**
- * @brief Returns true if the AI client has line of sight to the target entity.
+ * @brief Returns the origin from which the AI client looks.
  */
-static bool G_Ai_CanSee(const g_client_t *cl, const g_entity_t *other) {
+static inline vec3_t G_Ai_EyeOrigin(const g_client_t *cl) {
+  return Vec3_Add(cl->entity->s.origin, cl->ps.pm_state.view_offset);
+}
+
+/**
+ * @brief Returns true if the AI client could see the target entity, were nothing in the way.
+ */
+static bool G_Ai_CouldSee(const g_client_t *cl, const g_entity_t *other) {
 
   // invisible enemies are only detectable within a skill-dependent range
   if (other->s.effects & EF_INVISIBILITY) {
@@ -109,8 +117,7 @@ static bool G_Ai_CanSee(const g_client_t *cl, const g_entity_t *other) {
 
   // see if we're even facing the object
 
-  const vec3_t eye_origin = Vec3_Add(cl->entity->s.origin, cl->ps.pm_state.view_offset);
-  const vec3_t dir = Vec3_Normalize(Vec3_Subtract(other->s.origin, eye_origin));
+  const vec3_t dir = Vec3_Normalize(Vec3_Subtract(other->s.origin, G_Ai_EyeOrigin(cl)));
 
   float dot = Vec3_Dot(cl->forward, dir);
 
@@ -118,13 +125,33 @@ static bool G_Ai_CanSee(const g_client_t *cl, const g_entity_t *other) {
     return false;
   }
 
-  cm_trace_t tr = gi.Trace(eye_origin, other->s.origin, Box3_Zero(), cl->entity, CONTENTS_MASK_CLIP_PROJECTILE);
+  return true;
+}
+
+/**
+ * @brief Returns true if the line of sight trace to the target entity reached it.
+ */
+static inline bool G_Ai_TraceSees(const cm_trace_t *tr, const g_entity_t *other) {
 
-  if (tr.ent == other) {
+  if (tr->ent == other) {
     return true;
   }
 
-  return Box3_ContainsPoint(Box3_Expand(other->abs_bounds, 1.f), tr.end);
+  return Box3_ContainsPoint(Box3_Expand(other->abs_bounds, 1.f), tr->end);
+}
+
+/**
+ * @brief Returns true if the AI client has line of sight to the target entity.
+ */
+static bool G_Ai_CanSee(const g_client_t *cl, const g_entity_t *other) {
+
+  if (!G_Ai_CouldSee(cl, other)) {
+    return false;
+  }
+
+  const cm_trace_t tr = gi.Trace(G_Ai_EyeOrigin(cl), other->s.origin, Box3_Zero(), cl->entity, CONTENTS_MASK_CLIP_PROJECTILE);
+
+  return G_Ai_TraceSees(&tr, other);
 }
 
 /**
@@ -173,10 +200,43 @@ static int32_t G_Ai_CompareItems(const void *a, const void *b) {
 
 #define AI_ITEM_UNREACHABLE -1.0
 
+/**
+ * @brief The distance a bot may move before its closest node is found again.
+ */
+#define AI_ROUTE_NODE_DISTANCE 64.f
+
+/**
+ * @return The bot's closest node for route table lookups, or `AI_NODE_INVALID` if no route
+ * table is available. The visibility traced search is repeated only once the bot has moved
+ * away from where it was last run, or the navigation graph has changed.
+ */
+static ai_node_id_t G_Ai_RouteNode(g_client_t *cl) {
+
+  if (!G_Ai_Route_Available()) {
+    return AI_NODE_INVALID;
+  }
+
+  ai_t *ai = cl->ai;
+
+  if (ai->route_node_time == 0 ||
+      ai->route_node_generation != G_Ai_Node_Generation() ||
+      Vec3_DistanceSquared(cl->entity->s.origin, ai->route_node_origin) > AI_ROUTE_NODE_DISTANCE * AI_ROUTE_NODE_DISTANCE) {
+
+    ai->route_node = G_Ai_Node_FindClosest(cl->entity->s.origin, 512.f, true, true);
+    ai->route_node_origin = cl->entity->s.origin;
+    ai->route_node_generation = G_Ai_Node_Generation();
+    ai->route_node_time = g_level.time;
+  }
+
+  return ai->route_node;
+}
+
 /**
  * @brief Returns the distance to a nearby item, or `AI_ITEM_UNREACHABLE` if beyond awareness range.
+ * @param node The bot's closest node, if a route table is available, in which case the item's
+ * path distance is returned instead, and items the route table can not reach are unreachable.
  */
-static float G_Ai_ItemReachable(const g_client_t *cl, const g_entity_t *other) {
+static float G_Ai_ItemReachable(const g_client_t *cl, const ai_node_id_t node, const g_entity_t *other) {
 
   const float dist = Vec3_Distance(cl->entity->s.origin, other->s.origin);
 
@@ -187,6 +247,16 @@ static float G_Ai_ItemReachable(const g_client_t *cl, const g_entity_t *other) {
     return AI_ITEM_UNREACHABLE;
   }
 
+  // rank items by the length of the path to them, and skip those with no path at all
+  if (node != AI_NODE_INVALID && other->node != AI_NODE_INVALID) {
+    const float route = G_Ai_Route_Distance(node, other->node);
+    if (route == FLT_MAX) {
+      return AI_ITEM_UNREACHABLE;
+    }
+
+    return route;
+  }
+
   return dist;
 }
 
@@ -276,6 +346,8 @@ static uint32_t G_Ai_FindItems(g_client_t *cl, pm_cmd_t *cmd) {
   // we have nothing to do, start looking for a new one
   GArray *items_visible = g_array_new(false, false, sizeof(ai_item_pick_t));
 
+  const ai_node_id_t node = G_Ai_RouteNode(cl);
+
   G_ForEachEntity(ent, {
     if (ent->s.solid != SOLID_TRIGGER) {
       continue;
@@ -297,7 +369,7 @@ static uint32_t G_Ai_FindItems(g_client_t *cl, pm_cmd_t *cmd) {
 
     if (!G_Ai_CanTarget(cl, ent) ||
         !G_Ai_CanPickup(cl, ent) ||
-        (distance = G_Ai_ItemReachable(cl, ent)) <= AI_ITEM_UNREACHABLE) {
+        (distance = G_Ai_ItemReachable(cl, node, ent)) <= AI_ITEM_UNREACHABLE) {
       continue;
     }
 
@@ -669,19 +741,38 @@ static uint32_t G_Ai_Hunt(g_client_t *cl, pm_cmd_t *cmd) {
     }
   }
 
-  // scan for the best visible enemy, even if we already have a target
+  // scan for the best visible enemy, even if we already have a target, tracing the line
+  // of sight to every enemy in view together
+  g_entity_t *enemies[MAX_CLIENTS];
+  vec3_t starts[MAX_CLIENTS], ends[MAX_CLIENTS];
+  cm_trace_t traces[MAX_CLIENTS];
+  size_t num_enemies = 0;
+
+  const vec3_t eye_origin = G_Ai_EyeOrigin(cl);
+
+  G_ForEachEntity(ent, {
+    if (num_enemies < lengthof(enemies) && G_Ai_IsTargetable(cl, ent) && G_Ai_CouldSee(cl, ent)) {
+      enemies[num_enemies] = ent;
+      starts[num_enemies] = eye_origin;
+      ends[num_enemies] = ent->s.origin;
+      num_enemies++;
+    }
+  });
+
+  gi.TraceBatch(starts, ends, num_enemies, Box3_Zero(), cl->entity, CONTENTS_MASK_CLIP_PROJECTILE, traces);
+
   g_entity_t *best_enemy = NULL;
   float best_priority = 0.f;
 
-  G_ForEachEntity(ent, {
-    if (G_Ai_CanTarget(cl, ent)) {
-      const float priority = G_Ai_EnemyPriority(cl, ent, true);
+  for (size_t i = 0; i < num_enemies; i++) {
+    if (G_Ai_TraceSees(&traces[i], enemies[i])) {
+      const float priority = G_Ai_EnemyPriority(cl, enemies[i], true);
       if (priority > best_priority) {
         best_priority = priority;
-        best_enemy = ent;
+        best_enemy = enemies[i];
       }
     }
-  });
+  }
 
   // switch targets if we found a significantly better one
   if (best_enemy) {
@@ -891,6 +982,8 @@ static g_entity_t *g_ai_current_entity;
 
 /**
  * @brief Ignore ourselves, clipping to the correct mask based on our status.
+ * @remarks Player movement traces one step at a time, each starting from where the
+ * previous one ended, so these can not be batched with `gi.TraceBatch`.
  */
 static cm_trace_t G_Ai_MoveTrace(const vec3_t start, const vec3_t end, const box3_t bounds) {
 
@@ -1891,6 +1984,13 @@ static void G_Ai_DeleteNodes_f(void) {
   G_Ai_DeleteNodes();
 }
 
+/**
+ * @brief Console command handler to build the route table for the current navigation nodes.
+ */
+static void G_Ai_BuildRoutes_f(void) {
+  G_Ai_Route_Build();
+}
+
 /**
  * @brief Console command handler that tests pathfinding by routing all bots through a specified path.
  */
@@ -1939,6 +2039,8 @@ void G_Ai_Init(void) {
     gi.SetCvarInteger("g_cheats", 1);
   }
 
+  g_ai_path_cache_size = gi.AddCvar("g_ai_path_cache_size", "256", 0, "The number of bot paths to cache. Set to 0 to disable path caching.");
+
   gi.SetConfigString(CS_NAV_EDIT, g_ai_node_dev->string);
 
   gi.AddCmd("g_ai_save_nodes", G_Ai_SaveNodes_f, CMD_AI, "Save current node data");
@@ -1946,6 +2048,8 @@ void G_Ai_Init(void) {
   gi.AddCmd("g_ai_delete_nodes", G_Ai_DeleteNodes_f, CMD_AI, "Delete all current node data");
   gi.AddCmd("g_ai_test_path", G_Ai_TestPath_f, CMD_AI, "Save current node data");
   gi.AddCmd("g_ai_offset_nodes", G_Ai_OffsetNodes_f, CMD_AI, "Offset the loaded nodes by the specified translation");
+  gi.AddCmd("g_ai_build_routes", G_Ai_BuildRoutes_f, CMD_AI, "Build the all-pairs route table for the current node data");
+  gi.AddCmd("g_ai_path_cache_stats", G_Ai_PathCache_Stats, CMD_AI, "Print bot path cache hit and miss statistics");
 
   G_Ai_InitSkins();
 }
@@ -1956,6 +2060,7 @@ void G_Ai_Init(void) {
 void G_Ai_Load(void) {
 
   G_Ai_InitNodes();
+  G_Ai_Route_Load();
 }
 
 /**
@@ -1964,6 +2069,7 @@ void G_Ai_Load(void) {
 void G_Ai_Shutdown(void) {
 
   G_Ai_ShutdownSkins();
+  G_Ai_Route_Free();
 
   gi.FreeTag(MEM_TAG_AI);
 }
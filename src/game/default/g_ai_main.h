@@ -32,10 +32,12 @@
 #include "g_ai_info.h"
 #include "g_ai_item.h"
 #include "g_ai_node.h"
+#include "g_ai_route.h"
 #include "g_ai_types.h"
 
 extern cvar_t *g_ai_no_target;
 extern cvar_t *g_ai_node_dev;
+extern cvar_t *g_ai_path_cache_size;
 
 void G_Ai_Disconnect(g_client_t *cl);
 void G_Ai_Think(g_client_t *cl, pm_cmd_t *cmd);
@@ -66,18 +66,16 @@ GArray *G_Ai_Node_TestPath(void) {
 }
 
 /**
- * @brief An AI navigation node with world position, outgoing links, and pathfinding state.
+ * @brief An AI navigation node with world position and outgoing links.
  */
 typedef struct {
-  // persisted to disk
-
   vec3_t position;
   GArray *links;
 
-  // only used for nav purposes
-
-  float cost;
-  ai_node_id_t came_from;
+  /**
+   * @brief The point contents at `position`, cached when the node is loaded or placed.
+   */
+  int32_t contents;
 } ai_node_t;
 
 /**
@@ -86,10 +84,209 @@ typedef struct {
 static GArray *g_ai_nodes;
 
 /**
- * @brief Returns the index of a node pointer within the global node array.
+ * @brief Incremented whenever nodes or links change, invalidating cached paths.
+ */
+static uint32_t g_ai_node_generation;
+
+/**
+ * @brief Flags the node graph as changed, so that cached paths are recomputed.
+ */
+static inline void G_Ai_Node_GraphChanged(void) {
+  g_ai_node_generation++;
+}
+
+/**
+ * @return The node generation, which changes whenever nodes or links change.
+ */
+uint32_t G_Ai_Node_Generation(void) {
+  return g_ai_node_generation;
+}
+
+#define AI_NODE_GRID_CELL_SIZE 256.f
+
+/**
+ * @brief A uniform grid over the horizontal node positions, stored as a flattened cell array
+ * with per-cell offsets into a shared node list. Rebuilt lazily after nodes change.
+ */
+static struct {
+  float mins_x, mins_y;
+  int32_t width, height;
+
+  /**
+   * @brief Offsets into `nodes` for each cell, with a trailing sentinel.
+   */
+  int32_t *cells;
+
+  /**
+   * @brief Node ids, ordered by cell.
+   */
+  ai_node_id_t *nodes;
+
+  /**
+   * @brief Candidate nodes gathered while searching the grid.
+   */
+  GArray *candidates;
+
+  bool dirty;
+} g_ai_node_grid = {
+  .dirty = true
+};
+
+/**
+ * @brief A candidate node and its (weighted) squared distance from the query position.
+ */
+typedef struct {
+  ai_node_id_t id;
+  float dist;
+} ai_node_candidate_t;
+
+/**
+ * @brief Flags the node grid for rebuilding on its next query.
+ */
+static inline void G_Ai_Node_InvalidateGrid(void) {
+  g_ai_node_grid.dirty = true;
+}
+
+/**
+ * @brief Moves the node to the specified position, refreshing its cached contents.
+ */
+static void G_Ai_Node_SetPosition(ai_node_t *node, const vec3_t position) {
+
+  node->position = position;
+  node->contents = gi.PointContents(position);
+
+  G_Ai_Node_InvalidateGrid();
+  G_Ai_Node_GraphChanged();
+}
+
+/**
+ * @brief Frees the node grid.
+ */
+static void G_Ai_Node_FreeGrid(void) {
+
+  g_free(g_ai_node_grid.cells);
+  g_free(g_ai_node_grid.nodes);
+
+  if (g_ai_node_grid.candidates) {
+    g_array_free(g_ai_node_grid.candidates, true);
+  }
+
+  memset(&g_ai_node_grid, 0, sizeof(g_ai_node_grid));
+  g_ai_node_grid.dirty = true;
+}
+
+/**
+ * @brief Rebuilds the node grid, if nodes have changed since it was last built.
+ */
+static void G_Ai_Node_UpdateGrid(void) {
+
+  if (!g_ai_node_grid.dirty) {
+    return;
+  }
+
+  g_ai_node_grid.dirty = false;
+
+  const guint count = G_Ai_Node_Count();
+  if (!count) {
+    g_ai_node_grid.width = g_ai_node_grid.height = 0;
+    return;
+  }
+
+  float maxs_x = -FLT_MAX, maxs_y = -FLT_MAX;
+  g_ai_node_grid.mins_x = g_ai_node_grid.mins_y = FLT_MAX;
+
+  for (guint i = 0; i < count; i++) {
+    const ai_node_t *node = &g_array_index(g_ai_nodes, ai_node_t, i);
+
+    g_ai_node_grid.mins_x = Minf(g_ai_node_grid.mins_x, node->position.x);
+    g_ai_node_grid.mins_y = Minf(g_ai_node_grid.mins_y, node->position.y);
+    maxs_x = Maxf(maxs_x, node->position.x);
+    maxs_y = Maxf(maxs_y, node->position.y);
+  }
+
+  g_ai_node_grid.width = (int32_t) ((maxs_x - g_ai_node_grid.mins_x) / AI_NODE_GRID_CELL_SIZE) + 1;
+  g_ai_node_grid.height = (int32_t) ((maxs_y - g_ai_node_grid.mins_y) / AI_NODE_GRID_CELL_SIZE) + 1;
+
+  const int32_t num_cells = g_ai_node_grid.width * g_ai_node_grid.height;
+
+  g_ai_node_grid.cells = g_renew(int32_t, g_ai_node_grid.cells, num_cells + 1);
+  g_ai_node_grid.nodes = g_renew(ai_node_id_t, g_ai_node_grid.nodes, count);
+
+  memset(g_ai_node_grid.cells, 0, (num_cells + 1) * sizeof(int32_t));
+
+  // count the nodes in each cell, then convert the counts to offsets and scatter the nodes
+
+  for (guint i = 0; i < count; i++) {
+    const ai_node_t *node = &g_array_index(g_ai_nodes, ai_node_t, i);
+
+    const int32_t x = (int32_t) ((node->position.x - g_ai_node_grid.mins_x) / AI_NODE_GRID_CELL_SIZE);
+    const int32_t y = (int32_t) ((node->position.y - g_ai_node_grid.mins_y) / AI_NODE_GRID_CELL_SIZE);
+
+    g_ai_node_grid.cells[y * g_ai_node_grid.width + x + 1]++;
+  }
+
+  for (int32_t i = 0; i < num_cells; i++) {
+    g_ai_node_grid.cells[i + 1] += g_ai_node_grid.cells[i];
+  }
+
+  int32_t *offsets = g_new(int32_t, num_cells);
+  memcpy(offsets, g_ai_node_grid.cells, num_cells * sizeof(int32_t));
+
+  for (guint i = 0; i < count; i++) {
+    const ai_node_t *node = &g_array_index(g_ai_nodes, ai_node_t, i);
+
+    const int32_t x = (int32_t) ((node->position.x - g_ai_node_grid.mins_x) / AI_NODE_GRID_CELL_SIZE);
+    const int32_t y = (int32_t) ((node->position.y - g_ai_node_grid.mins_y) / AI_NODE_GRID_CELL_SIZE);
+
+    g_ai_node_grid.nodes[offsets[y * g_ai_node_grid.width + x]++] = i;
+  }
+
+  g_free(offsets);
+}
+
+/**
+ * @brief Appends the nodes of the specified grid cell within `max_dist` to the candidates.
+ */
+static void G_Ai_Node_GatherCell(const vec3_t position, int32_t x, int32_t y, float max_dist, bool prefer_level) {
+
+  if (x < 0 || x >= g_ai_node_grid.width || y < 0 || y >= g_ai_node_grid.height) {
+    return;
+  }
+
+  const int32_t cell = y * g_ai_node_grid.width + x;
+
+  for (int32_t i = g_ai_node_grid.cells[cell]; i < g_ai_node_grid.cells[cell + 1]; i++) {
+    const ai_node_id_t id = g_ai_node_grid.nodes[i];
+    const ai_node_t *node = &g_array_index(g_ai_nodes, ai_node_t, id);
+
+    vec3_t dir = Vec3_Subtract(position, node->position);
+    // weigh the Z axis more heavily
+    if (prefer_level && !(node->contents & CONTENTS_MASK_LIQUID)) {
+      dir.z *= 4.0f;
+    }
+
+    const float dist = Vec3_LengthSquared(dir);
+    if (dist < max_dist) {
+      g_array_append_val(g_ai_node_grid.candidates, ((ai_node_candidate_t) {
+        .id = id,
+        .dist = dist
+      }));
+    }
+  }
+}
+
+/**
+ * @brief GCompareFunc for sorting candidates by distance, then by id.
  */
-static inline ai_node_id_t G_Ai_Node_Index(const ai_node_t *node) {
-  return node - (ai_node_t *) g_ai_nodes->data;
+static gint G_Ai_Node_CandidateCmp(gconstpointer a, gconstpointer b) {
+
+  const ai_node_candidate_t *ca = a, *cb = b;
+
+  if (ca->dist != cb->dist) {
+    return ca->dist < cb->dist ? -1 : 1;
+  }
+
+  return (ca->id > cb->id) - (ca->id < cb->id);
 }
 
 /**
@@ -113,27 +310,75 @@ guint G_Ai_Node_Count(void) {
  */
 ai_node_id_t G_Ai_Node_FindClosest(const vec3_t position, const float max_distance, const bool only_visible, const bool prefer_level) {
 
-  if (!g_ai_nodes)
+  if (!g_ai_nodes) {
+    return AI_NODE_INVALID;
+  }
+
+  G_Ai_Node_UpdateGrid();
+
+  if (!g_ai_node_grid.width) {
     return AI_NODE_INVALID;
+  }
+
+  if (!g_ai_node_grid.candidates) {
+    g_ai_node_grid.candidates = g_array_new(false, false, sizeof(ai_node_candidate_t));
+  }
+
+  GArray *candidates = g_ai_node_grid.candidates;
+  g_array_set_size(candidates, 0);
+
+  const float max_dist = max_distance * max_distance;
+
+  const int32_t cx = (int32_t) floorf((position.x - g_ai_node_grid.mins_x) / AI_NODE_GRID_CELL_SIZE);
+  const int32_t cy = (int32_t) floorf((position.y - g_ai_node_grid.mins_y) / AI_NODE_GRID_CELL_SIZE);
+
+  // visit rings of cells outward from the position; nodes in ring r + 1 are at least
+  // r cells away horizontally, so any candidate nearer than that can be resolved now
 
   ai_node_id_t closest = AI_NODE_INVALID;
-  float closest_dist = 0;
-  const float dist_squared = max_distance * max_distance;
 
-  for (guint i = 0; i < g_ai_nodes->len; i++) {
-    const ai_node_t *node = &g_array_index(g_ai_nodes, ai_node_t, i);
+  for (int32_t r = 0; closest == AI_NODE_INVALID; r++) {
 
-    vec3_t dir = Vec3_Subtract(position, node->position);
-    // weigh the Z axis more heavily
-    if (prefer_level && !(gi.PointContents(node->position) & CONTENTS_MASK_LIQUID)) {
-      dir.z *= 4.0f;
+    if (r == 0) {
+      G_Ai_Node_GatherCell(position, cx, cy, max_dist, prefer_level);
+    } else {
+      for (int32_t x = cx - r; x <= cx + r; x++) {
+        G_Ai_Node_GatherCell(position, x, cy - r, max_dist, prefer_level);
+        G_Ai_Node_GatherCell(position, x, cy + r, max_dist, prefer_level);
+      }
+      for (int32_t y = cy - r + 1; y <= cy + r - 1; y++) {
+        G_Ai_Node_GatherCell(position, cx - r, y, max_dist, prefer_level);
+        G_Ai_Node_GatherCell(position, cx + r, y, max_dist, prefer_level);
+      }
     }
-    const float dist = Vec3_LengthSquared(dir);
 
-    if (dist < dist_squared && (closest == AI_NODE_INVALID || dist < closest_dist) && (!only_visible || G_Ai_Node_Visible(position, i))) {
-      closest = i;
-      closest_dist = dist;
+    const float bound = (r * AI_NODE_GRID_CELL_SIZE) * (r * AI_NODE_GRID_CELL_SIZE);
+
+    const bool last = bound >= max_dist ||
+                      (cx - r <= 0 && cx + r >= g_ai_node_grid.width - 1 &&
+                       cy - r <= 0 && cy + r >= g_ai_node_grid.height - 1);
+
+    g_array_sort(candidates, G_Ai_Node_CandidateCmp);
+
+    guint i;
+    for (i = 0; i < candidates->len; i++) {
+      const ai_node_candidate_t *c = &g_array_index(candidates, ai_node_candidate_t, i);
+
+      if (!last && c->dist >= bound) {
+        break;
+      }
+
+      if (!only_visible || G_Ai_Node_Visible(position, c->id)) {
+        closest = c->id;
+        break;
+      }
     }
+
+    if (last) {
+      break;
+    }
+
+    g_array_remove_range(candidates, 0, i);
   }
 
   return closest;
@@ -154,9 +399,12 @@ ai_node_id_t G_Ai_Node_Create(const vec3_t position) {
   }
 
   g_ai_nodes = g_array_append_val(g_ai_nodes, (ai_node_t) {
-    .position = position
+    .position = position,
+    .contents = gi.PointContents(position)
   });
 
+  G_Ai_Node_InvalidateGrid();
+
   G_Ai_Debug("Dropped new node %d\n", g_ai_nodes->len - 1);
 
   return g_ai_nodes->len - 1;
@@ -213,6 +461,8 @@ void G_Ai_Node_Link(const ai_node_id_t a, const ai_node_id_t b, const float cost
     .cost = cost
   }, 1);
 
+  G_Ai_Node_GraphChanged();
+
   G_Ai_Debug("Connected %d -> %d\n", a, b);
 }
 
@@ -236,6 +486,9 @@ static inline void G_Ai_Node_LinkDefault(const ai_node_id_t a, const ai_node_id_
  * @brief Removes the bidirectional link between two nodes.
  */
 static void G_Ai_Node_Unlink(const ai_node_id_t a, const ai_node_id_t b) {
+
+  G_Ai_Node_GraphChanged();
+
   {
     ai_node_t *node_a = &g_array_index(g_ai_nodes, ai_node_t, a);
 
@@ -332,6 +585,9 @@ void G_Ai_Node_Destroy(const ai_node_id_t id) {
   G_Ai_Node_UnlinkAll(id);
   g_ai_nodes = g_array_remove_index(g_ai_nodes, id);
 
+  G_Ai_Node_InvalidateGrid();
+  G_Ai_Node_GraphChanged();
+
   if (!g_ai_nodes->len) {
     g_array_free(g_ai_nodes, true);
     g_ai_nodes = NULL;
@@ -366,6 +622,8 @@ vec3_t G_Ai_Node_GetPosition(const ai_node_id_t node) {
  */
 static void G_Ai_Node_UpdateCosts(const ai_node_id_t id) {
 
+  G_Ai_Node_GraphChanged();
+
   for (guint i = 0; i < g_ai_nodes->len; i++) {
     const ai_node_t *node = &g_array_index(g_ai_nodes, ai_node_t, i);
 
@@ -626,11 +884,11 @@ void G_Ai_Node_PlayerRoam(g_client_t *cl, const pm_cmd_t *cmd) {
   } else if (allow_adjustments && ent->move_node) {
     if (g_ai_player_roam.last_nodes[0] != AI_NODE_INVALID) {
       ai_node_t *node = &g_array_index(g_ai_nodes, ai_node_t, g_ai_player_roam.last_nodes[0]);
-      node->position = ent->s.origin;
+      G_Ai_Node_SetPosition(node, ent->s.origin);
 
       if (cmd->up < 0) {
         const cm_trace_t tr = gi.Trace(node->position, Vec3_Subtract(node->position, Vec3(0.f, 0.f, MAX_WORLD_COORD)), PM_BOUNDS, ent, CONTENTS_MASK_SOLID);
-        node->position = tr.end;
+        G_Ai_Node_SetPosition(node, tr.end);
       }
 
       // recalculate links
@@ -973,6 +1231,7 @@ void G_Ai_InitNodes(void) {
     ai_node_t *node = &g_array_index(g_ai_nodes, ai_node_t, i);
 
     gi.ReadFile(file, &node->position, sizeof(node->position), 1);
+    node->contents = gi.PointContents(node->position);
 
     guint num_links;
   
@@ -993,6 +1252,9 @@ void G_Ai_InitNodes(void) {
   gi.CloseFile(file);
   gi.Print("  Loaded %u nodes with %u total links.\n", num_nodes, total_links);
 
+  G_Ai_Node_InvalidateGrid();
+  G_Ai_Node_GraphChanged();
+
   g_ai_player_roam.file_nodes = num_nodes;
   g_ai_player_roam.file_links = 0;
 
@@ -1132,6 +1394,288 @@ void G_Ai_DeleteNodes(void) {
 
     g_array_set_size(g_ai_nodes, 0);
   }
+
+  G_Ai_Node_InvalidateGrid();
+  G_Ai_Node_GraphChanged();
+}
+
+/**
+ * @brief Reusable path finding state, indexed by `ai_node_id_t`. Rather than clearing the
+ * arrays for each search, nodes are stamped with the search generation when first reached.
+ */
+typedef struct {
+
+  /**
+   * @brief The open set, prioritized by estimated total path cost.
+   */
+  heap_t open;
+
+  /**
+   * @brief The best known cost from the start node to each node.
+   */
+  float *costs;
+
+  /**
+   * @brief The node preceding each node along its best known path.
+   */
+  ai_node_id_t *came_from;
+
+  /**
+   * @brief The generation at which each node was last reached.
+   */
+  uint32_t *generations;
+
+  /**
+   * @brief The current search generation.
+   */
+  uint32_t generation;
+
+  /**
+   * @brief The number of nodes the arrays can accommodate.
+   */
+  guint capacity;
+} ai_path_scratch_t;
+
+/**
+ * @brief The scratch state of every thread which has searched for a path, so that it may
+ * be freed from the main thread. Each thread holds its own in thread-local storage, and
+ * discards it when the epoch has advanced.
+ */
+static struct {
+  GMutex lock;
+  GPtrArray *scratches;
+  gint epoch;
+} g_ai_path_scratches;
+
+static _Thread_local ai_path_scratch_t *g_ai_path_scratch;
+static _Thread_local gint g_ai_path_scratch_epoch;
+
+/**
+ * @brief Prepares the calling thread's path finding scratch state for a new search.
+ */
+static ai_path_scratch_t *G_Ai_PathScratch(void) {
+
+  const gint epoch = g_atomic_int_get(&g_ai_path_scratches.epoch);
+
+  if (g_ai_path_scratch == NULL || g_ai_path_scratch_epoch != epoch) {
+    g_ai_path_scratch = g_new0(ai_path_scratch_t, 1);
+    g_ai_path_scratch_epoch = epoch;
+
+    g_mutex_lock(&g_ai_path_scratches.lock);
+
+    if (g_ai_path_scratches.scratches == NULL) {
+      g_ai_path_scratches.scratches = g_ptr_array_new();
+    }
+
+    g_ptr_array_add(g_ai_path_scratches.scratches, g_ai_path_scratch);
+
+    g_mutex_unlock(&g_ai_path_scratches.lock);
+  }
+
+  ai_path_scratch_t *scratch = g_ai_path_scratch;
+
+  const guint count = G_Ai_Node_Count();
+
+  if (scratch->capacity < count) {
+    Heap_Reserve(&scratch->open, (int32_t) count);
+
+    scratch->costs = g_renew(float, scratch->costs, count);
+    scratch->came_from = g_renew(ai_node_id_t, scratch->came_from, count);
+    scratch->generations = g_renew(uint32_t, scratch->generations, count);
+
+    memset(scratch->generations + scratch->capacity, 0, (count - scratch->capacity) * sizeof(uint32_t));
+    scratch->capacity = count;
+  }
+
+  scratch->generation++;
+
+  if (scratch->generation == 0) { // wrapped, so reset all stamps
+    memset(scratch->generations, 0, scratch->capacity * sizeof(uint32_t));
+    scratch->generation = 1;
+  }
+
+  return scratch;
+}
+
+/**
+ * @brief Frees the path finding scratch state of all threads. No searches may be in
+ * progress.
+ */
+static void G_Ai_FreePathScratch(void) {
+
+  g_mutex_lock(&g_ai_path_scratches.lock);
+
+  if (g_ai_path_scratches.scratches) {
+    for (guint i = 0; i < g_ai_path_scratches.scratches->len; i++) {
+      ai_path_scratch_t *scratch = g_ptr_array_index(g_ai_path_scratches.scratches, i);
+
+      Heap_Free(&scratch->open);
+
+      g_free(scratch->costs);
+      g_free(scratch->came_from);
+      g_free(scratch->generations);
+
+      g_free(scratch);
+    }
+
+    g_ptr_array_free(g_ai_path_scratches.scratches, true);
+    g_ai_path_scratches.scratches = NULL;
+  }
+
+  // each thread will allocate new scratch state on its next search
+  g_atomic_int_inc(&g_ai_path_scratches.epoch);
+
+  g_mutex_unlock(&g_ai_path_scratches.lock);
+}
+
+#define AI_PATH_CACHE_TTL 1000
+
+/**
+ * @brief A cached path search result, keyed by its start and end nodes, heuristic and the
+ * fall damage the searching client may take (which limits the drops it may take).
+ */
+typedef struct {
+  ai_node_id_t start, end;
+  G_Ai_NodeCostFunc heuristic;
+  int32_t max_fall_damage;
+
+  /**
+   * @brief The path, or NULL if no path was found.
+   */
+  GArray *path;
+
+  /**
+   * @brief The path length.
+   */
+  float length;
+
+  /**
+   * @brief The node generation at which the path was found.
+   */
+  uint32_t generation;
+
+  /**
+   * @brief The level time at which the path was found. Paths expire after `AI_PATH_CACHE_TTL`,
+   * because platforms may have moved.
+   */
+  uint32_t time;
+
+  /**
+   * @brief This entry's link in the LRU queue.
+   */
+  GList *link;
+} ai_path_cache_entry_t;
+
+/**
+ * @brief A least recently used cache of path search results.
+ */
+static struct {
+  GHashTable *entries;
+  GQueue lru;
+
+  uint32_t hits, misses, stale;
+} g_ai_path_cache;
+
+/**
+ * @brief GHashFunc for path cache entries.
+ */
+static guint G_Ai_PathCache_Hash(gconstpointer key) {
+  const ai_path_cache_entry_t *e = key;
+
+  guint hash = e->start * 31 + e->end;
+  hash = hash * 31 + (guint) e->max_fall_damage;
+  hash = hash * 31 + g_direct_hash(e->heuristic);
+
+  return hash;
+}
+
+/**
+ * @brief GEqualFunc for path cache entries.
+ */
+static gboolean G_Ai_PathCache_Equal(gconstpointer a, gconstpointer b) {
+  const ai_path_cache_entry_t *ea = a, *eb = b;
+
+  return ea->start == eb->start && ea->end == eb->end && ea->heuristic == eb->heuristic && ea->max_fall_damage == eb->max_fall_damage;
+}
+
+/**
+ * @brief GDestroyNotify for path cache entries.
+ */
+static void G_Ai_PathCache_Free(gpointer data) {
+  ai_path_cache_entry_t *e = data;
+
+  if (e->path) {
+    g_array_free(e->path, true);
+  }
+
+  g_free(e);
+}
+
+/**
+ * @brief Removes the specified entry from the path cache.
+ */
+static void G_Ai_PathCache_Remove(ai_path_cache_entry_t *e) {
+
+  g_queue_delete_link(&g_ai_path_cache.lru, e->link);
+  g_hash_table_remove(g_ai_path_cache.entries, e);
+}
+
+/**
+ * @brief Empties the path cache, retaining its statistics.
+ */
+static void G_Ai_PathCache_Clear(void) {
+
+  if (g_ai_path_cache.entries) {
+    g_hash_table_remove_all(g_ai_path_cache.entries);
+  }
+
+  g_queue_clear(&g_ai_path_cache.lru);
+}
+
+/**
+ * @brief Frees the path cache.
+ */
+static void G_Ai_PathCache_Shutdown(void) {
+
+  G_Ai_PathCache_Clear();
+
+  if (g_ai_path_cache.entries) {
+    g_hash_table_destroy(g_ai_path_cache.entries);
+  }
+
+  memset(&g_ai_path_cache, 0, sizeof(g_ai_path_cache));
+}
+
+/**
+ * @return A copy of the cached path, which the caller owns.
+ */
+static GArray *G_Ai_PathCache_Copy(const ai_path_cache_entry_t *e, float *length) {
+
+  if (length) {
+    *length = e->length;
+  }
+
+  if (!e->path) {
+    return NULL;
+  }
+
+  GArray *path = g_array_sized_new(false, false, sizeof(ai_node_id_t), e->path->len);
+  return g_array_append_vals(path, e->path->data, e->path->len);
+}
+
+/**
+ * @brief Prints path cache statistics.
+ */
+void G_Ai_PathCache_Stats(void) {
+
+  const uint32_t lookups = g_ai_path_cache.hits + g_ai_path_cache.misses;
+
+  gi.Print("Path cache: %u entries, %u hits, %u misses (%u stale), %.1f%% hit ratio\n",
+           g_ai_path_cache.lru.length,
+           g_ai_path_cache.hits,
+           g_ai_path_cache.misses,
+           g_ai_path_cache.stale,
+           lookups ? 100.f * g_ai_path_cache.hits / lookups : 0.f);
 }
 
 /**
@@ -1151,18 +1695,18 @@ void G_Ai_ShutdownNodes(void) {
     g_array_free(g_ai_nodes, true);
     g_ai_nodes = NULL;
   }
-}
 
-typedef struct {
-  ai_node_id_t id;
-  float priority;
-} ai_node_priority_t;
+  G_Ai_Node_FreeGrid();
+  G_Ai_FreePathScratch();
+  G_Ai_PathCache_Shutdown();
+}
 
 #define AI_MAX_DROP_HEIGHT 512.f
 #define AI_DROP_PENALTY_START 128.f
 #define AI_DROP_PENALTY_SCALE 0.5f
 #define AI_DROP_HEALTH_MARGIN 8.f
 #define AI_DROP_DAMAGE_PENALTY_SCALE 6.f
+#define AI_DROP_DAMAGE_STEP 10
 
 static inline float G_Ai_LinkCost(const ai_node_id_t a, const ai_node_id_t b) {
   const ai_node_t *node = &g_array_index(g_ai_nodes, ai_node_t, a);
@@ -1231,7 +1775,71 @@ static float G_Ai_EstimatedFallDamage(const float drop, const int32_t gravity, c
   return Maxf(0.f, damage);
 }
 
-GArray *G_Ai_Node_FindPath(const g_client_t *cl, const ai_node_id_t start, const ai_node_id_t end, const G_Ai_NodeCostFunc heuristic, float *length) {
+/**
+ * @return The fall damage below which drops are permitted for the specified client, rounded
+ * down to a multiple of `AI_DROP_DAMAGE_STEP` so that small changes in health do not change
+ * the result. `INT32_MAX` permits every drop, and -1 ignores fall damage altogether.
+ */
+static int32_t G_Ai_MaxFallDamage(const g_client_t *cl) {
+
+  if (!cl || !cl->entity) {
+    return -1;
+  }
+
+  const float tolerable = cl->entity->health - AI_DROP_HEALTH_MARGIN;
+
+  if (tolerable > G_Ai_EstimatedFallDamage(AI_MAX_DROP_HEIGHT, g_level.gravity, 0)) {
+    return INT32_MAX;
+  }
+
+  return Maxi(0, (int32_t) floorf(tolerable / AI_DROP_DAMAGE_STEP) * AI_DROP_DAMAGE_STEP);
+}
+
+/**
+ * @brief Returns the cost of traversing the link from node `a`, including any drop penalty, or
+ * -1 if hazards or the drop height make the link impassable. Platforms and the fall damage that
+ * a particular client can sustain are not considered.
+ */
+float G_Ai_Node_TraversalCost(const ai_node_id_t a, const ai_link_t *link) {
+
+  const ai_node_t *node = &g_array_index(g_ai_nodes, ai_node_t, a);
+  const ai_node_t *link_node = &g_array_index(g_ai_nodes, ai_node_t, link->id);
+
+  const bool from_hazard = (node->contents & (CONTENTS_LAVA | CONTENTS_SLIME)) != 0;
+  const bool to_hazard = (link_node->contents & (CONTENTS_LAVA | CONTENTS_SLIME)) != 0;
+
+  if (from_hazard && to_hazard) {
+    return -1.f;
+  }
+
+  if (!from_hazard && G_Ai_LinkPassesHazard(node->position, link_node->position)) {
+    return -1.f;
+  }
+
+  const float drop = node->position.z - link_node->position.z;
+
+  if (drop > AI_MAX_DROP_HEIGHT) {
+    return -1.f;
+  }
+
+  if (drop > 0.f && to_hazard) {
+    return -1.f;
+  }
+
+  float drop_penalty = 0.f;
+  if (drop > AI_DROP_PENALTY_START) {
+    drop_penalty = (drop - AI_DROP_PENALTY_START) * AI_DROP_PENALTY_SCALE;
+  }
+
+  return link->cost + drop_penalty;
+}
+
+/**
+ * @brief Searches for a path from `start` to `end`, returning NULL if none exists. Drops
+ * whose fall damage reaches `max_fall_damage` are avoided, and others are penalized.
+ * @see G_Ai_MaxFallDamage
+ */
+static GArray *G_Ai_Node_SearchPath(const int32_t max_fall_damage, const ai_node_id_t start, const ai_node_id_t end, const G_Ai_NodeCostFunc heuristic, float *length) {
   
   if (length) {
     *length = 0;
@@ -1254,45 +1862,36 @@ GArray *G_Ai_Node_FindPath(const g_client_t *cl, const ai_node_id_t start, const
     }
   });
 
-  GHashTable *costs_started = g_hash_table_new(g_direct_hash, g_direct_equal);
-  GArray *queue = g_array_new(false, false, sizeof(ai_node_priority_t));
+  ai_path_scratch_t *scratch = G_Ai_PathScratch();
+  guint num_visited = 1;
   bool finished = false;
 
-  queue = g_array_append_vals(queue, &(ai_node_priority_t) {
-    .id = start,
-    .priority = 0
-  }, 1);
+  scratch->costs[start] = 0.f;
+  scratch->came_from[start] = AI_NODE_INVALID;
+  scratch->generations[start] = scratch->generation;
 
-  ai_node_t *start_node = &g_array_index(g_ai_nodes, ai_node_t, start);
-  start_node->cost = 0;
-  g_hash_table_add(costs_started, start_node);
+  Heap_Push(&scratch->open, start, 0.f);
 
-  while (queue->len) {
-    
-    ai_node_priority_t current = g_array_index(queue, ai_node_priority_t, queue->len - 1);
-    queue = g_array_remove_index_fast(queue, queue->len - 1);
+  while (!Heap_IsEmpty(&scratch->open)) {
 
-    if (current.id == end) {
+    const ai_node_id_t current = (ai_node_id_t) Heap_Pop(&scratch->open, NULL);
+
+    if (current == end) {
       finished = true;
       break;
     }
 
-    ai_node_t *node = &g_array_index(g_ai_nodes, ai_node_t, current.id);
+    const ai_node_t *node = &g_array_index(g_ai_nodes, ai_node_t, current);
 
     if (!node->links || !node->links->len) {
       continue;
     }
 
-    // Compute once per expanded node rather than once per link.
-    const int32_t node_contents = gi.PointContents(node->position);
-    const bool from_hazard = (node_contents & (CONTENTS_LAVA | CONTENTS_SLIME)) != 0;
+    const float node_cost = scratch->costs[current];
 
     for (guint i = 0; i < node->links->len; i++) {
       const ai_link_t *link = &g_array_index(node->links, ai_link_t, i);
-      ai_node_t *link_node = &g_array_index(g_ai_nodes, ai_node_t, link->id);
-      const float drop = node->position.z - link_node->position.z;
-      const int32_t link_contents = gi.PointContents(link_node->position);
-      const bool to_hazard = (link_contents & (CONTENTS_LAVA | CONTENTS_SLIME)) != 0;
+      const ai_node_t *link_node = &g_array_index(g_ai_nodes, ai_node_t, link->id);
 
       // Check platform accessibility using the pre-collected list.
       if (platforms) {
@@ -1313,115 +1912,66 @@ GArray *G_Ai_Node_FindPath(const g_client_t *cl, const ai_node_id_t start, const
         }
       }
 
-      if (from_hazard && to_hazard) {
-        continue;
-      }
-
-      if (!from_hazard && G_Ai_LinkPassesHazard(node->position, link_node->position)) {
-        continue;
-      }
-
-      if (drop > AI_MAX_DROP_HEIGHT) {
-        continue;
-      }
-
-      if (drop > 0.f && (link_contents & (CONTENTS_LAVA | CONTENTS_SLIME))) {
+      const float link_cost = G_Ai_Node_TraversalCost(current, link);
+      if (link_cost < 0.f) {
         continue;
       }
 
       float drop_penalty = 0.f;
-      if (drop > AI_DROP_PENALTY_START) {
-        drop_penalty = (drop - AI_DROP_PENALTY_START) * AI_DROP_PENALTY_SCALE;
-      }
 
-      if (cl && cl->entity) {
-        const int32_t water_level = (link_contents & CONTENTS_WATER) ? 1 : 0;
+      if (max_fall_damage >= 0) {
+        const float drop = node->position.z - link_node->position.z;
+        const int32_t water_level = (link_node->contents & CONTENTS_WATER) ? 1 : 0;
         const float estimated_damage = G_Ai_EstimatedFallDamage(drop, g_level.gravity, water_level);
 
-        if (estimated_damage + AI_DROP_HEALTH_MARGIN >= cl->entity->health) {
+        if (estimated_damage >= (float) max_fall_damage) {
           continue;
         }
 
         drop_penalty += estimated_damage * AI_DROP_DAMAGE_PENALTY_SCALE;
       }
 
-      const float new_cost = node->cost + link->cost + drop_penalty;
-
-      if (!g_hash_table_lookup(costs_started, link_node) || new_cost < link_node->cost) {
-
-        g_hash_table_add(costs_started, link_node);
+      const float new_cost = node_cost + link_cost + drop_penalty;
 
-        link_node->cost = new_cost;
-        const float priority = new_cost + heuristic(link->id, end);
+      if (scratch->generations[link->id] != scratch->generation) {
+        scratch->generations[link->id] = scratch->generation;
+        num_visited++;
+      } else if (new_cost >= scratch->costs[link->id]) {
+        continue;
+      }
 
-        if (!queue->len) {
-          queue = g_array_insert_vals(queue, 0, &(ai_node_priority_t) {
-            .id = link->id,
-            .priority = priority
-          }, 1);
-        } else {
-          for (gint x = queue->len - 1; ; x--) {
-
-            if (priority < g_array_index(queue, ai_node_priority_t, x).priority) {
-              queue = g_array_insert_vals(queue, x + 1, &(ai_node_priority_t) {
-                .id = link->id,
-                .priority = priority
-              }, 1);
-              break;
-            }
+      scratch->costs[link->id] = new_cost;
+      scratch->came_from[link->id] = current;
 
-            if (x == 0) {
-              queue = g_array_insert_vals(queue, 0, &(ai_node_priority_t) {
-                .id = link->id,
-                .priority = priority
-              }, 1);
-              break;
-            }
-          }
-        }
-
-        link_node->came_from = G_Ai_Node_Index(node);
-      }
+      Heap_Push(&scratch->open, link->id, new_cost + heuristic(link->id, end));
     }
   }
 
+  Heap_Clear(&scratch->open);
+
   GArray *return_path = NULL;
 
   if (finished) {
-    G_Ai_Debug("Found path from %u -> %u with %u nodes visited\n", start, end, g_hash_table_size(costs_started));
-
-    return_path = g_array_sized_new(false, false, sizeof(ai_node_id_t), g_hash_table_size(costs_started));
+    G_Ai_Debug("Found path from %u -> %u with %u nodes visited\n", start, end, num_visited);
 
-    return_path = g_array_prepend_val(return_path, end);
+    return_path = g_array_new(false, false, sizeof(ai_node_id_t));
 
-    if (start != end) {
-      ai_node_id_t from = end;
-
-      for (;;) {
-        const ai_node_t *from_node = &g_array_index(g_ai_nodes, ai_node_t, from);
-        from = from_node->came_from;
-        return_path = g_array_prepend_val(return_path, from);
-
-        if (from == start) {
-          break;
-        }
-      }
+    for (ai_node_id_t from = end; from != AI_NODE_INVALID; from = scratch->came_from[from]) {
+      return_path = g_array_prepend_val(return_path, from);
+    }
 
-      if (length) {
-        for (guint i = 0; i < return_path->len - 1; i++) {
-          const ai_node_id_t a = g_array_index(return_path, ai_node_id_t, i);
-          const ai_node_id_t b = g_array_index(return_path, ai_node_id_t, i + 1);
+    if (length) {
+      for (guint i = 0; i < return_path->len - 1; i++) {
+        const ai_node_id_t a = g_array_index(return_path, ai_node_id_t, i);
+        const ai_node_id_t b = g_array_index(return_path, ai_node_id_t, i + 1);
 
-          *length += G_Ai_LinkCost(a, b);
-        }
+        *length += G_Ai_LinkCost(a, b);
       }
     }
   } else {
     G_Ai_Debug("Couldn't find path from %u -> %u\n", start, end);
   }
 
-  g_array_free(queue, true);
-  g_hash_table_destroy(costs_started);
   if (platforms) {
     g_array_free(platforms, true);
   }
@@ -1429,6 +1979,82 @@ GArray *G_Ai_Node_FindPath(const g_client_t *cl, const ai_node_id_t start, const
   return return_path;
 }
 
+/**
+ * @brief Finds a path from `start` to `end`, consulting the path cache first. The caller owns
+ * the returned path.
+ */
+GArray *G_Ai_Node_FindPath(const g_client_t *cl, const ai_node_id_t start, const ai_node_id_t end, const G_Ai_NodeCostFunc heuristic, float *length) {
+
+  if (length) {
+    *length = 0;
+  }
+
+  if (start == AI_NODE_INVALID || end == AI_NODE_INVALID) {
+    return NULL;
+  }
+
+  if (g_ai_path_cache_size->integer <= 0) {
+    if (g_ai_path_cache.entries) {
+      G_Ai_PathCache_Clear();
+    }
+    return G_Ai_Node_SearchPath(G_Ai_MaxFallDamage(cl), start, end, heuristic, length);
+  }
+
+  if (!g_ai_path_cache.entries) {
+    g_ai_path_cache.entries = g_hash_table_new_full(G_Ai_PathCache_Hash, G_Ai_PathCache_Equal, G_Ai_PathCache_Free, NULL);
+  }
+
+  const ai_path_cache_entry_t key = {
+    .start = start,
+    .end = end,
+    .heuristic = heuristic,
+    .max_fall_damage = G_Ai_MaxFallDamage(cl)
+  };
+
+  ai_path_cache_entry_t *e = g_hash_table_lookup(g_ai_path_cache.entries, &key);
+  if (e) {
+    if (e->generation == g_ai_node_generation && g_level.time - e->time < AI_PATH_CACHE_TTL) {
+      g_ai_path_cache.hits++;
+
+      g_queue_unlink(&g_ai_path_cache.lru, e->link);
+      g_queue_push_head_link(&g_ai_path_cache.lru, e->link);
+
+      return G_Ai_PathCache_Copy(e, length);
+    }
+
+    g_ai_path_cache.stale++;
+    G_Ai_PathCache_Remove(e);
+  }
+
+  g_ai_path_cache.misses++;
+
+  float path_length = 0.f;
+  GArray *path = G_Ai_Node_SearchPath(key.max_fall_damage, start, end, heuristic, &path_length);
+
+  while (g_ai_path_cache.lru.length >= (guint) g_ai_path_cache_size->integer) {
+    G_Ai_PathCache_Remove(g_queue_peek_tail(&g_ai_path_cache.lru));
+  }
+
+  e = g_new(ai_path_cache_entry_t, 1);
+  *e = key;
+
+  e->path = path ? g_array_append_vals(g_array_sized_new(false, false, sizeof(ai_node_id_t), path->len), path->data, path->len) : NULL;
+  e->length = path_length;
+  e->generation = g_ai_node_generation;
+  e->time = g_level.time;
+
+  g_queue_push_head(&g_ai_path_cache.lru, e);
+  e->link = g_ai_path_cache.lru.head;
+
+  g_hash_table_add(g_ai_path_cache.entries, e);
+
+  if (length) {
+    *length = path_length;
+  }
+
+  return path;
+}
+
 void G_Ai_OffsetNodes_f(void) {
 
   vec3_t translate;
@@ -1451,7 +2077,7 @@ void G_Ai_OffsetNodes_f(void) {
 
   for (guint i = 0; i < g_ai_nodes->len; i++) {
     ai_node_t *node = &g_array_index(g_ai_nodes, ai_node_t, i);
-    node->position = Vec3_Add(node->position, translate);
+    G_Ai_Node_SetPosition(node, Vec3_Add(node->position, translate));
   }
 }
 
@@ -44,6 +44,8 @@ typedef struct {
 } ai_link_t;
 
 const GArray *G_Ai_Node_GetLinks(const ai_node_id_t a);
+float G_Ai_Node_TraversalCost(const ai_node_id_t a, const ai_link_t *link);
+uint32_t G_Ai_Node_Generation(void);
 vec3_t G_Ai_Node_GetPosition(const ai_node_id_t node);
 ai_node_id_t G_Ai_Node_FindClosest(const vec3_t position, const float max_distance, const bool only_visible, const bool prefer_level);
 bool G_Ai_Node_CanPathTo(const vec3_t position);
@@ -81,6 +83,7 @@ static inline float G_Ai_Node_Cost(const ai_node_id_t a, const ai_node_id_t b) {
 
 GArray *G_Ai_Node_FindPath(const g_client_t *cl, const ai_node_id_t start, const ai_node_id_t end, const G_Ai_NodeCostFunc heuristic, float *length);
 GArray *G_Ai_Node_TestPath(void);
+void G_Ai_PathCache_Stats(void);
 bool G_Ai_DropItemLikeNode(g_entity_t *ent);
 
 #endif
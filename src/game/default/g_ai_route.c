@@ -0,0 +1,378 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "g_local.h"
+
+#define AI_ROUTE_MAGIC ('Q' | '2' << 8 | 'N' << 16 | 'R' << 24)
+#define AI_ROUTE_VERSION 1
+
+/**
+ * @brief The maximum node count for which a route table is built; the table is quadratic.
+ */
+#define AI_ROUTE_MAX_NODES 4096
+
+/**
+ * @brief Distances are quantized to this many units.
+ */
+#define AI_ROUTE_DISTANCE_SCALE 8.f
+
+/**
+ * @brief The quantized distance marking an unreachable node.
+ */
+#define AI_ROUTE_UNREACHABLE UINT16_MAX
+
+#define AI_ROUTE_CHECKSUM_SIZE 16
+
+/**
+ * @brief The all-pairs path distance table for the current map's navigation graph.
+ */
+static struct {
+
+  /**
+   * @brief The node count when the table was built.
+   */
+  guint num_nodes;
+
+  /**
+   * @brief The quantized distances, in rows by source node.
+   */
+  uint16_t *distances;
+
+  /**
+   * @brief The node generation at which the table was loaded or built. If the nodes are
+   * edited afterwards, the table is no longer used.
+   */
+  uint32_t generation;
+} g_ai_route;
+
+/**
+ * @brief The navigation graph, flattened for use by the route table workers.
+ */
+typedef struct {
+  guint num_nodes;
+
+  /**
+   * @brief Offsets into `links` and `costs` for each node, with a trailing sentinel.
+   */
+  guint *first_link;
+  ai_node_id_t *links;
+  float *costs;
+
+  /**
+   * @brief The output distance table.
+   */
+  uint16_t *distances;
+
+  /**
+   * @brief The next source node to be processed by a worker.
+   */
+  gint next_source;
+} ai_route_build_t;
+
+/**
+ * @brief Computes an MD5 digest of the navigation graph, to validate the route table against.
+ */
+static void G_Ai_Route_Checksum(uint8_t *digest) {
+
+  GChecksum *md5 = g_checksum_new(G_CHECKSUM_MD5);
+
+  const guint num_nodes = G_Ai_Node_Count();
+  g_checksum_update(md5, (const guchar *) &num_nodes, sizeof(num_nodes));
+
+  for (ai_node_id_t i = 0; i < num_nodes; i++) {
+    const vec3_t position = G_Ai_Node_GetPosition(i);
+    g_checksum_update(md5, (const guchar *) &position, sizeof(position));
+
+    const GArray *links = G_Ai_Node_GetLinks(i);
+    if (links && links->len) {
+      g_checksum_update(md5, (const guchar *) links->data, links->len * sizeof(ai_link_t));
+    }
+  }
+
+  gsize len = AI_ROUTE_CHECKSUM_SIZE;
+  g_checksum_get_digest(md5, digest, &len);
+  g_checksum_free(md5);
+}
+
+/**
+ * @return True if a route table for the current navigation graph is loaded.
+ */
+bool G_Ai_Route_Available(void) {
+  return g_ai_route.distances && g_ai_route.generation == G_Ai_Node_Generation();
+}
+
+/**
+ * @return The path distance between the specified nodes, or `FLT_MAX` if no path exists.
+ * @remarks Use `G_Ai_Route_Available` to check that a route table is loaded first.
+ */
+float G_Ai_Route_Distance(const ai_node_id_t from, const ai_node_id_t to) {
+
+  if (from >= g_ai_route.num_nodes || to >= g_ai_route.num_nodes) {
+    return FLT_MAX;
+  }
+
+  const uint16_t dist = g_ai_route.distances[(size_t) from * g_ai_route.num_nodes + to];
+
+  if (dist == AI_ROUTE_UNREACHABLE) {
+    return FLT_MAX;
+  }
+
+  return dist * AI_ROUTE_DISTANCE_SCALE;
+}
+
+/**
+ * @brief Frees the route table.
+ */
+void G_Ai_Route_Free(void) {
+
+  g_free(g_ai_route.distances);
+
+  memset(&g_ai_route, 0, sizeof(g_ai_route));
+}
+
+/**
+ * @brief Route table worker: runs Dijkstra from each unclaimed source node in turn.
+ */
+static gpointer G_Ai_Route_Worker(gpointer data) {
+
+  ai_route_build_t *build = data;
+
+  heap_t open;
+  Heap_Init(&open, build->num_nodes);
+
+  float *dist = g_new(float, build->num_nodes);
+
+  while (true) {
+    const guint source = (guint) g_atomic_int_add(&build->next_source, 1);
+    if (source >= build->num_nodes) {
+      break;
+    }
+
+    for (guint i = 0; i < build->num_nodes; i++) {
+      dist[i] = FLT_MAX;
+    }
+
+    dist[source] = 0.f;
+    Heap_Push(&open, source, 0.f);
+
+    while (!Heap_IsEmpty(&open)) {
+      float d;
+      const ai_node_id_t node = (ai_node_id_t) Heap_Pop(&open, &d);
+
+      for (guint l = build->first_link[node]; l < build->first_link[node + 1]; l++) {
+        const ai_node_id_t link = build->links[l];
+        const float cost = d + build->costs[l];
+
+        if (cost < dist[link]) {
+          dist[link] = cost;
+          Heap_Push(&open, link, cost);
+        }
+      }
+    }
+
+    uint16_t *row = build->distances + (size_t) source * build->num_nodes;
+
+    for (guint i = 0; i < build->num_nodes; i++) {
+      if (dist[i] == FLT_MAX) {
+        row[i] = AI_ROUTE_UNREACHABLE;
+      } else {
+        row[i] = (uint16_t) Minf(ceilf(dist[i] / AI_ROUTE_DISTANCE_SCALE), AI_ROUTE_UNREACHABLE - 1);
+      }
+    }
+  }
+
+  g_free(dist);
+  Heap_Free(&open);
+
+  return NULL;
+}
+
+/**
+ * @brief Computes the route table for the current navigation graph and writes it alongside the
+ * map's .nav file.
+ */
+void G_Ai_Route_Build(void) {
+
+  const guint num_nodes = G_Ai_Node_Count();
+
+  if (!num_nodes) {
+    gi.Warn("No nodes to route.\n");
+    return;
+  }
+
+  if (num_nodes > AI_ROUTE_MAX_NODES) {
+    gi.Warn("Too many nodes to route (%u > %u).\n", num_nodes, AI_ROUTE_MAX_NODES);
+    return;
+  }
+
+  G_Ai_Route_Free();
+
+  const gint64 start = g_get_monotonic_time();
+
+  // flatten the graph on this thread, since traversal costs may trace
+
+  ai_route_build_t build = {
+    .num_nodes = num_nodes,
+    .first_link = g_new(guint, num_nodes + 1),
+    .distances = g_new(uint16_t, (size_t) num_nodes * num_nodes)
+  };
+
+  GArray *links = g_array_new(false, false, sizeof(ai_node_id_t));
+  GArray *costs = g_array_new(false, false, sizeof(float));
+
+  for (ai_node_id_t i = 0; i < num_nodes; i++) {
+    build.first_link[i] = links->len;
+
+    const GArray *node_links = G_Ai_Node_GetLinks(i);
+    if (!node_links) {
+      continue;
+    }
+
+    for (guint l = 0; l < node_links->len; l++) {
+      const ai_link_t *link = &g_array_index(node_links, ai_link_t, l);
+
+      const float cost = G_Ai_Node_TraversalCost(i, link);
+      if (cost < 0.f) {
+        continue;
+      }
+
+      g_array_append_val(links, link->id);
+      g_array_append_val(costs, cost);
+    }
+  }
+
+  build.first_link[num_nodes] = links->len;
+  build.links = (ai_node_id_t *) links->data;
+  build.costs = (float *) costs->data;
+
+  const guint num_threads = (guint) Maxi(1, Mini((int32_t) g_get_num_processors(), 32));
+  GThread *threads[32];
+
+  for (guint i = 0; i < num_threads; i++) {
+    threads[i] = g_thread_new("G_Ai_Route_Worker", G_Ai_Route_Worker, &build);
+  }
+
+  for (guint i = 0; i < num_threads; i++) {
+    g_thread_join(threads[i]);
+  }
+
+  g_array_free(links, true);
+  g_array_free(costs, true);
+  g_free(build.first_link);
+
+  g_ai_route.num_nodes = num_nodes;
+  g_ai_route.distances = build.distances;
+  g_ai_route.generation = G_Ai_Node_Generation();
+
+  char filename[MAX_OS_PATH];
+  g_snprintf(filename, sizeof(filename), "maps/%s.routes", g_level.name);
+
+  file_t *file = gi.OpenFileWrite(filename);
+  if (!file) {
+    gi.Warn("Failed to open %s for writing\n", filename);
+    return;
+  }
+
+  const int32_t magic = AI_ROUTE_MAGIC;
+  const int32_t version = AI_ROUTE_VERSION;
+
+  uint8_t checksum[AI_ROUTE_CHECKSUM_SIZE];
+  G_Ai_Route_Checksum(checksum);
+
+  gi.WriteFile(file, &magic, sizeof(magic), 1);
+  gi.WriteFile(file, &version, sizeof(version), 1);
+  gi.WriteFile(file, checksum, sizeof(checksum), 1);
+  gi.WriteFile(file, &num_nodes, sizeof(num_nodes), 1);
+  gi.WriteFile(file, g_ai_route.distances, sizeof(uint16_t), (size_t) num_nodes * num_nodes);
+
+  gi.CloseFile(file);
+
+  gi.Print("Routed %u nodes on %u threads in %" G_GINT64_FORMAT "ms, wrote %s.\n",
+           num_nodes, num_threads, (g_get_monotonic_time() - start) / 1000, gi.RealPath(filename));
+}
+
+/**
+ * @brief Loads the route table for the current map, if one exists and matches the loaded
+ * navigation graph.
+ */
+void G_Ai_Route_Load(void) {
+
+  G_Ai_Route_Free();
+
+  const guint num_nodes = G_Ai_Node_Count();
+  if (!num_nodes) {
+    return;
+  }
+
+  char filename[MAX_OS_PATH];
+  g_snprintf(filename, sizeof(filename), "maps/%s.routes", g_level.name);
+
+  if (!gi.FileExists(filename)) {
+    return;
+  }
+
+  file_t *file = gi.OpenFile(filename);
+
+  int32_t magic = 0, version = 0;
+  uint8_t checksum[AI_ROUTE_CHECKSUM_SIZE], expected[AI_ROUTE_CHECKSUM_SIZE];
+  guint file_nodes = 0;
+
+  if (gi.ReadFile(file, &magic, sizeof(magic), 1) != 1 ||
+      gi.ReadFile(file, &version, sizeof(version), 1) != 1 ||
+      gi.ReadFile(file, checksum, sizeof(checksum), 1) != 1 ||
+      gi.ReadFile(file, &file_nodes, sizeof(file_nodes), 1) != 1) {
+    gi.Warn("Route file truncated!\n");
+    gi.CloseFile(file);
+    return;
+  }
+
+  if (magic != AI_ROUTE_MAGIC || version != AI_ROUTE_VERSION) {
+    gi.Warn("Route file invalid format or out of date!\n");
+    gi.CloseFile(file);
+    return;
+  }
+
+  G_Ai_Route_Checksum(expected);
+
+  if (file_nodes != num_nodes || memcmp(checksum, expected, sizeof(checksum))) {
+    gi.Warn("Route file does not match navigation nodes; use `g_ai_build_routes` to rebuild it.\n");
+    gi.CloseFile(file);
+    return;
+  }
+
+  const size_t count = (size_t) num_nodes * num_nodes;
+  uint16_t *distances = g_new(uint16_t, count);
+
+  if (gi.ReadFile(file, distances, sizeof(uint16_t), count) != (int64_t) count) {
+    gi.Warn("Route file truncated!\n");
+    g_free(distances);
+    gi.CloseFile(file);
+    return;
+  }
+
+  gi.CloseFile(file);
+
+  g_ai_route.num_nodes = num_nodes;
+  g_ai_route.distances = distances;
+  g_ai_route.generation = G_Ai_Node_Generation();
+
+  gi.Print("  Loaded route table for %u nodes.\n", num_nodes);
+}
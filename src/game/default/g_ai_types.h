@@ -337,6 +337,26 @@ typedef struct ai_s {
    * Valid only when lookahead_frame == g_level.frame_num.
    */
   bool lookahead_no_ground;
+
+  /**
+   * @brief The closest node to `route_node_origin`, for route table lookups.
+   */
+  ai_node_id_t route_node;
+
+  /**
+   * @brief The bot's origin when `route_node` was found.
+   */
+  vec3_t route_node_origin;
+
+  /**
+   * @brief The node generation when `route_node` was found.
+   */
+  uint32_t route_node_generation;
+
+  /**
+   * @brief The level time when `route_node` was found, or 0 if it has not been.
+   */
+  uint32_t route_node_time;
 } ai_t;
 
 #endif /* __GAME_LOCAL_H__ */
@@ -344,6 +344,52 @@ void G_NailProjectile(g_entity_t *ent, const vec3_t start, const vec3_t dir, int
   gi.LinkEntity(projectile);
 }
 
+/**
+ * @return The end point of a bullet fired from `start` along `dir` with randomized spread.
+ */
+static vec3_t G_BulletEnd(const vec3_t start, const vec3_t dir, int32_t hspread, int32_t vspread) {
+  vec3_t forward, right, up;
+
+  Vec3_Vectors(Vec3_Euler(dir), &forward, &right, &up);
+
+  vec3_t end = Vec3_Fmaf(start, MAX_WORLD_DIST, forward);
+  end = Vec3_Fmaf(end, RandomRangef(-hspread, hspread), right);
+  end = Vec3_Fmaf(end, RandomRangef(-vspread, vspread), up);
+
+  return end;
+}
+
+/**
+ * @brief Deals damage and emits impact effects for a bullet that struck something.
+ */
+static void G_BulletHit(g_entity_t *ent, const vec3_t start, const vec3_t dir, cm_trace_t *tr, int32_t damage, int32_t knockback, int32_t mod) {
+
+  G_Damage(&(g_damage_t) {
+    .target = tr->ent,
+    .inflictor = ent,
+    .attacker = ent,
+    .dir = dir,
+    .point = tr->end,
+    .normal = tr->plane.normal,
+    .damage = damage,
+    .knockback = knockback,
+    .flags = DMG_BULLET,
+    .mod = mod
+  });
+
+  if (G_IsStructural(tr)) {
+    G_BulletImpact(tr);
+  }
+
+  if (gi.PointContents(start) & CONTENTS_MASK_LIQUID) {
+    G_Ripple(NULL, tr->end, start, 8.f, false);
+    G_BubbleTrail(start, tr, 12.f);
+  } else if (gi.PointContents(tr->end) & CONTENTS_MASK_LIQUID) {
+    G_Ripple(NULL, start, tr->end, 8.f, true);
+    G_BubbleTrail(start, tr, 12.f);
+  }
+}
+
 /**
  * @brief Fires a single bullet projectile with randomized spread, dealing damage and emitting impact effects.
  */
@@ -351,14 +397,7 @@ void G_BulletProjectile(g_entity_t *ent, const vec3_t start, const vec3_t dir, i
 
   cm_trace_t tr = gi.Trace(ent->s.origin, start, Box3f(1.f, 1.f, 1.f), ent, CONTENTS_MASK_CLIP_PROJECTILE);
   if (tr.fraction == 1.0) {
-    vec3_t angles, forward, right, up, end;
-
-    angles = Vec3_Euler(dir);
-    Vec3_Vectors(angles, &forward, &right, &up);
-
-    end = Vec3_Fmaf(start, MAX_WORLD_DIST, forward);
-    end = Vec3_Fmaf(end, RandomRangef(-hspread, hspread), right);
-    end = Vec3_Fmaf(end, RandomRangef(-vspread, vspread), up);
+    const vec3_t end = G_BulletEnd(start, dir, hspread, vspread);
 
     tr = gi.Trace(start, end, Box3_Zero(), ent, CONTENTS_MASK_CLIP_PROJECTILE);
 
@@ -366,41 +405,48 @@ void G_BulletProjectile(g_entity_t *ent, const vec3_t start, const vec3_t dir, i
   }
 
   if (tr.fraction < 1.0) {
-
-    G_Damage(&(g_damage_t) {
-      .target = tr.ent,
-      .inflictor = ent,
-      .attacker = ent,
-      .dir = dir,
-      .point = tr.end,
-      .normal = tr.plane.normal,
-      .damage = damage,
-      .knockback = knockback,
-      .flags = DMG_BULLET,
-      .mod = mod
-    });
-
-    if (G_IsStructural(&tr)) {
-      G_BulletImpact(&tr);
-    }
-
-    if (gi.PointContents(start) & CONTENTS_MASK_LIQUID) {
-      G_Ripple(NULL, tr.end, start, 8.f, false);
-      G_BubbleTrail(start, &tr, 12.f);
-    } else if (gi.PointContents(tr.end) & CONTENTS_MASK_LIQUID) {
-      G_Ripple(NULL, start, tr.end, 8.f, true);
-      G_BubbleTrail(start, &tr, 12.f);
-    }
+    G_BulletHit(ent, start, dir, &tr, damage, knockback, mod);
   }
 }
 
 /**
- * @brief Fires multiple bullet projectiles to simulate shotgun pellet spread.
+ * @brief Fires multiple bullet projectiles to simulate shotgun pellet spread. The pellets
+ * are traced together with `gi.TraceBatch`, and then deal their damage in turn.
  */
 void G_ShotgunProjectiles(g_entity_t *ent, const vec3_t start, const vec3_t dir, int32_t damage, int32_t knockback, int32_t hspread, int32_t vspread, int32_t count, int32_t mod) {
 
-  for (int32_t i = 0; i < count; i++) {
-    G_BulletProjectile(ent, start, dir, damage, knockback, hspread, vspread, mod);
+  const cm_trace_t tr = gi.Trace(ent->s.origin, start, Box3f(1.f, 1.f, 1.f), ent, CONTENTS_MASK_CLIP_PROJECTILE);
+  if (tr.fraction < 1.0) { // the muzzle is obstructed, so every pellet strikes the obstruction
+    for (int32_t i = 0; i < count; i++) {
+      cm_trace_t pellet = tr;
+      G_BulletHit(ent, start, dir, &pellet, damage, knockback, mod);
+    }
+    return;
+  }
+
+  vec3_t starts[32], ends[32];
+  cm_trace_t traces[32];
+
+  while (count > 0) {
+    const int32_t n = Mini(count, lengthof(starts));
+
+    for (int32_t i = 0; i < n; i++) {
+      starts[i] = start;
+      ends[i] = G_BulletEnd(start, dir, hspread, vspread);
+    }
+
+    gi.TraceBatch(starts, ends, n, Box3_Zero(), ent, CONTENTS_MASK_CLIP_PROJECTILE, traces);
+
+    for (int32_t i = 0; i < n; i++) {
+
+      G_Tracer(start, traces[i].end);
+
+      if (traces[i].fraction < 1.0) {
+        G_BulletHit(ent, start, dir, &traces[i], damage, knockback, mod);
+      }
+    }
+
+    count -= n;
   }
 }
 
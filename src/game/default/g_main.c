@@ -149,6 +149,7 @@ cvar_t *g_gameplay;
 cvar_t *g_gravity;
 cvar_t *g_motd;
 cvar_t *g_num_teams;
+cvar_t *g_parallel_physics;
 cvar_t *g_password;
 cvar_t *g_player_projectile;
 cvar_t *g_random_map;
@@ -839,6 +840,9 @@ static void G_Frame(void) {
     }
   }
 
+  // predict physics traces in parallel, for the serial pass to consume
+  G_Physics_BeginFrame();
+
   // treat each object in turn, even the world gets a chance to think
   G_ForEachEntity(ent, {
     g_level.current_entity = ent;
@@ -852,6 +856,8 @@ static void G_Frame(void) {
     g_level.current_entity = NULL;
   });
 
+  G_Physics_EndFrame();
+
   // let the AI think
   G_Ai_Frame();
 
@@ -1062,6 +1068,7 @@ void G_Init(void) {
   g_gravity = gi.AddCvar("g_gravity", "800", CVAR_SERVER_INFO, NULL);
   g_num_teams = gi.AddCvar("g_num_teams", "default", CVAR_SERVER_INFO, "The number of teams allowed. By default, picks the valid amount for the map, or 2.");
   g_motd = gi.AddCvar("g_motd", "", CVAR_SERVER_INFO, "Message of the day, shown to clients on initial connect.");
+  g_parallel_physics = gi.AddCvar("g_parallel_physics", "0", 0, "Predicts entity physics traces on the thread pool. 2 also verifies each prediction.");
   g_password = gi.AddCvar("g_password", "", CVAR_USER_INFO, "The server password.");
   g_player_projectile = gi.AddCvar("g_player_projectile", "1", CVAR_SERVER_INFO, "Scales player velocity to projectiles.");
   g_random_map = gi.AddCvar("g_random_map", "0", 0, "Enables map shuffling.");
@@ -1077,6 +1084,8 @@ void G_Init(void) {
   g_weapon_respawn_time = gi.AddCvar("g_weapon_respawn_time", "5", CVAR_SERVER_INFO, "Weapon respawn interval in seconds.");
   g_weapon_stay = gi.AddCvar("g_weapon_stay", "0", CVAR_SERVER_INFO, "If enabled, weapons will remain when picked up rather than respawn with delay.");
 
+  G_Physics_Init();
+
   G_Ai_Init(); // initialize the AI
 
   G_MapList_Init();
@@ -151,6 +151,7 @@ extern cvar_t *g_friendly_fire;
 extern cvar_t *g_gameplay;
 extern cvar_t *g_gravity;
 extern cvar_t *g_num_teams;
+extern cvar_t *g_parallel_physics;
 extern cvar_t *g_motd;
 extern cvar_t *g_password;
 extern cvar_t *g_player_projectile;
@@ -22,6 +22,313 @@
 #include "g_local.h"
 #include "bg_pmove.h"
 
+/**
+ * @brief The edge length of a cell in the dirty region grid.
+ */
+#define G_PHYSICS_CELL_SIZE 128.f
+
+/**
+ * @brief The count of buckets in the dirty region grid. Must be a power of two.
+ */
+#define G_PHYSICS_CELLS 8192
+
+/**
+ * @brief Dirty regions spanning more cells than this simply dirty the whole world.
+ */
+#define G_PHYSICS_MAX_DIRTY_CELLS 1024
+
+/**
+ * @brief The maximum number of traces predicted per entity.
+ */
+#define G_PHYSICS_MAX_PREDICTIONS 3
+
+/**
+ * @brief A trace predicted on the thread pool, before any entity has run.
+ */
+typedef struct {
+  vec3_t start, end;
+  box3_t bounds;
+  int32_t contents;
+
+  /**
+   * @brief The owner and solid of the skipped entity, which affect the trace.
+   */
+  const g_entity_t *owner;
+  solid_t solid;
+
+  cm_trace_t trace;
+} g_physics_prediction_t;
+
+/**
+ * @brief The predicted traces of a single entity.
+ */
+typedef struct {
+  g_physics_prediction_t predictions[G_PHYSICS_MAX_PREDICTIONS];
+  int32_t num_predictions;
+} g_physics_entity_t;
+
+/**
+ * @brief Parallel physics state. Traces for free-moving entities are predicted in
+ * parallel at the start of each frame, and consumed by the serial pass wherever the
+ * entity's arguments match exactly and no other entity has since been linked into the
+ * trace's region of the world.
+ */
+static struct {
+  /**
+   * @brief The entities predicted this frame.
+   */
+  g_entity_t *entities[MAX_ENTITIES];
+  int32_t num_entities;
+
+  /**
+   * @brief The predicted traces, indexed by entity number.
+   */
+  g_physics_entity_t predicted[MAX_ENTITIES];
+
+  /**
+   * @brief True while the serial pass is recording dirty regions.
+   */
+  bool recording;
+
+  /**
+   * @brief The dirty region grid. Each bucket is 0 if clean, the number + 1 of the
+   * only entity to have dirtied it, or -1 if several entities have dirtied it.
+   */
+  int32_t cells[G_PHYSICS_CELLS];
+
+  /**
+   * @brief True if an entity has dirtied too large a region to record.
+   */
+  bool all_dirty;
+
+  /**
+   * @brief The original link functions, wrapped to record dirty regions.
+   */
+  void (*LinkEntity)(g_entity_t *ent);
+  void (*UnlinkEntity)(g_entity_t *ent);
+  void (*SetModel)(g_entity_t *ent, const char *name);
+
+  /**
+   * @brief Statistics, printed and reset by `g_physics_stats`.
+   */
+  struct {
+    uint32_t predicted;
+    uint32_t used;
+    uint32_t rejected;
+    uint32_t mismatched;
+  } stats;
+} g_physics;
+
+/**
+ * @return The dirty region grid bucket for the specified cell.
+ */
+static inline int32_t G_Physics_Cell(int32_t x, int32_t y, int32_t z) {
+  const uint32_t hash = ((uint32_t) x * 73856093u) ^ ((uint32_t) y * 19349663u) ^ ((uint32_t) z * 83492791u);
+  return (int32_t) (hash & (G_PHYSICS_CELLS - 1));
+}
+
+/**
+ * @brief Resolves the cell range spanned by the specified bounds.
+ * @return The count of cells in the range.
+ */
+static int32_t G_Physics_CellRange(const box3_t bounds, int32_t *mins, int32_t *maxs) {
+
+  int32_t count = 1;
+
+  for (int32_t i = 0; i < 3; i++) {
+    mins[i] = (int32_t) floorf(bounds.mins.xyz[i] / G_PHYSICS_CELL_SIZE);
+    maxs[i] = (int32_t) floorf(bounds.maxs.xyz[i] / G_PHYSICS_CELL_SIZE);
+    count *= (maxs[i] - mins[i] + 1);
+  }
+
+  return count;
+}
+
+/**
+ * @brief Marks the region occupied by the specified entity dirty, invalidating any
+ * predicted traces that pass through it.
+ */
+static void G_Physics_Dirty(const g_entity_t *ent, const box3_t bounds) {
+
+  if (g_physics.all_dirty) {
+    return;
+  }
+
+  int32_t mins[3], maxs[3];
+  if (G_Physics_CellRange(bounds, mins, maxs) > G_PHYSICS_MAX_DIRTY_CELLS) {
+    g_physics.all_dirty = true;
+    return;
+  }
+
+  const int32_t value = ent->s.number + 1;
+
+  for (int32_t x = mins[0]; x <= maxs[0]; x++) {
+    for (int32_t y = mins[1]; y <= maxs[1]; y++) {
+      for (int32_t z = mins[2]; z <= maxs[2]; z++) {
+        int32_t *cell = &g_physics.cells[G_Physics_Cell(x, y, z)];
+        if (*cell == 0) {
+          *cell = value;
+        } else if (*cell != value) {
+          *cell = -1;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @return True if no entity other than `skip` has dirtied the specified region.
+ */
+static bool G_Physics_Clean(const box3_t bounds, const g_entity_t *skip) {
+
+  if (g_physics.all_dirty) {
+    return false;
+  }
+
+  int32_t mins[3], maxs[3];
+  if (G_Physics_CellRange(bounds, mins, maxs) > G_PHYSICS_MAX_DIRTY_CELLS) {
+    return false;
+  }
+
+  const int32_t value = skip->s.number + 1;
+
+  for (int32_t x = mins[0]; x <= maxs[0]; x++) {
+    for (int32_t y = mins[1]; y <= maxs[1]; y++) {
+      for (int32_t z = mins[2]; z <= maxs[2]; z++) {
+        const int32_t cell = g_physics.cells[G_Physics_Cell(x, y, z)];
+        if (cell != 0 && cell != value) {
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief Wraps `gi.LinkEntity` to record the regions the entity leaves and enters.
+ */
+static void G_Physics_LinkEntity(g_entity_t *ent) {
+
+  if (g_physics.recording) {
+    G_Physics_Dirty(ent, ent->abs_bounds);
+  }
+
+  g_physics.LinkEntity(ent);
+
+  if (g_physics.recording) {
+    G_Physics_Dirty(ent, ent->abs_bounds);
+  }
+}
+
+/**
+ * @brief Wraps `gi.UnlinkEntity` to record the region the entity leaves.
+ */
+static void G_Physics_UnlinkEntity(g_entity_t *ent) {
+
+  if (g_physics.recording) {
+    G_Physics_Dirty(ent, ent->abs_bounds);
+  }
+
+  g_physics.UnlinkEntity(ent);
+}
+
+/**
+ * @brief Wraps `gi.SetModel`, which may link the entity, to record the regions the
+ * entity leaves and enters.
+ */
+static void G_Physics_SetModel(g_entity_t *ent, const char *name) {
+
+  if (g_physics.recording) {
+    G_Physics_Dirty(ent, ent->abs_bounds);
+  }
+
+  g_physics.SetModel(ent, name);
+
+  if (g_physics.recording) {
+    G_Physics_Dirty(ent, ent->abs_bounds);
+  }
+}
+
+/**
+ * @return True if the vectors are exactly equal.
+ */
+static inline bool G_Physics_Vec3Equal(const vec3_t a, const vec3_t b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+/**
+ * @return True if the predicted trace was issued with exactly the specified arguments.
+ */
+static bool G_Physics_Matches(const g_physics_prediction_t *p, const vec3_t start, const vec3_t end,
+                              const box3_t bounds, const g_entity_t *skip, int32_t contents) {
+
+  return G_Physics_Vec3Equal(p->start, start) &&
+         G_Physics_Vec3Equal(p->end, end) &&
+         G_Physics_Vec3Equal(p->bounds.mins, bounds.mins) &&
+         G_Physics_Vec3Equal(p->bounds.maxs, bounds.maxs) &&
+         p->contents == contents &&
+         p->owner == skip->owner &&
+         p->solid == skip->solid;
+}
+
+/**
+ * @return True if the traces are identical, for `g_parallel_physics 2`.
+ */
+static bool G_Physics_TraceEqual(const cm_trace_t *a, const cm_trace_t *b) {
+
+  return a->fraction == b->fraction &&
+         a->all_solid == b->all_solid &&
+         a->start_solid == b->start_solid &&
+         a->ent == b->ent &&
+         a->contents == b->contents &&
+         G_Physics_Vec3Equal(a->end, b->end) &&
+         G_Physics_Vec3Equal(a->plane.normal, b->plane.normal);
+}
+
+/**
+ * @brief Traces on behalf of the entity `skip`, using the trace predicted for it this
+ * frame if its arguments match, and its region of the world remains clean.
+ */
+static cm_trace_t G_Physics_Trace(const vec3_t start, const vec3_t end, const box3_t bounds,
+                                  const g_entity_t *skip, int32_t contents) {
+
+  if (g_physics.recording) {
+
+    const g_physics_entity_t *e = &g_physics.predicted[skip->s.number];
+    for (int32_t i = 0; i < e->num_predictions; i++) {
+
+      const g_physics_prediction_t *p = &e->predictions[i];
+      if (!G_Physics_Matches(p, start, end, bounds, skip, contents)) {
+        continue;
+      }
+
+      const box3_t abs_bounds = Box3_Expand(Box3_ExpandBox(Box3_FromPoints((const vec3_t []) { start, end }, 2), bounds), BOX_EPSILON);
+
+      if (!G_Physics_Clean(abs_bounds, skip)) {
+        g_physics.stats.rejected++;
+        break;
+      }
+
+      g_physics.stats.used++;
+
+      if (g_parallel_physics->integer > 1) {
+        const cm_trace_t trace = gi.Trace(start, end, bounds, skip, contents);
+        if (!G_Physics_TraceEqual(&trace, &p->trace)) {
+          G_Debug("%s predicted trace mismatch\n", etos(skip));
+          g_physics.stats.mismatched++;
+          return trace;
+        }
+      }
+
+      return p->trace;
+    }
+  }
+
+  return gi.Trace(start, end, bounds, skip, contents);
+}
+
 /**
  * @see Pm_CheckGround
  */
@@ -38,7 +345,7 @@ static void G_CheckGround(g_entity_t *ent) {
     pos = ent->s.origin;
     pos.z -= PM_GROUND_DIST;
 
-    cm_trace_t trace = gi.Trace(ent->s.origin, pos, ent->bounds, ent, ent->clip_mask ? : CONTENTS_MASK_SOLID);
+    cm_trace_t trace = G_Physics_Trace(ent->s.origin, pos, ent->bounds, ent, ent->clip_mask ? : CONTENTS_MASK_SOLID);
 
     if (trace.ent && trace.plane.normal.z >= PM_STEP_NORMAL) {
       if (ent->ground.ent == NULL) {
@@ -167,7 +474,7 @@ static bool G_GoodPosition(const g_entity_t *ent) {
 
   const int32_t mask = ent->clip_mask ? : CONTENTS_MASK_SOLID;
 
-  const cm_trace_t tr = gi.Trace(ent->s.origin, ent->s.origin, ent->bounds, ent, mask);
+  const cm_trace_t tr = G_Physics_Trace(ent->s.origin, ent->s.origin, ent->bounds, ent, mask);
 
   return tr.start_solid == false && tr.all_solid == false;
 }
@@ -206,16 +513,16 @@ static bool G_CorrectPosition(g_entity_t *ent) {
 #define STOP_EPSILON PM_STOP_EPSILON
 
 /**
- * @brief Clamps entity velocity to `MAX_SPEED`, or zeroes it when below `STOP_EPSILON`.
+ * @brief Clamps the velocity to `MAX_SPEED`, or zeroes it when below `STOP_EPSILON`.
  */
-static void G_ClampVelocity(g_entity_t *ent) {
+static void G_ClampVelocity(vec3_t *velocity) {
 
-  const float speed = Vec3_Length(ent->velocity);
+  const float speed = Vec3_Length(*velocity);
 
   if (speed > MAX_SPEED) {
-    ent->velocity = Vec3_Scale(ent->velocity, MAX_SPEED / speed);
+    *velocity = Vec3_Scale(*velocity, MAX_SPEED / speed);
   } else if (speed < STOP_EPSILON) {
-    ent->velocity = Vec3_Zero();
+    *velocity = Vec3_Zero();
   }
 }
 
@@ -238,11 +545,13 @@ static vec3_t G_ClipVelocity(const vec3_t in, const vec3_t normal, float bounce)
 #define SPEED_STOP 150.0
 
 /**
+ * @brief Applies the entity's friction to the specified velocity, and to the angular
+ * velocity, if one is given.
  * @see Pm_Friction
  */
-static void G_Friction(g_entity_t *ent) {
+static void G_Friction(const g_entity_t *ent, vec3_t *velocity, vec3_t *avelocity) {
 
-  vec3_t vel = ent->velocity;
+  vec3_t vel = *velocity;
 
   if (ent->ground.contents & CONTENTS_MASK_SOLID) {
     vel.z = 0.0;
@@ -251,7 +560,7 @@ static void G_Friction(g_entity_t *ent) {
   const float speed = Vec3_Length(vel);
 
   if (speed < 1.0) {
-    ent->velocity = Vec3_Zero();
+    *velocity = Vec3_Zero();
     return;
   }
 
@@ -275,16 +584,19 @@ static void G_Friction(g_entity_t *ent) {
 
   float scale = Maxf(0.0, speed - (friction * control * QUETOO_TICK_SECONDS)) / speed;
 
-  ent->velocity = Vec3_Scale(ent->velocity, scale);
-  ent->avelocity = Vec3_Scale(ent->avelocity, scale);
+  *velocity = Vec3_Scale(*velocity, scale);
+
+  if (avelocity) {
+    *avelocity = Vec3_Scale(*avelocity, scale);
+  }
 }
 
 /**
  * @see Pm_Accelerate
  */
-static void G_Accelerate(g_entity_t *ent, const vec3_t dir, float speed, float accel) {
+static void G_Accelerate(vec3_t *velocity, const vec3_t dir, float speed, float accel) {
 
-  const float current_speed = Vec3_Dot(ent->velocity, dir);
+  const float current_speed = Vec3_Dot(*velocity, dir);
   const float add_speed = speed - current_speed;
 
   if (add_speed <= 0.0) {
@@ -297,13 +609,13 @@ static void G_Accelerate(g_entity_t *ent, const vec3_t dir, float speed, float a
     accel_speed = add_speed;
   }
 
-  ent->velocity = Vec3_Fmaf(ent->velocity, accel_speed, dir);
+  *velocity = Vec3_Fmaf(*velocity, accel_speed, dir);
 }
 
 /**
  * @see Pm_Gravity
  */
-static void G_Gravity(g_entity_t *ent) {
+static void G_Gravity(const g_entity_t *ent, vec3_t *velocity) {
 
   if (ent->ground.ent == NULL) {
     float gravity = g_level.gravity;
@@ -312,14 +624,14 @@ static void G_Gravity(g_entity_t *ent) {
       gravity *= PM_GRAVITY_WATER;
     }
 
-    ent->velocity.z -= gravity * QUETOO_TICK_SECONDS;
+    velocity->z -= gravity * QUETOO_TICK_SECONDS;
   }
 }
 
 /**
  * @see Pm_Currents
  */
-static void G_Currents(g_entity_t *ent) {
+static void G_Currents(const g_entity_t *ent, vec3_t *velocity) {
   vec3_t current = Vec3_Zero();
 
   if (ent->water_level) {
@@ -376,7 +688,7 @@ static void G_Currents(g_entity_t *ent) {
 
   current = Vec3_Normalize(current);
 
-  G_Accelerate(ent, current, speed, PM_ACCEL_GROUND);
+  G_Accelerate(velocity, current, speed, PM_ACCEL_GROUND);
 }
 
 /**
@@ -996,7 +1308,7 @@ static bool G_Physics_Fly_Move(g_entity_t *ent, const float bounce) {
     pos = Vec3_Fmaf(ent->s.origin, time_remaining, ent->velocity);
 
     // trace to it
-    const cm_trace_t trace = gi.Trace(ent->s.origin, pos, ent->bounds, ent, mask);
+    const cm_trace_t trace = G_Physics_Trace(ent->s.origin, pos, ent->bounds, ent, mask);
 
     // if the entity is trapped in a solid, don't build up Z
     if (trace.all_solid) {
@@ -1125,11 +1437,11 @@ static void G_Physics_Bounce(g_entity_t *ent) {
 
   if (ent->ground.ent == NULL || !Vec3_Equal(ent->velocity, Vec3_Zero())) {
 
-    G_Friction(ent);
+    G_Friction(ent, &ent->velocity, &ent->avelocity);
 
-    G_Gravity(ent);
+    G_Gravity(ent, &ent->velocity);
 
-    G_Currents(ent);
+    G_Currents(ent, &ent->velocity);
 
     G_Physics_Fly_Move(ent, 1.33);
   }
@@ -1146,7 +1458,7 @@ static void G_Physics_Bounce(g_entity_t *ent) {
  */
 void G_RunEntity(g_entity_t *ent) {
 
-  G_ClampVelocity(ent);
+  G_ClampVelocity(&ent->velocity);
 
   G_RunThink(ent);
 
@@ -1175,3 +1487,158 @@ void G_RunEntity(g_entity_t *ent) {
     ent->s.animation1 = ent->move_info.state;
   }
 }
+
+/**
+ * @brief Records a trace predicted for the specified entity.
+ */
+static cm_trace_t G_Physics_Predict(g_physics_entity_t *e, const g_entity_t *ent, const vec3_t start, const vec3_t end, int32_t contents) {
+
+  g_physics_prediction_t *p = &e->predictions[e->num_predictions++];
+
+  p->start = start;
+  p->end = end;
+  p->bounds = ent->bounds;
+  p->contents = contents;
+  p->owner = ent->owner;
+  p->solid = ent->solid;
+  p->trace = gi.Trace(start, end, ent->bounds, ent, contents);
+
+  return p->trace;
+}
+
+/**
+ * @brief `gi.Parallel` callback, predicting the traces the serial pass will issue for
+ * the specified entity. This mirrors `G_RunEntity`, save for thinking, which may alter
+ * the entity so that the predictions no longer match. The entity itself is not modified;
+ * the origin and velocity it would move with are kept in locals, and the entity is passed
+ * to the traces so that it and the entities it owns are skipped, as they are serially.
+ */
+static void G_Physics_PredictEntity(int32_t index, void *data) {
+
+  const g_entity_t *ent = g_physics.entities[index];
+  g_physics_entity_t *e = &g_physics.predicted[ent->s.number];
+
+  vec3_t origin = ent->s.origin;
+  vec3_t velocity = ent->velocity;
+
+  G_ClampVelocity(&velocity);
+
+  const int32_t mask = ent->clip_mask ? : CONTENTS_MASK_SOLID;
+
+  bool move = true;
+
+  if (ent->move_type == MOVE_TYPE_BOUNCE) {
+    if (ent->ground.ent == NULL || !Vec3_Equal(velocity, Vec3_Zero())) {
+      G_Friction(ent, &velocity, NULL);
+      G_Gravity(ent, &velocity);
+      G_Currents(ent, &velocity);
+    } else {
+      move = false;
+    }
+  }
+
+  if (move) {
+    const vec3_t end = Vec3_Fmaf(origin, QUETOO_TICK_SECONDS, velocity);
+    const cm_trace_t trace = G_Physics_Predict(e, ent, origin, end, mask);
+
+    if (trace.fraction < 1.f || trace.all_solid) {
+      return; // the remainder of the move depends on touches and clipping
+    }
+
+    origin = end;
+
+    G_Physics_Predict(e, ent, origin, origin, mask); // G_GoodPosition
+  }
+
+  if (ent->move_type == MOVE_TYPE_BOUNCE) {
+    vec3_t pos = origin;
+    pos.z -= PM_GROUND_DIST;
+
+    G_Physics_Predict(e, ent, origin, pos, mask); // G_CheckGround
+  }
+}
+
+/**
+ * @brief Predicts traces for all free-moving entities on the thread pool, and begins
+ * recording the regions dirtied by the serial pass, if `g_parallel_physics` is set.
+ */
+void G_Physics_BeginFrame(void) {
+
+  g_physics.recording = false;
+
+  if (!g_parallel_physics->integer) {
+    return;
+  }
+
+  g_physics.num_entities = 0;
+
+  for (int32_t i = 0; i < sv_max_entities->integer; i++) {
+    g_physics.predicted[i].num_predictions = 0;
+  }
+
+  G_ForEachEntity(ent, {
+    if (ent->client) {
+      continue;
+    }
+
+    if (ent->move_type != MOVE_TYPE_FLY && ent->move_type != MOVE_TYPE_BOUNCE) {
+      continue;
+    }
+
+    g_physics.entities[g_physics.num_entities++] = ent;
+  });
+
+  gi.Parallel(G_Physics_PredictEntity, g_physics.num_entities, NULL);
+
+  for (int32_t i = 0; i < g_physics.num_entities; i++) {
+    g_physics.stats.predicted += g_physics.predicted[g_physics.entities[i]->s.number].num_predictions;
+  }
+
+  memset(g_physics.cells, 0, sizeof(g_physics.cells));
+  g_physics.all_dirty = false;
+
+  g_physics.recording = true;
+}
+
+/**
+ * @brief Ends recording, so that predictions are not consumed outside of the serial pass.
+ */
+void G_Physics_EndFrame(void) {
+
+  g_physics.recording = false;
+}
+
+/**
+ * @brief Prints and resets the parallel physics statistics.
+ */
+static void G_Physics_Stats_f(void) {
+
+  const uint32_t attempted = g_physics.stats.used + g_physics.stats.rejected;
+
+  gi.Print("Parallel physics: %u predicted, %u used, %u rejected (%.1f%% hit), %u mismatched\n",
+           g_physics.stats.predicted,
+           g_physics.stats.used,
+           g_physics.stats.rejected,
+           attempted ? 100.f * g_physics.stats.used / attempted : 0.f,
+           g_physics.stats.mismatched);
+
+  memset(&g_physics.stats, 0, sizeof(g_physics.stats));
+}
+
+/**
+ * @brief Wraps the link functions to record dirty regions, and adds the statistics command.
+ */
+void G_Physics_Init(void) {
+
+  memset(&g_physics, 0, sizeof(g_physics));
+
+  g_physics.LinkEntity = gi.LinkEntity;
+  g_physics.UnlinkEntity = gi.UnlinkEntity;
+  g_physics.SetModel = gi.SetModel;
+
+  gi.LinkEntity = G_Physics_LinkEntity;
+  gi.UnlinkEntity = G_Physics_UnlinkEntity;
+  gi.SetModel = G_Physics_SetModel;
+
+  gi.AddCmd("g_physics_stats", G_Physics_Stats_f, CMD_GAME, "Print and reset parallel physics statistics");
+}
@@ -28,4 +28,7 @@
 void G_TouchOccupy(g_entity_t *ent);
 void G_RunThink(g_entity_t *ent);
 void G_RunEntity(g_entity_t *ent);
+void G_Physics_Init(void);
+void G_Physics_BeginFrame(void);
+void G_Physics_EndFrame(void);
 #endif /* __GAME_LOCAL_H__ */
@@ -24,7 +24,7 @@
 #include "shared/shared.h"
 #include "collision/cm_types.h"
 
-#define GAME_API_VERSION 27
+#define GAME_API_VERSION 29
 
 /**
  * @brief Server flags for `g_entity_t`.
@@ -574,6 +574,20 @@ typedef struct g_import_s {
    */
   cm_trace_t (*Trace)(const vec3_t start, const vec3_t end, const box3_t bounds, const g_entity_t *skip, int32_t contents);
 
+  /**
+   * @brief Collision detection for many traces of the same size at once, such as shotgun
+   * pellets. The results are identical to calling `Trace` for each start and end point.
+   *
+   * @param starts The start points.
+   * @param ends The end points.
+   * @param count The number of traces.
+   * @param bounds The bounding box mins (optional; `Box3_Zero()` for line traces).
+   * @param skip The entity to skip (e.g. self) (optional).
+   * @param contents The contents mask to intersect with (e.g. `CONTENTS_MASK_SOLID`).
+   * @param traces The resulting traces, one per start and end point.
+   */
+  void (*TraceBatch)(const vec3_t *starts, const vec3_t *ends, size_t count, const box3_t bounds, const g_entity_t *skip, int32_t contents, cm_trace_t *traces);
+
   /**
    * @brief Collision detection. Traces between the two endpoints, impacting
    * the specified entity's planes matching the specified contents mask.
@@ -620,6 +634,17 @@ typedef struct g_import_s {
    */
   size_t (*BoxEntities)(const box3_t bounds, g_entity_t **list, const size_t len, uint32_t type);
 
+  /**
+   * @brief Invokes `func` once for each index in `[0, count)`, distributing the
+   * work across the server's thread pool, and returns when all indexes are done.
+   *
+   * @param func The function to invoke. It may call `Trace`, `Clip`, `PointContents`,
+   * `BoxContents` and `BoxEntities`, but must not modify any entity or link state.
+   * @param count The count of indexes.
+   * @param data The user data passed to `func`.
+   */
+  void (*Parallel)(void (*func)(int32_t index, void *data), int32_t count, void *data);
+
   /**
    * @}
    * @defgroup network Network messaging.
@@ -52,6 +52,38 @@
 
 quetoo_t quetoo;
 
+/**
+ * @brief Servers which have not sent a heartbeat in this many seconds are pinged.
+ */
+#define MS_HEARTBEAT_TIMEOUT 30
+
+/**
+ * @brief The interval in seconds at which unresponsive servers are pinged.
+ */
+#define MS_PING_INTERVAL 10
+
+/**
+ * @brief Servers which have not answered this many pings are dropped.
+ */
+#define MS_MAX_QUEUED_PINGS 6
+
+/**
+ * @brief The number of one-second slots in the timer wheel, which must exceed the longest
+ * timer.
+ */
+#define MS_WHEEL_SLOTS 64
+
+/**
+ * @brief The maximum number of cached server lists, which are keyed by client protocol.
+ */
+#define MS_MAX_SERVER_LISTS 8
+
+/**
+ * @brief The `getservers` response header, which is followed by an address and port for
+ * each server.
+ */
+#define MS_SERVERS_HEADER "\xFF\xFF\xFF\xFF" "servers "
+
 typedef struct ms_server_s {
   struct sockaddr_in addr;
   uint16_t queued_pings;
@@ -64,9 +96,43 @@ typedef struct ms_server_s {
   int32_t num_clients;
   int32_t max_clients;
   char players[MAX_CLIENTS][64];
+
+  /**
+   * @brief The address and port, which key the server in `ms_servers`.
+   */
+  gint64 key;
+
+  /**
+   * @brief The time at which the server's timer fires.
+   */
+  time_t deadline;
+
+  /**
+   * @brief The neighbors of the server in its timer wheel slot.
+   */
+  struct ms_server_s *prev, *next;
 } ms_server_t;
 
-static GList *ms_servers;
+/**
+ * @brief The servers, keyed by address and port.
+ */
+static GHashTable *ms_servers;
+
+/**
+ * @brief The serialized `getservers` responses, keyed by protocol. These are invalidated
+ * whenever the set of validated servers changes.
+ */
+static GHashTable *ms_server_lists;
+
+/**
+ * @brief The timer wheel, which schedules the ping and expiry of each server, so that
+ * `Ms_Frame` visits only the servers whose timers have fired.
+ */
+static struct {
+  ms_server_t *slots[MS_WHEEL_SLOTS];
+  time_t time;
+} ms_wheel;
+
 static int32_t ms_sock;
 
 static bool verbose;
@@ -74,6 +140,13 @@ static bool debug;
 
 static const char *ms_discord_webhook;
 
+/**
+ * @brief Discards all cached server lists. Called when the set of validated servers changes.
+ */
+static void Ms_InvalidateServerLists(void) {
+  g_hash_table_remove_all(ms_server_lists);
+}
+
 /**
  * @brief Extracts the value for the given key from a Quake infostring.
  * @return True if the key was found and the value copied, false otherwise.
@@ -161,7 +234,13 @@ static void Ms_ParseStatusString(ms_server_t *server, const char *status) {
   }
 
   if (Ms_InfoValue(status, "sv_protocol", val, sizeof(val))) {
-    server->protocol = atoi(val);
+    const int32_t protocol = atoi(val);
+    if (protocol != server->protocol) {
+      server->protocol = protocol;
+      if (server->validated) {
+        Ms_InvalidateServerLists();
+      }
+    }
   }
 
   server->max_clients = 0;
@@ -242,24 +321,57 @@ static const char *atos(const struct sockaddr_in *addr) {
 
 #define stos(s) (atos(&s->addr))
 
+/**
+ * @return The hash key for the specified address.
+ */
+static gint64 Ms_ServerKey(const struct sockaddr_in *addr) {
+  return ((gint64) addr->sin_addr.s_addr << 16) | addr->sin_port;
+}
+
 /**
  * @brief Returns the server for the specified address, or `NULL`.
  */
-static ms_server_t *Ms_GetServer(struct sockaddr_in *from) {
+static ms_server_t *Ms_GetServer(const struct sockaddr_in *from) {
 
-  GList *s = ms_servers;
-  while (s) {
-    ms_server_t *server = (ms_server_t *) s->data;
+  const gint64 key = Ms_ServerKey(from);
 
-    const struct sockaddr_in *addr = &server->addr;
-    if (addr->sin_addr.s_addr == from->sin_addr.s_addr && addr->sin_port == from->sin_port) {
-      return server;
-    }
+  return g_hash_table_lookup(ms_servers, &key);
+}
 
-    s = s->next;
+/**
+ * @brief Removes the specified server from its timer wheel slot.
+ */
+static void Ms_Unschedule(ms_server_t *server) {
+
+  if (server->prev) {
+    server->prev->next = server->next;
+  } else if (ms_wheel.slots[server->deadline % MS_WHEEL_SLOTS] == server) {
+    ms_wheel.slots[server->deadline % MS_WHEEL_SLOTS] = server->next;
+  }
+
+  if (server->next) {
+    server->next->prev = server->prev;
   }
 
-  return NULL;
+  server->prev = server->next = NULL;
+}
+
+/**
+ * @brief Schedules the specified server's timer to fire at `deadline`.
+ */
+static void Ms_Schedule(ms_server_t *server, time_t deadline) {
+
+  Ms_Unschedule(server);
+
+  server->deadline = MAX(deadline, ms_wheel.time + 1);
+
+  ms_server_t **slot = &ms_wheel.slots[server->deadline % MS_WHEEL_SLOTS];
+
+  server->next = *slot;
+  if (*slot) {
+    (*slot)->prev = server;
+  }
+  *slot = server;
 }
 
 /**
@@ -267,9 +379,13 @@ static ms_server_t *Ms_GetServer(struct sockaddr_in *from) {
  */
 static void Ms_DropServer(ms_server_t *server) {
 
-  ms_servers = g_list_remove(ms_servers, server);
+  Ms_Unschedule(server);
+
+  if (server->validated) {
+    Ms_InvalidateServerLists();
+  }
 
-  Mem_Free(server);
+  g_hash_table_remove(ms_servers, &server->key);
 }
 
 /**
@@ -335,10 +451,13 @@ static void Ms_AddServer(struct sockaddr_in *from) {
   ms_server_t *server = Mem_Malloc(sizeof(ms_server_t));
 
   server->addr = *from;
+  server->key = Ms_ServerKey(from);
   server->last_heartbeat = time(NULL);
   server->num_clients = -1;
 
-  ms_servers = g_list_prepend(ms_servers, server);
+  g_hash_table_insert(ms_servers, &server->key, server);
+  Ms_Schedule(server, server->last_heartbeat + MS_HEARTBEAT_TIMEOUT + 1);
+
   Com_Print("Server %s registered\n", stos(server));
 
   // send an acknowledgment
@@ -361,44 +480,96 @@ static void Ms_RemoveServer(struct sockaddr_in *from) {
 }
 
 /**
- * @brief Processes one master-server tick: evicts stale servers, handles pending pings, and cycles to the next server.
+ * @brief Fires the specified server's timer. Servers which have sent a heartbeat recently
+ * are simply rescheduled; others are pinged, and eventually dropped.
  */
-static void Ms_Frame(void) {
-  const time_t now = time(NULL);
+static void Ms_ServerTimer(ms_server_t *server, time_t now) {
 
-  GList *s = ms_servers;
-  while (s) {
-    GList *next = s->next;
-    ms_server_t *server = (ms_server_t *) s->data;
-    if (now - server->last_heartbeat > 30) {
+  if (now - server->last_heartbeat <= MS_HEARTBEAT_TIMEOUT) {
+    Ms_Schedule(server, server->last_heartbeat + MS_HEARTBEAT_TIMEOUT + 1);
+    return;
+  }
 
-      if (server->queued_pings > 6) {
-        Com_Print("Server %s timed out\n", stos(server));
-        Ms_DropServer(server);
-      } else {
-        if (now - server->last_ping >= 10) {
-          server->queued_pings++;
-          server->last_ping = now;
+  if (server->queued_pings > MS_MAX_QUEUED_PINGS) {
+    Com_Print("Server %s timed out\n", stos(server));
+    Ms_DropServer(server);
+    return;
+  }
 
-          Com_Verbose("Pinging %s\n", stos(server));
+  server->queued_pings++;
+  server->last_ping = now;
 
-          const char *ping = "\xFF\xFF\xFF\xFF" "ping";
-          sendto(ms_sock, ping, strlen(ping), 0, (struct sockaddr *) &server->addr,
-                 sizeof(server->addr));
-        }
+  Com_Verbose("Pinging %s\n", stos(server));
+
+  const char *ping = "\xFF\xFF\xFF\xFF" "ping";
+  sendto(ms_sock, ping, strlen(ping), 0, (struct sockaddr *) &server->addr,
+         sizeof(server->addr));
+
+  Ms_Schedule(server, now + MS_PING_INTERVAL);
+}
+
+/**
+ * @brief Processes one master-server tick: advances the timer wheel to `now`, pinging and
+ * evicting the servers whose timers have fired.
+ */
+static void Ms_Frame(time_t now) {
+
+  if (now - ms_wheel.time > MS_WHEEL_SLOTS) {
+    ms_wheel.time = now - MS_WHEEL_SLOTS;
+  }
+
+  while (ms_wheel.time < now) {
+    ms_wheel.time++;
+
+    ms_server_t *server = ms_wheel.slots[ms_wheel.time % MS_WHEEL_SLOTS];
+    while (server) {
+      ms_server_t *next = server->next;
+
+      if (server->deadline <= now) {
+        Ms_ServerTimer(server, now);
       }
+
+      server = next;
     }
+  }
+}
+
+/**
+ * @brief Serializes the `getservers` response for the specified protocol.
+ */
+static GByteArray *Ms_BuildServerList(int32_t protocol) {
+
+  GByteArray *list = g_byte_array_new();
+
+  g_byte_array_append(list, (const guint8 *) MS_SERVERS_HEADER, (guint) strlen(MS_SERVERS_HEADER));
 
-    s = next;
+  GHashTableIter iter;
+  g_hash_table_iter_init(&iter, ms_servers);
+
+  const ms_server_t *server;
+  while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &server)) {
+
+    if (!server->validated || server->protocol != protocol) {
+      continue;
+    }
+
+    if (list->len + sizeof(server->addr.sin_addr) + sizeof(server->addr.sin_port) > 0xffff) {
+      Com_Warn("Server list for protocol %d is full\n", protocol);
+      break;
+    }
+
+    g_byte_array_append(list, (const guint8 *) &server->addr.sin_addr, sizeof(server->addr.sin_addr));
+    g_byte_array_append(list, (const guint8 *) &server->addr.sin_port, sizeof(server->addr.sin_port));
   }
+
+  return list;
 }
 
 /**
- * @brief Send the servers list to the specified client address.
+ * @brief Send the servers list to the specified client address. The serialized list is
+ * cached per protocol until the set of validated servers changes.
  */
 static void Ms_GetServers(struct sockaddr_in *from, const char *cmd) {
-  mem_buf_t buf;
-  byte buffer[0xffff];
 
   // parse optional protocol version from command (e.g. "getservers 2026")
   int32_t protocol = PROTOCOL_MAJOR;
@@ -411,27 +582,21 @@ static void Ms_GetServers(struct sockaddr_in *from, const char *cmd) {
     }
   }
 
-  Mem_InitBuffer(&buf, buffer, sizeof(buffer));
-
-  const char *servers = "\xFF\xFF\xFF\xFF" "servers ";
-  Mem_WriteBuffer(&buf, servers, strlen(servers));
+  GByteArray *list = g_hash_table_lookup(ms_server_lists, GINT_TO_POINTER(protocol));
+  if (list == NULL) {
 
-  uint32_t i = 0;
-  GList *s = ms_servers;
-  while (s) {
-    const ms_server_t *server = (ms_server_t *) s->data;
-    if (server->validated && server->protocol == protocol) {
-      Mem_WriteBuffer(&buf, &server->addr.sin_addr, sizeof(server->addr.sin_addr));
-      Mem_WriteBuffer(&buf, &server->addr.sin_port, sizeof(server->addr.sin_port));
-      i++;
+    if (g_hash_table_size(ms_server_lists) == MS_MAX_SERVER_LISTS) {
+      Ms_InvalidateServerLists();
     }
-    s = s->next;
+
+    list = Ms_BuildServerList(protocol);
+    g_hash_table_insert(ms_server_lists, GINT_TO_POINTER(protocol), list);
   }
 
-  if ((sendto(ms_sock, buf.data, buf.size, 0, (struct sockaddr *) from, sizeof(*from))) == -1) {
+  if ((sendto(ms_sock, list->data, list->len, 0, (struct sockaddr *) from, sizeof(*from))) == -1) {
     Com_Warn("%s: %s\n", atos(from), strerror(errno));
   } else {
-    Com_Verbose("Sent %d servers (protocol %d) to %s\n", i, protocol, atos(from));
+    Com_Verbose("Sent %d servers (protocol %d) to %s\n", (int32_t) ((list->len - strlen(MS_SERVERS_HEADER)) / 6), protocol, atos(from));
   }
 }
 
@@ -444,7 +609,11 @@ static void Ms_Ack(struct sockaddr_in *from) {
   if (server) {
     Com_Verbose("Ack from %s (%d)\n", stos(server), server->queued_pings);
 
-    server->validated = true;
+    if (!server->validated) {
+      server->validated = true;
+      Ms_InvalidateServerLists();
+    }
+
     server->queued_pings = 0;
 
   } else {
@@ -503,6 +672,45 @@ static void Ms_ParseMessage(struct sockaddr_in *from, char *data) {
   }
 }
 
+/**
+ * @brief Reads and dispatches all pending packets, in batches.
+ */
+static void Ms_ReadPackets(void) {
+  static net_datagram_t datagrams[NET_DATAGRAM_BATCH];
+  ssize_t count;
+
+  do {
+    count = Net_RecvDatagrams(ms_sock, datagrams, lengthof(datagrams));
+    if (count == -1) {
+      const int32_t err = Net_GetError();
+      if (err != EWOULDBLOCK && err != ECONNREFUSED) {
+        Com_Warn("Socket error: %s\n", Net_GetErrorString());
+      }
+      break;
+    }
+
+    for (ssize_t i = 0; i < count; i++) {
+      net_datagram_t *datagram = &datagrams[i];
+
+      struct sockaddr_in from;
+      memset(&from, 0, sizeof(from));
+
+      from.sin_family = AF_INET;
+      from.sin_addr.s_addr = datagram->addr.addr;
+      from.sin_port = datagram->addr.port;
+
+      if (datagram->size == sizeof(datagram->data)) {
+        Com_Warn("Oversized packet from %s\n", atos(&from));
+      } else if (datagram->size > 4) {
+        datagram->data[datagram->size] = '\0';
+        Ms_ParseMessage(&from, (char *) datagram->data);
+      } else {
+        Com_Warn("Invalid packet from %s\n", atos(&from));
+      }
+    }
+  } while (count == lengthof(datagrams));
+}
+
 /**
  * @brief `Com_Debug` implementation.
  */
@@ -523,6 +731,34 @@ static void Verbose(const char *msg) {
   }
 }
 
+/**
+ * @brief Initializes the server registry.
+ */
+static void Ms_Init(void) {
+
+  ms_servers = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, Mem_Free);
+  ms_server_lists = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_byte_array_unref);
+
+  memset(&ms_wheel, 0, sizeof(ms_wheel));
+  ms_wheel.time = time(NULL);
+}
+
+/**
+ * @brief Frees the server registry.
+ */
+static void Ms_Shutdown(void) {
+
+  if (ms_server_lists) {
+    g_hash_table_destroy(ms_server_lists);
+    ms_server_lists = NULL;
+  }
+
+  if (ms_servers) {
+    g_hash_table_destroy(ms_servers);
+    ms_servers = NULL;
+  }
+}
+
 /**
  * @brief `Com_Init` implementation.
  */
@@ -531,6 +767,8 @@ static void Init(void) {
   Mem_Init();
 
   Fs_Init(FS_NONE);
+
+  Ms_Init();
 }
 
 /**
@@ -542,7 +780,7 @@ static void Shutdown(const char *msg) {
     fputs(msg, stdout);
   }
 
-  g_list_free_full(ms_servers, Mem_Free);
+  Ms_Shutdown();
 
   Fs_Shutdown();
 
@@ -607,6 +845,8 @@ int32_t quetoo_main(int32_t argc, char **argv) {
     Com_Error(ERROR_FATAL, "Failed to bind port %i\n", PORT_MASTER);
   }
 
+  Net_SetNonBlocking(ms_sock, true);
+
   Com_Print("Listening on %s\n", atos(&address));
 
   while (true) {
@@ -622,27 +862,7 @@ int32_t quetoo_main(int32_t argc, char **argv) {
     if (select(ms_sock + 1, &set, NULL, NULL, &delay) > 0) {
 
       if (FD_ISSET(ms_sock, &set)) {
-
-        char buffer[0xffff];
-        memset(buffer, 0, sizeof(buffer));
-
-        struct sockaddr_in from;
-        memset(&from, 0, sizeof(from));
-
-        socklen_t from_len = sizeof(from);
-
-        const ssize_t len = recvfrom(ms_sock, buffer, sizeof(buffer), 0,
-                                     (struct sockaddr *) &from, &from_len);
-
-        if (len > 0) {
-          if (len > 4) {
-            Ms_ParseMessage(&from, buffer);
-          } else {
-            Com_Warn("Invalid packet from %s\n", atos(&from));
-          }
-        } else {
-          Com_Warn("Socket error: %s\n", strerror(errno));
-        }
+        Ms_ReadPackets();
       }
     }
 
@@ -650,7 +870,7 @@ int32_t quetoo_main(int32_t argc, char **argv) {
       Com_Shutdown("Received signal %d, quitting...\n", sys_signal_received);
     }
 
-    Ms_Frame();
+    Ms_Frame(time(NULL));
   }
 }
 
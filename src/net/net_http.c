@@ -163,6 +163,181 @@ void Net_HttpPostAsync(const char *url_string, const void *body, size_t length,
   $((URLSessionTask *) task, resume);
 }
 
+/**
+ * @brief Sends all of the specified data on a blocking socket.
+ * @return True if all of the data was sent.
+ */
+static bool Net_HttpSendAll(int32_t sock, const void *data, size_t len) {
+
+  const byte *bytes = data;
+
+  while (len) {
+    const ssize_t sent = Net_Send(sock, bytes, len);
+    if (sent <= 0) {
+      return false;
+    }
+
+    bytes += sent;
+    len -= sent;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Synchronously `GET` a byte range of the specified path, streaming the body to `write`.
+ * @details This speaks HTTP/1.0 directly over a blocking socket, rather than through
+ * `URLSession`, so that the response is streamed rather than buffered, and so that its
+ * `Content-Range` and `ETag` are available to the caller.
+ */
+int32_t Net_HttpGetRange(const net_addr_t *addr, const char *path, int64_t offset, int64_t length,
+                         const char *etag, Net_HttpWriteFunc write, void *user_data,
+                         net_http_response_t *response) {
+
+  memset(response, 0, sizeof(*response));
+  response->status = -1;
+  response->length = -1;
+  response->size = -1;
+
+  char request[MAX_OS_PATH + 256];
+  int32_t request_len = g_snprintf(request, sizeof(request), "GET /%s HTTP/1.0\r\n", path);
+
+  if (offset || length) {
+    if (length) {
+      request_len += g_snprintf(request + request_len, sizeof(request) - request_len,
+                                "Range: bytes=%" PRId64 "-%" PRId64 "\r\n", offset, offset + length - 1);
+    } else {
+      request_len += g_snprintf(request + request_len, sizeof(request) - request_len,
+                                "Range: bytes=%" PRId64 "-\r\n", offset);
+    }
+
+    if (etag && *etag) {
+      request_len += g_snprintf(request + request_len, sizeof(request) - request_len,
+                                "If-Range: %s\r\n", etag);
+    }
+  }
+
+  request_len += g_snprintf(request + request_len, sizeof(request) - request_len, "\r\n");
+  if (request_len >= (int32_t) sizeof(request)) {
+    Com_Warn("Request for %s is too long\n", path);
+    return -1;
+  }
+
+  Com_Debug(DEBUG_NET, "%s: %" PRId64 " + %" PRId64 "\n", path, offset, length);
+
+  const int32_t sock = Net_Connect(addr, NET_HTTP_TIMEOUT);
+  if (sock == -1) {
+    return -1;
+  }
+
+  int32_t status = -1;
+
+  char header[2048];
+  size_t header_len = 0;
+  char *body = NULL;
+
+  if (!Net_HttpSendAll(sock, request, request_len)) {
+    goto done;
+  }
+
+  while (body == NULL) {
+
+    if (header_len == sizeof(header) - 1) {
+      goto done;
+    }
+
+    const ssize_t received = Net_Recv(sock, header + header_len, sizeof(header) - 1 - header_len);
+    if (received <= 0) {
+      goto done;
+    }
+
+    header_len += received;
+    header[header_len] = '\0';
+
+    body = strstr(header, "\r\n\r\n");
+  }
+
+  body += 4;
+
+  if (sscanf(header, "HTTP/%*d.%*d %d", &status) != 1) {
+    status = -1;
+    goto done;
+  }
+
+  char value[128];
+  if (Net_HttpParseHeader(header, "Content-Length", value, sizeof(value))) {
+    response->length = g_ascii_strtoll(value, NULL, 10);
+  }
+
+  Net_HttpParseHeader(header, "ETag", response->etag, sizeof(response->etag));
+
+  if (status == 200) {
+    response->offset = 0;
+    response->size = response->length;
+  } else if (status == 206) {
+    int64_t first, last, size;
+    if (!Net_HttpParseHeader(header, "Content-Range", value, sizeof(value)) ||
+        sscanf(value, "bytes %" SCNd64 "-%" SCNd64 "/%" SCNd64, &first, &last, &size) != 3) {
+      status = -1;
+      goto done;
+    }
+
+    response->offset = first;
+    response->length = last - first + 1;
+    response->size = size;
+  } else {
+    goto done; // no body of interest
+  }
+
+  response->status = status;
+
+  // stream the body, beginning with whatever arrived with the header
+  const byte *data = (const byte *) body;
+  size_t data_len = header + header_len - body;
+
+  int64_t remaining = response->length;
+  byte buffer[0x8000];
+
+  while (true) {
+
+    if (remaining >= 0 && (int64_t) data_len > remaining) {
+      data_len = (size_t) remaining;
+    }
+
+    if (data_len) {
+      if (!write(response, data, data_len, user_data)) {
+        status = -1;
+        break;
+      }
+
+      if (remaining >= 0) {
+        remaining -= data_len;
+      }
+    }
+
+    if (remaining == 0) {
+      break;
+    }
+
+    const ssize_t received = Net_Recv(sock, buffer, sizeof(buffer));
+    if (received == 0 && remaining == -1) {
+      break; // the body is delimited by the connection closing
+    } else if (received <= 0) {
+      status = -1;
+      break;
+    }
+
+    data = buffer;
+    data_len = received;
+  }
+
+done:
+  Net_CloseSocket(sock);
+
+  response->status = status;
+  return status;
+}
+
 /**
  * @brief Construct an HTTP URL from a `net_addr_t` and path.
  */
@@ -216,11 +391,125 @@ bool Net_HttpParseRequestLine(const char *request, char *method, size_t method_s
 }
 
 /**
- * @brief Format an HTTP/1.0 response header into a buffer.
+ * @brief Find the value of a header field in an HTTP request or response.
  */
-int32_t Net_HttpFormatResponse(int32_t status, const char *reason,
-                               const char *content_type, int64_t content_length,
-                               char *buf, size_t buf_size) {
+bool Net_HttpParseHeader(const char *message, const char *name, char *value, size_t value_size) {
+
+  const size_t name_len = strlen(name);
+
+  // skip the request or status line
+  const char *line = strstr(message, "\r\n");
+
+  while (line) {
+    line += 2;
+
+    const char *end = strstr(line, "\r\n");
+    if (end == NULL || end == line) {
+      break; // end of headers
+    }
+
+    if (g_ascii_strncasecmp(line, name, name_len) == 0 && line[name_len] == ':') {
+
+      const char *start = line + name_len + 1;
+      while (start < end && (*start == ' ' || *start == '\t')) {
+        start++;
+      }
+
+      const char *stop = end;
+      while (stop > start && (*(stop - 1) == ' ' || *(stop - 1) == '\t')) {
+        stop--;
+      }
+
+      const size_t len = stop - start;
+      if (len >= value_size) {
+        return false;
+      }
+
+      memcpy(value, start, len);
+      value[len] = '\0';
+
+      return true;
+    }
+
+    line = end;
+  }
+
+  return false;
+}
+
+/**
+ * @brief Resolve the value of a `Range` header against a file.
+ */
+int32_t Net_HttpParseRange(const char *range, int64_t size, int64_t *first, int64_t *last) {
+
+  if (strncmp(range, "bytes=", 6) != 0 || strchr(range, ',')) {
+    return 200;
+  }
+
+  const char *spec = range + 6;
+  char *end;
+
+  int64_t f, l;
+
+  if (*spec == '-') { // suffix range, the last n bytes
+    const int64_t n = g_ascii_strtoll(spec + 1, &end, 10);
+    if (end == spec + 1 || *end || n < 0) {
+      return 200;
+    }
+
+    if (n == 0 || size == 0) {
+      return 416;
+    }
+
+    f = n < size ? size - n : 0;
+    l = size - 1;
+  } else {
+    f = g_ascii_strtoll(spec, &end, 10);
+    if (end == spec || *end != '-' || f < 0) {
+      return 200;
+    }
+
+    spec = end + 1;
+    if (*spec) {
+      l = g_ascii_strtoll(spec, &end, 10);
+      if (end == spec || *end || l < f) {
+        return 200;
+      }
+    } else {
+      l = size - 1;
+    }
+
+    if (f >= size) {
+      return 416;
+    }
+
+    if (l >= size) {
+      l = size - 1;
+    }
+  }
+
+  // the outputs are only written for a satisfiable range, so that they are never left
+  // holding a partially parsed one
+  *first = f;
+  *last = l;
+
+  return 206;
+}
+
+/**
+ * @brief Format an entity tag for a file from its size and modification time.
+ */
+int32_t Net_HttpFormatETag(int64_t size, int64_t mtime, char *buf, size_t buf_size) {
+
+  return g_snprintf(buf, buf_size, "\"%" PRIx64 "-%" PRIx64 "\"", (uint64_t) size, (uint64_t) mtime);
+}
+
+/**
+ * @brief Format an HTTP/1.0 response header with additional header fields into a buffer.
+ */
+int32_t Net_HttpFormatResponseFields(int32_t status, const char *reason,
+                                     const char *content_type, int64_t content_length,
+                                     const char *fields, char *buf, size_t buf_size) {
 
   if (content_type) {
     return g_snprintf(buf, buf_size,
@@ -228,18 +517,30 @@ int32_t Net_HttpFormatResponse(int32_t status, const char *reason,
       "Connection: close\r\n"
       "Content-Length: %" PRId64 "\r\n"
       "Content-Type: %s\r\n"
+      "%s"
       "\r\n",
-      status, reason, content_length, content_type);
+      status, reason, content_length, content_type, fields ?: "");
   } else {
     return g_snprintf(buf, buf_size,
       "HTTP/1.0 %d %s\r\n"
       "Connection: close\r\n"
       "Content-Length: %" PRId64 "\r\n"
+      "%s"
       "\r\n",
-      status, reason, content_length);
+      status, reason, content_length, fields ?: "");
   }
 }
 
+/**
+ * @brief Format an HTTP/1.0 response header into a buffer.
+ */
+int32_t Net_HttpFormatResponse(int32_t status, const char *reason,
+                               const char *content_type, int64_t content_length,
+                               char *buf, size_t buf_size) {
+
+  return Net_HttpFormatResponseFields(status, reason, content_type, content_length, NULL, buf, buf_size);
+}
+
 /**
  * @brief Send an HTTP error response on a socket.
  */
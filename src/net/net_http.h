@@ -32,6 +32,57 @@
  */
 typedef void (*Net_HttpCallback)(int32_t status, void *body, size_t length, void *user_data);
 
+/**
+ * @brief The maximum length of an HTTP entity tag, including its quotes.
+ */
+#define NET_HTTP_ETAG_SIZE 64
+
+/**
+ * @brief The timeout in milliseconds for stalled `Net_HttpGetRange` requests.
+ */
+#define NET_HTTP_TIMEOUT 10000
+
+/**
+ * @brief The response to a `Net_HttpGetRange` request.
+ */
+typedef struct {
+
+  /**
+   * @brief The HTTP status code, or -1 if the request failed or its body was truncated.
+   */
+  int32_t status;
+
+  /**
+   * @brief The offset of the response body within the file.
+   */
+  int64_t offset;
+
+  /**
+   * @brief The response body length in bytes, or -1 if the server did not specify it.
+   */
+  int64_t length;
+
+  /**
+   * @brief The file size in bytes, or -1 if unknown.
+   */
+  int64_t size;
+
+  /**
+   * @brief The entity tag of the file, or empty if the server did not specify one.
+   */
+  char etag[NET_HTTP_ETAG_SIZE];
+} net_http_response_t;
+
+/**
+ * @brief The `Net_HttpGetRange` body callback, invoked as the body is received.
+ * @param response The response, whose headers have been parsed.
+ * @param data The body bytes.
+ * @param length The number of body bytes.
+ * @param user_data The user data pointer passed to `Net_HttpGetRange`.
+ * @return False to abort the request.
+ */
+typedef bool (*Net_HttpWriteFunc)(const net_http_response_t *response, const void *data, size_t length, void *user_data);
+
 /**
  * @brief Synchronously `GET` the specified URL string.
  * @param url_string The URL string to `GET`.
@@ -61,6 +112,24 @@ void Net_HttpGetAsync(const char *url_string, Net_HttpCallback callback, void *u
 void Net_HttpPostAsync(const char *url_string, const void *body, size_t length,
                        const char *content_type, Net_HttpCallback callback, void *user_data);
 
+/**
+ * @brief Synchronously `GET` a byte range of the specified path from an HTTP server, streaming
+ * the response body to `write`. This is safe to call from any thread.
+ * @param addr The server address.
+ * @param path The path, without leading slash.
+ * @param offset The offset of the first byte to request.
+ * @param length The number of bytes to request, or 0 for all bytes from `offset`.
+ * @param etag The entity tag of a partially downloaded file, or `NULL`. If the file has since
+ * changed, the server responds with the entire file and status 200.
+ * @param write The body callback.
+ * @param user_data User data pointer passed through to `write`.
+ * @param response Receives the response.
+ * @return The HTTP response code, or -1 on failure.
+ */
+int32_t Net_HttpGetRange(const net_addr_t *addr, const char *path, int64_t offset, int64_t length,
+                         const char *etag, Net_HttpWriteFunc write, void *user_data,
+                         net_http_response_t *response);
+
 /**
  * @brief Construct an HTTP URL from a `net_addr_t` and path.
  * @param addr The server address.
@@ -83,6 +152,53 @@ int32_t Net_HttpUrl(const net_addr_t *addr, const char *path, char *buf, size_t
 bool Net_HttpParseRequestLine(const char *request, char *method, size_t method_size,
                               char *path, size_t path_size);
 
+/**
+ * @brief Find the value of a header field in an HTTP request or response.
+ * @param message The raw HTTP message (must be null-terminated).
+ * @param name The header field name, which is matched case-insensitively.
+ * @param value The header field value, without surrounding whitespace.
+ * @param value_size The size of the value buffer.
+ * @return True if the header field was found, and its value fit in the buffer.
+ */
+bool Net_HttpParseHeader(const char *message, const char *name, char *value, size_t value_size);
+
+/**
+ * @brief Resolve the value of a `Range` header against a file. Only single byte ranges are
+ * supported.
+ * @param range The `Range` header field value (e.g. "bytes=`0-1023`").
+ * @param size The file size in bytes.
+ * @param first The first byte of the range, written only if the range is satisfiable.
+ * @param last The last byte of the range, inclusive, written only if the range is satisfiable.
+ * @return 206 if the range is satisfiable, 416 if it is not, or 200 if the header is
+ * malformed or unsupported and should be ignored.
+ */
+int32_t Net_HttpParseRange(const char *range, int64_t size, int64_t *first, int64_t *last);
+
+/**
+ * @brief Format an entity tag for a file from its size and modification time.
+ * @param size The file size in bytes.
+ * @param mtime The file modification time.
+ * @param buf The output buffer, which should be `NET_HTTP_ETAG_SIZE` bytes.
+ * @param buf_size The size of the output buffer.
+ * @return The number of characters written.
+ */
+int32_t Net_HttpFormatETag(int64_t size, int64_t mtime, char *buf, size_t buf_size);
+
+/**
+ * @brief Format an HTTP/1.0 response header with additional header fields into a buffer.
+ * @param status The HTTP status code.
+ * @param reason The HTTP reason phrase.
+ * @param content_type The Content-Type header value, or `NULL` for none.
+ * @param content_length The Content-Length value.
+ * @param fields Additional header fields, each terminated by CRLF, or `NULL` for none.
+ * @param buf The output buffer.
+ * @param buf_size The size of the output buffer.
+ * @return The number of characters written.
+ */
+int32_t Net_HttpFormatResponseFields(int32_t status, const char *reason,
+                                     const char *content_type, int64_t content_length,
+                                     const char *fields, char *buf, size_t buf_size);
+
 /**
  * @brief Format an HTTP/1.0 response header into a buffer.
  * @param status The HTTP status code.
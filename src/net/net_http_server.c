@@ -0,0 +1,803 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "net_http_server.h"
+
+#if defined(_WIN32)
+  #define poll WSAPoll
+#else
+  #include <poll.h>
+#endif
+
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+
+/**
+ * @brief The interval in milliseconds at which the server thread checks for shutdown and
+ * close requests while idle.
+ */
+#define NET_HTTP_SERVER_POLL_TIMEOUT 100
+
+/**
+ * @brief The maximum number of bytes sent to a connection before servicing the others.
+ */
+#define NET_HTTP_SERVER_SEND_SIZE 0x40000
+
+/**
+ * @brief A file in the server's cache, shared read-only by all connections serving it.
+ */
+typedef struct {
+
+  /**
+   * @brief The file path, which is also its key in the cache.
+   */
+  char *path;
+
+  /**
+   * @brief The file contents, read into memory.
+   */
+  byte *data;
+
+  /**
+   * @brief The file size in bytes.
+   */
+  int64_t size;
+
+  /**
+   * @brief The file modification time, to revalidate the cached contents.
+   */
+  int64_t mod_time;
+
+  /**
+   * @brief The entity tag, derived from the file size and modification time.
+   */
+  char etag[NET_HTTP_ETAG_SIZE];
+
+  /**
+   * @brief The number of connections serving this file.
+   */
+  int32_t refcount;
+
+  /**
+   * @brief The server iteration at which this file was last requested, for eviction.
+   */
+  uint64_t last_used;
+
+  /**
+   * @brief True if the file changed on disk and was removed from the cache. It is freed
+   * when the last connection serving it releases it.
+   */
+  bool stale;
+} net_http_file_t;
+
+/**
+ * @brief A connection, which reads a single request and then streams a single response.
+ */
+typedef struct {
+
+  /**
+   * @brief The socket.
+   */
+  int32_t socket;
+
+  /**
+   * @brief The key assigned by the connection filter.
+   */
+  int32_t key;
+
+  /**
+   * @brief The request, accumulated until the blank line terminating its headers.
+   */
+  char request[1024];
+  int32_t request_len;
+
+  /**
+   * @brief The response header, and the number of its bytes sent.
+   */
+  char header[512];
+  int32_t header_len;
+  int32_t header_sent;
+
+  /**
+   * @brief The file being served, or `NULL` while the request is being read.
+   */
+  net_http_file_t *file;
+
+  /**
+   * @brief The offset of the next body byte to send.
+   */
+  int64_t offset;
+
+  /**
+   * @brief The offset at which the body ends, exclusive.
+   */
+  int64_t end;
+} net_http_connection_t;
+
+/**
+ * @brief The server.
+ */
+struct net_http_server_s {
+
+  /**
+   * @brief The configuration.
+   */
+  net_http_server_config_t config;
+
+  /**
+   * @brief The listen socket.
+   */
+  int32_t socket;
+
+  /**
+   * @brief The server thread, which owns the connections and the cache.
+   */
+  SDL_Thread *thread;
+
+  /**
+   * @brief Guards `close_keys`, `shutdown` and `stats`, which are shared with other threads.
+   */
+  SDL_Mutex *lock;
+
+  /**
+   * @brief Keys of connections to close, requested by `Net_HttpServerClose`.
+   */
+  GArray *close_keys;
+
+  /**
+   * @brief Keys of connections being closed, swapped with `close_keys` by the server thread.
+   */
+  GArray *closing_keys;
+
+  /**
+   * @brief Set to terminate the server thread.
+   */
+  bool shutdown;
+
+  /**
+   * @brief The statistics.
+   */
+  net_http_server_stats_t stats;
+
+  /**
+   * @brief The connections.
+   */
+  GPtrArray *connections;
+
+  /**
+   * @brief The file cache, keyed by path.
+   */
+  GHashTable *files;
+
+  /**
+   * @brief The total size of unreferenced files retained in the cache.
+   */
+  size_t cached_size;
+
+  /**
+   * @brief The server iteration, incremented each time the thread wakes.
+   */
+  uint64_t iteration;
+};
+
+/**
+ * @brief Frees the specified cached file.
+ */
+static void Net_HttpServerFreeFile(net_http_file_t *file) {
+
+  Mem_Free(file->data);
+  Mem_Free(file->path);
+  Mem_Free(file);
+}
+
+/**
+ * @brief Evicts the least recently used unreferenced files until the cache is within budget.
+ */
+static void Net_HttpServerTrimCache(net_http_server_t *server) {
+
+  while (server->cached_size > server->config.cache_size) {
+
+    net_http_file_t *oldest = NULL;
+
+    GHashTableIter iter;
+    g_hash_table_iter_init(&iter, server->files);
+
+    net_http_file_t *file;
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &file)) {
+      if (file->refcount == 0) {
+        if (oldest == NULL || file->last_used < oldest->last_used) {
+          oldest = file;
+        }
+      }
+    }
+
+    if (oldest == NULL) {
+      break;
+    }
+
+    Com_Debug(DEBUG_NET, "HTTP: Evicting %s\n", oldest->path);
+
+    server->cached_size -= oldest->size;
+    g_hash_table_remove(server->files, oldest->path);
+    Net_HttpServerFreeFile(oldest);
+  }
+}
+
+/**
+ * @brief Removes the specified file from the cache, because it changed on disk. Connections
+ * already serving it continue to do so, and the last of them frees it.
+ */
+static void Net_HttpServerEvictStaleFile(net_http_server_t *server, net_http_file_t *file) {
+
+  Com_Debug(DEBUG_NET, "HTTP: Evicting stale %s\n", file->path);
+
+  g_hash_table_remove(server->files, file->path);
+
+  if (file->refcount == 0) {
+    server->cached_size -= file->size;
+    Net_HttpServerFreeFile(file);
+  } else {
+    file->stale = true;
+  }
+}
+
+/**
+ * @brief Resolves the specified file from the cache, loading it if necessary. Files are
+ * read into memory once, and shared by all connections serving them. They are not mapped,
+ * as truncating or rewriting a mapped file in place (e.g. recompiling a map while it is
+ * being downloaded) would fault the server thread. Cached files are revalidated against
+ * their size and modification time on every request, so that files replaced on disk are
+ * reloaded.
+ * @return The referenced file, or `NULL` if it could not be found.
+ */
+static net_http_file_t *Net_HttpServerAcquireFile(net_http_server_t *server, const char *path) {
+
+  net_http_file_t *file = g_hash_table_lookup(server->files, path);
+  if (file) {
+    if (Fs_FileSize(path) != file->size || Fs_LastModTime(path) != file->mod_time) {
+      Net_HttpServerEvictStaleFile(server, file);
+      file = NULL;
+    }
+  }
+
+  if (file) {
+    if (file->refcount++ == 0) {
+      server->cached_size -= file->size;
+    }
+
+    file->last_used = server->iteration;
+
+    SDL_LockMutex(server->lock);
+    server->stats.cache_hits++;
+    SDL_UnlockMutex(server->lock);
+
+    return file;
+  }
+
+  void *data = NULL;
+
+  file_t *f = Fs_OpenRead(path);
+  if (f == NULL) {
+    return NULL;
+  }
+
+  const int64_t size = Fs_FileLength(f);
+  if (size < 0) {
+    Fs_Close(f);
+    return NULL;
+  }
+
+  if (size) {
+    data = Mem_Malloc(size);
+    if (Fs_Read(f, data, 1, size) != size) {
+      Com_Warn("HTTP: Failed to read %s\n", path);
+      Mem_Free(data);
+      Fs_Close(f);
+      return NULL;
+    }
+  }
+
+  Fs_Close(f);
+
+  file = Mem_Malloc(sizeof(*file));
+  file->path = Mem_CopyString(path);
+  file->data = data;
+  file->size = size;
+  file->refcount = 1;
+  file->mod_time = Fs_LastModTime(path);
+  file->stale = false;
+
+  Net_HttpFormatETag(size, file->mod_time, file->etag, sizeof(file->etag));
+
+  file->last_used = server->iteration;
+
+  g_hash_table_insert(server->files, file->path, file);
+
+  SDL_LockMutex(server->lock);
+  server->stats.cache_misses++;
+  SDL_UnlockMutex(server->lock);
+
+  Com_Debug(DEBUG_NET, "HTTP: Cached %s (%" PRId64 " bytes)\n", path, size);
+  return file;
+}
+
+/**
+ * @brief Releases a reference to the specified file, which is retained in the cache while
+ * the cache is within budget.
+ */
+static void Net_HttpServerReleaseFile(net_http_server_t *server, net_http_file_t *file) {
+
+  if (--file->refcount == 0) {
+    if (file->stale) {
+      Net_HttpServerFreeFile(file);
+    } else {
+      server->cached_size += file->size;
+      Net_HttpServerTrimCache(server);
+    }
+  }
+}
+
+/**
+ * @brief Closes the connection at the specified index.
+ */
+static void Net_HttpServerCloseConnection(net_http_server_t *server, guint index) {
+
+  net_http_connection_t *conn = g_ptr_array_index(server->connections, index);
+
+  if (conn->file) {
+    Net_HttpServerReleaseFile(server, conn->file);
+  }
+
+  Net_CloseSocket(conn->socket);
+  Mem_Free(conn);
+
+  g_ptr_array_remove_index_fast(server->connections, index);
+}
+
+/**
+ * @brief Sends an error response and closes the connection at the specified index.
+ */
+static void Net_HttpServerSendError(net_http_server_t *server, guint index, int32_t status, const char *reason) {
+
+  const net_http_connection_t *conn = g_ptr_array_index(server->connections, index);
+
+  Net_HttpSendError(conn->socket, status, reason);
+
+  Net_HttpServerCloseConnection(server, index);
+}
+
+/**
+ * @brief Parses the completed request and begins the response.
+ * @return True if the response was begun, false if the connection was closed.
+ */
+static bool Net_HttpServerHandleRequest(net_http_server_t *server, guint index) {
+
+  net_http_connection_t *conn = g_ptr_array_index(server->connections, index);
+
+  char method[16], path[MAX_OS_PATH];
+  if (!Net_HttpParseRequestLine(conn->request, method, sizeof(method), path, sizeof(path))) {
+    Net_HttpServerSendError(server, index, 400, "Bad Request");
+    return false;
+  }
+
+  if (strcmp(method, "GET") != 0) {
+    Net_HttpServerSendError(server, index, 405, "Method Not Allowed");
+    return false;
+  }
+
+  if (server->config.Allow && !server->config.Allow(path, server->config.user_data)) {
+    Net_HttpServerSendError(server, index, 403, "Forbidden");
+    return false;
+  }
+
+  conn->file = Net_HttpServerAcquireFile(server, path);
+  if (conn->file == NULL) {
+    Com_Debug(DEBUG_NET, "HTTP: File not found: %s\n", path);
+    Net_HttpServerSendError(server, index, 404, "Not Found");
+    return false;
+  }
+
+  const net_http_file_t *file = conn->file;
+
+  int32_t status = 200;
+  int64_t first = 0, last = file->size - 1;
+
+  char value[256];
+  if (Net_HttpParseHeader(conn->request, "If-None-Match", value, sizeof(value)) &&
+      (strstr(value, file->etag) || !strcmp(value, "*"))) {
+    status = 304;
+  } else if (Net_HttpParseHeader(conn->request, "Range", value, sizeof(value))) {
+
+    // a range of a file which has since changed is ignored, and the entire file is sent
+    char if_range[NET_HTTP_ETAG_SIZE];
+    if (!Net_HttpParseHeader(conn->request, "If-Range", if_range, sizeof(if_range)) ||
+        !strcmp(if_range, file->etag)) {
+      status = Net_HttpParseRange(value, file->size, &first, &last);
+    }
+  }
+
+  char fields[192];
+  switch (status) {
+    case 200:
+      g_snprintf(fields, sizeof(fields), "Accept-Ranges: bytes\r\nETag: %s\r\n", file->etag);
+      conn->header_len = Net_HttpFormatResponseFields(200, "OK", "application/octet-stream", file->size,
+                                                      fields, conn->header, sizeof(conn->header));
+      break;
+
+    case 206:
+      g_snprintf(fields, sizeof(fields), "Accept-Ranges: bytes\r\nETag: %s\r\n"
+                 "Content-Range: bytes %" PRId64 "-%" PRId64 "/%" PRId64 "\r\n",
+                 file->etag, first, last, file->size);
+      conn->header_len = Net_HttpFormatResponseFields(206, "Partial Content", "application/octet-stream", last - first + 1,
+                                                      fields, conn->header, sizeof(conn->header));
+      break;
+
+    case 304:
+      g_snprintf(fields, sizeof(fields), "ETag: %s\r\n", file->etag);
+      conn->header_len = Net_HttpFormatResponseFields(304, "Not Modified", NULL, 0,
+                                                      fields, conn->header, sizeof(conn->header));
+      break;
+
+    default:
+      g_snprintf(fields, sizeof(fields), "Content-Range: bytes */%" PRId64 "\r\n", file->size);
+      conn->header_len = Net_HttpFormatResponseFields(416, "Range Not Satisfiable", NULL, 0,
+                                                      fields, conn->header, sizeof(conn->header));
+      break;
+  }
+
+  if (status == 200 || status == 206) {
+    conn->offset = first;
+    conn->end = last + 1;
+  }
+
+  Com_Debug(DEBUG_NET, "HTTP: Serving %s (%d, %" PRId64 " bytes)\n", path, status, conn->end - conn->offset);
+  return true;
+}
+
+/**
+ * @brief Reads from the connection at the specified index until its request is complete.
+ */
+static void Net_HttpServerRead(net_http_server_t *server, guint index) {
+
+  net_http_connection_t *conn = g_ptr_array_index(server->connections, index);
+
+  const ssize_t received = Net_Recv(conn->socket,
+                                    conn->request + conn->request_len,
+                                    sizeof(conn->request) - 1 - conn->request_len);
+
+  if (received > 0) {
+    conn->request_len += (int32_t) received;
+    conn->request[conn->request_len] = '\0';
+
+    if (strstr(conn->request, "\r\n\r\n")) {
+      Net_HttpServerHandleRequest(server, index);
+    } else if (conn->request_len >= (int32_t) sizeof(conn->request) - 1) {
+      Net_HttpServerSendError(server, index, 400, "Bad Request");
+    }
+  } else if (received == 0 || Net_GetError() != EWOULDBLOCK) {
+    Net_HttpServerCloseConnection(server, index);
+  }
+}
+
+/**
+ * @brief Sends as much of the response to the connection at the specified index as its
+ * socket will accept, up to `NET_HTTP_SERVER_SEND_SIZE`. The body, or the requested range
+ * of it, is sent directly from the cached file, without copying.
+ */
+static void Net_HttpServerSend(net_http_server_t *server, guint index) {
+
+  net_http_connection_t *conn = g_ptr_array_index(server->connections, index);
+
+  while (conn->header_sent < conn->header_len) {
+    const ssize_t sent = Net_Send(conn->socket, conn->header + conn->header_sent, conn->header_len - conn->header_sent);
+    if (sent > 0) {
+      conn->header_sent += (int32_t) sent;
+    } else {
+      if (sent == 0 || Net_GetError() != EWOULDBLOCK) {
+        Net_HttpServerCloseConnection(server, index);
+      }
+      return;
+    }
+  }
+
+  int64_t budget = NET_HTTP_SERVER_SEND_SIZE, total = 0;
+  bool closed = false;
+
+  while (budget > 0 && conn->offset < conn->end) {
+    const int64_t remaining = conn->end - conn->offset;
+    const size_t len = (size_t) (remaining < budget ? remaining : budget);
+
+    const ssize_t sent = Net_Send(conn->socket, conn->file->data + conn->offset, len);
+    if (sent > 0) {
+      conn->offset += sent;
+      budget -= sent;
+      total += sent;
+    } else {
+      closed = sent == 0 || Net_GetError() != EWOULDBLOCK;
+      break;
+    }
+  }
+
+  const bool complete = conn->offset == conn->end;
+
+  SDL_LockMutex(server->lock);
+  server->stats.bytes_sent += total;
+  if (complete) {
+    server->stats.responses++;
+  }
+  SDL_UnlockMutex(server->lock);
+
+  if (complete || closed) {
+    Net_HttpServerCloseConnection(server, index);
+  }
+}
+
+/**
+ * @brief Counts the open connections identified by the specified key.
+ */
+int32_t Net_HttpServerConnections(const net_http_server_t *server, int32_t key) {
+
+  int32_t count = 0;
+
+  for (guint i = 0; i < server->connections->len; i++) {
+    const net_http_connection_t *conn = g_ptr_array_index(server->connections, i);
+    if (conn->key == key) {
+      count++;
+    }
+  }
+
+  return count;
+}
+
+/**
+ * @brief The maximum number of concurrent connections per key.
+ */
+int32_t Net_HttpServerMaxConnectionsPerKey(const net_http_server_t *server) {
+  return server->config.max_connections_per_key;
+}
+
+/**
+ * @brief Closes all connections whose keys were requested closed.
+ */
+static void Net_HttpServerCloseKeys(net_http_server_t *server) {
+
+  SDL_LockMutex(server->lock);
+
+  GArray *keys = server->close_keys;
+  server->close_keys = server->closing_keys;
+  server->closing_keys = keys;
+
+  SDL_UnlockMutex(server->lock);
+
+  for (guint i = 0; i < keys->len; i++) {
+    const int32_t key = g_array_index(keys, int32_t, i);
+
+    for (guint j = server->connections->len; j > 0; j--) {
+      const net_http_connection_t *conn = g_ptr_array_index(server->connections, j - 1);
+      if (conn->key == key) {
+        Net_HttpServerCloseConnection(server, j - 1);
+      }
+    }
+  }
+
+  g_array_set_size(keys, 0);
+}
+
+/**
+ * @brief Accepts all pending connections, subject to the connection filter.
+ */
+static void Net_HttpServerAccept(net_http_server_t *server) {
+
+  net_addr_t from;
+  int32_t sock;
+
+  while ((sock = Net_Accept(server->socket, &from)) != -1) {
+
+    if ((int32_t) server->connections->len >= server->config.max_connections) {
+      Com_Debug(DEBUG_NET, "HTTP: Too many connections, rejecting %s\n", Net_NetaddrToIpString(&from));
+      Net_HttpSendError(sock, 503, "Service Unavailable");
+      Net_CloseSocket(sock);
+      continue;
+    }
+
+    int32_t key = -1;
+    if (server->config.Accept) {
+      key = server->config.Accept(server, &from, server->config.user_data);
+
+      // closes requested before the filter ran must not claim the new connection
+      Net_HttpServerCloseKeys(server);
+
+      if (key != -1 && Net_HttpServerConnections(server, key) >= server->config.max_connections_per_key) {
+        key = -1; // already has its share of connections
+      }
+
+      if (key == -1) {
+        Com_Debug(DEBUG_NET, "HTTP: Rejected connection from %s\n", Net_NetaddrToIpString(&from));
+        Net_HttpSendError(sock, 403, "Forbidden");
+        Net_CloseSocket(sock);
+        continue;
+      }
+    }
+
+    net_http_connection_t *conn = Mem_Malloc(sizeof(*conn));
+    conn->socket = sock;
+    conn->key = key;
+
+    g_ptr_array_add(server->connections, conn);
+
+    Com_Debug(DEBUG_NET, "HTTP: Accepted connection from %s\n", Net_NetaddrToIpString(&from));
+  }
+}
+
+/**
+ * @brief The server thread. Waits on the listen socket and all connections, reading
+ * requests and streaming responses as their sockets become ready.
+ */
+static int32_t Net_HttpServerThread(void *data) {
+
+  net_http_server_t *server = data;
+
+  GArray *fds = g_array_new(false, false, sizeof(struct pollfd));
+
+  while (true) {
+
+    SDL_LockMutex(server->lock);
+
+    const bool shutdown = server->shutdown;
+
+    server->stats.connections = (int32_t) server->connections->len;
+
+    SDL_UnlockMutex(server->lock);
+
+    if (shutdown) {
+      break;
+    }
+
+    Net_HttpServerCloseKeys(server);
+
+    g_array_set_size(fds, 0);
+    g_array_append_val(fds, ((struct pollfd) { .fd = server->socket, .events = POLLIN }));
+
+    for (guint i = 0; i < server->connections->len; i++) {
+      const net_http_connection_t *conn = g_ptr_array_index(server->connections, i);
+      g_array_append_val(fds, ((struct pollfd) { .fd = conn->socket, .events = conn->file ? POLLOUT : POLLIN }));
+    }
+
+    const guint num_connections = server->connections->len;
+
+    if (poll((struct pollfd *) fds->data, fds->len, NET_HTTP_SERVER_POLL_TIMEOUT) <= 0) {
+      continue;
+    }
+
+    server->iteration++;
+
+    // service in reverse, so that closing a connection only moves one already serviced
+    for (guint i = num_connections; i > 0; i--) {
+      const struct pollfd *fd = &g_array_index(fds, struct pollfd, i);
+
+      if (fd->revents == 0) {
+        continue;
+      }
+
+      const net_http_connection_t *conn = g_ptr_array_index(server->connections, i - 1);
+      if (conn->file) {
+        Net_HttpServerSend(server, i - 1);
+      } else {
+        Net_HttpServerRead(server, i - 1);
+      }
+    }
+
+    if (g_array_index(fds, struct pollfd, 0).revents & POLLIN) {
+      Net_HttpServerAccept(server);
+    }
+  }
+
+  while (server->connections->len) {
+    Net_HttpServerCloseConnection(server, server->connections->len - 1);
+  }
+
+  g_array_free(fds, true);
+
+  return 0;
+}
+
+/**
+ * @brief Creates an HTTP file server and starts its thread.
+ */
+net_http_server_t *Net_HttpServerCreate(const net_http_server_config_t *config) {
+
+  const int32_t sock = Net_SocketListen(config->iface, config->port, 64);
+  if (sock == -1) {
+    return NULL;
+  }
+
+  net_http_server_t *server = Mem_Malloc(sizeof(*server));
+
+  server->config = *config;
+  server->config.max_connections = config->max_connections ?: 64;
+  server->config.max_connections_per_key = config->max_connections_per_key ?: 1;
+
+  server->socket = sock;
+  server->lock = SDL_CreateMutex();
+  server->close_keys = g_array_new(false, false, sizeof(int32_t));
+  server->closing_keys = g_array_new(false, false, sizeof(int32_t));
+  server->connections = g_ptr_array_new();
+  server->files = g_hash_table_new(g_str_hash, g_str_equal);
+
+  server->thread = SDL_CreateThread(Net_HttpServerThread, __func__, server);
+
+  return server;
+}
+
+/**
+ * @brief Requests that any connection identified by the specified key be closed.
+ */
+void Net_HttpServerClose(net_http_server_t *server, int32_t key) {
+
+  if (key == -1) {
+    return;
+  }
+
+  SDL_LockMutex(server->lock);
+  g_array_append_val(server->close_keys, key);
+  SDL_UnlockMutex(server->lock);
+}
+
+/**
+ * @brief Copies the statistics of the specified server.
+ */
+void Net_HttpServerStats(net_http_server_t *server, net_http_server_stats_t *stats) {
+
+  SDL_LockMutex(server->lock);
+  *stats = server->stats;
+  SDL_UnlockMutex(server->lock);
+}
+
+/**
+ * @brief Stops the server thread, closes all connections, and frees the server.
+ */
+void Net_HttpServerDestroy(net_http_server_t *server) {
+
+  SDL_LockMutex(server->lock);
+  server->shutdown = true;
+  SDL_UnlockMutex(server->lock);
+
+  SDL_WaitThread(server->thread, NULL);
+
+  Net_CloseSocket(server->socket);
+
+  GHashTableIter iter;
+  g_hash_table_iter_init(&iter, server->files);
+
+  net_http_file_t *file;
+  while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &file)) {
+    Net_HttpServerFreeFile(file);
+  }
+
+  g_hash_table_destroy(server->files);
+  g_ptr_array_free(server->connections, true);
+  g_array_free(server->close_keys, true);
+  g_array_free(server->closing_keys, true);
+
+  SDL_DestroyMutex(server->lock);
+
+  Mem_Free(server);
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#pragma once
+
+#include "net_http.h"
+
+/**
+ * @brief An HTTP file server, serving files from the virtual filesystem on a dedicated thread.
+ */
+typedef struct net_http_server_s net_http_server_t;
+
+/**
+ * @brief The connection filter, invoked on the server thread for each accepted connection.
+ * @param server The server.
+ * @param from The remote address.
+ * @param user_data The user data pointer from the server configuration.
+ * @return A non-negative key identifying the owner of the connection (e.g. a client slot),
+ * or -1 to reject it. At most `max_connections_per_key` connections per key are permitted
+ * at a time.
+ */
+typedef int32_t (*Net_HttpServerAcceptFunc)(const net_http_server_t *server, const net_addr_t *from, void *user_data);
+
+/**
+ * @brief The request filter, invoked on the server thread for each requested path.
+ * @param path The requested path, without leading slash.
+ * @param user_data The user data pointer from the server configuration.
+ * @return True if the path may be served.
+ */
+typedef bool (*Net_HttpServerAllowFunc)(const char *path, void *user_data);
+
+/**
+ * @brief HTTP file server configuration.
+ */
+typedef struct {
+
+  /**
+   * @brief The interface to listen on, or `NULL` for all interfaces.
+   */
+  const char *iface;
+
+  /**
+   * @brief The port to listen on.
+   */
+  in_port_t port;
+
+  /**
+   * @brief The maximum number of concurrent connections.
+   */
+  int32_t max_connections;
+
+  /**
+   * @brief The maximum number of concurrent connections per key, e.g. for range requests
+   * fetched in parallel. Defaults to 1.
+   */
+  int32_t max_connections_per_key;
+
+  /**
+   * @brief The budget in bytes for unreferenced files retained in the file cache.
+   */
+  size_t cache_size;
+
+  /**
+   * @brief The connection filter, or `NULL` to accept all connections.
+   */
+  Net_HttpServerAcceptFunc Accept;
+
+  /**
+   * @brief The request filter, or `NULL` to allow all paths.
+   */
+  Net_HttpServerAllowFunc Allow;
+
+  /**
+   * @brief User data passed through to the filters.
+   */
+  void *user_data;
+} net_http_server_config_t;
+
+/**
+ * @brief HTTP file server statistics.
+ */
+typedef struct {
+
+  /**
+   * @brief The number of open connections.
+   */
+  int32_t connections;
+
+  /**
+   * @brief The number of responses completed.
+   */
+  int64_t responses;
+
+  /**
+   * @brief The number of body bytes sent.
+   */
+  int64_t bytes_sent;
+
+  /**
+   * @brief The number of requests served from an already cached file.
+   */
+  int64_t cache_hits;
+
+  /**
+   * @brief The number of requests which loaded a file.
+   */
+  int64_t cache_misses;
+} net_http_server_stats_t;
+
+
+/**
+ * @brief Creates an HTTP file server and starts its thread.
+ * @param config The server configuration, which is copied.
+ * @return The server, or `NULL` if its socket could not be created.
+ */
+net_http_server_t *Net_HttpServerCreate(const net_http_server_config_t *config);
+
+/**
+ * @brief Counts the open connections identified by the specified key. This must be called on
+ * the server thread, i.e. from the connection filter.
+ * @param server The server.
+ * @param key The key.
+ * @return The number of open connections identified by `key`.
+ */
+int32_t Net_HttpServerConnections(const net_http_server_t *server, int32_t key);
+
+/**
+ * @brief The maximum number of concurrent connections per key of the specified server.
+ * @param server The server.
+ * @return The maximum number of concurrent connections per key.
+ */
+int32_t Net_HttpServerMaxConnectionsPerKey(const net_http_server_t *server);
+
+/**
+ * @brief Closes any connection identified by the specified key. This is asynchronous, and
+ * takes effect on the server thread.
+ * @param server The server.
+ * @param key The key returned by the connection filter.
+ */
+void Net_HttpServerClose(net_http_server_t *server, int32_t key);
+
+/**
+ * @brief Copies the statistics of the specified server.
+ * @param server The server.
+ * @param stats The statistics.
+ */
+void Net_HttpServerStats(net_http_server_t *server, net_http_server_stats_t *stats);
+
+/**
+ * @brief Stops the server thread, closes all connections, and frees the server.
+ * @param server The server.
+ */
+void Net_HttpServerDestroy(net_http_server_t *server);
@@ -26,6 +26,52 @@ typedef union {
   float v;
 } net_float;
 
+/**
+ * @brief Quantizes a position component to the `NET_POSITION_SCALE` grid.
+ */
+static inline int32_t Net_QuantizePosition(float f) {
+  return (int32_t) floorf(f * NET_POSITION_SCALE + .5f);
+}
+
+/**
+ * @brief Returns the position component for the specified quantized value.
+ */
+static inline float Net_DequantizePosition(int32_t q) {
+  return q / (float) NET_POSITION_SCALE;
+}
+
+/**
+ * @return True if the positions quantize to the same grid point.
+ */
+static inline bool Net_PositionEqual(const vec3_t a, const vec3_t b) {
+  return Net_QuantizePosition(a.x) == Net_QuantizePosition(b.x) &&
+         Net_QuantizePosition(a.y) == Net_QuantizePosition(b.y) &&
+         Net_QuantizePosition(a.z) == Net_QuantizePosition(b.z);
+}
+
+/**
+ * @brief Encodes an angle in degrees as a 16-bit integer.
+ */
+static inline uint16_t Net_PackAngle(float angle) {
+
+  while (angle < 0.f) {
+    angle += 360.f;
+  }
+
+  while (angle >= 360.f) {
+    angle -= 360.f;
+  }
+
+  return (uint16_t) ((angle / 360.0f) * UINT16_MAX);
+}
+
+/**
+ * @brief Decodes a 16-bit encoded angle to degrees.
+ */
+static inline float Net_UnpackAngle(uint16_t angle) {
+  return ((int16_t) angle) * 360.f / UINT16_MAX;
+}
+
 /**
  * @brief Appends raw bytes to a network message buffer.
  */
@@ -100,6 +146,27 @@ void Net_WriteFloat(mem_buf_t *msg, float v) {
   Net_WriteLong(msg, vec.i);
 }
 
+/**
+ * @brief Writes an unsigned integer in 7-bit groups, least significant first, to a network
+ * message buffer. Small values occupy a single byte.
+ */
+void Net_WriteVarInt(mem_buf_t *msg, uint32_t value) {
+
+  while (value >= 0x80) {
+    Net_WriteByte(msg, (value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+
+  Net_WriteByte(msg, value);
+}
+
+/**
+ * @brief Writes an entity number, or -1 to terminate an entity list, to a network message buffer.
+ */
+void Net_WriteEntityNumber(mem_buf_t *msg, int32_t number) {
+  Net_WriteVarInt(msg, (uint32_t) (number + 1));
+}
+
 /**
  * @brief Writes a 3D world-space position as three consecutive floats to a network message buffer.
  */
@@ -113,16 +180,7 @@ void Net_WritePosition(mem_buf_t *msg, const vec3_t pos) {
  * @brief Encodes an angle in degrees as a 16-bit integer and writes it to a network message buffer.
  */
 void Net_WriteAngle(mem_buf_t *msg, float angle) {
-
-  while (angle < 0.f) {
-    angle += 360.f;
-  }
-
-  while (angle >= 360.f) {
-    angle -= 360.f;
-  }
-
-  Net_WriteShort(msg, (uint16_t) ((angle / 360.0f) * UINT16_MAX));
+  Net_WriteShort(msg, Net_PackAngle(angle));
 }
 
 /**
@@ -170,6 +228,145 @@ void Net_WriteBounds(mem_buf_t *msg, const box3_t bounds) {
   Net_WriteShort(msg, _maxs.z);
 }
 
+/**
+ * @brief Begins writing or reading bits to or from the specified message buffer.
+ */
+void Net_BeginBits(net_bits_t *bits, mem_buf_t *msg) {
+
+  bits->msg = msg;
+  bits->bits = 0;
+  bits->count = 0;
+}
+
+/**
+ * @brief Writes the low `count` bits of `value`, up to 32, to the bit stream.
+ */
+void Net_WriteBits(net_bits_t *bits, uint32_t value, int32_t count) {
+
+  if (count < 32) {
+    value &= (1u << count) - 1;
+  }
+
+  bits->bits |= (uint64_t) value << bits->count;
+  bits->count += count;
+
+  while (bits->count >= 8) {
+    Net_WriteByte(bits->msg, (int32_t) (bits->bits & 0xff));
+    bits->bits >>= 8;
+    bits->count -= 8;
+  }
+}
+
+/**
+ * @brief Writes an unsigned integer in 4-bit groups, each followed by a continuation bit, to the
+ * bit stream. Values below 16 occupy 5 bits.
+ */
+void Net_WriteBitsVarInt(net_bits_t *bits, uint32_t value) {
+
+  while (value >= 0x10) {
+    Net_WriteBits(bits, (value & 0xf) | 0x10, 5);
+    value >>= 4;
+  }
+
+  Net_WriteBits(bits, value, 5);
+}
+
+/**
+ * @brief Writes a signed integer to the bit stream, zigzag encoded so that values of small
+ * magnitude occupy few bits.
+ */
+void Net_WriteBitsSignedVarInt(net_bits_t *bits, int32_t value) {
+  Net_WriteBitsVarInt(bits, ((uint32_t) value << 1) ^ (uint32_t) (value >> 31));
+}
+
+/**
+ * @brief Writes any remaining bits to the message, padding them to a whole byte.
+ */
+void Net_FlushBits(net_bits_t *bits) {
+
+  if (bits->count) {
+    Net_WriteByte(bits->msg, (int32_t) (bits->bits & 0xff));
+  }
+
+  bits->bits = 0;
+  bits->count = 0;
+}
+
+/**
+ * @brief Writes a float to the bit stream, without loss of precision.
+ */
+static void Net_WriteBitsFloat(net_bits_t *bits, float f) {
+
+  const net_float vec = {
+    .v = f
+  };
+
+  Net_WriteBits(bits, (uint32_t) vec.i, 32);
+}
+
+/**
+ * @brief Writes a vector to the bit stream, without loss of precision.
+ */
+static void Net_WriteBitsVector(net_bits_t *bits, const vec3_t v) {
+  Net_WriteBitsFloat(bits, v.x);
+  Net_WriteBitsFloat(bits, v.y);
+  Net_WriteBitsFloat(bits, v.z);
+}
+
+/**
+ * @brief Writes a position to the bit stream as the quantized difference from `from`.
+ */
+static void Net_WriteBitsDeltaPosition(net_bits_t *bits, const vec3_t from, const vec3_t to) {
+  for (int32_t i = 0; i < 3; i++) {
+    Net_WriteBitsSignedVarInt(bits, Net_QuantizePosition(to.xyz[i]) - Net_QuantizePosition(from.xyz[i]));
+  }
+}
+
+/**
+ * @brief Writes the components of `to` that differ from `from`, preceded by a 3 bit mask.
+ */
+static void Net_WriteBitsDeltaAngles(net_bits_t *bits, const vec3_t from, const vec3_t to) {
+
+  uint32_t mask = 0;
+  for (int32_t i = 0; i < 3; i++) {
+    if (to.xyz[i] != from.xyz[i]) {
+      mask |= 1 << i;
+    }
+  }
+
+  Net_WriteBits(bits, mask, 3);
+
+  for (int32_t i = 0; i < 3; i++) {
+    if (mask & (1 << i)) {
+      Net_WriteBits(bits, Net_PackAngle(to.xyz[i]), 16);
+    }
+  }
+}
+
+/**
+ * @brief Writes the elements of `to` that differ from `from` as a count, followed by the index
+ * distance and value of each changed element.
+ */
+static void Net_WriteBitsDeltaArray(net_bits_t *bits, const int16_t *from, const int16_t *to, int32_t count) {
+
+  uint32_t changed = 0;
+  for (int32_t i = 0; i < count; i++) {
+    if (to[i] != from[i]) {
+      changed++;
+    }
+  }
+
+  Net_WriteBitsVarInt(bits, changed);
+
+  for (int32_t i = 0, last = -1; i < count; i++) {
+    if (to[i] != from[i]) {
+      Net_WriteBitsVarInt(bits, (uint32_t) (i - last - 1));
+      Net_WriteBitsSignedVarInt(bits, to[i]);
+      last = i;
+    }
+  }
+}
+
 /**
  * @brief Writes only the changed fields of a movement command as a delta from `from` to `to`.
  */
@@ -241,7 +438,8 @@ void Net_WriteDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, const pm_cmd_t
 }
 
 /**
- * @brief Writes only the changed fields of a player state as a delta from `from` to `to`.
+ * @brief Writes only the changed fields of a player state as a delta from `from` to `to`. Movement
+ * state is written without loss of precision, so that client side prediction matches the server.
  */
 void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to) {
 
@@ -303,96 +501,84 @@ void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const
     bits |= PS_PM_STEP_OFFSET;
   }
 
-  Net_WriteShort(msg, bits);
+  if (memcmp(to->stats, from->stats, sizeof(to->stats))) {
+    bits |= PS_STATS;
+  }
+
+  if (memcmp(to->inventory, from->inventory, sizeof(to->inventory))) {
+    bits |= PS_INVENTORY;
+  }
+
+  Net_WriteVarInt(msg, bits);
+
+  net_bits_t b;
+  Net_BeginBits(&b, msg);
 
   if (bits & PS_PM_CLIENT) {
-    Net_WriteByte(msg, to->client);
+    Net_WriteBitsVarInt(&b, to->client);
   }
 
   if (bits & PS_PM_ENTITY) {
-    Net_WriteShort(msg, to->entity);
+    Net_WriteBitsVarInt(&b, (uint16_t) to->entity);
   }
 
   if (bits & PS_PM_TYPE) {
-    Net_WriteByte(msg, to->pm_state.type);
+    Net_WriteBitsVarInt(&b, to->pm_state.type);
   }
 
   if (bits & PS_PM_ORIGIN) {
-    Net_WritePosition(msg, to->pm_state.origin);
+    Net_WriteBitsVector(&b, to->pm_state.origin);
   }
 
   if (bits & PS_PM_VELOCITY) {
-    Net_WritePosition(msg, to->pm_state.velocity);
+    Net_WriteBitsVector(&b, to->pm_state.velocity);
   }
 
   if (bits & PS_PM_FLAGS) {
-    Net_WriteShort(msg, to->pm_state.flags);
+    Net_WriteBitsVarInt(&b, to->pm_state.flags);
   }
 
   if (bits & PS_PM_TIME) {
-    Net_WriteShort(msg, to->pm_state.time);
+    Net_WriteBitsVarInt(&b, to->pm_state.time);
   }
 
   if (bits & PS_PM_GRAVITY) {
-    Net_WriteShort(msg, to->pm_state.gravity);
+    Net_WriteBitsSignedVarInt(&b, to->pm_state.gravity);
   }
 
   if (bits & PS_PM_VIEW_OFFSET) {
-    Net_WritePosition(msg, to->pm_state.view_offset);
+    Net_WriteBitsVector(&b, to->pm_state.view_offset);
   }
 
   if (bits & PS_PM_VIEW_ANGLES) {
-    Net_WriteAngles(msg, to->pm_state.view_angles);
+    Net_WriteBitsDeltaAngles(&b, from->pm_state.view_angles, to->pm_state.view_angles);
   }
 
   if (bits & PS_PM_DELTA_ANGLES) {
-    Net_WriteAngles(msg, to->pm_state.delta_angles);
+    Net_WriteBitsDeltaAngles(&b, from->pm_state.delta_angles, to->pm_state.delta_angles);
   }
 
   if (bits & PS_PM_HOOK_POSITION) {
-    Net_WritePosition(msg, to->pm_state.hook_position);
+    Net_WriteBitsVector(&b, to->pm_state.hook_position);
   }
 
   if (bits & PS_PM_HOOK_LENGTH) {
-    Net_WriteShort(msg, to->pm_state.hook_length);
+    Net_WriteBitsVarInt(&b, to->pm_state.hook_length);
   }
 
   if (bits & PS_PM_STEP_OFFSET) {
-    Net_WriteFloat(msg, to->pm_state.step_offset);
+    Net_WriteBitsFloat(&b, to->pm_state.step_offset);
   }
 
-  uint32_t stat_bits = 0;
-
-  for (int32_t i = 0; i < MAX_STATS; i++) {
-    if (to->stats[i] != from->stats[i]) {
-      stat_bits |= 1 << i;
-    }
+  if (bits & PS_STATS) {
+    Net_WriteBitsDeltaArray(&b, from->stats, to->stats, MAX_STATS);
   }
 
-  Net_WriteLong(msg, stat_bits);
-
-  for (int32_t i = 0; i < MAX_STATS; i++) {
-    if (stat_bits & (1U << i)) {
-      Net_WriteShort(msg, to->stats[i]);
-    }
-  }
-
-  uint64_t inv_bits = 0;
-
-  for (int32_t i = 0; i < MAX_INVENTORY; i++) {
-    if (to->inventory[i] != from->inventory[i]) {
-      inv_bits |= (uint64_t) 1 << i;
-    }
+  if (bits & PS_INVENTORY) {
+    Net_WriteBitsDeltaArray(&b, from->inventory, to->inventory, MAX_INVENTORY);
   }
 
-  Net_WriteLong(msg, (int32_t) (inv_bits & 0xFFFFFFFF));
-  Net_WriteLong(msg, (int32_t) (inv_bits >> 32));
-
-  for (int32_t i = 0; i < MAX_INVENTORY; i++) {
-    if (inv_bits & ((uint64_t) 1 << i)) {
-      Net_WriteShort(msg, to->inventory[i]);
-    }
-  }
+  Net_FlushBits(&b);
 }
 
 /**
@@ -414,11 +600,11 @@ void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const enti
     bits |= U_SPAWN_ID;
   }
 
-  if (!Vec3_Equal(to->origin, from->origin)) {
+  if (!Net_PositionEqual(to->origin, from->origin)) {
     bits |= U_ORIGIN;
   }
 
-  if (!Vec3_Equal(from->termination, to->termination)) {
+  if (!Net_PositionEqual(from->termination, to->termination)) {
     bits |= U_TERMINATION;
   }
 
@@ -473,76 +659,89 @@ void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const enti
 
   // write the message
 
-  Net_WriteShort(msg, to->number);
-  Net_WriteShort(msg, bits);
+  Net_WriteEntityNumber(msg, to->number);
+  Net_WriteVarInt(msg, bits);
+
+  net_bits_t b;
+  Net_BeginBits(&b, msg);
 
   if (bits & U_STEP_OFFSET) {
-    Net_WriteByte(msg, to->step_offset);
+    Net_WriteBitsSignedVarInt(&b, to->step_offset);
   }
 
   if (bits & U_SPAWN_ID) {
-    Net_WriteByte(msg, to->spawn_id);
+    Net_WriteBits(&b, to->spawn_id, 8);
   }
 
   if (bits & U_ORIGIN) {
-    Net_WritePosition(msg, to->origin);
+    Net_WriteBitsDeltaPosition(&b, from->origin, to->origin);
   }
 
   if (bits & U_TERMINATION) {
-    Net_WritePosition(msg, to->termination);
+    Net_WriteBitsDeltaPosition(&b, from->termination, to->termination);
   }
 
   if (bits & U_ANGLES) {
-    Net_WriteAngles(msg, to->angles);
+    Net_WriteBitsDeltaAngles(&b, from->angles, to->angles);
   }
 
   if (bits & U_ANIMATIONS) {
-    Net_WriteByte(msg, to->animation1);
-    Net_WriteByte(msg, to->animation2);
+    Net_WriteBits(&b, to->animation1, 8);
+    Net_WriteBits(&b, to->animation2, 8);
   }
 
   if (bits & U_EVENT) {
-    Net_WriteByte(msg, to->event);
-    Net_WriteByte(msg, to->event_data);
+    Net_WriteBitsVarInt(&b, to->event);
+    Net_WriteBitsVarInt(&b, to->event_data);
   }
 
   if (bits & U_EFFECTS) {
-    Net_WriteLong(msg, (int32_t) to->effects);
+    Net_WriteBitsVarInt(&b, to->effects);
   }
 
   if (bits & U_TRAIL) {
-    Net_WriteByte(msg, to->trail);
+    Net_WriteBitsVarInt(&b, to->trail);
   }
 
   if (bits & U_MODELS) {
-    Net_WriteByte(msg, to->model1);
-    Net_WriteByte(msg, to->model2);
-    Net_WriteByte(msg, to->model3);
-    Net_WriteByte(msg, to->model4);
+    Net_WriteBitsVarInt(&b, to->model1);
+    Net_WriteBitsVarInt(&b, to->model2);
+    Net_WriteBitsVarInt(&b, to->model3);
+    Net_WriteBitsVarInt(&b, to->model4);
   }
 
   if (bits & U_COLOR) {
-    Net_WriteByte(msg, to->color.r);
-    Net_WriteByte(msg, to->color.g);
-    Net_WriteByte(msg, to->color.b);
-    Net_WriteByte(msg, to->color.a);
+    Net_WriteBits(&b, to->color.r, 8);
+    Net_WriteBits(&b, to->color.g, 8);
+    Net_WriteBits(&b, to->color.b, 8);
+    Net_WriteBits(&b, to->color.a, 8);
   }
 
   if (bits & U_CLIENT) {
-    Net_WriteByte(msg, to->client);
+    Net_WriteBitsVarInt(&b, to->client);
   }
 
   if (bits & U_SOUND) {
-    Net_WriteByte(msg, to->sound);
+    Net_WriteBitsVarInt(&b, to->sound);
   }
 
   if (bits & U_SOLID) {
-    Net_WriteByte(msg, to->solid);
+    Net_WriteBitsVarInt(&b, to->solid);
   }
 
   if (bits & U_BOUNDS) {
-    Net_WriteBounds(msg, to->bounds);
+    const vec3s_t mins = Vec3_CastVec3s(to->bounds.mins);
+    const vec3s_t maxs = Vec3_CastVec3s(to->bounds.maxs);
+
+    Net_WriteBitsSignedVarInt(&b, mins.x);
+    Net_WriteBitsSignedVarInt(&b, mins.y);
+    Net_WriteBitsSignedVarInt(&b, mins.z);
+    Net_WriteBitsSignedVarInt(&b, maxs.x);
+    Net_WriteBitsSignedVarInt(&b, maxs.y);
+    Net_WriteBitsSignedVarInt(&b, maxs.z);
   }
+
+  Net_FlushBits(&b);
 }
 
 /**
@@ -687,6 +886,36 @@ float Net_ReadFloat(mem_buf_t *msg) {
   return vec.v;
 }
 
+/**
+ * @brief Reads an unsigned integer written with `Net_WriteVarInt` from a network message buffer.
+ */
+uint32_t Net_ReadVarInt(mem_buf_t *msg) {
+
+  uint32_t value = 0;
+
+  for (int32_t shift = 0; shift < 35; shift += 7) {
+    const int32_t c = Net_ReadByte(msg);
+    if (c == -1) {
+      break;
+    }
+
+    value |= (uint32_t) (c & 0x7f) << shift;
+
+    if (!(c & 0x80)) {
+      break;
+    }
+  }
+
+  return value;
+}
+
+/**
+ * @brief Reads an entity number from a network message buffer; returns -1 at the end of an entity list.
+ */
+int32_t Net_ReadEntityNumber(mem_buf_t *msg) {
+  return (int32_t) Net_ReadVarInt(msg) - 1;
+}
+
 /**
  * @brief Reads a 3D world-space position from three consecutive floats in a network message buffer.
  */
@@ -702,7 +931,7 @@ vec3_t Net_ReadPosition(mem_buf_t *msg) {
  * @brief Reads a 16-bit encoded angle and converts it to degrees.
  */
 float Net_ReadAngle(mem_buf_t *msg) {
-  return Net_ReadShort(msg) * 360.f / UINT16_MAX;
+  return Net_UnpackAngle((uint16_t) Net_ReadShort(msg));
 }
 
 /**
@@ -746,6 +975,130 @@ box3_t Net_ReadBounds(mem_buf_t *msg) {
   return b;
 }
 
+/**
+ * @brief Reads `count` bits, up to 32, from the bit stream.
+ */
+uint32_t Net_ReadBits(net_bits_t *bits, int32_t count) {
+
+  while (bits->count < count) {
+    bits->bits |= (uint64_t) (byte) Net_ReadByte(bits->msg) << bits->count;
+    bits->count += 8;
+  }
+
+  const uint32_t value = (uint32_t) (bits->bits & ((1ull << count) - 1));
+
+  bits->bits >>= count;
+  bits->count -= count;
+
+  return value;
+}
+
+/**
+ * @brief Reads an unsigned integer written with `Net_WriteBitsVarInt` from the bit stream.
+ */
+uint32_t Net_ReadBitsVarInt(net_bits_t *bits) {
+
+  uint32_t value = 0;
+
+  for (int32_t shift = 0; shift < 32; shift += 4) {
+    const uint32_t c = Net_ReadBits(bits, 5);
+
+    value |= (c & 0xf) << shift;
+
+    if (!(c & 0x10)) {
+      break;
+    }
+  }
+
+  return value;
+}
+
+/**
+ * @brief Reads a signed integer written with `Net_WriteBitsSignedVarInt` from the bit stream.
+ */
+int32_t Net_ReadBitsSignedVarInt(net_bits_t *bits) {
+
+  const uint32_t value = Net_ReadBitsVarInt(bits);
+
+  return (int32_t) (value >> 1) ^ -(int32_t) (value & 1);
+}
+
+/**
+ * @brief Reads a float written with `Net_WriteBitsFloat` from the bit stream.
+ */
+static float Net_ReadBitsFloat(net_bits_t *bits) {
+
+  const net_float vec = {
+    .i = (int32_t) Net_ReadBits(bits, 32)
+  };
+
+  return vec.v;
+}
+
+/**
+ * @brief Reads a vector written with `Net_WriteBitsVector` from the bit stream.
+ */
+static vec3_t Net_ReadBitsVector(net_bits_t *bits) {
+  return (vec3_t) {
+    .x = Net_ReadBitsFloat(bits),
+    .y = Net_ReadBitsFloat(bits),
+    .z = Net_ReadBitsFloat(bits)
+  };
+}
+
+/**
+ * @brief Reads a position written with `Net_WriteBitsDeltaPosition` from the bit stream.
+ */
+static vec3_t Net_ReadBitsDeltaPosition(net_bits_t *bits, const vec3_t from) {
+
+  vec3_t to;
+
+  for (int32_t i = 0; i < 3; i++) {
+    to.xyz[i] = Net_DequantizePosition(Net_QuantizePosition(from.xyz[i]) + Net_ReadBitsSignedVarInt(bits));
+  }
+
+  return to;
+}
+
+/**
+ * @brief Reads angles written with `Net_WriteBitsDeltaAngles` from the bit stream.
+ */
+static vec3_t Net_ReadBitsDeltaAngles(net_bits_t *bits, const vec3_t from) {
+
+  vec3_t to = from;
+
+  const uint32_t mask = Net_ReadBits(bits, 3);
+
+  for (int32_t i = 0; i < 3; i++) {
+    if (mask & (1 << i)) {
+      to.xyz[i] = Net_UnpackAngle((uint16_t) Net_ReadBits(bits, 16));
+    }
+  }
+
+  return to;
+}
+
+/**
+ * @brief Reads array elements written with `Net_WriteBitsDeltaArray` from the bit stream.
+ */
+static void Net_ReadBitsDeltaArray(net_bits_t *bits, int16_t *to, int32_t count) {
+
+  const uint32_t changed = Net_ReadBitsVarInt(bits);
+
+  for (uint32_t i = 0, index = 0; i < changed; i++, index++) {
+
+    index += Net_ReadBitsVarInt(bits);
+
+    const int16_t value = (int16_t) Net_ReadBitsSignedVarInt(bits);
+
+    if (index >= (uint32_t) count) {
+      Com_Error(ERROR_DROP, "Bad index: %u\n", index);
+    }
+
+    to[index] = value;
+  }
+}
+
 /**
  * @brief Reads delta-compressed movement command fields into `to`, starting from the baseline in `from`.
  */
@@ -795,79 +1148,73 @@ void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player
 
   *to = *from;
 
-  const uint16_t bits = Net_ReadShort(msg);
+  const uint32_t bits = Net_ReadVarInt(msg);
+
+  net_bits_t b;
+  Net_BeginBits(&b, msg);
 
   if (bits & PS_PM_CLIENT) {
-    to->client = Net_ReadByte(msg);
+    to->client = Net_ReadBitsVarInt(&b);
   }
 
   if (bits & PS_PM_ENTITY) {
-    to->entity = Net_ReadShort(msg);
+    to->entity = (int16_t) Net_ReadBitsVarInt(&b);
   }
 
   if (bits & PS_PM_TYPE) {
-    to->pm_state.type = Net_ReadByte(msg);
+    to->pm_state.type = Net_ReadBitsVarInt(&b);
   }
 
   if (bits & PS_PM_ORIGIN) {
-    to->pm_state.origin = Net_ReadPosition(msg);
+    to->pm_state.origin = Net_ReadBitsVector(&b);
   }
 
   if (bits & PS_PM_VELOCITY) {
-    to->pm_state.velocity = Net_ReadPosition(msg);
+    to->pm_state.velocity = Net_ReadBitsVector(&b);
   }
 
   if (bits & PS_PM_FLAGS) {
-    to->pm_state.flags = Net_ReadShort(msg);
+    to->pm_state.flags = Net_ReadBitsVarInt(&b);
   }
 
   if (bits & PS_PM_TIME) {
-    to->pm_state.time = Net_ReadShort(msg);
+    to->pm_state.time = Net_ReadBitsVarInt(&b);
   }
 
   if (bits & PS_PM_GRAVITY) {
-    to->pm_state.gravity = Net_ReadShort(msg);
+    to->pm_state.gravity = Net_ReadBitsSignedVarInt(&b);
   }
 
   if (bits & PS_PM_VIEW_OFFSET) {
-    to->pm_state.view_offset = Net_ReadPosition(msg);
+    to->pm_state.view_offset = Net_ReadBitsVector(&b);
   }
 
   if (bits & PS_PM_VIEW_ANGLES) {
-    to->pm_state.view_angles = Net_ReadAngles(msg);
+    to->pm_state.view_angles = Net_ReadBitsDeltaAngles(&b, from->pm_state.view_angles);
   }
 
   if (bits & PS_PM_DELTA_ANGLES) {
-    to->pm_state.delta_angles = Net_ReadAngles(msg);
+    to->pm_state.delta_angles = Net_ReadBitsDeltaAngles(&b, from->pm_state.delta_angles);
   }
 
   if (bits & PS_PM_HOOK_POSITION) {
-    to->pm_state.hook_position = Net_ReadPosition(msg);
+    to->pm_state.hook_position = Net_ReadBitsVector(&b);
   }
 
   if (bits & PS_PM_HOOK_LENGTH) {
-    to->pm_state.hook_length = Net_ReadShort(msg);
+    to->pm_state.hook_length = Net_ReadBitsVarInt(&b);
   }
 
   if (bits & PS_PM_STEP_OFFSET) {
-    to->pm_state.step_offset = Net_ReadFloat(msg);
+    to->pm_state.step_offset = Net_ReadBitsFloat(&b);
   }
 
-  const int32_t stat_bits = Net_ReadLong(msg);
-
-  for (int32_t i = 0; i < MAX_STATS; i++) {
-    if (stat_bits & (1U << i)) {
-      to->stats[i] = Net_ReadShort(msg);
-    }
+  if (bits & PS_STATS) {
+    Net_ReadBitsDeltaArray(&b, to->stats, MAX_STATS);
   }
 
-  const uint64_t inv_bits = (uint64_t) (uint32_t) Net_ReadLong(msg) |
-                            ((uint64_t) (uint32_t) Net_ReadLong(msg) << 32);
-
-  for (int32_t i = 0; i < MAX_INVENTORY; i++) {
-    if (inv_bits & ((uint64_t) 1 << i)) {
-      to->inventory[i] = Net_ReadShort(msg);
-    }
+  if (bits & PS_INVENTORY) {
+    Net_ReadBitsDeltaArray(&b, to->inventory, MAX_INVENTORY);
   }
 }
 
@@ -881,74 +1228,82 @@ void Net_ReadDeltaEntity(mem_buf_t *msg, const entity_state_t *from, entity_stat
 
   to->number = number;
 
+  net_bits_t b;
+  Net_BeginBits(&b, msg);
+
   if (bits & U_STEP_OFFSET) {
-    to->step_offset = Net_ReadByte(msg);
+    to->step_offset = (int8_t) Net_ReadBitsSignedVarInt(&b);
   }
 
   if (bits & U_SPAWN_ID) {
-    to->spawn_id = Net_ReadByte(msg);
+    to->spawn_id = Net_ReadBits(&b, 8);
   }
 
   if (bits & U_ORIGIN) {
-    to->origin = Net_ReadPosition(msg);
+    to->origin = Net_ReadBitsDeltaPosition(&b, from->origin);
   }
 
   if (bits & U_TERMINATION) {
-    to->termination = Net_ReadPosition(msg);
+    to->termination = Net_ReadBitsDeltaPosition(&b, from->termination);
   }
 
   if (bits & U_ANGLES) {
-    to->angles = Net_ReadAngles(msg);
+    to->angles = Net_ReadBitsDeltaAngles(&b, from->angles);
   }
 
   if (bits & U_ANIMATIONS) {
-    to->animation1 = Net_ReadByte(msg);
-    to->animation2 = Net_ReadByte(msg);
+    to->animation1 = Net_ReadBits(&b, 8);
+    to->animation2 = Net_ReadBits(&b, 8);
   }
 
   if (bits & U_EVENT) {
-    to->event = Net_ReadByte(msg);
-    to->event_data = Net_ReadByte(msg);
+    to->event = Net_ReadBitsVarInt(&b);
+    to->event_data = Net_ReadBitsVarInt(&b);
   } else {
     to->event = 0;
     to->event_data = 0;
   }
 
   if (bits & U_EFFECTS) {
-    to->effects = (uint32_t) Net_ReadLong(msg);
+    to->effects = Net_ReadBitsVarInt(&b);
   }
 
   if (bits & U_TRAIL) {
-    to->trail = Net_ReadByte(msg);
+    to->trail = Net_ReadBitsVarInt(&b);
   }
 
   if (bits & U_MODELS) {
-    to->model1 = Net_ReadByte(msg);
-    to->model2 = Net_ReadByte(msg);
-    to->model3 = Net_ReadByte(msg);
-    to->model4 = Net_ReadByte(msg);
+    to->model1 = Net_ReadBitsVarInt(&b);
+    to->model2 = Net_ReadBitsVarInt(&b);
+    to->model3 = Net_ReadBitsVarInt(&b);
+    to->model4 = Net_ReadBitsVarInt(&b);
   }
 
   if (bits & U_COLOR) {
-    to->color.r = Net_ReadByte(msg);
-    to->color.g = Net_ReadByte(msg);
-    to->color.b = Net_ReadByte(msg);
-    to->color.a = Net_ReadByte(msg);
+    to->color.r = Net_ReadBits(&b, 8);
+    to->color.g = Net_ReadBits(&b, 8);
+    to->color.b = Net_ReadBits(&b, 8);
+    to->color.a = Net_ReadBits(&b, 8);
   }
 
   if (bits & U_CLIENT) {
-    to->client = Net_ReadByte(msg);
+    to->client = Net_ReadBitsVarInt(&b);
   }
 
   if (bits & U_SOUND) {
-    to->sound = Net_ReadByte(msg);
+    to->sound = Net_ReadBitsVarInt(&b);
   }
 
   if (bits & U_SOLID) {
-    to->solid = Net_ReadByte(msg);
+    to->solid = Net_ReadBitsVarInt(&b);
   }
 
   if (bits & U_BOUNDS) {
-    to->bounds = Net_ReadBounds(msg);
+    to->bounds.mins.x = Net_ReadBitsSignedVarInt(&b);
+    to->bounds.mins.y = Net_ReadBitsSignedVarInt(&b);
+    to->bounds.mins.z = Net_ReadBitsSignedVarInt(&b);
+    to->bounds.maxs.x = Net_ReadBitsSignedVarInt(&b);
+    to->bounds.maxs.y = Net_ReadBitsSignedVarInt(&b);
+    to->bounds.maxs.z = Net_ReadBitsSignedVarInt(&b);
   }
 }
@@ -24,22 +24,25 @@
 #include "net_types.h"
 
 /**
- * @brief Delta compression flags for `pm_state_t`.
+ * @brief Delta compression flags for `player_state_t`, ordered by how frequently they change,
+ * so that the most common combinations fit in a single byte.
  */
-#define PS_PM_CLIENT        (1 << 0)
-#define PS_PM_ENTITY        (1 << 1)
-#define PS_PM_TYPE          (1 << 2)
-#define PS_PM_ORIGIN        (1 << 3)
-#define PS_PM_VELOCITY      (1 << 4)
-#define PS_PM_FLAGS         (1 << 5)
-#define PS_PM_TIME          (1 << 6)
-#define PS_PM_GRAVITY       (1 << 7)
-#define PS_PM_VIEW_OFFSET   (1 << 8)
-#define PS_PM_VIEW_ANGLES   (1 << 9)
-#define PS_PM_DELTA_ANGLES  (1 << 10)
-#define PS_PM_HOOK_POSITION (1 << 11)
-#define PS_PM_HOOK_LENGTH   (1 << 12)
-#define PS_PM_STEP_OFFSET   (1 << 13)
+#define PS_PM_ORIGIN        (1 << 0)
+#define PS_PM_VELOCITY      (1 << 1)
+#define PS_PM_VIEW_ANGLES   (1 << 2)
+#define PS_PM_FLAGS         (1 << 3)
+#define PS_PM_TIME          (1 << 4)
+#define PS_PM_STEP_OFFSET   (1 << 5)
+#define PS_STATS            (1 << 6)
+#define PS_PM_VIEW_OFFSET   (1 << 7)
+#define PS_INVENTORY        (1 << 8)
+#define PS_PM_DELTA_ANGLES  (1 << 9)
+#define PS_PM_HOOK_POSITION (1 << 10)
+#define PS_PM_HOOK_LENGTH   (1 << 11)
+#define PS_PM_TYPE          (1 << 12)
+#define PS_PM_GRAVITY       (1 << 13)
+#define PS_PM_ENTITY        (1 << 14)
+#define PS_PM_CLIENT        (1 << 15)
 
 /**
  * @brief Delta compression flags for `user_cmd_t`.
@@ -55,24 +58,51 @@
 
 /**
  * @brief These flags indicate which fields in a given `entity_state_t` must be
- * written or read for delta compression from one snapshot to the next.
+ * written or read for delta compression from one snapshot to the next. They are
+ * ordered by how frequently they change, so that the most common combinations
+ * fit in a single byte.
  */
 #define U_ORIGIN      (1 << 0)
-#define U_TERMINATION (1 << 1)
-#define U_ANGLES      (1 << 2)
-#define U_ANIMATIONS  (1 << 3)
-#define U_EVENT       (1 << 4)
+#define U_ANGLES      (1 << 1)
+#define U_ANIMATIONS  (1 << 2)
+#define U_EVENT       (1 << 3)
+#define U_STEP_OFFSET (1 << 4)
 #define U_EFFECTS     (1 << 5)
-#define U_TRAIL       (1 << 6)
-#define U_MODELS      (1 << 7)
-#define U_COLOR       (1 << 8)
-#define U_CLIENT      (1 << 9)
-#define U_SOUND       (1 << 10)
-#define U_SOLID       (1 << 11)
-#define U_BOUNDS      (1 << 12)
-#define U_REMOVE      (1 << 13)
-#define U_SPAWN_ID    (1 << 14)
-#define U_STEP_OFFSET (1 << 15)
+#define U_REMOVE      (1 << 6)
+#define U_TERMINATION (1 << 7)
+#define U_TRAIL       (1 << 8)
+#define U_MODELS      (1 << 9)
+#define U_COLOR       (1 << 10)
+#define U_CLIENT      (1 << 11)
+#define U_SOUND       (1 << 12)
+#define U_SPAWN_ID    (1 << 13)
+#define U_SOLID       (1 << 14)
+#define U_BOUNDS      (1 << 15)
+
+/**
+ * @brief Entity positions are quantized to 1 / `NET_POSITION_SCALE` units for delta compression.
+ * This must be a power of two, so that dequantized positions quantize back to the same value.
+ */
+#define NET_POSITION_SCALE 16
+
+/**
+ * @brief Bit-level message writing and reading. Bits are packed least significant first, and
+ * whole bytes are appended to, or consumed from, the underlying message as needed.
+ */
+typedef struct {
+  mem_buf_t *msg;
+  uint64_t bits;
+  int32_t count;
+} net_bits_t;
+
+void Net_BeginBits(net_bits_t *bits, mem_buf_t *msg);
+void Net_WriteBits(net_bits_t *bits, uint32_t value, int32_t count);
+void Net_WriteBitsVarInt(net_bits_t *bits, uint32_t value);
+void Net_WriteBitsSignedVarInt(net_bits_t *bits, int32_t value);
+void Net_FlushBits(net_bits_t *bits);
+uint32_t Net_ReadBits(net_bits_t *bits, int32_t count);
+uint32_t Net_ReadBitsVarInt(net_bits_t *bits);
+int32_t Net_ReadBitsSignedVarInt(net_bits_t *bits);
 
 /**
  * @brief Message writing and reading facilities.
@@ -84,6 +114,8 @@ void Net_WriteShort(mem_buf_t *msg, int32_t c);
 void Net_WriteLong(mem_buf_t *msg, int32_t c);
 void Net_WriteString(mem_buf_t *msg, const char *s);
 void Net_WriteFloat(mem_buf_t *msg, float f);
+void Net_WriteVarInt(mem_buf_t *msg, uint32_t value);
+void Net_WriteEntityNumber(mem_buf_t *msg, int32_t number);
 void Net_WritePosition(mem_buf_t *msg, const vec3_t pos);
 void Net_WriteAngle(mem_buf_t *msg, float f);
 void Net_WriteAngles(mem_buf_t *msg, const vec3_t angles);
@@ -102,6 +134,8 @@ int32_t Net_ReadLong(mem_buf_t *msg);
 char *Net_ReadString(mem_buf_t *msg);
 char *Net_ReadStringLine(mem_buf_t *msg);
 float Net_ReadFloat(mem_buf_t *msg);
+uint32_t Net_ReadVarInt(mem_buf_t *msg);
+int32_t Net_ReadEntityNumber(mem_buf_t *msg);
 vec3_t Net_ReadPosition(mem_buf_t *msg);
 float Net_ReadAngle(mem_buf_t *msg);
 vec3_t Net_ReadAngles(mem_buf_t *msg);
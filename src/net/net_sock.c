@@ -296,6 +296,11 @@ int32_t Net_Accept(int32_t sock, net_addr_t *from) {
 
   Net_SetNonBlocking(client, true);
 
+#if defined(SO_NOSIGPIPE)
+  const int32_t opt = 1;
+  setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, (const void *) &opt, sizeof(opt));
+#endif
+
   if (from) {
     from->type = NA_STREAM;
     from->addr = addr.sin_addr.s_addr;
@@ -305,12 +310,64 @@ int32_t Net_Accept(int32_t sock, net_addr_t *from) {
   return client;
 }
 
+/**
+ * @brief Opens a blocking TCP connection to the specified address. Sends and receives on the
+ * connected socket fail with `EWOULDBLOCK` after `timeout` milliseconds without progress.
+ * @return The connected socket descriptor, or -1 on failure.
+ */
+int32_t Net_Connect(const net_addr_t *to, uint32_t timeout) {
+  int32_t opt = 1;
+
+  const int32_t sock = socket(PF_INET, SOCK_STREAM, 0);
+  if (sock == -1) {
+    Com_Warn("socket: %s\n", Net_GetErrorString());
+    return -1;
+  }
+
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const void *) &opt, sizeof(opt));
+
+#if defined(SO_NOSIGPIPE)
+  setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, (const void *) &opt, sizeof(opt));
+#endif
+
+#if defined(_WIN32)
+  const DWORD tv = timeout;
+#else
+  const struct timeval tv = {
+    .tv_sec = timeout / 1000,
+    .tv_usec = (timeout % 1000) * 1000
+  };
+#endif
+
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const void *) &tv, sizeof(tv));
+  setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (const void *) &tv, sizeof(tv));
+
+  net_sockaddr addr;
+  memset(&addr, 0, sizeof(addr));
+
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = to->type == NA_LOOP ? net_lo : to->addr;
+  addr.sin_port = to->port;
+
+  if (connect(sock, (const struct sockaddr *) &addr, sizeof(addr)) == -1) {
+    Com_Debug(DEBUG_NET, "connect: %s\n", Net_GetErrorString());
+    Net_CloseSocket(sock);
+    return -1;
+  }
+
+  return sock;
+}
+
 /**
  * @brief Send data on a connected socket.
  * @return Bytes sent, or -1 on error.
  */
 ssize_t Net_Send(int32_t sock, const void *data, size_t len) {
+#if defined(MSG_NOSIGNAL)
+  return send(sock, data, len, MSG_NOSIGNAL); // a closed peer must not raise SIGPIPE
+#else
   return send(sock, data, len, 0);
+#endif
 }
 
 /**
@@ -321,6 +378,122 @@ ssize_t Net_Recv(int32_t sock, void *data, size_t len) {
   return recv(sock, data, len, 0);
 }
 
+/**
+ * @brief Receives up to `count` pending datagrams from the specified non-blocking socket.
+ * On Linux, the datagrams are received with a single call to `recvmmsg`. Elsewhere, they
+ * are received one at a time. Oversized datagrams are truncated to `MAX_MSG_SIZE`.
+ * @return The number of datagrams received, or -1 on error.
+ */
+ssize_t Net_RecvDatagrams(int32_t sock, net_datagram_t *datagrams, size_t count) {
+
+  count = MIN(count, NET_DATAGRAM_BATCH);
+
+#if defined(__linux__)
+  struct mmsghdr msgs[NET_DATAGRAM_BATCH];
+  struct iovec iovs[NET_DATAGRAM_BATCH];
+  net_sockaddr addrs[NET_DATAGRAM_BATCH];
+
+  memset(msgs, 0, count * sizeof(msgs[0]));
+
+  for (size_t i = 0; i < count; i++) {
+    iovs[i].iov_base = datagrams[i].data;
+    iovs[i].iov_len = sizeof(datagrams[i].data);
+
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  const int32_t received = recvmmsg(sock, msgs, (uint32_t) count, MSG_DONTWAIT, NULL);
+  if (received == -1) {
+    return -1;
+  }
+
+  for (int32_t i = 0; i < received; i++) {
+    datagrams[i].addr.type = NA_DATAGRAM;
+    datagrams[i].addr.addr = addrs[i].sin_addr.s_addr;
+    datagrams[i].addr.port = addrs[i].sin_port;
+    datagrams[i].size = msgs[i].msg_len;
+  }
+
+  return received;
+#else
+  size_t i;
+  for (i = 0; i < count; i++) {
+    net_datagram_t *datagram = &datagrams[i];
+
+    net_sockaddr addr;
+    socklen_t addr_len = sizeof(addr);
+
+    const ssize_t received = recvfrom(sock, (void *) datagram->data, (int32_t) sizeof(datagram->data), 0,
+                                      (struct sockaddr *) &addr, &addr_len);
+    if (received == -1) {
+      if (i) {
+        break; // the error will be reported by the next call
+      }
+      return -1;
+    }
+
+    datagram->addr.type = NA_DATAGRAM;
+    datagram->addr.addr = addr.sin_addr.s_addr;
+    datagram->addr.port = addr.sin_port;
+    datagram->size = received;
+  }
+
+  return i;
+#endif
+}
+
+/**
+ * @brief Sends up to `count` datagrams on the specified socket. On Linux, the datagrams are
+ * sent with a single call to `sendmmsg`. Elsewhere, they are sent one at a time.
+ * @return The number of datagrams sent, or -1 if the first datagram could not be sent.
+ */
+ssize_t Net_SendDatagrams(int32_t sock, const net_datagram_t *datagrams, size_t count) {
+
+  count = MIN(count, NET_DATAGRAM_BATCH);
+
+#if defined(__linux__)
+  struct mmsghdr msgs[NET_DATAGRAM_BATCH];
+  struct iovec iovs[NET_DATAGRAM_BATCH];
+  net_sockaddr addrs[NET_DATAGRAM_BATCH];
+
+  memset(msgs, 0, count * sizeof(msgs[0]));
+
+  for (size_t i = 0; i < count; i++) {
+    Net_NetAddrToSockaddr(&datagrams[i].addr, &addrs[i]);
+
+    iovs[i].iov_base = (void *) datagrams[i].data;
+    iovs[i].iov_len = datagrams[i].size;
+
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  return sendmmsg(sock, msgs, (uint32_t) count, MSG_NOSIGNAL);
+#else
+  size_t i;
+  for (i = 0; i < count; i++) {
+    net_sockaddr addr;
+    Net_NetAddrToSockaddr(&datagrams[i].addr, &addr);
+
+    const ssize_t sent = sendto(sock, (const void *) datagrams[i].data, (int32_t) datagrams[i].size, 0,
+                                (const struct sockaddr *) &addr, sizeof(addr));
+    if (sent == -1) {
+      if (i) {
+        break; // the error will be reported by the next call
+      }
+      return -1;
+    }
+  }
+
+  return i;
+#endif
+}
+
 /**
  * @brief Make the specified socket non-blocking.
  */
@@ -39,8 +39,11 @@ bool Net_StringToNetaddr(const char *s, net_addr_t *a);
 int32_t Net_Socket(net_addr_type_t type, const char *iface, in_port_t port);
 int32_t Net_SocketListen(const char *iface, in_port_t port, int32_t backlog);
 int32_t Net_Accept(int32_t sock, net_addr_t *from);
+int32_t Net_Connect(const net_addr_t *to, uint32_t timeout);
 ssize_t Net_Send(int32_t sock, const void *data, size_t len);
 ssize_t Net_Recv(int32_t sock, void *data, size_t len);
+ssize_t Net_RecvDatagrams(int32_t sock, net_datagram_t *datagrams, size_t count);
+ssize_t Net_SendDatagrams(int32_t sock, const net_datagram_t *datagrams, size_t count);
 void Net_SetNonBlocking(int32_t sock, bool non_blocking);
 void Net_CloseSocket(int32_t sock);
 
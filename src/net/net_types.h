@@ -79,6 +79,20 @@ typedef enum {
   NS_UDP_SERVER
 } net_src_t;
 
+/**
+ * @brief The maximum number of datagrams transferred in a single batch.
+ */
+#define NET_DATAGRAM_BATCH 64
+
+/**
+ * @brief A datagram and its remote address, for batched socket I/O.
+ */
+typedef struct {
+  net_addr_t addr;
+  size_t size;
+  byte data[MAX_MSG_SIZE];
+} net_datagram_t;
+
 /**
  * @brief The network channel provides a conduit for packet sequencing and
  * optional reliable message delivery. The client and server speak explicitly
@@ -40,8 +40,15 @@ typedef struct {
   int32_t send, recv;
 } net_udp_loop_t;
 
+typedef struct {
+  net_datagram_t datagrams[NET_DATAGRAM_BATCH];
+  size_t count;
+  bool batch;
+} net_udp_queue_t;
+
 typedef struct {
   net_udp_loop_t loops[2];
+  net_udp_queue_t queues[2];
   int32_t sockets[2];
 } net_udp_state_t;
 
@@ -148,6 +155,77 @@ bool Net_ReceiveDatagram(net_src_t source, net_addr_t *from, mem_buf_t *buf) {
   return true;
 }
 
+/**
+ * @brief Receives up to `count` pending datagrams, from the loop buffer and then from the
+ * specified socket. Batches of datagrams are read from the socket with a single system call
+ * where possible. A result less than `count` indicates that no more datagrams are pending.
+ * @return The number of datagrams received.
+ */
+size_t Net_ReceiveDatagrams(net_src_t source, net_datagram_t *datagrams, size_t count) {
+  size_t received = 0;
+
+  while (received < count) {
+    net_datagram_t *datagram = &datagrams[received];
+
+    mem_buf_t buf;
+    Mem_InitBuffer(&buf, datagram->data, sizeof(datagram->data));
+
+    memset(&datagram->addr, 0, sizeof(datagram->addr));
+
+    if (!Net_ReceiveDatagram_Loop(source, &datagram->addr, &buf)) {
+      break;
+    }
+
+    datagram->size = buf.size;
+    received++;
+  }
+
+  const int32_t sock = net_udp_state.sockets[source];
+
+  if (!sock) {
+    return received;
+  }
+
+  while (received < count) {
+
+    const ssize_t batch = Net_RecvDatagrams(sock, datagrams + received, count - received);
+    if (batch == -1) {
+      const int32_t err = Net_GetError();
+
+      if (err != EWOULDBLOCK && err != ECONNREFUSED) {
+        Com_Warn("%s\n", Net_GetErrorString());
+      }
+      break;
+    }
+
+    const size_t end = received + batch;
+    for (size_t i = received; i < end; i++) {
+      const net_datagram_t *datagram = &datagrams[i];
+
+      if (datagram->size == sizeof(datagram->data)) {
+        Com_Warn("Oversized packet from %s\n", Net_NetaddrToString(&datagram->addr));
+        continue;
+      }
+
+      if (i != received) {
+        datagrams[received].addr = datagram->addr;
+        datagrams[received].size = datagram->size;
+        memcpy(datagrams[received].data, datagram->data, datagram->size);
+      }
+
+      received++;
+    }
+
+    // a partial batch means the socket has been drained, but a full batch from which
+    // oversized datagrams were dropped does not, so keep reading to fill the result
+    if (end < count) {
+      break;
+    }
+  }
+
+  return received;
+}
+
 /**
  * @brief Enqueues a datagram directly into the opposing side's loopback receive queue.
  */
@@ -176,6 +254,49 @@ static bool Net_SendDatagramToAddr(int32_t sock, const net_sockaddr *to_addr, co
   return true;
 }
 
+/**
+ * @brief Sends all datagrams in the specified source's queue. Datagrams which can not be
+ * sent are dropped with a warning, as `Net_SendDatagramToAddr` would.
+ */
+static void Net_SendQueuedDatagrams(net_src_t source) {
+  net_udp_queue_t *queue = &net_udp_state.queues[source];
+
+  const int32_t sock = net_udp_state.sockets[source];
+
+  size_t sent = 0;
+  while (sock && sent < queue->count) {
+
+    const ssize_t batch = Net_SendDatagrams(sock, queue->datagrams + sent, queue->count - sent);
+    if (batch <= 0) {
+      Com_Warn("%s\n", Net_GetErrorString());
+      sent++;
+    } else {
+      sent += batch;
+    }
+  }
+
+  queue->count = 0;
+}
+
+/**
+ * @brief Appends a datagram to the specified source's queue, sending the queue if it is full.
+ */
+static bool Net_QueueDatagram(net_src_t source, const net_addr_t *to, const void *data, size_t len) {
+  net_udp_queue_t *queue = &net_udp_state.queues[source];
+
+  if (queue->count == lengthof(queue->datagrams)) {
+    Net_SendQueuedDatagrams(source);
+  }
+
+  net_datagram_t *datagram = &queue->datagrams[queue->count++];
+
+  datagram->addr = *to;
+  datagram->size = len;
+  memcpy(datagram->data, data, len);
+
+  return true;
+}
+
 /**
  * @brief Sends a broadcast datagram by enumerating interfaces and sending to
  * each interface's subnet-directed broadcast address. This avoids `EHOSTUNREACH`,
@@ -237,11 +358,34 @@ bool Net_SendDatagram(net_src_t source, const net_addr_t *to, const void *data,
     return Net_SendBroadcastDatagram(sock, to, data, len);
   }
 
+  if (net_udp_state.queues[source].batch) {
+    return Net_QueueDatagram(source, to, data, len);
+  }
+
   net_sockaddr to_addr;
   Net_NetAddrToSockaddr(to, &to_addr);
   return Net_SendDatagramToAddr(sock, &to_addr, data, len);
 }
 
+/**
+ * @brief Begins a batch of datagrams for the specified source. Datagrams sent to remote
+ * addresses are queued until `Net_FlushDatagrams` is called, and then sent with as few
+ * system calls as possible.
+ */
+void Net_BeginDatagrams(net_src_t source) {
+  net_udp_state.queues[source].batch = true;
+}
+
+/**
+ * @brief Sends all datagrams queued since `Net_BeginDatagrams`, and ends the batch.
+ */
+void Net_FlushDatagrams(net_src_t source) {
+
+  Net_SendQueuedDatagrams(source);
+
+  net_udp_state.queues[source].batch = false;
+}
+
 /**
  * @brief Sleeps for msec or until the server socket is ready.
  */
@@ -291,6 +435,9 @@ void Net_Config(net_src_t source, bool up) {
     }
   } else {
     if (*sock != 0) {
+      net_udp_state.queues[source].count = 0;
+      net_udp_state.queues[source].batch = false;
+
       Net_CloseSocket(*sock);
       *sock = 0;
     }
@@ -25,6 +25,9 @@
 
 bool Net_ReceiveDatagram(net_src_t source, net_addr_t *from, mem_buf_t *buf);
 bool Net_SendDatagram(net_src_t source, const net_addr_t *to, const void *data, size_t len);
+size_t Net_ReceiveDatagrams(net_src_t source, net_datagram_t *datagrams, size_t count);
+void Net_BeginDatagrams(net_src_t source);
+void Net_FlushDatagrams(net_src_t source);
 
 void Net_Config(net_src_t source, bool up);
 void Net_Sleep(uint32_t msec);
@@ -67,6 +67,12 @@ typedef struct light_s {
    */
   box3_t visible_bounds;
 
+  /**
+   * @brief The inclusive range of voxels reached by this light, in voxel grid coordinates.
+   * The range is empty (mins exceed maxs) if the light reaches no voxels.
+   */
+  vec3i_t voxel_mins, voxel_maxs;
+
   /**
    * @brief The light style.
    */
@@ -47,9 +47,9 @@ typedef struct {
   int32_t contents;
 
   /**
-   * @brief The brush cache, to avoid multiple tests against the same brush.
+   * @brief The brushes visited by this trace, to avoid multiple tests against the same brush.
    */
-  int32_t brush_cache[128];
+  cm_brush_visits_t visits;
 
   /**
    * @brief The trace result.
@@ -63,16 +63,10 @@ typedef struct {
 } cm_trace_data_t;
 
 /**
- * @brief Returns true if the given brush number has already been tested in this trace, using a hash cache.
+ * @brief Returns true if the given brush number has already been tested in this trace.
  */
 static inline bool Light_BrushAlreadyTested(cm_trace_data_t *data, int32_t brush_num) {
-  const int32_t hash = brush_num & (lengthof(data->brush_cache) - 1);
-
-  const bool skip = (data->brush_cache[hash] == brush_num);
-
-  data->brush_cache[hash] = brush_num;
-
-  return skip;
+  return Cm_BrushVisited(&data->visits, brush_num);
 }
 
 /**
@@ -300,6 +294,265 @@ static inline void Light_TraceToNode(cm_trace_data_t *data, int32_t num, float p
   }
 }
 
+/**
+ * @brief Initializes the trace data for a line trace from start to end.
+ */
+static inline void Light_InitTrace(cm_trace_data_t *data, const vec3_t start, const vec3_t end, int32_t contents,
+                                   const cm_brush_visits_t visits) {
+
+  data->trace = (cm_trace_t) {
+    .fraction = 1.f
+  };
+
+  data->start = start;
+  data->end = end;
+  data->abs_bounds = Box3_FromPoints((const vec3_t []) { start, end }, 2);
+  data->contents = contents;
+  data->unnudged_fraction = 1.f + TRACE_EPSILON;
+  data->visits = visits;
+}
+
+/**
+ * @brief Resolves the trace end point from the trace fraction.
+ */
+static inline cm_trace_t Light_FinishTrace(cm_trace_data_t *data) {
+
+  Cm_EndBrushVisits(&data->visits);
+
+  data->trace.fraction = Maxf(0.f, data->trace.fraction);
+
+  if (data->trace.fraction == 0.f) {
+    data->trace.end = data->start;
+  } else if (data->trace.fraction == 1.f) {
+    data->trace.end = data->end;
+  } else {
+    data->trace.end = Vec3_Mix(data->start, data->end, data->trace.fraction);
+  }
+
+  return data->trace;
+}
+
+/**
+ * @brief A bundle of line traces sharing a common start point. The end points are stored as
+ * structures of arrays so that the per-node plane tests vectorize.
+ */
+typedef struct {
+
+  /**
+   * @brief The common start point.
+   */
+  vec3_t start;
+
+  /**
+   * @brief The end points of the rays.
+   */
+  float end_x[LIGHT_TRACE_BUNDLE_SIZE];
+  float end_y[LIGHT_TRACE_BUNDLE_SIZE];
+  float end_z[LIGHT_TRACE_BUNDLE_SIZE];
+
+  /**
+   * @brief The number of rays in the bundle.
+   */
+  int32_t count;
+
+  /**
+   * @brief The contents mask to collide with.
+   */
+  int32_t contents;
+
+  /**
+   * @brief The per-ray trace data.
+   */
+  cm_trace_data_t data[LIGHT_TRACE_BUNDLE_SIZE];
+} light_trace_bundle_t;
+
+/**
+ * @brief Traces the active rays of the bundle through a single BSP leaf.
+ */
+static void Light_TraceBundleToLeaf(light_trace_bundle_t *bundle, int32_t leaf_num, const bool *active) {
+
+  const cm_bsp_leaf_t *leaf = &Cm_Bsp()->leafs[leaf_num];
+
+  if (!(leaf->contents & bundle->contents)) {
+    return;
+  }
+
+  for (int32_t i = 0; i < leaf->num_leaf_brushes; i++) {
+    const int32_t brush_num = Cm_Bsp()->leaf_brushes[leaf->first_leaf_brush + i];
+
+    const cm_bsp_brush_t *b = &Cm_Bsp()->brushes[brush_num];
+
+    if (!(b->contents & bundle->contents)) {
+      continue;
+    }
+
+    for (int32_t j = 0; j < bundle->count; j++) {
+
+      if (!active[j]) {
+        continue;
+      }
+
+      cm_trace_data_t *data = &bundle->data[j];
+
+      if (data->trace.all_solid) {
+        continue;
+      }
+
+      if (Light_BrushAlreadyTested(data, brush_num)) {
+        continue;
+      }
+
+      Light_TraceToBrush(data, b);
+    }
+  }
+}
+
+/**
+ * @brief Recursively traces the bundle through the BSP tree. Each ray carries its own parametric
+ * interval within the current node, and drops out of the bundle once it has hit something nearer
+ * than that interval.
+ */
+static void Light_TraceBundleToNode(light_trace_bundle_t *bundle, int32_t num,
+                                    const float *t1, const float *t2, const bool *active) {
+
+  if (num < 0) {
+    Light_TraceBundleToLeaf(bundle, -1 - num, active);
+    return;
+  }
+
+  const cm_bsp_node_t *node = Cm_Bsp()->nodes + num;
+  const cm_bsp_plane_t plane = *node->plane;
+
+  // the start point is shared, so its distance to the plane is too
+  const float d1 = Vec3_Dot(plane.normal, bundle->start) - plane.dist;
+
+  float d2[LIGHT_TRACE_BUNDLE_SIZE];
+  for (int32_t i = 0; i < bundle->count; i++) {
+    d2[i] = plane.normal.x * bundle->end_x[i] +
+            plane.normal.y * bundle->end_y[i] +
+            plane.normal.z * bundle->end_z[i] - plane.dist;
+  }
+
+  // split each ray's interval against the plane, near side first
+
+  const int32_t near_side = d1 >= 0.f ? 0 : 1;
+
+  float near_t1[LIGHT_TRACE_BUNDLE_SIZE], near_t2[LIGHT_TRACE_BUNDLE_SIZE];
+  float far_t1[LIGHT_TRACE_BUNDLE_SIZE], far_t2[LIGHT_TRACE_BUNDLE_SIZE];
+  bool near_active[LIGHT_TRACE_BUNDLE_SIZE], far_active[LIGHT_TRACE_BUNDLE_SIZE];
+
+  bool any_near = false, any_far = false;
+
+  for (int32_t i = 0; i < bundle->count; i++) {
+
+    near_active[i] = far_active[i] = false;
+
+    if (!active[i]) {
+      continue;
+    }
+
+    const float da = d1 + t1[i] * (d2[i] - d1);
+    const float db = d1 + t2[i] * (d2[i] - d1);
+
+    const int32_t side_a = da >= 0.f ? 0 : 1;
+    const int32_t side_b = db >= 0.f ? 0 : 1;
+
+    if (side_a == side_b) {
+      if (side_a == near_side) {
+        near_t1[i] = t1[i];
+        near_t2[i] = t2[i];
+        near_active[i] = any_near = true;
+      } else {
+        far_t1[i] = t1[i];
+        far_t2[i] = t2[i];
+        far_active[i] = any_far = true;
+      }
+      continue;
+    }
+
+    // the interval crosses the plane, so d1 != d2[i]
+    const float split = Clampf(d1 / (d1 - d2[i]), t1[i], t2[i]);
+
+    if (side_a == near_side) {
+      near_t1[i] = t1[i];
+      near_t2[i] = split;
+      far_t1[i] = split;
+      far_t2[i] = t2[i];
+    } else {
+      far_t1[i] = t1[i];
+      far_t2[i] = split;
+      near_t1[i] = split;
+      near_t2[i] = t2[i];
+    }
+
+    near_active[i] = far_active[i] = any_near = any_far = true;
+  }
+
+  if (any_near) {
+    for (int32_t i = 0; i < bundle->count; i++) {
+      if (near_active[i] && near_t1[i] >= bundle->data[i].unnudged_fraction) {
+        near_active[i] = false;
+      }
+    }
+    Light_TraceBundleToNode(bundle, node->children[near_side], near_t1, near_t2, near_active);
+  }
+
+  if (any_far) {
+    any_far = false;
+    for (int32_t i = 0; i < bundle->count; i++) {
+      if (far_active[i]) {
+        const cm_trace_data_t *data = &bundle->data[i];
+        if (data->trace.all_solid || far_t1[i] >= data->unnudged_fraction) {
+          far_active[i] = false;
+        } else {
+          any_far = true;
+        }
+      }
+    }
+    if (any_far) {
+      Light_TraceBundleToNode(bundle, node->children[near_side ^ 1], far_t1, far_t2, far_active);
+    }
+  }
+}
+
+/**
+ * @brief Traces a bundle of at most `LIGHT_TRACE_BUNDLE_SIZE` rays sharing a start point down the
+ * BSP tree from the specified head node, visiting each node once for the whole bundle.
+ */
+static void Light_TraceBundle_(const vec3_t start, const vec3_t *ends, int32_t count,
+                               int32_t head_node, int32_t contents, cm_trace_t *traces) {
+
+  light_trace_bundle_t bundle;
+
+  bundle.start = start;
+  bundle.count = count;
+  bundle.contents = contents;
+
+  float t1[LIGHT_TRACE_BUNDLE_SIZE], t2[LIGHT_TRACE_BUNDLE_SIZE];
+  bool active[LIGHT_TRACE_BUNDLE_SIZE];
+
+  // the rays of the bundle share a generation of brush visits, one lane each
+  const cm_brush_visits_t visits = Cm_BeginBrushVisits(Cm_Bsp()->num_brushes);
+
+  for (int32_t i = 0; i < count; i++) {
+    bundle.end_x[i] = ends[i].x;
+    bundle.end_y[i] = ends[i].y;
+    bundle.end_z[i] = ends[i].z;
+
+    Light_InitTrace(&bundle.data[i], start, ends[i], contents, Cm_BrushVisitLane(&visits, i));
+
+    t1[i] = 0.f;
+    t2[i] = 1.f;
+    active[i] = true;
+  }
+
+  Light_TraceBundleToNode(&bundle, head_node, t1, t2, active);
+
+  for (int32_t i = 0; i < count; i++) {
+    traces[i] = Light_FinishTrace(&bundle.data[i]);
+  }
+}
+
 /**
  * @brief Primary collision detection entry point. This function recurses down
  * the BSP tree from the specified head node, clipping the desired movement to
@@ -320,31 +573,11 @@ static inline cm_trace_t Light_Trace_(vec3_t start, vec3_t end, int32_t head_nod
 
   cm_trace_data_t data;
 
-  data.trace = (cm_trace_t) {
-    .fraction = 1.f
-  };
-
-  data.start = start;
-  data.end = end;
-  data.abs_bounds = Box3_FromPoints((const vec3_t []) { start, end }, 2);
-  data.contents = contents;
-  data.unnudged_fraction = 1.f + TRACE_EPSILON;
-
-  memset(data.brush_cache, 0xff, sizeof(data.brush_cache));
+  Light_InitTrace(&data, start, end, contents, Cm_BeginBrushVisits(Cm_Bsp()->num_brushes));
 
   Light_TraceToNode(&data, head_node, 0.f, 1.f, data.start, data.end);
 
-  data.trace.fraction = Maxf(0.f, data.trace.fraction);
-
-  if (data.trace.fraction == 0.f) {
-    data.trace.end = data.start;
-  } else if (data.trace.fraction == 1.f) {
-    data.trace.end = data.end;
-  } else {
-    data.trace.end = Vec3_Mix(data.start, data.end, data.trace.fraction);
-  }
-
-  return data.trace;
+  return Light_FinishTrace(&data);
 }
 
 /**
@@ -387,6 +620,48 @@ cm_trace_t Light_Trace(const vec3_t start, const vec3_t end, int32_t head_node,
   return trace;
 }
 
+/**
+ * @brief Batched lighting collision detection for rays sharing a start point, such as visibility
+ * tests from a light source. The results are identical to calling `Light_Trace` for each end point.
+ * @param start The common starting point.
+ * @param ends The desired end points.
+ * @param count The number of end points.
+ * @param mask The contents mask to clip to.
+ * @param traces The traces, one per end point.
+ */
+void Light_TraceBundle(const vec3_t start, const vec3_t *ends, size_t count, int32_t head_node, int32_t mask, cm_trace_t *traces) {
+
+  while (count) {
+    const int32_t n = (int32_t) Mini((int32_t) count, LIGHT_TRACE_BUNDLE_SIZE);
+
+    Light_TraceBundle_(start, ends, n, 0, mask, traces);
+
+    for (int32_t i = 0; i < n; i++) {
+      if (traces[i].start_solid) {
+        traces[i].fraction = 0.f;
+      }
+    }
+
+    if (head_node) {
+      cm_trace_t trs[LIGHT_TRACE_BUNDLE_SIZE];
+      Light_TraceBundle_(start, ends, n, head_node, mask, trs);
+
+      for (int32_t i = 0; i < n; i++) {
+        if (trs[i].start_solid) {
+          trs[i].fraction = 0.f;
+        }
+        if (trs[i].fraction < traces[i].fraction) {
+          traces[i] = trs[i];
+        }
+      }
+    }
+
+    ends += n;
+    traces += n;
+    count -= n;
+  }
+}
+
 /**
  * @brief Builds voxels, bakes light, and emits all lightmap, voxel, and entity data into the BSP file.
  */
@@ -449,8 +724,13 @@ int32_t LIGHT_Main(void) {
     bsp_models[i] = Cm_Model(va("*%d", i));
   }
 
+  Cm_ResetBrushVisitStats();
+
   LightWorld();
 
+  const cm_brush_visit_stats_t stats = Cm_BrushVisitStats();
+  Com_Verbose("%" PRIu64 " brush tests, %" PRIu64 " repeat tests avoided\n", stats.visited, stats.avoided);
+
   WriteBSPFile(va("maps/%s.bsp", map_base));
 
   for (int32_t tag = MEM_TAG_QLIGHT; tag < MEM_TAG_QMAT; tag++) {
@@ -29,7 +29,13 @@
 
 extern bool antialias;
 
+/**
+ * @brief The maximum number of rays traced together by `Light_TraceBundle`.
+ */
+#define LIGHT_TRACE_BUNDLE_SIZE 16
+
 int32_t Light_PointContents(const vec3_t p, int32_t head_node);
 cm_trace_t Light_Trace(const vec3_t start, const vec3_t end, int32_t head_node, int32_t mask);
+void Light_TraceBundle(const vec3_t start, const vec3_t *ends, size_t count, int32_t head_node, int32_t mask, cm_trace_t *traces);
 
 int32_t LIGHT_Main(void);
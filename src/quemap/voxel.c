@@ -202,8 +202,6 @@ static void BuildVoxelVoxels(void) {
         );
 
         v->bounds = Box3_FromCenterRadius(v->origin, BSP_VOXEL_SIZE * .5f);
-
-        v->lights = g_hash_table_new(g_direct_hash, g_direct_equal);
       }
     }
   }
@@ -256,15 +254,15 @@ size_t BuildVoxels(void) {
 }
 
 /**
- * @brief Assigns lights to a voxel based on visibility traces to corners and center.
+ * @brief Assigns lights to a voxel based on visibility traces to corners and center. The center
+ * is traced first, as it is most often visible; the corners are traced together as a bundle.
  */
 void LightVoxel(int32_t voxel_num) {
 
   voxel_t *voxel = &voxels.voxels[voxel_num];
 
-  vec3_t points[9];
-  points[0] = voxel->origin;
-  Box3_ToPoints(voxel->bounds, &points[1]);
+  vec3_t corners[8];
+  Box3_ToPoints(voxel->bounds, corners);
 
   for (guint i = 0; i < lights->len; i++) {
 
@@ -276,56 +274,94 @@ void LightVoxel(int32_t voxel_num) {
       continue;
     }
 
-    for (size_t j = 0; j < lengthof(points); j++) {
+    bool visible = false;
+
+    const cm_trace_t to_center = Light_Trace(light->origin, voxel->origin, 0, CONTENTS_MASK_SHADOW);
+    if (to_center.fraction == 1.f || Box3_ContainsPoint(voxel->bounds, to_center.end)) {
+      visible = true;
+    } else {
+      cm_trace_t to_corners[lengthof(corners)];
+      Light_TraceBundle(light->origin, corners, lengthof(corners), 0, CONTENTS_MASK_SHADOW, to_corners);
+
+      for (size_t j = 0; j < lengthof(corners); j++) {
+        if (to_corners[j].fraction == 1.f || Box3_ContainsPoint(voxel->bounds, to_corners[j].end)) {
+          visible = true;
+          break;
+        }
+      }
+    }
 
-      const cm_trace_t to_voxel = Light_Trace(light->origin, points[j], 0, CONTENTS_MASK_SHADOW);
-      if (to_voxel.fraction == 1.f || Box3_ContainsPoint(voxel->bounds, to_voxel.end)) {
-        g_hash_table_add(voxel->lights, light);
-        break;
+    if (visible) {
+      if (!voxel->lights) {
+        voxel->lights = g_array_new(false, false, sizeof(int32_t));
       }
+      g_array_append_val(voxel->lights, i);
     }
   }
 }
 
 /**
- * @brief Calculates light visible bounds by taking the union of all visible voxels and feathering
- * those bounds to ensure smooth shadowing with no visible voxel boundaries in-game.
+ * @brief Feathers the light into the voxels neighboring those it directly lights, ensuring smooth
+ * shadowing with no visible voxel boundaries in-game. Its visible bounds are the union of the
+ * voxels it reaches.
  */
-void FloodLights(void) {
+void FloodLight(int32_t light_num) {
 
-  voxel_t *v = voxels.voxels;
+  light_t *l = g_ptr_array_index(lights, light_num);
+
+  l->visible_bounds = Box3_Null();
+
+  if (l->target_entity != -1 || l->voxel_mins.x > l->voxel_maxs.x) {
+    l->voxel_mins = Vec3i(0, 0, 0);
+    l->voxel_maxs = Vec3i(-1, -1, -1);
+    return;
+  }
+
+  for (int32_t i = 0; i < 3; i++) {
+    l->voxel_mins.xyz[i] = Maxi(l->voxel_mins.xyz[i] - 1, 0);
+    l->voxel_maxs.xyz[i] = Mini(l->voxel_maxs.xyz[i] + 1, voxels.size.xyz[i] - 1);
+  }
+
+  const voxel_t *mins = &voxels.voxels[(l->voxel_mins.z * voxels.size.y + l->voxel_mins.y) * voxels.size.x + l->voxel_mins.x];
+  const voxel_t *maxs = &voxels.voxels[(l->voxel_maxs.z * voxels.size.y + l->voxel_maxs.y) * voxels.size.x + l->voxel_maxs.x];
+
+  l->visible_bounds = Box3_Union(mins->bounds, maxs->bounds);
+}
+
+/**
+ * @brief Resolves the range of voxels directly lit by each light, and then floods each light
+ * into its neighboring voxels.
+ */
+void FloodLights(void) {
 
   for (guint i = 0; i < lights->len; i++) {
     light_t *l = g_ptr_array_index(lights, i);
 
-    l->visible_bounds = Box3_Null();
-
-    if (l->target_entity != -1) {
-      continue;
-    }
+    l->voxel_mins = Vec3i(INT32_MAX, INT32_MAX, INT32_MAX);
+    l->voxel_maxs = Vec3i(INT32_MIN, INT32_MIN, INT32_MIN);
+  }
 
-    box3_t bounds = Box3_Null();
+  voxel_t *v = voxels.voxels;
+  for (size_t i = 0; i < voxels.num_voxels; i++, v++) {
 
-    for (size_t j = 0; j < voxels.num_voxels; j++) {
-      if (g_hash_table_contains(v[j].lights, l)) {
-        bounds = Box3_Union(bounds, v[j].bounds);
-      }
+    if (!v->lights) {
+      continue;
     }
 
-    bounds = Box3_Expand(bounds, BSP_VOXEL_SIZE * .5f);
+    for (guint j = 0; j < v->lights->len; j++) {
+      light_t *l = g_ptr_array_index(lights, g_array_index(v->lights, int32_t, j));
 
-    for (size_t j = 0; j < voxels.num_voxels; j++) {
-      if (Box3_Intersects(bounds, v[j].bounds)) {
-        g_hash_table_add(v[j].lights, l);
+      for (int32_t k = 0; k < 3; k++) {
+        l->voxel_mins.xyz[k] = Mini(l->voxel_mins.xyz[k], v->xyz.xyz[k]);
+        l->voxel_maxs.xyz[k] = Maxi(l->voxel_maxs.xyz[k], v->xyz.xyz[k]);
       }
     }
 
-    for (size_t j = 0; j < voxels.num_voxels; j++) {
-      if (g_hash_table_contains(v[j].lights, l)) {
-        l->visible_bounds = Box3_Union(l->visible_bounds, v[j].bounds);
-      }
-    }
+    g_array_free(v->lights, true);
+    v->lights = NULL;
   }
+
+  Work("Flooding lights", FloodLight, (int32_t) lights->len);
 }
 
 #define CAUSTICS_RADIUS 256.f
@@ -514,10 +550,6 @@ void SmoothVoxels(void) {
   Mem_Free(smooth_caust);
 }
 
-static int IntCompare(const void *a, const void *b) {
-  return *(const int32_t *) a - *(const int32_t *) b;
-}
-
 /**
  * @brief Serializes the voxel grid (caustics direction/strength, exposure, and light indices) into the BSP voxels lump.
  */
@@ -528,12 +560,34 @@ void EmitVoxels(void) {
   voxels.num_light_indices = 0;
 
   voxel_t *v = voxels.voxels;
+  for (size_t i = 0; i < voxels.num_voxels; i++, v++) {
+    v->lights_count = 0;
+  }
+
+  // count the lights reaching each voxel; only lights with visible bounds are emitted
+
+  for (guint i = 0; i < lights->len; i++) {
+    const light_t *l = g_ptr_array_index(lights, i);
+
+    if (!l->out || l->target_entity != -1) {
+      continue;
+    }
+
+    for (int32_t z = l->voxel_mins.z; z <= l->voxel_maxs.z; z++) {
+      for (int32_t y = l->voxel_mins.y; y <= l->voxel_maxs.y; y++) {
+        for (int32_t x = l->voxel_mins.x; x <= l->voxel_maxs.x; x++) {
+          voxels.voxels[(z * voxels.size.y + y) * voxels.size.x + x].lights_count++;
+        }
+      }
+    }
+  }
+
+  v = voxels.voxels;
   int32_t min_lights = INT32_MAX, max_lights = 0;
   size_t total_lights = 0;
   
   for (size_t i = 0; i < voxels.num_voxels; i++, v++) {
     v->lights_offset = (int32_t) voxels.num_light_indices;
-    v->lights_count = (int32_t) g_hash_table_size(v->lights);
 
     voxels.num_light_indices += v->lights_count;
     
@@ -604,34 +658,39 @@ void EmitVoxels(void) {
   int32_t *out_light_indices = (int32_t *) out;
   out += voxels.num_light_indices * sizeof(int32_t);
 
-  for (int32_t z = 0; z < voxels.size.z; z++) {
-    for (int32_t y = 0; y < voxels.size.y; y++) {
-      for (int32_t x = 0; x < voxels.size.x; x++) {
+  // scatter each light into the voxels it reaches; lights are emitted in order, so each
+  // voxel's light indices are written in ascending order
 
-        const int32_t index = (z * voxels.size.y + y) * voxels.size.x + x;
-        const voxel_t *voxel = &voxels.voxels[index];
+  int32_t *cursor = Mem_TagMalloc(voxels.num_voxels * sizeof(int32_t), MEM_TAG_VOXEL);
 
-        GHashTableIter iter;
-        light_t *light;
+  v = voxels.voxels;
+  for (size_t i = 0; i < voxels.num_voxels; i++, v++) {
+    cursor[i] = v->lights_offset;
+  }
 
-        int32_t *indices = out_light_indices;
+  for (guint i = 0; i < lights->len; i++) {
+    const light_t *l = g_ptr_array_index(lights, i);
 
-        g_hash_table_iter_init(&iter, voxel->lights);
-        while (g_hash_table_iter_next(&iter, (gpointer *) &light, NULL)) {
-          if (!light->out) {
-            continue;
-          }
-          *out_light_indices++ = (int32_t) (ptrdiff_t) (light->out - bsp_file.lights);
-        }
+    if (!l->out || l->target_entity != -1) {
+      continue;
+    }
 
-        const int32_t count = (int32_t) (out_light_indices - indices);
-        if (count > 1) {
-          qsort(indices, count, sizeof(int32_t), IntCompare);
+    const int32_t light_index = (int32_t) (ptrdiff_t) (l->out - bsp_file.lights);
+
+    for (int32_t z = l->voxel_mins.z; z <= l->voxel_maxs.z; z++) {
+      for (int32_t y = l->voxel_mins.y; y <= l->voxel_maxs.y; y++) {
+        for (int32_t x = l->voxel_mins.x; x <= l->voxel_maxs.x; x++) {
+          const int32_t index = (z * voxels.size.y + y) * voxels.size.x + x;
+          out_light_indices[cursor[index]++] = light_index;
         }
       }
     }
   }
 
+  Mem_Free(cursor);
+
+  out_light_indices += voxels.num_light_indices;
+
   byte *out_occlusion = (byte *) out_light_indices;
 
   for (int32_t z = 0; z < voxels.size.z; z++) {
@@ -653,13 +712,15 @@ void EmitVoxels(void) {
 }
 
 /**
- * @brief Frees all per-voxel light hash tables and releases the voxel memory pool.
+ * @brief Frees any remaining per-voxel light lists and releases the voxel memory pool.
  */
 void FreeVoxels(void) {
 
   voxel_t *v = voxels.voxels;
   for (size_t i = 0; i < voxels.num_voxels; i++, v++) {
-    g_hash_table_destroy(v->lights);
+    if (v->lights) {
+      g_array_free(v->lights, true);
+    }
   }
 
   Mem_FreeTag((mem_tag_t) MEM_TAG_VOXEL);
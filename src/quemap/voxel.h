@@ -31,7 +31,7 @@ typedef struct {
   vec3_t caustics;
   float exposure;
   float occlusion;
-  GHashTable *lights;
+  GArray *lights; // indexes of lights visible to this voxel, used only until `FloodLights`
   int32_t lights_offset;
   int32_t lights_count;
 } voxel_t;
@@ -51,6 +51,7 @@ extern voxels_t voxels;
 
 size_t BuildVoxels(void);
 void LightVoxel(int32_t voxel_num);
+void FloodLight(int32_t light_num);
 void FloodLights(void);
 void CausticsVoxel(int32_t voxel_num);
 void ExposureVoxel(int32_t voxel_num);
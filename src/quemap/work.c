@@ -23,59 +23,83 @@
 
 #include "quemap.h"
 
+/**
+ * @brief Work is claimed in chunks of consecutive iterations, sized so that each thread
+ * claims roughly this many chunks over the course of a pass. This keeps contention on the
+ * shared counter low, while still balancing iterations of uneven cost.
+ */
+#define WORK_CHUNKS_PER_THREAD 32
+
+/**
+ * @brief The maximum number of iterations claimed at once.
+ */
+#define WORK_MAX_CHUNK 1024
+
+/**
+ * @brief Per-thread work statistics, for reporting load imbalance.
+ */
+typedef struct {
+  uint64_t busy; // performance counter ticks spent in the work function
+  int32_t iterations; // iterations completed
+} work_stats_t;
+
 typedef struct {
-  SDL_Mutex *lock; // mutex on all running work
   const char *name; // the work name
   WorkFunc func; // the work function
-  int32_t index; // current work cycle
   int32_t count; // total work cycles
+  int32_t chunk; // work cycles claimed at once
+  SDL_AtomicInt index; // next unclaimed work cycle
+  SDL_AtomicInt completed; // work cycles completed
+  SDL_AtomicInt active; // threads still running
   int32_t percent; // last fraction of work completed
 } work_t;
 
 static work_t work;
 
 /**
- * @brief Return an iteration of work, updating progress when appropriate.
+ * @brief Outputs the progress of the current work, if it has changed.
  */
-static int32_t GetWork(void) {
-
-  int32_t w = -1;
-  SDL_LockMutex(work.lock);
-
-  if (Com_WasInit(QUEMAP)) {
-    if (work.index < work.count) {
+static void WorkProgress(void) {
 
-      // update work percent and output progress
-      const int32_t p = ceilf(100.0 * work.index / work.count);
-      if (p != work.percent) {
-        if (work.name) {
-          Com_Print("\r%-24s [%3d%%]", work.name, p);
-        }
-        work.percent = p;
-      }
-
-      // assign the next work iteration
-      w = work.index++;
+  if (work.name && work.count) {
+    const int32_t p = ceilf(100.0 * SDL_GetAtomicInt(&work.completed) / work.count);
+    if (p != work.percent) {
+      Com_Print("\r%-24s [%3d%%]", work.name, p);
+      work.percent = p;
     }
   }
-
-  SDL_UnlockMutex(work.lock);
-  return w;
 }
 
 /**
- * @brief Shared work entry point by all threads. Retrieve and perform
- * chunks of work iteratively until work is finished.
+ * @brief Shared work entry point by all threads. Claim and perform chunks of
+ * work iteratively until work is finished.
  */
 static void RunWorkFunc(void *p) {
 
-  while (true) {
-    const int32_t w = GetWork();
-    if (w == -1) {
+  work_stats_t *stats = p;
+
+  while (Com_WasInit(QUEMAP)) {
+
+    const int32_t start = SDL_AddAtomicInt(&work.index, work.chunk);
+    if (start >= work.count) {
       break;
     }
-    work.func(w);
+
+    const int32_t end = Mini(start + work.chunk, work.count);
+
+    const uint64_t ticks = SDL_GetPerformanceCounter();
+
+    for (int32_t w = start; w < end; w++) {
+      work.func(w);
+    }
+
+    stats->busy += SDL_GetPerformanceCounter() - ticks;
+    stats->iterations += end - start;
+
+    SDL_AddAtomicInt(&work.completed, end - start);
   }
+
+  SDL_AddAtomicInt(&work.active, -1);
 }
 
 /**
@@ -85,24 +109,38 @@ void Work(const char *name, WorkFunc func, int32_t count) {
 
   memset(&work, 0, sizeof(work));
 
-  work.lock = SDL_CreateMutex();
+  const int32_t thread_count = Thread_Count();
+  const int32_t num_workers = Maxi(thread_count, 1);
+
   work.name = name;
   work.count = count;
+  work.chunk = Maxi(1, Mini(count / (num_workers * WORK_CHUNKS_PER_THREAD), WORK_MAX_CHUNK));
   work.func = func;
-  work.index = 0;
   work.percent = -1;
 
+  SDL_SetAtomicInt(&work.active, num_workers);
+
+  work_stats_t stats[num_workers];
+  memset(stats, 0, sizeof(stats));
+
   const uint32_t start = (uint32_t) SDL_GetTicks();
 
-  const int32_t thread_count = Thread_Count();
+  WorkProgress();
 
   if (thread_count == 0) {
-    RunWorkFunc(0);
+    RunWorkFunc(&stats[0]);
   } else {
     thread_t *threads[thread_count];
 
     for (int32_t i = 0; i < thread_count; i++) {
-      threads[i] = Thread_Create(RunWorkFunc, NULL, 0);
+      threads[i] = Thread_Create(RunWorkFunc, &stats[i], 0);
+    }
+
+    // report progress from this thread, so that workers never wait on the console
+
+    while (SDL_GetAtomicInt(&work.active)) {
+      WorkProgress();
+      SDL_Delay(10);
     }
 
     for (int32_t i = 0; i < thread_count; i++) {
@@ -110,13 +148,22 @@ void Work(const char *name, WorkFunc func, int32_t count) {
     }
   }
 
-  SDL_DestroyMutex(work.lock);
-  work.lock = NULL;
+  WorkProgress();
 
   const uint32_t end = (uint32_t) SDL_GetTicks();
 
   if (work.name) {
-    Com_Print(" %d ms\n", end - start);
+    uint64_t total = 0, max = 0;
+
+    for (int32_t i = 0; i < num_workers; i++) {
+      total += stats[i].busy;
+      max = (uint64_t) Maxui64(max, stats[i].busy);
+    }
+
+    // the busiest thread's time over the mean; 0% is a perfect balance
+    const double imbalance = total ? 100.0 * (max * num_workers / (double) total - 1.0) : 0.0;
+
+    Com_Print(" %d ms, %d threads, %.1f%% imbalance\n", end - start, num_workers, imbalance);
   }
 }
 
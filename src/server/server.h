@@ -29,6 +29,7 @@
 #include "sv_admin.h"
 #include "sv_console.h"
 #include "sv_client.h"
+#include "sv_demo.h"
 #include "sv_editor.h"
 #include "sv_entity.h"
 #include "sv_game.h"
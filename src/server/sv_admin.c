@@ -153,6 +153,50 @@ static void Sv_Demo_f(void) {
   }
 }
 
+/**
+ * @brief Seeks the demo being played back to the specified level time, or by the specified
+ * offset. Times are given in seconds, or as minutes and seconds.
+ */
+static void Sv_DemoSeek_f(void) {
+
+  if (Cmd_Argc() != 2) {
+    Com_Print("Usage: %s <[+|-]seconds | m:ss>\n", Cmd_Argv(0));
+    return;
+  }
+
+  if (svs.state != SV_ACTIVE_DEMO) {
+    Com_Print("Not playing a demo\n");
+    return;
+  }
+
+  const char *arg = Cmd_Argv(1);
+  const bool relative = *arg == '+' || *arg == '-';
+
+  int32_t minutes = 0;
+  float seconds = 0.f;
+
+  if (strchr(arg, ':')) {
+    if (relative || sscanf(arg, "%d:%f", &minutes, &seconds) != 2) {
+      Com_Print("Usage: %s <[+|-]seconds | m:ss>\n", Cmd_Argv(0));
+      return;
+    }
+  } else {
+    seconds = strtof(arg, NULL);
+  }
+
+  const int64_t offset = (int64_t) ((minutes * 60 + seconds) * 1000.f);
+
+  const int64_t time = relative ? sv.demo_time + offset : offset;
+
+  if (!Sv_SeekDemo((uint32_t) MAX(time, 0))) {
+    Com_Print("%s has no keyframes, and can not be seeked. Demos recorded before keyframes "
+              "can not be indexed; record one again during playback to make a seekable copy\n", sv.name);
+    return;
+  }
+
+  Com_Print("Seeking to %u:%02u\n", sv.demo_time / 60000, (sv.demo_time / 1000) % 60);
+}
+
 /**
  * @brief Map command autocompletion.
  */
@@ -238,6 +282,49 @@ static void Sv_Status_f(void) {
   }
 }
 
+/**
+ * @brief Prints per-frame statistics for entity and multicast culling.
+ */
+static void Sv_FrameStats_f(void) {
+
+  if (svs.state == SV_UNINITIALIZED) {
+    Com_Print("No server running\n");
+    return;
+  }
+
+  const sv_frame_stats_t *frame = &sv.last_frame_stats;
+  const sv_frame_stats_t *total = &sv.total_stats;
+
+  Com_Print("frame %u: %u client frames, %u entities sent, %u entities culled, %zu bytes sent, %zu bytes culled\n",
+            sv.frame_num,
+            frame->client_frames,
+            frame->entities_sent,
+            frame->entities_culled,
+            frame->datagram_bytes,
+            frame->multicast_bytes_culled);
+
+  if (total->client_frames) {
+    const float sent = total->entities_sent / (float) total->client_frames;
+    const float culled = total->entities_culled / (float) total->client_frames;
+
+    Com_Print("average over %u frames: %.1f entities sent, %.1f entities culled per client frame (%.1f%% culled)\n",
+              sv.num_stats_frames, sent, culled, 100.f * culled / Maxf(sent + culled, 1.f));
+
+    const float bytes = total->datagram_bytes * QUETOO_TICK_RATE / (float) total->client_frames;
+    const float unfiltered = (total->datagram_bytes + total->multicast_bytes_culled) * QUETOO_TICK_RATE / (float) total->client_frames;
+
+    Com_Print("datagram bandwidth: %.0f bytes per client per second, %.0f without multicast filtering\n",
+              bytes, unfiltered);
+
+    const uint32_t deltas = total->entity_deltas_encoded + total->entity_deltas_cached;
+
+    Com_Print("entity deltas: %u encoded, %u cached (%.1f%% hit ratio)\n",
+              total->entity_deltas_encoded,
+              total->entity_deltas_cached,
+              100.f * total->entity_deltas_cached / Maxf(deltas, 1.f));
+  }
+}
+
 /**
  * @brief Lists all entities currently in use.
  */
@@ -409,12 +496,15 @@ void Sv_InitAdmin(void) {
   Cmd_Add("kick", Sv_Kick_f, CMD_SERVER, "Kick a specific user");
   Cmd_Add("status", Sv_Status_f, CMD_SERVER, "Print server status information");
   Cmd_Add("list_entities", Sv_ListEntities_f, CMD_SERVER, "List all entities in use");
+  Cmd_Add("frame_stats", Sv_FrameStats_f, CMD_SERVER, "Print per-frame entity culling and bandwidth statistics");
   Cmd_Add("server_info", Sv_ServerInfo_f, CMD_SERVER, "Print server info settings");
   Cmd_Add("user_info", Sv_UserInfo_f, CMD_SERVER, "Print information for a given user");
 
   cmd_t *demo_cmd = Cmd_Add("demo", Sv_Demo_f, CMD_SERVER, "Start playback of the specified demo file");
   Cmd_SetAutocomplete(demo_cmd, Sv_Demo_Autocomplete_f);
 
+  Cmd_Add("demo_seek", Sv_DemoSeek_f, CMD_SERVER, "Seek the demo being played back to the specified time");
+
   cmd_t *map_cmd = Cmd_Add("map", Sv_Map_f, CMD_SERVER, "Start a server for the specified map");
   Cmd_SetAutocomplete(map_cmd, Sv_Map_Autocomplete_f);
 
@@ -183,6 +183,8 @@ static void Sv_Begin_f(void) {
 
   sv_client->state = SV_CLIENT_ACTIVE;
 
+  Sv_ClearClientVisibility(sv_client);
+
   g_client_t *cl = sv_client->gclient;
 
   svs.game->ClientBegin(cl);
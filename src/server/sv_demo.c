@@ -0,0 +1,425 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "sv_local.h"
+
+/**
+ * @brief Advances to the next demo in the playlist or restarts from the beginning.
+ */
+static void Sv_DemoCompleted(void) {
+
+  if (sv_demo_list->string[0]) {
+
+    const char *current_demo = sv.name;
+    const char *next_demo = g_strrstr(sv_demo_list->string, current_demo);
+    char demo_token[MAX_QPATH];
+
+    if (!next_demo) {
+
+      next_demo = sv_demo_list->string;
+    } else {
+
+      next_demo += strlen(current_demo);
+
+      if (next_demo[0] == ' ') {
+        next_demo++;
+      } else if (!next_demo[0]) {
+        next_demo = sv_demo_list->string;
+      }
+    }
+
+    const char *space = strchr(next_demo, ' ') ? : (next_demo + strlen(next_demo));
+    size_t len = space - next_demo;
+
+    strncpy(demo_token, next_demo, len);
+    demo_token[len] = 0;
+
+    if (demo_token[0]) {
+      Sv_InitServer(demo_token, SV_ACTIVE_DEMO);
+    } else {
+      Sv_ShutdownServer("Demo complete\n");
+    }
+  } else {
+    Sv_ShutdownServer("Demo complete\n");
+  }
+}
+
+/**
+ * @brief Reads `count` keyframe index entries from the specified file.
+ * @return True if all entries were read, false otherwise.
+ */
+static bool Sv_ReadDemoIndexEntries(file_t *file, int32_t count) {
+
+  for (int32_t i = 0; i < count; i++) {
+    int32_t entry[2];
+
+    if (Fs_Read(file, entry, sizeof(entry), 1) != 1) {
+      g_array_set_size(sv.demo_keyframes, 0);
+      return false;
+    }
+
+    const sv_demo_keyframe_t keyframe = {
+      .time = (uint32_t) LittleLong(entry[0]),
+      .offset = LittleLong(entry[1])
+    };
+
+    g_array_append_val(sv.demo_keyframes, keyframe);
+  }
+
+  return true;
+}
+
+/**
+ * @brief Loads the keyframe index from the end of the demo file.
+ * @return True if the demo file ends with a valid index, false otherwise.
+ */
+static bool Sv_LoadDemoIndex(void) {
+  int32_t trailer[2], count;
+
+  const int64_t length = Fs_FileLength(sv.demo_file);
+  if (length < (int64_t) (sizeof(trailer) + sizeof(count))) {
+    return false;
+  }
+
+  if (!Fs_Seek(sv.demo_file, length - sizeof(trailer)) ||
+      Fs_Read(sv.demo_file, trailer, sizeof(trailer), 1) != 1) {
+    return false;
+  }
+
+  if (LittleLong(trailer[1]) != DEMO_INDEX_MAGIC) {
+    return false;
+  }
+
+  const int64_t offset = LittleLong(trailer[0]);
+  if (offset <= 0 || offset > length - (int64_t) (sizeof(trailer) + sizeof(count))) {
+    return false;
+  }
+
+  if (!Fs_Seek(sv.demo_file, offset) || Fs_Read(sv.demo_file, &count, sizeof(count), 1) != 1) {
+    return false;
+  }
+
+  count = LittleLong(count);
+
+  if (count < 0 || offset + sizeof(count) + count * sizeof(int32_t) * 2 + sizeof(trailer) != (uint64_t) length) {
+    Com_Warn("Invalid keyframe index in %s\n", sv.name);
+    return false;
+  }
+
+  return Sv_ReadDemoIndexEntries(sv.demo_file, count);
+}
+
+/**
+ * @return The path of the keyframe index file of the demo being played back, which holds
+ * the index rebuilt for a demo without one.
+ */
+static const char *Sv_DemoIndexPath(void) {
+  return va("demos/%s.demo.idx", sv.name);
+}
+
+/**
+ * @brief Loads the keyframe index of the demo being played back from its index file. The
+ * index file is only valid for the demo file's length and modification time.
+ * @return True if a valid index file was loaded, false otherwise.
+ */
+static bool Sv_LoadDemoIndexFile(void) {
+  int32_t header[4];
+
+  const char *path = Sv_DemoIndexPath();
+
+  if (!Fs_Exists(path)) {
+    return false;
+  }
+
+  file_t *file = Fs_OpenRead(path);
+  if (!file) {
+    return false;
+  }
+
+  bool valid = Fs_Read(file, header, sizeof(header), 1) == 1 &&
+               LittleLong(header[0]) == DEMO_INDEX_MAGIC &&
+               LittleLong(header[1]) == (int32_t) Fs_FileLength(sv.demo_file) &&
+               LittleLong(header[2]) == (int32_t) Fs_LastModTime(va("demos/%s.demo", sv.name)) &&
+               LittleLong(header[3]) >= 0;
+
+  if (valid) {
+    valid = Sv_ReadDemoIndexEntries(file, LittleLong(header[3]));
+  }
+
+  Fs_Close(file);
+  return valid;
+}
+
+/**
+ * @brief Writes the rebuilt keyframe index of the demo being played back to its index
+ * file, so that the demo is only scanned once. Demos without keyframes are written an
+ * empty index.
+ */
+static void Sv_WriteDemoIndexFile(void) {
+
+  const char *path = Sv_DemoIndexPath();
+
+  file_t *file = Fs_OpenWrite(path);
+  if (!file) {
+    Com_Warn("Failed to write %s\n", path);
+    return;
+  }
+
+  const int32_t header[] = {
+    LittleLong(DEMO_INDEX_MAGIC),
+    LittleLong((int32_t) Fs_FileLength(sv.demo_file)),
+    LittleLong((int32_t) Fs_LastModTime(va("demos/%s.demo", sv.name))),
+    LittleLong((int32_t) sv.demo_keyframes->len)
+  };
+
+  Fs_Write(file, header, sizeof(header), 1);
+
+  for (guint i = 0; i < sv.demo_keyframes->len; i++) {
+    const sv_demo_keyframe_t *keyframe = &g_array_index(sv.demo_keyframes, sv_demo_keyframe_t, i);
+    const int32_t entry[] = { LittleLong((int32_t) keyframe->time), LittleLong((int32_t) keyframe->offset) };
+    Fs_Write(file, entry, sizeof(entry), 1);
+  }
+
+  Fs_Close(file);
+}
+
+/**
+ * @brief Rebuilds the keyframe index of a demo file which has none, e.g. because
+ * recording was interrupted, by scanning its records. Scanning stops at the first
+ * incomplete record. Demos recorded before keyframes were introduced will yield an
+ * empty index.
+ */
+static void Sv_BuildDemoIndex(void) {
+
+  const int64_t length = Fs_FileLength(sv.demo_file);
+
+  Fs_Seek(sv.demo_file, 0);
+
+  bool group = false;
+
+  while (true) {
+    const int64_t offset = Fs_Tell(sv.demo_file);
+    int32_t len, time = 0;
+
+    if (Fs_Read(sv.demo_file, &len, sizeof(len), 1) != 1) {
+      break;
+    }
+
+    len = LittleLong(len);
+
+    const bool keyframe = len == DEMO_KEYFRAME;
+    if (keyframe) {
+      if (Fs_Read(sv.demo_file, &time, sizeof(time), 1) != 1 ||
+          Fs_Read(sv.demo_file, &len, sizeof(len), 1) != 1) {
+        break;
+      }
+
+      time = LittleLong(time);
+      len = LittleLong(len);
+    }
+
+    if (len < 0 || len > MAX_MSG_SIZE || Fs_Tell(sv.demo_file) + len > length) { // truncated
+      break;
+    }
+
+    if (keyframe && !group) { // only the first record of each keyframe is indexed
+      const sv_demo_keyframe_t kf = {
+        .time = (uint32_t) time,
+        .offset = offset
+      };
+
+      g_array_append_val(sv.demo_keyframes, kf);
+    }
+
+    group = keyframe;
+
+    if (!Fs_Seek(sv.demo_file, Fs_Tell(sv.demo_file) + len)) {
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Loads the keyframe index of the demo file that was just opened, and rewinds the
+ * file for playback. Demos without a trailing index are scanned once, and the rebuilt
+ * index is written to an index file for subsequent playback.
+ */
+void Sv_OpenDemo(void) {
+
+  sv.demo_keyframes = g_array_new(false, false, sizeof(sv_demo_keyframe_t));
+
+  if (!sv.demo_file) {
+    return;
+  }
+
+  if (!Sv_LoadDemoIndex() && !Sv_LoadDemoIndexFile()) {
+    Com_Debug(DEBUG_SERVER, "Rebuilding keyframe index for %s\n", sv.name);
+    Sv_BuildDemoIndex();
+    Sv_WriteDemoIndexFile();
+  }
+
+  if (sv.demo_keyframes->len) {
+    Com_Debug(DEBUG_SERVER, "%s has %u keyframes\n", sv.name, sv.demo_keyframes->len);
+  } else {
+    Com_Print("  %s has no keyframes, and can not be indexed or seeked\n", sv.name);
+  }
+
+  Fs_Seek(sv.demo_file, 0);
+}
+
+/**
+ * @brief Closes the demo file and frees its keyframe index.
+ */
+void Sv_CloseDemo(void) {
+
+  if (sv.demo_file) {
+    Fs_Close(sv.demo_file);
+    sv.demo_file = NULL;
+  }
+
+  if (sv.demo_keyframes) {
+    g_array_free(sv.demo_keyframes, true);
+    sv.demo_keyframes = NULL;
+  }
+}
+
+/**
+ * @brief Reads the next message from the current demo file into the specified buffer,
+ * returning the size of the message in bytes. Keyframe records are skipped, unless
+ * playback is resuming from them after a seek.
+ *
+ * FIXME: This doesn't work with the new packetized overflow avoidance. Multiple
+ * messages can constitute a frame. We need a mechanism to indicate frame
+ * completion.
+ */
+size_t Sv_ReadDemoMessage(byte *buffer) {
+
+  while (true) {
+    int32_t size;
+
+    if (Fs_Read(sv.demo_file, &size, sizeof(size), 1) != 1) { // improperly terminated demo file
+      Com_Warn("Failed to read demo file\n");
+      Sv_DemoCompleted();
+      return 0;
+    }
+
+    size = LittleLong(size);
+
+    if (size == -1) { // properly terminated demo file
+      Sv_DemoCompleted();
+      return 0;
+    }
+
+    const bool keyframe = size == DEMO_KEYFRAME;
+    if (keyframe) {
+      int32_t header[2];
+
+      if (Fs_Read(sv.demo_file, header, sizeof(header), 1) != 1) {
+        Com_Warn("Incomplete or corrupt demo file\n");
+        Sv_DemoCompleted();
+        return 0;
+      }
+
+      sv.demo_time = (uint32_t) LittleLong(header[0]);
+      size = LittleLong(header[1]);
+    } else {
+      sv.demo_seek = false;
+    }
+
+    if (size < 0 || size > MAX_MSG_SIZE) { // corrupt demo file
+      Com_Warn("Invalid message size %d\n", size);
+      Sv_DemoCompleted();
+      return 0;
+    }
+
+    if (keyframe && !sv.demo_seek) { // the preceding messages already hold this frame
+      if (!Fs_Seek(sv.demo_file, Fs_Tell(sv.demo_file) + size)) {
+        Com_Warn("Incomplete or corrupt demo file\n");
+        Sv_DemoCompleted();
+        return 0;
+      }
+      continue;
+    }
+
+    if (Fs_Read(sv.demo_file, buffer, size, 1) != 1) {
+      Com_Warn("Incomplete or corrupt demo file\n");
+      Sv_DemoCompleted();
+      return 0;
+    }
+
+    if (!keyframe) {
+      sv.demo_time += QUETOO_TICK_MILLIS;
+    }
+
+    return size;
+  }
+}
+
+/**
+ * @brief Resumes demo playback from the latest keyframe at or before the specified
+ * server time. Only the keyframes of the level being played back are considered.
+ * @return True if the demo was seeked, false if it has no keyframes.
+ */
+bool Sv_SeekDemo(uint32_t time) {
+
+  if (!sv.demo_file || !sv.demo_keyframes || !sv.demo_keyframes->len) {
+    return false;
+  }
+
+  const sv_demo_keyframe_t *keyframes = (sv_demo_keyframe_t *) sv.demo_keyframes->data;
+  const guint count = sv.demo_keyframes->len;
+
+  // find the keyframe at or before the current position
+  const int64_t position = Fs_Tell(sv.demo_file);
+
+  guint current = 0;
+  while (current + 1 < count && keyframes[current + 1].offset <= position) {
+    current++;
+  }
+
+  // server time restarts with each level, so bound the search to this level
+  guint first = current, last = current;
+
+  while (first > 0 && keyframes[first - 1].time < keyframes[first].time) {
+    first--;
+  }
+
+  while (last + 1 < count && keyframes[last + 1].time > keyframes[last].time) {
+    last++;
+  }
+
+  const sv_demo_keyframe_t *keyframe = &keyframes[first];
+
+  for (guint i = first; i <= last && keyframes[i].time <= time; i++) {
+    keyframe = &keyframes[i];
+  }
+
+  if (!Fs_Seek(sv.demo_file, keyframe->offset)) {
+    Com_Warn("Failed to seek %s\n", sv.name);
+    return false;
+  }
+
+  sv.demo_time = keyframe->time;
+  sv.demo_seek = true;
+
+  return true;
+}
@@ -21,6 +21,76 @@
 
 #include "sv_local.h"
 
+/**
+ * @brief Invalidates all shared entity deltas. Called once per server frame, since
+ * the encoded deltas reference the arena, which is reused each frame.
+ */
+void Sv_ClearEntityDeltas(void) {
+
+  svs.entity_deltas->generation++;
+  svs.entity_deltas->arena_size = 0;
+}
+
+/**
+ * @brief Writes a delta update of an `entity_state_t` to the message. Most clients
+ * delta from the same frame, so identical deltas are encoded once per server frame
+ * and copied into each client's message.
+ * @remarks Client frames hold private copies of their entity states, so deltas are
+ * matched by content rather than by their index in `svs.entity_states`.
+ */
+static void Sv_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to, bool force) {
+
+  sv_entity_delta_cache_t *cache = svs.entity_deltas;
+  sv_entity_deltas_t *deltas = &cache->entities[to->number];
+
+  if (deltas->generation != cache->generation) {
+    deltas->generation = cache->generation;
+    deltas->num_deltas = 0;
+  }
+
+  const sv_entity_delta_t *delta = deltas->deltas;
+  for (int32_t i = 0; i < deltas->num_deltas; i++, delta++) {
+    if (delta->force == force &&
+        !memcmp(&delta->to, to, sizeof(*to)) &&
+        !memcmp(&delta->from, from, sizeof(*from))) {
+
+      Mem_WriteBuffer(msg, cache->arena + delta->offset, delta->length);
+      sv.frame_stats.entity_deltas_cached++;
+      return;
+    }
+  }
+
+  const size_t offset = msg->size;
+
+  Net_WriteDeltaEntity(msg, from, to, force);
+  sv.frame_stats.entity_deltas_encoded++;
+
+  if (msg->overflowed) {
+    return;
+  }
+
+  const uint32_t length = (uint32_t) (msg->size - offset);
+
+  if (deltas->num_deltas == SV_ENTITY_DELTA_VARIANTS) {
+    return;
+  }
+
+  if (cache->arena_size + length > sizeof(cache->arena)) {
+    return;
+  }
+
+  sv_entity_delta_t *out = &deltas->deltas[deltas->num_deltas++];
+
+  out->from = *from;
+  out->to = *to;
+  out->force = force;
+  out->offset = cache->arena_size;
+  out->length = length;
+
+  memcpy(cache->arena + cache->arena_size, msg->data + offset, length);
+  cache->arena_size += length;
+}
+
 /**
  * @brief Writes a delta update of an `entity_state_t` list to the message.
  */
@@ -63,30 +133,28 @@ static void Sv_WriteEntities(sv_client_frame_t *from, sv_client_frame_t *to, mem
     }
 
     if (new_num == old_num) { // delta update from old position
-      Net_WriteDeltaEntity(msg, old_state, new_state, false);
+      Sv_WriteDeltaEntity(msg, old_state, new_state, false);
       old_index++;
       new_index++;
       continue;
     }
 
     if (new_num < old_num) { // this is a new entity, send it from the baseline
-      Net_WriteDeltaEntity(msg, &sv.entities[new_num].baseline, new_state, true);
+      Sv_WriteDeltaEntity(msg, &sv.entities[new_num].baseline, new_state, true);
       new_index++;
       continue;
     }
 
     if (new_num > old_num) { // the old entity isn't present in the new message
-      const int16_t bits = U_REMOVE;
-
-      Net_WriteShort(msg, old_num);
-      Net_WriteShort(msg, bits);
+      Net_WriteEntityNumber(msg, old_num);
+      Net_WriteVarInt(msg, U_REMOVE);
 
       old_index++;
       continue;
     }
   }
 
-  Net_WriteShort(msg, -1); // end of entities
+  Net_WriteEntityNumber(msg, -1); // end of entities
 }
 
 /**
@@ -137,6 +205,87 @@ void Sv_WriteClientFrame(sv_client_t *client, mem_buf_t *msg) {
   Sv_WriteEntities(delta_frame, frame, msg);
 }
 
+/**
+ * @return The bounds used to test the visibility of the specified entity.
+ */
+static box3_t Sv_EntityVisBounds(const g_entity_t *ent) {
+
+  box3_t bounds = ent->abs_bounds;
+
+  if (Box3_Equal(bounds, Box3_Zero())) { // never linked
+    bounds = Box3_FromCenter(ent->s.origin);
+  }
+
+  if (!Vec3_Equal(ent->s.termination, Vec3_Zero())) { // beams
+    bounds = Box3_Append(bounds, ent->s.termination);
+  }
+
+  return bounds;
+}
+
+/**
+ * @return True if the specified entity should be culled from the client's frame.
+ */
+static bool Sv_CullEntity(sv_client_t *client, const vec3_t eye, const g_entity_t *ent) {
+
+  if (!sv_cull_entities->integer || editor->value) {
+    return false;
+  }
+
+  const g_client_t *cl = client->gclient;
+
+  // the client's own entity, and those it owns, are required for prediction
+  if (ent == cl->entity || ent->owner == cl->entity) {
+    return false;
+  }
+
+  // as are inline models, which are also relatively inexpensive to send
+  if (ent->solid == SOLID_BSP) {
+    return false;
+  }
+
+  const int32_t num = ent->s.number;
+
+  if (client->entity_visible_time[num] && quetoo.ticks - client->entity_visible_time[num] < SV_VIS_LINGER) {
+    return false;
+  }
+
+  // events are transient, so they are always tested
+  if (!ent->s.event) {
+    if (client->entity_culled_time[num] && quetoo.ticks - client->entity_culled_time[num] < SV_VIS_RECHECK) {
+      return true;
+    }
+  }
+
+  const box3_t bounds = Sv_EntityVisBounds(ent);
+
+  bool visible;
+  if (ent->s.event || ent->s.sound) {
+    visible = Sv_InPHS(eye, bounds);
+  } else {
+    visible = Sv_InPVS(eye, bounds);
+  }
+
+  if (visible) {
+    client->entity_visible_time[num] = quetoo.ticks;
+    client->entity_culled_time[num] = 0;
+    return false;
+  }
+
+  client->entity_culled_time[num] = quetoo.ticks ?: 1;
+  return true;
+}
+
+/**
+ * @brief Clears the client's cached visibility results. Entity numbers are reused across
+ * levels and connections, so this is done whenever the client connects or spawns.
+ */
+void Sv_ClearClientVisibility(sv_client_t *client) {
+
+  memset(client->entity_visible_time, 0, sizeof(client->entity_visible_time));
+  memset(client->entity_culled_time, 0, sizeof(client->entity_culled_time));
+}
+
 /**
  * @brief Decides which entities are going to be visible to the client and copies off the player state.
  */
@@ -159,6 +308,8 @@ void Sv_BuildClientFrame(sv_client_t *client) {
   frame->num_entities = 0;
   frame->entity_state = svs.next_entity_state;
 
+  const vec3_t eye = Vec3_Add(cl->ps.pm_state.origin, cl->ps.pm_state.view_offset);
+
   for (int32_t i = 0; i < sv_max_entities->integer; i++) {
 
     const g_entity_t *ent = sv.entities[i].gent;
@@ -182,6 +333,11 @@ void Sv_BuildClientFrame(sv_client_t *client) {
       }
     }
 
+    if (Sv_CullEntity(client, eye, ent)) {
+      sv.frame_stats.entities_culled++;
+      continue;
+    }
+
     // copy it to the circular entity_state_t array
     entity_state_t *s = &svs.entity_states[svs.next_entity_state % svs.num_entity_states];
 
@@ -195,4 +351,7 @@ void Sv_BuildClientFrame(sv_client_t *client) {
     svs.next_entity_state++;
     frame->num_entities++;
   }
+
+  sv.frame_stats.client_frames++;
+  sv.frame_stats.entities_sent += frame->num_entities;
 }
@@ -24,6 +24,8 @@
 #include "sv_types.h"
 
 #if defined(__SV_LOCAL_H__)
+void Sv_ClearEntityDeltas(void);
 void Sv_WriteClientFrame(sv_client_t *client, mem_buf_t *msg);
 void Sv_BuildClientFrame(sv_client_t *client);
+void Sv_ClearClientVisibility(sv_client_t *client);
 #endif /* __SV_LOCAL_H__ */
@@ -201,6 +201,63 @@ static void Sv_WriteAngles(const vec3_t angles) {
   Net_WriteAngles(&sv.multicast, angles);
 }
 
+/**
+ * @brief The state of a `Sv_Parallel` invocation, shared by all participating threads.
+ */
+typedef struct {
+  void (*func)(int32_t index, void *data);
+  int32_t count;
+  void *data;
+  SDL_AtomicInt next;
+} sv_parallel_t;
+
+/**
+ * @brief `ThreadRunFunc` for `Sv_Parallel`, claiming indexes until none remain.
+ */
+static void Sv_Parallel_Run(void *data) {
+
+  sv_parallel_t *parallel = data;
+
+  while (true) {
+    const int32_t index = SDL_AddAtomicInt(&parallel->next, 1);
+    if (index >= parallel->count) {
+      break;
+    }
+    parallel->func(index, parallel->data);
+  }
+}
+
+/**
+ * @brief Invokes `func` for each index in `[0, count)` on the thread pool, returning
+ * once all indexes have been processed. The calling thread participates.
+ */
+static void Sv_Parallel(void (*func)(int32_t index, void *data), int32_t count, void *data) {
+
+  if (count <= 0) {
+    return;
+  }
+
+  sv_parallel_t parallel = {
+    .func = func,
+    .count = count,
+    .data = data
+  };
+
+  const int32_t num_threads = Mini(Thread_Count(), count - 1);
+
+  thread_t *threads[Maxi(num_threads, 1)];
+
+  for (int32_t i = 0; i < num_threads; i++) {
+    threads[i] = Thread_Create(Sv_Parallel_Run, &parallel, THREAD_NONE);
+  }
+
+  Sv_Parallel_Run(&parallel);
+
+  for (int32_t i = 0; i < num_threads; i++) {
+    Thread_Wait(threads[i]);
+  }
+}
+
 static void *game_handle;
 
 /**
@@ -352,11 +409,13 @@ void Sv_InitGame(void) {
   import.BoxContents = Sv_BoxContents;
   import.PointInsideBrush = Cm_PointInsideBrush;
   import.Trace = Sv_Trace;
+  import.TraceBatch = Sv_TraceBatch;
   import.Clip = Sv_Clip;
   import.SetModel = Sv_SetModel;
   import.LinkEntity = Sv_LinkEntity;
   import.UnlinkEntity = Sv_UnlinkEntity;
   import.BoxEntities = Sv_BoxEntities;
+  import.Parallel = Sv_Parallel;
 
   import.Multicast = Sv_Multicast;
   import.Unicast = Sv_Unicast;
@@ -20,9 +20,24 @@
  */
 
 #include "sv_local.h"
-#include "net/net_http.h"
+#include "net/net_http_server.h"
 
-static int32_t sv_http_socket = -1;
+/**
+ * @brief The maximum number of concurrent HTTP connections per client, which may fetch ranges
+ * of large files in parallel.
+ */
+#define SV_HTTP_CONNECTIONS_PER_CLIENT 4
+
+/**
+ * @brief The HTTP download server runs on its own thread. Each frame, the addresses of
+ * connected clients are published to it, so that it may authorize connections without
+ * touching `svs.clients`.
+ */
+static struct {
+	net_http_server_t *server;
+	SDL_Mutex *lock;
+	in_addr_t addrs[MAX_CLIENTS];
+} sv_http;
 
 /**
  * @brief Allowed download patterns, matching the former UDP download allowlist.
@@ -40,223 +55,105 @@ static const char *sv_http_allowed_patterns[] = {
 };
 
 /**
- * @return True if the filename matches the download allowlist.
- */
-static bool Sv_HttpIsAllowed(const char *filename) {
-
-	const char **pattern = sv_http_allowed_patterns;
-	while (*pattern) {
-		if (GlobMatch(*pattern, filename, GLOB_FLAGS_NONE)) {
-			return true;
-		}
-		pattern++;
-	}
-
-	return false;
-}
-
-/**
- * @brief Send an HTTP error response and close the connection.
- */
-static void Sv_HttpSendError(sv_http_client_t *http, int32_t code, const char *reason) {
-
-	Net_HttpSendError(http->socket, code, reason);
-
-	Net_CloseSocket(http->socket);
-	memset(http, 0, sizeof(*http));
-}
-
-/**
- * @brief Parse the completed HTTP request and begin the response.
+ * @brief Associates new connections with connected clients, by source address. Called on
+ * the HTTP server thread.
+ * @return The client slot, or -1 to reject the connection.
  */
-static void Sv_HttpHandleRequest(sv_http_client_t *http) {
-
-	// null-terminate the request
-	http->request[http->request_len] = '\0';
-
-	// parse the request line
-	char method[16], filename[MAX_OS_PATH];
-	if (!Net_HttpParseRequestLine(http->request, method, sizeof(method), filename, sizeof(filename))) {
-		Sv_HttpSendError(http, 400, "Bad Request");
-		return;
-	}
-
-	if (strcmp(method, "GET") != 0) {
-		Sv_HttpSendError(http, 405, "Method Not Allowed");
-		return;
-	}
-
-	// validate the filename
-	if (IS_INVALID_DOWNLOAD(filename)) {
-		Com_Warn("HTTP: Invalid download request: %s\n", filename);
-		Sv_HttpSendError(http, 403, "Forbidden");
-		return;
-	}
-
-	if (!Sv_HttpIsAllowed(filename)) {
-		Com_Warn("HTTP: Disallowed download request: %s\n", filename);
-		Sv_HttpSendError(http, 403, "Forbidden");
-		return;
-	}
-
-	// load the file
-	void *file_data = NULL;
-	const int64_t file_size = Fs_Load(filename, &file_data);
-	if (file_size == -1 || !file_data) {
-		Com_Debug(DEBUG_SERVER, "HTTP: File not found: %s\n", filename);
-		Sv_HttpSendError(http, 404, "Not Found");
-		return;
-	}
-
-	// build the response header
-	char header[256];
-	const int32_t header_len = Net_HttpFormatResponse(200, "OK",
-		"application/octet-stream", file_size, header, sizeof(header));
-
-	// allocate a single buffer for header + file data
-	http->size = header_len + (int32_t) file_size;
-	http->data = Mem_Malloc(http->size);
-	memcpy(http->data, header, header_len);
-	memcpy(http->data + header_len, file_data, file_size);
-	http->count = 0;
+static int32_t Sv_HttpAccept(const net_http_server_t *server, const net_addr_t *from, void *user_data) {
 
-	Fs_Free(file_data);
+	int32_t slot = -1;
 
-	Com_Debug(DEBUG_SERVER, "HTTP: Serving %s (%" PRId64 " bytes)\n", filename, file_size);
-}
+	SDL_LockMutex(sv_http.lock);
 
-/**
- * @brief Accept new HTTP connections and associate them with connected clients.
- */
-static void Sv_HttpAccept(void) {
-
-	net_addr_t from;
-	const int32_t sock = Net_Accept(sv_http_socket, &from);
-	if (sock == -1) {
-		return;
-	}
-
-	// match the source IP to a connected client
-	sv_client_t *cl = svs.clients;
-	for (int32_t i = 0; i < sv_max_clients->integer; i++, cl++) {
+	for (int32_t i = 0; i < MAX_CLIENTS; i++) {
 
-		if (cl->state == SV_CLIENT_FREE) {
+		if (sv_http.addrs[i] == 0 || sv_http.addrs[i] != from->addr) {
 			continue;
 		}
 
-		if (cl->net_chan.remote_address.addr != from.addr) {
-			continue;
+		if (Net_HttpServerConnections(server, i) >= Net_HttpServerMaxConnectionsPerKey(server)) {
+			continue; // already has its share of HTTP connections
 		}
 
-		if (cl->http.socket > 0) {
-			continue; // already has an active HTTP connection
-		}
+		slot = i;
+		break;
+	}
 
-		memset(&cl->http, 0, sizeof(cl->http));
-		cl->http.socket = sock;
+	SDL_UnlockMutex(sv_http.lock);
 
-		Com_Debug(DEBUG_SERVER, "HTTP: Accepted connection from %s\n", cl->name);
-		return;
+	if (slot == -1) {
+		Com_Debug(DEBUG_SERVER, "HTTP: Rejected connection from %s\n", Net_NetaddrToIpString(from));
 	}
 
-	// no matching client found, reject
-	Com_Debug(DEBUG_SERVER, "HTTP: Rejected connection from %s\n", Net_NetaddrToIpString(&from));
-
-	Net_HttpSendError(sock, 403, "Forbidden");
-	Net_CloseSocket(sock);
+	return slot;
 }
 
 /**
- * @brief Process a single client's HTTP connection.
+ * @return True if the filename is a valid download matching the allowlist. Called on the
+ * HTTP server thread.
  */
-static void Sv_HttpClientThink(sv_http_client_t *http) {
-
-	// still reading the request
-	if (!http->data) {
-		const ssize_t received = Net_Recv(http->socket,
-			http->request + http->request_len,
-			sizeof(http->request) - 1 - http->request_len);
-
-		if (received > 0) {
-			http->request_len += (int32_t) received;
-
-			// check for end of HTTP request
-			if (strstr(http->request, "\r\n\r\n")) {
-				Sv_HttpHandleRequest(http);
-			} else if (http->request_len >= (int32_t) sizeof(http->request) - 1) {
-				Sv_HttpSendError(http, 400, "Bad Request");
-			}
-		} else if (received == 0) {
-			// client closed connection
-			Net_CloseSocket(http->socket);
-			memset(http, 0, sizeof(*http));
-		} else {
-			if (Net_GetError() != EWOULDBLOCK) {
-				Net_CloseSocket(http->socket);
-				memset(http, 0, sizeof(*http));
-			}
-		}
-		return;
-	}
+static bool Sv_HttpAllow(const char *filename, void *user_data) {
 
-	// sending the response
-	const int32_t remaining = http->size - http->count;
-	if (remaining <= 0) {
-		Net_CloseSocket(http->socket);
-		Mem_Free(http->data);
-		memset(http, 0, sizeof(*http));
-		return;
+	if (IS_INVALID_DOWNLOAD(filename)) {
+		Com_Warn("HTTP: Invalid download request: %s\n", filename);
+		return false;
 	}
 
-	const ssize_t sent = Net_Send(http->socket, http->data + http->count, remaining);
-	if (sent > 0) {
-		http->count += (int32_t) sent;
-	} else if (sent == -1) {
-		if (Net_GetError() != EWOULDBLOCK) {
-			Com_Debug(DEBUG_SERVER, "HTTP: Send error, closing connection\n");
-			Net_CloseSocket(http->socket);
-			Mem_Free(http->data);
-			memset(http, 0, sizeof(*http));
+	const char **pattern = sv_http_allowed_patterns;
+	while (*pattern) {
+		if (GlobMatch(*pattern, filename, GLOB_FLAGS_NONE)) {
+			return true;
 		}
+		pattern++;
 	}
+
+	Com_Warn("HTTP: Disallowed download request: %s\n", filename);
+	return false;
 }
 
 /**
- * @brief Process all active HTTP connections. Called once per server frame.
+ * @brief Publishes the addresses of connected clients to the HTTP server. Connections held
+ * by a slot whose address has changed are closed. Called once per server frame.
  */
 void Sv_HttpThink(void) {
 
-	if (sv_http_socket == -1 || svs.clients == NULL) {
+	if (sv_http.server == NULL || svs.clients == NULL) {
 		return;
 	}
 
-	Sv_HttpAccept();
+	SDL_LockMutex(sv_http.lock);
 
-	sv_client_t *cl = svs.clients;
+	const sv_client_t *cl = svs.clients;
 	for (int32_t i = 0; i < sv_max_clients->integer; i++, cl++) {
 
-		if (cl->http.socket <= 0) {
-			continue;
+		const in_addr_t addr = cl->state == SV_CLIENT_FREE ? 0 : cl->net_chan.remote_address.addr;
+		if (addr != sv_http.addrs[i]) {
+			if (sv_http.addrs[i]) {
+				Net_HttpServerClose(sv_http.server, i);
+			}
+			sv_http.addrs[i] = addr;
 		}
-
-		Sv_HttpClientThink(&cl->http);
 	}
+
+	SDL_UnlockMutex(sv_http.lock);
 }
 
 /**
  * @brief Close a client's active HTTP connection. Called when the client disconnects.
  */
-void Sv_HttpClientDisconnect(sv_http_client_t *http) {
+void Sv_HttpClientDisconnect(const sv_client_t *cl) {
 
-	if (http->socket > 0) {
-		Net_CloseSocket(http->socket);
+	if (sv_http.server == NULL || svs.clients == NULL) {
+		return;
 	}
 
-	if (http->data) {
-		Mem_Free(http->data);
-	}
+	const int32_t slot = (int32_t) (cl - svs.clients);
 
-	memset(http, 0, sizeof(*http));
+	SDL_LockMutex(sv_http.lock);
+	sv_http.addrs[slot] = 0;
+	SDL_UnlockMutex(sv_http.lock);
+
+	Net_HttpServerClose(sv_http.server, slot);
 }
 
 /**
@@ -265,16 +162,29 @@ void Sv_HttpClientDisconnect(sv_http_client_t *http) {
 void Sv_InitHttp(void) {
 
 	const cvar_t *net_port = Cvar_Add("net_port", va("%i", PORT_SERVER), CVAR_NO_SET, NULL);
+	const cvar_t *sv_http_cache = Cvar_Add("sv_http_cache", "64", CVAR_LATCH, "The HTTP download file cache size, in megabytes");
+
+	memset(&sv_http, 0, sizeof(sv_http));
+
+	sv_http.lock = SDL_CreateMutex();
 
-	const in_port_t port = net_port->integer;
+	sv_http.server = Net_HttpServerCreate(&(const net_http_server_config_t) {
+		.port = net_port->integer,
+		.max_connections = MAX_CLIENTS * SV_HTTP_CONNECTIONS_PER_CLIENT,
+		.max_connections_per_key = SV_HTTP_CONNECTIONS_PER_CLIENT,
+		.cache_size = (size_t) Maxi(sv_http_cache->integer, 0) << 20,
+		.Accept = Sv_HttpAccept,
+		.Allow = Sv_HttpAllow
+	});
 
-	sv_http_socket = Net_SocketListen(NULL, port, 8);
-	if (sv_http_socket == -1) {
-		Com_Warn("HTTP: Failed to create listen socket on port %d\n", port);
+	if (sv_http.server == NULL) {
+		Com_Warn("HTTP: Failed to create listen socket on port %d\n", net_port->integer);
+		SDL_DestroyMutex(sv_http.lock);
+		sv_http.lock = NULL;
 		return;
 	}
 
-	Com_Print("HTTP server listening on port %d\n", port);
+	Com_Print("HTTP server listening on port %d\n", net_port->integer);
 }
 
 /**
@@ -282,18 +192,15 @@ void Sv_InitHttp(void) {
  */
 void Sv_ShutdownHttp(void) {
 
-	if (sv_http_socket == -1) {
+	if (sv_http.server == NULL) {
 		return;
 	}
 
-	// close all active client HTTP connections
-	sv_client_t *cl = svs.clients;
-	for (int32_t i = 0; i < sv_max_clients->integer; i++, cl++) {
-		Sv_HttpClientDisconnect(&cl->http);
-	}
+	Net_HttpServerDestroy(sv_http.server);
+	sv_http.server = NULL;
 
-	Net_CloseSocket(sv_http_socket);
-	sv_http_socket = -1;
+	SDL_DestroyMutex(sv_http.lock);
+	sv_http.lock = NULL;
 
 	Com_Print("HTTP server stopped\n");
 }
@@ -145,9 +145,7 @@ static void Sv_ClearState(void) {
     return;
   }
 
-  if (sv.demo_file) {
-    Fs_Close(sv.demo_file);
-  }
+  Sv_CloseDemo();
 
   memset(&sv, 0, sizeof(sv));
   Com_QuitSubsystem(QUETOO_SERVER);
@@ -178,11 +176,13 @@ static void Sv_InitClients(void) {
 }
 
 /**
- * @brief Allocates the entity state ring buffer used for delta compression.
+ * @brief Allocates the entity state ring buffer and delta cache used for delta compression.
  */
 static void Sv_InitEntityState(void) {
   svs.num_entity_states = PACKET_BACKUP * MAX_ENTITIES;
   svs.entity_states = Mem_TagMalloc(sizeof(entity_state_t) * svs.num_entity_states, MEM_TAG_SERVER);
+
+  svs.entity_deltas = Mem_TagMalloc(sizeof(sv_entity_delta_cache_t), MEM_TAG_SERVER);
 }
 
 /**
@@ -196,7 +196,7 @@ static void Sv_ShutdownClients(void) {
 
   sv_client_t *cl = svs.clients;
   for (int32_t i = 0; i < sv_max_clients->integer; i++, cl++) {
-    Sv_HttpClientDisconnect(&cl->http);
+    Sv_HttpClientDisconnect(cl);
   }
 
   Mem_Free(svs.clients);
@@ -204,6 +204,9 @@ static void Sv_ShutdownClients(void) {
 
   Mem_Free(svs.entity_states);
   svs.entity_states = NULL;
+
+  Mem_Free(svs.entity_deltas);
+  svs.entity_deltas = NULL;
 }
 
 /**
@@ -274,6 +277,8 @@ static void Sv_LoadMedia(const char *server, sv_state_t state) {
     sv.demo_file = Fs_OpenRead(va("demos/%s.demo", sv.name));
     svs.spawn_count = 0;
 
+    Sv_OpenDemo();
+
     Com_Print("  Loaded demo %s.\n", sv.name);
   } else { // loading a map
     g_snprintf(sv.config_strings[CS_BSP], MAX_STRING_CHARS, "maps/%s.bsp", sv.name);
@@ -31,12 +31,15 @@ sv_server_t sv; // per-level server info
 
 sv_client_t *sv_client; // current client
 
+cvar_t *sv_cull_entities;
+cvar_t *sv_cull_multicast;
 cvar_t *sv_demo_list;
 cvar_t *sv_enforce_time;
 cvar_t *sv_hostname;
 cvar_t *sv_max_clients;
 cvar_t *sv_max_entities;
 cvar_t *sv_min_clients;
+cvar_t *sv_phs_distance;
 cvar_t *sv_public;
 cvar_t *sv_stats_url;
 cvar_t *sv_timeout;
@@ -63,7 +66,7 @@ void Sv_DropClient(sv_client_t *client) {
     }
   }
 
-  Sv_HttpClientDisconnect(&client->http);
+  Sv_HttpClientDisconnect(client);
 
   Mem_ClearBuffer(&client->net_chan.message);
   Mem_ClearBuffer(&client->datagram.buffer);
@@ -330,6 +333,8 @@ static void Sv_Connect_f(void) {
 
   client->last_message = quetoo.ticks;
 
+  Sv_ClearClientVisibility(client);
+
   client->state = SV_CLIENT_CONNECTED;
 }
 
@@ -521,58 +526,80 @@ static void Sv_CheckCommandTimes(void) {
 }
 
 /**
- * @brief Reads and dispatches all pending network packets from connected clients.
+ * @brief Dispatches the packet in `net_message` from `net_from`.
  */
-static void Sv_ReadPackets(void) {
+static void Sv_ReadPacket(void) {
 
-  while (Net_ReceiveDatagram(NS_UDP_SERVER, &net_from, &net_message)) {
+  // check for connectionless packet (0xffffffff) first
+  if (*(uint32_t *) net_message.data == 0xffffffff) {
+    Sv_ConnectionlessPacket();
+    return;
+  }
 
-    // check for connectionless packet (0xffffffff) first
-    if (*(uint32_t *) net_message.data == 0xffffffff) {
-      Sv_ConnectionlessPacket();
+  // read the qport out of the message so we can fix up
+  // stupid address translating routers
+  Net_BeginReading(&net_message);
+
+  Net_ReadLong(&net_message); // sequence number
+  Net_ReadLong(&net_message); // sequence number
+
+  const byte qport = Net_ReadByte(&net_message) & 0xff;
+
+  // check for packets from connected clients
+  sv_client_t *cl = svs.clients;
+  for (int32_t i = 0; i < sv_max_clients->integer; i++, cl++) {
+
+    if (cl->state == SV_CLIENT_FREE) {
       continue;
     }
 
-    // read the qport out of the message so we can fix up
-    // stupid address translating routers
-    Net_BeginReading(&net_message);
+    if (!Net_CompareClientNetaddr(&net_from, &cl->net_chan.remote_address)) {
+      continue;
+    }
 
-    Net_ReadLong(&net_message); // sequence number
-    Net_ReadLong(&net_message); // sequence number
+    if (cl->net_chan.qport != qport) {
+      continue;
+    }
 
-    const byte qport = Net_ReadByte(&net_message) & 0xff;
+    if (cl->net_chan.remote_address.port != net_from.port) {
+      cl->net_chan.remote_address.port = net_from.port;
+      Com_Warn("Fixed translated port for %s\n", Net_NetaddrToString(&net_from));
+    }
 
-    // check for packets from connected clients
-    sv_client_t *cl = svs.clients;
-    for (int32_t i = 0; i < sv_max_clients->integer; i++, cl++) {
+    // this is a valid, sequenced packet, so process it
+    if (Netchan_Process(&cl->net_chan, &net_message)) {
+      cl->last_message = quetoo.ticks; // nudge timeout
+      Sv_ParseClientMessage(cl);
+    }
 
-      if (cl->state == SV_CLIENT_FREE) {
-        continue;
-      }
+    // we've processed the packet for the correct client, so break
+    break;
+  }
+}
 
-      if (!Net_CompareClientNetaddr(&net_from, &cl->net_chan.remote_address)) {
-        continue;
-      }
+/**
+ * @brief Reads and dispatches all pending network packets from connected clients. Packets
+ * are received in batches, so that a busy server needs few system calls per frame.
+ */
+static void Sv_ReadPackets(void) {
+  static net_datagram_t datagrams[NET_DATAGRAM_BATCH];
+  size_t count;
 
-      if (cl->net_chan.qport != qport) {
-        continue;
-      }
+  do {
+    count = Net_ReceiveDatagrams(NS_UDP_SERVER, datagrams, lengthof(datagrams));
 
-      if (cl->net_chan.remote_address.port != net_from.port) {
-        cl->net_chan.remote_address.port = net_from.port;
-        Com_Warn("Fixed translated port for %s\n", Net_NetaddrToString(&net_from));
-      }
+    for (size_t i = 0; i < count; i++) {
+      const net_datagram_t *datagram = &datagrams[i];
 
-      // this is a valid, sequenced packet, so process it
-      if (Netchan_Process(&cl->net_chan, &net_message)) {
-        cl->last_message = quetoo.ticks; // nudge timeout
-        Sv_ParseClientMessage(cl);
-      }
+      net_from = datagram->addr;
 
-      // we've processed the packet for the correct client, so break
-      break;
+      memcpy(net_message.data, datagram->data, datagram->size);
+      net_message.size = datagram->size;
+      net_message.read = 0;
+
+      Sv_ReadPacket();
     }
-  }
+  } while (count == lengthof(datagrams));
 }
 
 /**
@@ -893,12 +920,15 @@ void Sv_Frame(const uint32_t msec) {
  */
 static void Sv_InitLocal(void) {
 
+  sv_cull_entities = Cvar_Add("sv_cull_entities", "1", 0, "Set to 0 to send all entities to all clients, regardless of visibility");
+  sv_cull_multicast = Cvar_Add("sv_cull_multicast", "1", 0, "Set to 0 to send all PVS and PHS multicasts to all clients, regardless of visibility");
   sv_demo_list = Cvar_Add("sv_demo_list", "", CVAR_SERVER_INFO, "A list of demo names to cycle through");
   sv_enforce_time = Cvar_Add("sv_enforce_time", va("%d", CMD_MSEC_MAX_DRIFT_ERRORS), 0, "Prevents the most blatant form of speed cheating, disable at your own risk");
   sv_hostname = Cvar_Add("sv_hostname", "Quetoo", CVAR_SERVER_INFO | CVAR_ARCHIVE, "The server hostname, visible in the server browser");
   sv_min_clients = Cvar_Add("sv_min_clients", "0", CVAR_SERVER_INFO, "The minimum number of clients the server will allow");
   sv_max_clients = Cvar_Add("sv_max_clients", va("%d", MAX_CLIENTS), CVAR_SERVER_INFO | CVAR_LATCH, "The maximum number of clients the server will allow");
   sv_max_entities = Cvar_Add("sv_max_entities", va("%d", MAX_ENTITIES), CVAR_SERVER_INFO | CVAR_LATCH, "The maximum number of entities the server will allow");
+  sv_phs_distance = Cvar_Add("sv_phs_distance", "2048", 0, "The distance at which sounds and events are audible through walls");
   sv_public = Cvar_Add("sv_public", "0", CVAR_SERVER_INFO, "Set to 1 to to advertise this server via the master server");
   sv_stats_url = Cvar_Add("sv_stats_url", "https://giblets.quetoo.org", CVAR_ARCHIVE, "URL to POST per-match stats to. Requires sv_public 1. Set to \"\" to disable.");
   sv_timeout = Cvar_Add("sv_timeout", va("%d", SV_TIMEOUT), 0, "The client connection timeout threshold in seconds");
@@ -182,13 +182,47 @@ void Sv_Unicast(const g_client_t *cl, const bool reliable) {
   Mem_ClearBuffer(&sv.multicast);
 }
 
+/**
+ * @brief The half-size of the bounds tested for multicast visibility. Most multicast
+ * events produce effects or sounds with some volume, so their origin alone is too strict.
+ */
+#define SV_MULTICAST_EXTENTS 16.f
+
+/**
+ * @return True if the client should receive a multicast to the given origin and scope.
+ */
+static bool Sv_MulticastFilter(const sv_client_t *cl, const box3_t bounds, multicast_t to) {
+
+  if (!sv_cull_multicast->integer || editor->value) {
+    return true;
+  }
+
+  const g_client_t *gcl = cl->gclient;
+  if (!gcl->in_use) {
+    return true; // not in game yet, so we can't know where they are
+  }
+
+  const vec3_t eye = Vec3_Add(gcl->ps.pm_state.origin, gcl->ps.pm_state.view_offset);
+
+  switch (to) {
+    case MULTICAST_PHS:
+    case MULTICAST_PHS_R:
+      return Sv_InPHS(eye, bounds);
+    case MULTICAST_PVS:
+    case MULTICAST_PVS_R:
+      return Sv_InPVS(eye, bounds);
+    default:
+      return true;
+  }
+}
+
 /**
  * @brief Sends the contents of `sv.multicast` to a subset of the clients,
  * then clears `sv.multicast`.
  */
 void Sv_Multicast(const vec3_t origin, multicast_t to) {
 
-  bool reliable = false;
+  bool reliable = false, filter = false;
 
   switch (to) {
     case MULTICAST_ALL_R:
@@ -201,12 +235,14 @@ void Sv_Multicast(const vec3_t origin, multicast_t to) {
       reliable = true;
       __attribute__((fallthrough));
     case MULTICAST_PHS:
+      filter = true;
       break;
 
     case MULTICAST_PVS_R:
       reliable = true;
       __attribute__((fallthrough));
     case MULTICAST_PVS:
+      filter = true;
       break;
 
     default:
@@ -215,6 +251,8 @@ void Sv_Multicast(const vec3_t origin, multicast_t to) {
       return;
   }
 
+  const box3_t bounds = Box3_FromCenterRadius(origin, SV_MULTICAST_EXTENTS);
+
   // send the data to all relevant clients
   sv_client_t *cl = svs.clients;
   for (int32_t j = 0; j < sv_max_clients->integer; j++, cl++) {
@@ -235,8 +273,11 @@ void Sv_Multicast(const vec3_t origin, multicast_t to) {
       continue;
     }
 
-    if (to != MULTICAST_ALL && to != MULTICAST_ALL_R) {
-      // TODO: Some basic tracing or just distance attenuation?
+    if (filter && !Sv_MulticastFilter(cl, bounds, to)) {
+      if (!reliable) { // reliable messages are not counted in datagram_bytes
+        sv.frame_stats.multicast_bytes_culled += sv.multicast.size;
+      }
+      continue;
     }
 
     if (reliable) {
@@ -280,6 +321,7 @@ static void Sv_SendClientDatagram(sv_client_t *cl) {
       Com_Debug(DEBUG_SERVER, "Fragmenting datagram @ %u bytes\n", (uint32_t) buf.size);
 
       Netchan_Transmit(&cl->net_chan, buf.data, buf.size);
+      sv.frame_stats.datagram_bytes += buf.size;
 
       Mem_ClearBuffer(&buf);
     }
@@ -290,91 +332,7 @@ static void Sv_SendClientDatagram(sv_client_t *cl) {
 
   // send the pending packet, which may include reliable messages
   Netchan_Transmit(&cl->net_chan, buf.data, buf.size);
-}
-
-/**
- * @brief Advances to the next demo in the playlist or restarts from the beginning.
- */
-static void Sv_DemoCompleted(void) {
-
-  if (sv_demo_list->string[0]) {
-
-    const char *current_demo = sv.name;
-    const char *next_demo = g_strrstr(sv_demo_list->string, current_demo);
-    char demo_token[MAX_QPATH];
-
-    if (!next_demo) {
-
-      next_demo = sv_demo_list->string;
-    } else {
-
-      next_demo += strlen(current_demo);
-
-      if (next_demo[0] == ' ') {
-        next_demo++;
-      } else if (!next_demo[0]) {
-        next_demo = sv_demo_list->string;
-      }
-    }
-
-    const char *space = strchr(next_demo, ' ') ? : (next_demo + strlen(next_demo));
-    size_t len = space - next_demo;
-
-    strncpy(demo_token, next_demo, len);
-    demo_token[len] = 0;
-
-    if (demo_token[0]) {
-      Sv_InitServer(demo_token, SV_ACTIVE_DEMO);
-    } else {
-      Sv_ShutdownServer("Demo complete\n");
-    }
-  } else {
-    Sv_ShutdownServer("Demo complete\n");
-  }
-}
-
-/**
- * @brief Reads the next frame from the current demo file into the specified buffer,
- * returning the size of the frame in bytes.
- *
- * FIXME: This doesn't work with the new packetized overflow avoidance. Multiple
- * messages can constitute a frame. We need a mechanism to indicate frame
- * completion, or we need a timecode in our demos.
- */
-static size_t Sv_GetDemoMessage(byte *buffer) {
-  int32_t size;
-  int64_t r;
-
-  r = Fs_Read(sv.demo_file, &size, sizeof(size), 1);
-
-  if (r != 1) { // improperly terminated demo file
-    Com_Warn("Failed to read demo file\n");
-    Sv_DemoCompleted();
-    return 0;
-  }
-
-  size = LittleLong(size);
-
-  if (size == -1) { // properly terminated demo file
-    Sv_DemoCompleted();
-    return 0;
-  }
-
-  if (size > MAX_MSG_SIZE) { // corrupt demo file
-    Com_Warn("%d > MAX_MSG_SIZE\n", size);
-    Sv_DemoCompleted();
-    return 0;
-  }
-
-  r = Fs_Read(sv.demo_file, buffer, size, 1);
-
-  if (r != 1) {
-    Com_Warn("Incomplete or corrupt demo file\n");
-    Sv_DemoCompleted();
-    return 0;
-  }
-
-  return size;
+  sv.frame_stats.datagram_bytes += buf.size;
 }
 
 /**
@@ -386,6 +344,12 @@ void Sv_SendClientPackets(void) {
     return;
   }
 
+  // deltas encoded for the previous frame are no longer relevant
+  Sv_ClearEntityDeltas();
+
+  // queue the packets, and send them together once all clients have been visited
+  Net_BeginDatagrams(NS_UDP_SERVER);
+
   // send a message to each connected client
   sv_client_t *cl = svs.clients;
   for (int32_t i = 0; i < sv_max_clients->integer; i++, cl++) {
@@ -409,7 +373,7 @@ void Sv_SendClientPackets(void) {
       byte buffer[MAX_MSG_SIZE];
       size_t size;
 
-      if ((size = Sv_GetDemoMessage(buffer))) {
+      if ((size = Sv_ReadDemoMessage(buffer))) {
         Netchan_Transmit(&cl->net_chan, buffer, size);
       } else {
         break;    // recording is done, so we're done
@@ -433,4 +397,19 @@ void Sv_SendClientPackets(void) {
       Netchan_Transmit(&cl->net_chan, NULL, 0);
     }
   }
+
+  Net_FlushDatagrams(NS_UDP_SERVER);
+
+  sv.total_stats.client_frames += sv.frame_stats.client_frames;
+  sv.total_stats.entities_sent += sv.frame_stats.entities_sent;
+  sv.total_stats.entities_culled += sv.frame_stats.entities_culled;
+  sv.total_stats.datagram_bytes += sv.frame_stats.datagram_bytes;
+  sv.total_stats.multicast_bytes_culled += sv.frame_stats.multicast_bytes_culled;
+  sv.total_stats.entity_deltas_encoded += sv.frame_stats.entity_deltas_encoded;
+  sv.total_stats.entity_deltas_cached += sv.frame_stats.entity_deltas_cached;
+
+  sv.num_stats_frames++;
+
+  sv.last_frame_stats = sv.frame_stats;
+  memset(&sv.frame_stats, 0, sizeof(sv.frame_stats));
 }
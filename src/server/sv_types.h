@@ -43,9 +43,9 @@ typedef struct {
   entity_state_t baseline;
 
   /**
-   * @brief World sector for entity list management.
+   * @brief The world tree leaf of this entity, or `CM_TREE_NULL` if it is not linked.
    */
-  struct sv_sector_s *sector;
+  int32_t leaf;
 
   /**
    * @brief World-space transform for collision tests.
@@ -58,6 +58,95 @@ typedef struct {
   mat4_t inverse_matrix;
 } sv_entity_t;
 
+/**
+ * @brief The context of a `Sv_BoxEntitiesQuery`.
+ */
+typedef struct {
+
+  /**
+   * @brief The query bounds.
+   */
+  box3_t bounds;
+
+  /**
+   * @brief The filter bits, e.g. `BOX_COLLIDE`.
+   */
+  uint32_t type;
+
+  /**
+   * @brief The output array of entities.
+   */
+  g_entity_t **entities;
+
+  /**
+   * @brief The count of entities found.
+   */
+  size_t num_entities;
+
+  /**
+   * @brief The length of `entities`.
+   */
+  size_t max_entities;
+} sv_box_entities_t;
+
+/**
+ * @brief Per-frame accounting, used to measure the effectiveness of entity culling, etc.
+ */
+typedef struct {
+
+  /**
+   * @brief The count of client frames built.
+   */
+  uint32_t client_frames;
+
+  /**
+   * @brief The count of entities written to client frames.
+   */
+  uint32_t entities_sent;
+
+  /**
+   * @brief The count of entities culled from client frames by visibility.
+   */
+  uint32_t entities_culled;
+
+  /**
+   * @brief The count of bytes transmitted to clients in unreliable datagrams.
+   */
+  size_t datagram_bytes;
+
+  /**
+   * @brief The count of unreliable multicast bytes not sent to clients that could not see
+   * or hear them. Reliable multicasts are excluded, as they are not sent in datagrams.
+   */
+  size_t multicast_bytes_culled;
+
+  /**
+   * @brief The count of entity deltas serialized by `Net_WriteDeltaEntity`.
+   */
+  uint32_t entity_deltas_encoded;
+
+  /**
+   * @brief The count of entity deltas copied from the shared delta cache.
+   */
+  uint32_t entity_deltas_cached;
+} sv_frame_stats_t;
+
+/**
+ * @brief A demo keyframe, from which playback may resume.
+ */
+typedef struct {
+
+  /**
+   * @brief The server time of the keyframe, in milliseconds.
+   */
+  uint32_t time;
+
+  /**
+   * @brief The offset of the keyframe's first record within the demo file.
+   */
+  int64_t offset;
+} sv_demo_keyframe_t;
+
 /**
  * @brief The `sv_server_t` struct is wiped at each level load.
  */
@@ -107,6 +196,41 @@ typedef struct {
    * @brief Open demo file for demo playback, or `NULL` during live gameplay.
    */
   file_t *demo_file;
+
+  /**
+   * @brief The keyframe index of the demo file, as `sv_demo_keyframe_t`.
+   */
+  GArray *demo_keyframes;
+
+  /**
+   * @brief The approximate server time of the demo playback position.
+   */
+  uint32_t demo_time;
+
+  /**
+   * @brief True after seeking, so that keyframe records are sent rather than skipped.
+   */
+  bool demo_seek;
+
+  /**
+   * @brief Statistics for the frame in progress.
+   */
+  sv_frame_stats_t frame_stats;
+
+  /**
+   * @brief Statistics for the most recently sent frame.
+   */
+  sv_frame_stats_t last_frame_stats;
+
+  /**
+   * @brief Statistics accumulated since the level was loaded.
+   */
+  sv_frame_stats_t total_stats;
+
+  /**
+   * @brief The count of frames accumulated in `total_stats`.
+   */
+  uint32_t num_stats_frames;
 } sv_server_t;
 
 /**
@@ -137,6 +261,18 @@ typedef struct {
   uint32_t sent_time;
 } sv_client_frame_t;
 
+/**
+ * @brief Entities remain in a client's frames for this many milliseconds after they were
+ * last potentially visible.
+ */
+#define SV_VIS_LINGER 1000
+
+/**
+ * @brief Entities which failed a visibility test are not tested again for this many
+ * milliseconds, unless they carry an event.
+ */
+#define SV_VIS_RECHECK 100
+
 /**
  * @brief Clients are dropped after 20 seconds without receiving a packet.
  */
@@ -210,18 +346,6 @@ typedef struct {
   GList *messages;
 } sv_client_datagram_t;
 
-/**
- * @brief Tracks a client's HTTP file download connection.
- */
-typedef struct {
-  int32_t socket;
-  char request[1024];
-  int32_t request_len;
-  byte *data;
-  int32_t size;
-  int32_t count;
-} sv_http_client_t;
-
 /**
  * @brief The server client type.
  */
@@ -288,9 +412,17 @@ typedef struct {
   sv_client_frame_t frames[PACKET_BACKUP];
 
   /**
-   * @brief HTTP file download connection for this client.
+   * @brief The time (`quetoo.ticks`) at which each entity was last potentially visible.
+   * @details Entities linger in the client's frames for `SV_VIS_LINGER` milliseconds after
+   * their last successful visibility test, which prevents popping and amortizes the tests.
    */
-  sv_http_client_t http;
+  uint32_t entity_visible_time[MAX_ENTITIES];
+
+  /**
+   * @brief The time (`quetoo.ticks`) at which each entity last failed a visibility test,
+   * or 0. Entities remain culled for `SV_VIS_RECHECK` milliseconds.
+   */
+  uint32_t entity_culled_time[MAX_ENTITIES];
 
   /**
    * @brief UDP network channel to this client.
@@ -337,6 +469,96 @@ typedef enum {
   SV_ACTIVE_DEMO
 } sv_state_t;
 
+/**
+ * @brief The count of distinct deltas retained per entity, per frame. Clients that
+ * acknowledged different frames, or that own the entity, require different deltas.
+ */
+#define SV_ENTITY_DELTA_VARIANTS 4
+
+/**
+ * @brief The size of the per-frame arena of encoded entity deltas.
+ */
+#define SV_ENTITY_DELTA_ARENA_SIZE (MAX_MSG_SIZE * 16)
+
+/**
+ * @brief An entity delta, serialized once and shared by all clients requiring it.
+ */
+typedef struct {
+
+  /**
+   * @brief The state the delta was encoded from.
+   */
+  entity_state_t from;
+
+  /**
+   * @brief The state the delta was encoded to.
+   */
+  entity_state_t to;
+
+  /**
+   * @brief True if the delta was forced (sent from the baseline).
+   */
+  bool force;
+
+  /**
+   * @brief The offset of the encoded delta in the arena.
+   */
+  uint32_t offset;
+
+  /**
+   * @brief The length of the encoded delta in bytes.
+   */
+  uint32_t length;
+} sv_entity_delta_t;
+
+/**
+ * @brief The encoded deltas for a single entity number.
+ */
+typedef struct {
+
+  /**
+   * @brief The cache generation in which these deltas were encoded.
+   */
+  uint32_t generation;
+
+  /**
+   * @brief The count of valid deltas.
+   */
+  int32_t num_deltas;
+
+  /**
+   * @brief The deltas.
+   */
+  sv_entity_delta_t deltas[SV_ENTITY_DELTA_VARIANTS];
+} sv_entity_deltas_t;
+
+/**
+ * @brief The shared entity delta cache. Deltas are keyed by entity number and
+ * validated against their from and to states, and are discarded each server frame.
+ */
+typedef struct {
+
+  /**
+   * @brief Incremented each server frame to invalidate all cached deltas.
+   */
+  uint32_t generation;
+
+  /**
+   * @brief The deltas, indexed by entity number.
+   */
+  sv_entity_deltas_t entities[MAX_ENTITIES];
+
+  /**
+   * @brief The number of bytes of `arena` in use.
+   */
+  uint32_t arena_size;
+
+  /**
+   * @brief The encoded deltas.
+   */
+  byte arena[SV_ENTITY_DELTA_ARENA_SIZE];
+} sv_entity_delta_cache_t;
+
 /**
  * @brief The `sv_static_t` structure is persistent for the execution of the
  * game. It is only cleared when `Sv_Init` is called. It is not exposed to the
@@ -369,6 +591,11 @@ typedef struct {
    */
   uint32_t next_entity_state;
 
+  /**
+   * @brief Encoded entity deltas shared by all clients in the current frame.
+   */
+  sv_entity_delta_cache_t *entity_deltas;
+
   /**
    * @brief Configured master server addresses for heartbeat broadcasts.
    */
@@ -21,86 +21,41 @@
 
 #include "sv_local.h"
 
-// FIXME: Couldn't we use the BSP blocks for this now?
-
 /**
- * @brief The world is divided into evenly sized sectors to aid in entity
- * management. This works like a meta-BSP tree, providing fast searches via
- * recursion to find entities within an arbitrary box.
+ * @brief Entity bounds are inflated by this distance in the world tree, so that most
+ * movement does not require the tree to be updated.
  */
-typedef struct sv_sector_s {
-  int32_t axis; // -1 = leaf
-  float dist;
-  struct sv_sector_s *children[2];
-  GList *entities;
-} sv_sector_t;
-
-#define SECTOR_DEPTH  4
-#define SECTOR_NODES  32
+#define SV_WORLD_MARGIN 16.f
 
 /**
- * @brief The world structure contains all sectors and also the current query
- * context issued to `Sv_BoxEntities`.
+ * @brief The world structure contains the dynamic bounding volume tree of all linked
+ * entities. Queries carry their own context, so they may run concurrently, provided
+ * that no entities are linked or unlinked meanwhile.
  */
 typedef struct {
-  sv_sector_t sectors[SECTOR_NODES];
-  size_t num_sectors;
-
-  box3_t box;
+  cm_tree_t tree;
 
-  g_entity_t **box_entities;
-  size_t num_box_entities, max_box_entities;
-
-  uint32_t box_type; // BOX_SOLID, BOX_TRIGGER, ..
+  /**
+   * @brief The world-space planes of transformed inline models, rebuilt as they are linked.
+   */
+  cm_plane_cache_t plane_caches[MAX_ENTITIES];
 } sv_world_t;
 
 static sv_world_t sv_world;
 
 /**
- * @brief Builds a uniformly subdivided tree for the given world size.
- */
-static sv_sector_t *Sv_CreateSector(int32_t depth, const box3_t bounds) {
-  sv_sector_t *sector = &sv_world.sectors[sv_world.num_sectors];
-  sv_world.num_sectors++;
-
-  if (depth == SECTOR_DEPTH) {
-    sector->axis = -1;
-    sector->children[0] = sector->children[1] = NULL;
-    return sector;
-  }
-
-  vec3_t size = Box3_Size(bounds);
-
-  if (size.x > size.y) {
-    sector->axis = 0;
-  } else {
-    sector->axis = 1;
-  }
-
-  sector->dist = 0.5f * (bounds.maxs.xyz[sector->axis] + bounds.mins.xyz[sector->axis]);
-
-  box3_t bounds1 = bounds, bounds2 = bounds;
-
-  bounds1.maxs.xyz[sector->axis] = bounds2.mins.xyz[sector->axis] = sector->dist;
-
-  sector->children[0] = Sv_CreateSector(depth + 1, bounds2);
-  sector->children[1] = Sv_CreateSector(depth + 1, bounds1);
-
-  return sector;
-}
-
-/**
- * @brief Initializes the world sector tree for spatial partitioning of entities.
+ * @brief Initializes the world tree for spatial partitioning of entities.
  */
 static void Sv_InitWorld(void) {
 
-  for (size_t i = 0; i < sv_world.num_sectors; i++) {
-    g_list_free(sv_world.sectors[i].entities);
-  }
+  Cm_FreeTree(&sv_world.tree);
 
-  memset(&sv_world, 0, sizeof(sv_world));
+  Cm_InitTree(&sv_world.tree, SV_WORLD_MARGIN);
 
-  Sv_CreateSector(0, sv.cm_models[0]->bounds);
+  for (int32_t i = 0; i < MAX_ENTITIES; i++) {
+    sv.entities[i].leaf = CM_TREE_NULL;
+    Cm_FreePlaneCache(&sv_world.plane_caches[i]);
+  }
 }
 
 /**
@@ -145,13 +100,13 @@ void Sv_UnlinkEntity(g_entity_t *ent) {
 
   sv_entity_t *sent = &sv.entities[ent->s.number];
 
-  if (sent->sector) {
-    sv_sector_t *sector = (sv_sector_t *) sent->sector;
-    sector->entities = g_list_remove(sector->entities, ent);
+  if (sent->leaf != CM_TREE_NULL) {
+    Cm_TreeRemove(&sv_world.tree, sent->leaf);
+
+    sent->leaf = CM_TREE_NULL;
 
-    g_entity_t *gent = sent->gent;
-    memset(sent, 0, sizeof(*sent));
-    sent->gent = gent;
+    memset(&sent->matrix, 0, sizeof(sent->matrix));
+    memset(&sent->inverse_matrix, 0, sizeof(sent->inverse_matrix));
   }
 }
 
@@ -161,10 +116,8 @@ void Sv_UnlinkEntity(g_entity_t *ent) {
  */
 void Sv_LinkEntity(g_entity_t *ent) {
 
-  // remove it from its current sector
-  Sv_UnlinkEntity(ent);
-
-  if (!ent->in_use) { // and if its free, we're done
+  if (!ent->in_use) { // if its free, remove it and we're done
+    Sv_UnlinkEntity(ent);
     return;
   }
 
@@ -190,6 +143,10 @@ void Sv_LinkEntity(g_entity_t *ent) {
 
   sv_entity_t *sent = &sv.entities[ent->s.number];
 
+  if (ent->solid == SOLID_NOT) {
+    Sv_UnlinkEntity(ent);
+  }
+
   sent->matrix = Mat4_FromRotationTranslationScale(angles, ent->s.origin, 1.f);
   sent->inverse_matrix = Mat4_Inverse(sent->matrix);
   ent->abs_bounds = Cm_EntityBounds(ent->solid, sent->matrix, ent->bounds);
@@ -198,37 +155,31 @@ void Sv_LinkEntity(g_entity_t *ent) {
     return;
   }
 
-  // find the first sector that the ent's box crosses
-  sv_sector_t *sector = sv_world.sectors;
-  while (true) {
-
-    if (sector->axis == -1) {
-      break;
-    }
-
-    if (ent->abs_bounds.mins.xyz[sector->axis] > sector->dist) {
-      sector = sector->children[0];
-    } else if (ent->abs_bounds.maxs.xyz[sector->axis] < sector->dist) {
-      sector = sector->children[1];
-    } else {
-      break; // crosses the node
+  // transform the planes of rotated and translated inline models once, rather than per trace
+  if (ent->solid == SOLID_BSP && !Mat4_Equal(sent->matrix, Mat4_Identity())) {
+    const cm_bsp_model_t *mod = sv.cm_models[ent->s.model1];
+    if (mod) {
+      Cm_UpdatePlaneCache(&sv_world.plane_caches[ent->s.number], mod->head_node, sent->matrix, sent->inverse_matrix);
     }
   }
 
-  // add it to the sector
-  sent->sector = sector;
-  sector->entities = g_list_prepend(sector->entities, ent);
+  // move it within the tree, which is a no-op for most small movements
+  if (sent->leaf == CM_TREE_NULL) {
+    sent->leaf = Cm_TreeInsert(&sv_world.tree, ent->abs_bounds, ent);
+  } else {
+    Cm_TreeMove(&sv_world.tree, sent->leaf, ent->abs_bounds);
+  }
 }
 
 /**
- * @return True if the entity matches the current world filter, false otherwise.
+ * @return True if the entity matches the query's filter, false otherwise.
  */
-static bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
+static bool Sv_BoxEntities_Filter(const sv_box_entities_t *query, const g_entity_t *ent) {
 
   switch (ent->solid) {
     case SOLID_TRIGGER:
     case SOLID_PROJECTILE:
-      if (sv_world.box_type & BOX_OCCUPY) {
+      if (query->type & BOX_OCCUPY) {
         return true;
       }
       break;
@@ -236,7 +187,7 @@ static bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
     case SOLID_DEAD:
     case SOLID_BOX:
     case SOLID_BSP:
-      if (sv_world.box_type & BOX_COLLIDE) {
+      if (query->type & BOX_COLLIDE) {
         return true;
       }
       break;
@@ -250,43 +201,47 @@ static bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
 }
 
 /**
- * @brief Recursively collects entities from the sector tree that overlap the query box.
+ * @brief World tree query callback, appending entities that overlap the query box.
+ * @return False if the query is full.
  */
-static void Sv_BoxEntities_r(sv_sector_t *sector) {
+static bool Sv_BoxEntities_Leaf(void *data, void *context) {
 
-  GList *e = sector->entities;
-  while (e) {
-    g_entity_t *ent = (g_entity_t *) e->data;
+  sv_box_entities_t *query = context;
+  g_entity_t *ent = data;
 
-    if (Sv_BoxEntities_Filter(ent)) {
+  if (Sv_BoxEntities_Filter(query, ent)) {
 
-      if (Box3_Intersects(ent->abs_bounds, sv_world.box)) {
+    if (Box3_Intersects(ent->abs_bounds, query->bounds)) {
 
-        sv_world.box_entities[sv_world.num_box_entities] = ent;
-        sv_world.num_box_entities++;
+      query->entities[query->num_entities] = ent;
+      query->num_entities++;
 
-        if (sv_world.num_box_entities == sv_world.max_box_entities) {
-          Com_Warn("sv_world.max_box_entities\n");
-          return;
-        }
+      if (query->num_entities == query->max_entities) {
+        Com_Warn("max_entities (%zu) reached\n", query->max_entities);
+        return false;
       }
     }
-
-    e = e->next;
   }
 
-  if (sector->axis == -1) {
-    return; // terminal node
-  }
+  return true;
+}
 
-  // recurse down both sides
-  if (sv_world.box.maxs.xyz[sector->axis] > sector->dist) {
-    Sv_BoxEntities_r(sector->children[0]);
-  }
+/**
+ * @brief Populates the query's entity array with those which have bounding boxes
+ * that intersect the query's box. All state is held in the query, so this may be
+ * called from any thread, provided that no entities are linked meanwhile.
+ *
+ * @return The number of entities found.
+ */
+size_t Sv_BoxEntitiesQuery(sv_box_entities_t *query) {
+
+  query->num_entities = 0;
 
-  if (sv_world.box.mins.xyz[sector->axis] < sector->dist) {
-    Sv_BoxEntities_r(sector->children[1]);
+  if (query->max_entities) {
+    Cm_TreeQuery(&sv_world.tree, query->bounds, Sv_BoxEntities_Leaf, query);
   }
+
+  return query->num_entities;
 }
 
 /**
@@ -298,18 +253,14 @@ static void Sv_BoxEntities_r(sv_sector_t *sector) {
  */
 size_t Sv_BoxEntities(const box3_t bounds, g_entity_t **list, const size_t len, uint32_t type) {
 
-  sv_world.box = bounds;
-  sv_world.box_entities = list;
-  sv_world.num_box_entities = 0;
-  sv_world.max_box_entities = len;
-  sv_world.box_type = type;
-
-  Sv_BoxEntities_r(sv_world.sectors);
-
-  sv_world.box = Box3_Zero();
-  sv_world.box_entities = NULL;
+  sv_box_entities_t query = {
+    .bounds = bounds,
+    .type = type,
+    .entities = list,
+    .max_entities = len
+  };
 
-  return sv_world.num_box_entities;
+  return Sv_BoxEntitiesQuery(&query);
 }
 
 /**
@@ -414,40 +365,65 @@ typedef struct {
 } sv_trace_t;
 
 /**
- * @brief Clips the specified trace to the specified entity.
+ * @return True if traces skipping `skip` should not clip to `ent`.
  */
-static void Sv_ClipTraceToEntity(sv_trace_t *trace, const g_entity_t *ent) {
+static bool Sv_SkipTraceEntity(const g_entity_t *skip, const g_entity_t *ent) {
 
-  if (trace->skip) { // see if we can skip it
+  if (skip) { // see if we can skip it
 
-    if (ent == trace->skip) {
-      return; // explicitly (ourselves)
+    if (ent == skip) {
+      return true; // explicitly (ourselves)
     }
 
-    if (ent->owner == trace->skip) {
-      return; // or via ownership (we own it)
+    if (ent->owner == skip) {
+      return true; // or via ownership (we own it)
     }
 
-    if (trace->skip->owner) {
+    if (skip->owner) {
 
-      if (ent == trace->skip->owner) {
-        return; // which is bidirectional (inverse of previous case)
+      if (ent == skip->owner) {
+        return true; // which is bidirectional (inverse of previous case)
       }
 
-      if (ent->owner == trace->skip->owner) {
-        return; // and commutative (we are both owned by the same)
+      if (ent->owner == skip->owner) {
+        return true; // and commutative (we are both owned by the same)
       }
     }
 
     // triggers only clip to the world (while other entities can occupy triggers)
-    if (trace->skip->solid == SOLID_TRIGGER) {
+    if (skip->solid == SOLID_TRIGGER) {
 
       if (ent->solid != SOLID_BSP) {
-        return;
+        return true;
       }
     }
   }
 
+  return false;
+}
+
+/**
+ * @brief Merges the result of clipping the trace to the specified entity into the trace.
+ */
+static void Sv_MergeTrace(sv_trace_t *trace, const cm_trace_t *tr, const g_entity_t *ent) {
+
+  // check for a full or partial intersection
+  if (tr->all_solid || tr->fraction < trace->trace.fraction) {
+
+    trace->trace = *tr;
+    trace->trace.ent = (g_entity_t *) ent;
+  }
+}
+
+/**
+ * @brief Clips the specified trace to the specified entity.
+ */
+static void Sv_ClipTraceToEntity(sv_trace_t *trace, const g_entity_t *ent) {
+
+  if (Sv_SkipTraceEntity(trace->skip, ent)) {
+    return;
+  }
+
   const int32_t head_node = Sv_HullForEntity(ent);
   if (head_node == -1) {
     return;
@@ -457,22 +433,18 @@ static void Sv_ClipTraceToEntity(sv_trace_t *trace, const g_entity_t *ent) {
 
   cm_trace_t tr;
   
+  const cm_plane_cache_t *cache = &sv_world.plane_caches[ent->s.number];
+
   if (Mat4_Equal(sent->matrix, Mat4_Identity())) {
     tr = Cm_BoxTrace(trace->start, trace->end, trace->bounds, head_node, trace->contents);
+  } else if (ent->solid == SOLID_BSP && cache->planes && cache->head_node == head_node &&
+             !memcmp(&cache->matrix, &sent->matrix, sizeof(sent->matrix))) {
+    tr = Cm_CachedBoxTrace(trace->start, trace->end, trace->bounds, trace->contents, cache);
   } else {
     tr = Cm_TransformedBoxTrace(trace->start, trace->end, trace->bounds, head_node, trace->contents, sent->matrix, sent->inverse_matrix);
   }
 
-  // check for a full or partial intersection
-  if (tr.all_solid || tr.fraction < trace->trace.fraction) {
-
-    trace->trace = tr;
-    trace->trace.ent = (g_entity_t *) ent;
-
-    if (tr.all_solid) { // we were actually blocked
-      return;
-    }
-  }
+  Sv_MergeTrace(trace, &tr, ent);
 }
 
 /**
@@ -515,6 +487,108 @@ cm_trace_t Sv_Trace(const vec3_t start, const vec3_t end, const box3_t bounds,
   return trace.trace;
 }
 
+/**
+ * @brief Moves a batch of at most `CM_TRACE_BATCH_SIZE` box volumes through the world.
+ */
+static void Sv_TraceBatch_(const vec3_t *starts, const vec3_t *ends, int32_t count, const box3_t bounds,
+                           const g_entity_t *skip, int32_t contents, cm_trace_t *traces) {
+
+  sv_trace_t trace[CM_TRACE_BATCH_SIZE];
+  box3_t abs_bounds = Box3_Null();
+
+  for (int32_t i = 0; i < count; i++) {
+    trace[i] = (sv_trace_t) {
+      .start = starts[i],
+      .end = ends[i],
+      .bounds = bounds,
+      .abs_bounds = Cm_TraceBounds(starts[i], ends[i], bounds),
+      .skip = skip,
+      .contents = contents,
+      .trace = {
+        .fraction = 1.f,
+        .end = ends[i],
+      }
+    };
+
+    abs_bounds = Box3_Union(abs_bounds, trace[i].abs_bounds);
+  }
+
+  g_entity_t *e[MAX_ENTITIES];
+
+  const size_t len = Sv_BoxEntities(abs_bounds, e, lengthof(e), BOX_COLLIDE);
+  for (size_t i = 0; i < len; i++) {
+    const g_entity_t *ent = e[i];
+
+    if (Sv_SkipTraceEntity(skip, ent)) {
+      continue;
+    }
+
+    // gather the traces which may actually intersect this entity
+    int32_t lanes[CM_TRACE_BATCH_SIZE], num_lanes = 0;
+
+    for (int32_t j = 0; j < count; j++) {
+      if (Box3_Intersects(ent->abs_bounds, trace[j].abs_bounds)) {
+        lanes[num_lanes++] = j;
+      }
+    }
+
+    if (num_lanes == 0) {
+      continue;
+    }
+
+    const int32_t head_node = Sv_HullForEntity(ent);
+    if (head_node == -1) {
+      continue;
+    }
+
+    // untransformed models, most notably the world, are traced as a batch
+    if (num_lanes > 1 && Mat4_Equal(sv.entities[ent->s.number].matrix, Mat4_Identity())) {
+
+      vec3_t s[CM_TRACE_BATCH_SIZE], d[CM_TRACE_BATCH_SIZE];
+      cm_trace_t tr[CM_TRACE_BATCH_SIZE];
+
+      for (int32_t j = 0; j < num_lanes; j++) {
+        s[j] = starts[lanes[j]];
+        d[j] = ends[lanes[j]];
+      }
+
+      Cm_BoxTraceBatch(s, d, num_lanes, bounds, head_node, contents, tr);
+
+      for (int32_t j = 0; j < num_lanes; j++) {
+        Sv_MergeTrace(&trace[lanes[j]], &tr[j], ent);
+      }
+    } else {
+      for (int32_t j = 0; j < num_lanes; j++) {
+        Sv_ClipTraceToEntity(&trace[lanes[j]], ent);
+      }
+    }
+  }
+
+  for (int32_t i = 0; i < count; i++) {
+    traces[i] = trace[i].trace;
+  }
+}
+
+/**
+ * @brief Moves many box volumes of the same size through the world at once. The results
+ * are identical to calling `Sv_Trace` for each start and end point, but entities are
+ * gathered once per batch, and untransformed models are traced with `Cm_BoxTraceBatch`.
+ */
+void Sv_TraceBatch(const vec3_t *starts, const vec3_t *ends, size_t count, const box3_t bounds,
+                   const g_entity_t *skip, int32_t contents, cm_trace_t *traces) {
+
+  while (count) {
+    const int32_t n = count < CM_TRACE_BATCH_SIZE ? (int32_t) count : CM_TRACE_BATCH_SIZE;
+
+    Sv_TraceBatch_(starts, ends, n, bounds, skip, contents, traces);
+
+    starts += n;
+    ends += n;
+    traces += n;
+    count -= n;
+  }
+}
+
 /**
  * @brief Tests a clip of the specified translation against the specified entity.
  */
@@ -535,3 +609,80 @@ cm_trace_t Sv_Clip(const vec3_t start, const vec3_t end, const box3_t bounds,
 
   return trace.trace;
 }
+
+/**
+ * @brief Entities larger than this radius are sampled at their corners, as well as their
+ * nearest point and center, when testing for line of sight.
+ */
+#define SV_VIS_LARGE_RADIUS 64.f
+
+/**
+ * @brief Sample points are inset by up to this distance, so that points flush with
+ * walls and floors are not considered occluded.
+ */
+#define SV_VIS_INSET 4.f
+
+/**
+ * @return True if `eye` has an unobstructed line of sight to any of a handful of sample
+ * points within `bounds`. Only opaque world geometry is considered an occluder.
+ */
+static bool Sv_LineOfSight(const vec3_t eye, const box3_t bounds) {
+
+  const vec3_t inset = Vec3_Minf(Box3_Extents(bounds), Vec3(SV_VIS_INSET, SV_VIS_INSET, SV_VIS_INSET));
+  const box3_t inner = Box3_Expand3(bounds, Vec3_Negate(inset));
+
+  vec3_t points[10];
+  size_t num_points = 0;
+
+  points[num_points++] = Box3_ClampPoint(inner, eye);
+  points[num_points++] = Box3_Center(inner);
+
+  if (Box3_Radius(bounds) > SV_VIS_LARGE_RADIUS) {
+    Box3_ToPoints(inner, points + num_points);
+    num_points += 8;
+  }
+
+  for (size_t i = 0; i < num_points; i++) {
+    const cm_trace_t tr = Cm_BoxTrace(eye, points[i], Box3_Zero(), 0, CONTENTS_SOLID);
+    if (tr.fraction == 1.f) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief Quetoo's BSP format carries no precomputed visibility, so the potentially visible
+ * set is resolved on demand with line of sight tests against the world. Eyes that reside
+ * in solid leafs (e.g. noclipping spectators) can not be reasoned about, and see everything.
+ * @return True if `bounds` is potentially visible from `eye`.
+ */
+bool Sv_InPVS(const vec3_t eye, const box3_t bounds) {
+
+  if (Box3_ContainsPoint(bounds, eye)) {
+    return true;
+  }
+
+  const int32_t leaf_num = Cm_PointLeafnum(eye, 0);
+  if (Cm_LeafContents(leaf_num) & CONTENTS_SOLID) {
+    return true;
+  }
+
+  return Sv_LineOfSight(eye, bounds);
+}
+
+/**
+ * @brief Sounds carry through walls, so anything within `sv_phs_distance` of the eye is
+ * audible. Beyond that, sounds must be potentially visible to be heard.
+ * @return True if `bounds` is potentially audible from `eye`.
+ */
+bool Sv_InPHS(const vec3_t eye, const box3_t bounds) {
+
+  const vec3_t point = Box3_ClampPoint(bounds, eye);
+  if (Vec3_DistanceSquared(eye, point) < sv_phs_distance->value * sv_phs_distance->value) {
+    return true;
+  }
+
+  return Sv_InPVS(eye, bounds);
+}
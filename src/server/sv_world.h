@@ -27,10 +27,14 @@
 void Sv_SpawnEntities(void);
 void Sv_LinkEntity(g_entity_t *ent);
 void Sv_UnlinkEntity(g_entity_t *ent);
+size_t Sv_BoxEntitiesQuery(sv_box_entities_t *query);
 size_t Sv_BoxEntities(const box3_t bounds, g_entity_t **list, size_t len, uint32_t type);
 int32_t Sv_PointContents(const vec3_t p);
 int32_t Sv_BoxContents(const box3_t bounds);
 cm_trace_t Sv_Trace(const vec3_t start, const vec3_t end, const box3_t bounds, const g_entity_t *skip, int32_t contents);
+void Sv_TraceBatch(const vec3_t *starts, const vec3_t *ends, size_t count, const box3_t bounds, const g_entity_t *skip, int32_t contents, cm_trace_t *traces);
 cm_trace_t Sv_Clip(const vec3_t start, const vec3_t end, const box3_t bounds, const g_entity_t *test, int32_t contents);
+bool Sv_InPVS(const vec3_t eye, const box3_t bounds);
+bool Sv_InPHS(const vec3_t eye, const box3_t bounds);
 
 #endif /* __SV_LOCAL_H__ */
@@ -0,0 +1,209 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "heap.h"
+
+/**
+ * @brief Swaps the heap slots `a` and `b`, maintaining the key positions.
+ */
+static void Heap_Swap(heap_t *heap, int32_t a, int32_t b) {
+
+  const int32_t key = heap->keys[a];
+  heap->keys[a] = heap->keys[b];
+  heap->keys[b] = key;
+
+  const float priority = heap->priorities[a];
+  heap->priorities[a] = heap->priorities[b];
+  heap->priorities[b] = priority;
+
+  heap->positions[heap->keys[a]] = a;
+  heap->positions[heap->keys[b]] = b;
+}
+
+/**
+ * @brief Moves the key at slot `i` toward the root until the heap property is restored.
+ */
+static void Heap_SiftUp(heap_t *heap, int32_t i) {
+
+  while (i > 0) {
+    const int32_t parent = (i - 1) >> 1;
+
+    if (heap->priorities[parent] <= heap->priorities[i]) {
+      break;
+    }
+
+    Heap_Swap(heap, parent, i);
+    i = parent;
+  }
+}
+
+/**
+ * @brief Moves the key at slot `i` toward the leaves until the heap property is restored.
+ */
+static void Heap_SiftDown(heap_t *heap, int32_t i) {
+
+  while (true) {
+    const int32_t left = (i << 1) + 1;
+    const int32_t right = left + 1;
+
+    int32_t smallest = i;
+
+    if (left < heap->size && heap->priorities[left] < heap->priorities[smallest]) {
+      smallest = left;
+    }
+
+    if (right < heap->size && heap->priorities[right] < heap->priorities[smallest]) {
+      smallest = right;
+    }
+
+    if (smallest == i) {
+      break;
+    }
+
+    Heap_Swap(heap, i, smallest);
+    i = smallest;
+  }
+}
+
+/**
+ * @brief Initializes the heap for keys in `[0, capacity)`.
+ */
+void Heap_Init(heap_t *heap, int32_t capacity) {
+
+  memset(heap, 0, sizeof(*heap));
+
+  Heap_Reserve(heap, capacity);
+}
+
+/**
+ * @brief Ensures the heap can accommodate keys in `[0, capacity)`, growing it if necessary.
+ * @remarks The heap must be empty when it is grown.
+ */
+void Heap_Reserve(heap_t *heap, int32_t capacity) {
+
+  if (capacity <= heap->capacity) {
+    return;
+  }
+
+  assert(heap->size == 0);
+
+  heap->keys = g_renew(int32_t, heap->keys, capacity);
+  heap->priorities = g_renew(float, heap->priorities, capacity);
+  heap->positions = g_renew(int32_t, heap->positions, capacity);
+
+  for (int32_t i = heap->capacity; i < capacity; i++) {
+    heap->positions[i] = -1;
+  }
+
+  heap->capacity = capacity;
+}
+
+/**
+ * @brief Removes all keys from the heap, in time proportional to the count of keys removed.
+ */
+void Heap_Clear(heap_t *heap) {
+
+  for (int32_t i = 0; i < heap->size; i++) {
+    heap->positions[heap->keys[i]] = -1;
+  }
+
+  heap->size = 0;
+}
+
+/**
+ * @brief Frees all memory associated with the heap.
+ */
+void Heap_Free(heap_t *heap) {
+
+  g_free(heap->keys);
+  g_free(heap->priorities);
+  g_free(heap->positions);
+
+  memset(heap, 0, sizeof(*heap));
+}
+
+/**
+ * @return True if `key` is currently in the heap.
+ */
+bool Heap_Contains(const heap_t *heap, int32_t key) {
+
+  assert(key >= 0 && key < heap->capacity);
+
+  return heap->positions[key] != -1;
+}
+
+/**
+ * @brief Inserts `key` with the given priority. If `key` is already in the heap, its
+ * priority is updated in place.
+ */
+void Heap_Push(heap_t *heap, int32_t key, float priority) {
+
+  assert(key >= 0 && key < heap->capacity);
+
+  int32_t i = heap->positions[key];
+
+  if (i == -1) {
+    i = heap->size++;
+
+    heap->keys[i] = key;
+    heap->priorities[i] = priority;
+    heap->positions[key] = i;
+
+    Heap_SiftUp(heap, i);
+  } else if (priority < heap->priorities[i]) {
+    heap->priorities[i] = priority;
+    Heap_SiftUp(heap, i);
+  } else {
+    heap->priorities[i] = priority;
+    Heap_SiftDown(heap, i);
+  }
+}
+
+/**
+ * @brief Removes the key with the lowest priority from the heap.
+ * @param priority If not `NULL`, receives the priority of the removed key.
+ * @return The removed key, or -1 if the heap is empty.
+ */
+int32_t Heap_Pop(heap_t *heap, float *priority) {
+
+  if (heap->size == 0) {
+    return -1;
+  }
+
+  const int32_t key = heap->keys[0];
+
+  if (priority) {
+    *priority = heap->priorities[0];
+  }
+
+  heap->size--;
+
+  if (heap->size) {
+    heap->keys[0] = heap->keys[heap->size];
+    heap->priorities[0] = heap->priorities[heap->size];
+    heap->positions[heap->keys[0]] = 0;
+
+    Heap_SiftDown(heap, 0);
+  }
+
+  heap->positions[key] = -1;
+  return key;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#pragma once
+
+#include "vector.h"
+
+/**
+ * @brief An indexed binary min-heap of integer keys in `[0, capacity)`, ordered by float
+ * priority. Because each key's position in the heap is tracked, a key's priority may be
+ * lowered in place (decrease-key) in `O(log n)`, which makes this well suited to graph
+ * searches such as A* and Dijkstra, where keys are node indexes.
+ */
+typedef struct {
+
+  /**
+   * @brief The keys, in heap order.
+   */
+  int32_t *keys;
+
+  /**
+   * @brief The priorities, parallel to `keys`.
+   */
+  float *priorities;
+
+  /**
+   * @brief The heap position of each key, or -1 if the key is not in the heap.
+   */
+  int32_t *positions;
+
+  /**
+   * @brief The count of keys currently in the heap.
+   */
+  int32_t size;
+
+  /**
+   * @brief The key capacity; keys must be less than this value.
+   */
+  int32_t capacity;
+} heap_t;
+
+void Heap_Init(heap_t *heap, int32_t capacity);
+void Heap_Reserve(heap_t *heap, int32_t capacity);
+void Heap_Clear(heap_t *heap);
+void Heap_Free(heap_t *heap);
+bool Heap_Contains(const heap_t *heap, int32_t key);
+void Heap_Push(heap_t *heap, int32_t key, float priority);
+int32_t Heap_Pop(heap_t *heap, float *priority);
+
+/**
+ * @return True if the heap is empty.
+ */
+static inline bool __attribute__ ((warn_unused_result)) Heap_IsEmpty(const heap_t *heap) {
+  return heap->size == 0;
+}
@@ -23,6 +23,7 @@
 
 #include "box.h"
 #include "color.h"
+#include "heap.h"
 #include "matrix.h"
 #include "parse.h"
 #include "swap.h"
@@ -0,0 +1,185 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include <SDL3/SDL_endian.h>
+
+#include "tests.h"
+#include "collision/collision.h"
+
+#define NUM_LOADS 16
+
+quetoo_t quetoo;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+  Mem_Init();
+
+  Fs_Init(FS_AUTO_LOAD_ARCHIVES);
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+  Fs_Shutdown();
+
+  Mem_Shutdown();
+}
+
+/**
+ * @brief Asserts that the specified lump holds identical data in both files.
+ */
+#define AssertLumpEqual(a, b, num, data) { \
+  ck_assert_int_eq((a)->num, (b)->num); \
+  ck_assert(memcmp((a)->data, (b)->data, (a)->num * sizeof(*(a)->data)) == 0); \
+}
+
+START_TEST(check_Bsp_AliasLumps) {
+
+  bsp_header_t *loaded_header, *mapped_header;
+
+  const int64_t loaded_len = Fs_Load("maps/torn.bsp", (void **) &loaded_header);
+  ck_assert_msg(loaded_len > 0, "Failed to load maps/torn.bsp");
+
+  const int64_t mapped_len = Fs_Map("maps/torn.bsp", (void **) &mapped_header);
+  if (mapped_len == -1) {
+    printf("maps/torn.bsp can not be mapped, skipping\n");
+    Fs_Free(loaded_header);
+    return;
+  }
+
+  bsp_file_t loaded = { }, aliased = { };
+
+  ck_assert(Bsp_LoadLumps(loaded_header, &loaded, BSP_LUMPS_ALL));
+  ck_assert(Bsp_AliasLumps(mapped_header, &aliased, BSP_LUMPS_ALL));
+
+  ck_assert_int_eq(loaded.loaded_lumps, aliased.loaded_lumps);
+  ck_assert_int_eq(loaded.aliased_lumps, 0);
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+  ck_assert(aliased.aliased_lumps != 0);
+#endif
+
+  ck_assert(!(aliased.aliased_lumps & (1 << BSP_LUMP_ENTITIES)));
+
+  AssertLumpEqual(&loaded, &aliased, entity_string_size, entity_string);
+  AssertLumpEqual(&loaded, &aliased, num_planes, planes);
+  AssertLumpEqual(&loaded, &aliased, num_nodes, nodes);
+  AssertLumpEqual(&loaded, &aliased, num_leafs, leafs);
+  AssertLumpEqual(&loaded, &aliased, num_leaf_brushes, leaf_brushes);
+  AssertLumpEqual(&loaded, &aliased, num_brushes, brushes);
+  AssertLumpEqual(&loaded, &aliased, num_brush_sides, brush_sides);
+  AssertLumpEqual(&loaded, &aliased, num_models, models);
+
+  ck_assert_int_eq(loaded.voxels_size, aliased.voxels_size);
+  if (loaded.voxels_size) {
+    ck_assert(memcmp(loaded.voxels, aliased.voxels, loaded.voxels_size) == 0);
+  }
+
+  Bsp_UnloadLumps(&loaded, BSP_LUMPS_ALL);
+  Bsp_UnloadLumps(&aliased, BSP_LUMPS_ALL);
+
+  Fs_Unmap(mapped_header);
+  Fs_Free(loaded_header);
+
+  // time both paths, from opening the file to releasing it, warming the page cache first
+  gint64 loaded_time = 0, mapped_time = 0;
+
+  for (int32_t i = 0; i <= NUM_LOADS; i++) {
+    bsp_header_t *header;
+    bsp_file_t file = { };
+
+    gint64 time = g_get_monotonic_time();
+
+    ck_assert(Fs_Load("maps/torn.bsp", (void **) &header) == loaded_len);
+    ck_assert(Bsp_LoadLumps(header, &file, BSP_LUMPS_ALL));
+    Bsp_UnloadLumps(&file, BSP_LUMPS_ALL);
+    Fs_Free(header);
+
+    if (i) {
+      loaded_time += g_get_monotonic_time() - time;
+    }
+
+    time = g_get_monotonic_time();
+
+    ck_assert(Fs_Map("maps/torn.bsp", (void **) &header) == mapped_len);
+    ck_assert(Bsp_AliasLumps(header, &file, BSP_LUMPS_ALL));
+    Bsp_UnloadLumps(&file, BSP_LUMPS_ALL);
+    Fs_Unmap(header);
+
+    if (i) {
+      mapped_time += g_get_monotonic_time() - time;
+    }
+  }
+
+  printf("maps/torn.bsp (%" PRId64 " bytes): loaded %" G_GINT64_FORMAT "us, mapped %" G_GINT64_FORMAT "us\n",
+         loaded_len, loaded_time / NUM_LOADS, mapped_time / NUM_LOADS);
+
+} END_TEST
+
+START_TEST(check_Cm_LoadBspModel) {
+
+  gint64 time = g_get_monotonic_time();
+
+  int64_t size;
+  const cm_bsp_model_t *world = Cm_LoadBspModel("maps/torn.bsp", &size);
+
+  time = g_get_monotonic_time() - time;
+
+  ck_assert(world != NULL);
+  ck_assert_int_gt(size, 0);
+  ck_assert_int_gt(Cm_NumModels(), 0);
+  ck_assert(strlen(Cm_EntityString()) > 0);
+
+  // nothing but the entity string, which is a copy, outlives the load
+  ck_assert_int_eq(Cm_Bsp()->file->loaded_lumps, 1 << BSP_LUMP_ENTITIES);
+  ck_assert_int_eq(Cm_Bsp()->file->aliased_lumps, 0);
+
+  printf("Cm_LoadBspModel maps/torn.bsp: %" G_GINT64_FORMAT "us\n", time);
+
+  Cm_LoadBspModel(NULL, NULL);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+  Test_Init(argc, argv);
+
+  TCase *tcase = tcase_create("check_cm_bsp");
+  tcase_add_checked_fixture(tcase, setup, teardown);
+  tcase_set_timeout(tcase, 60);
+
+  tcase_add_test(tcase, check_Bsp_AliasLumps);
+  tcase_add_test(tcase, check_Cm_LoadBspModel);
+
+  Suite *suite = suite_create("check_cm_bsp");
+  suite_add_tcase(suite, tcase);
+
+  int32_t failed = Test_Run(suite);
+
+  Test_Shutdown();
+  return failed;
+}
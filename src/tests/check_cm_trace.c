@@ -0,0 +1,381 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "collision/cm_local.h"
+
+#define NUM_MATRICES 64
+#define NUM_TRACES 1024
+
+quetoo_t quetoo;
+
+/**
+ * @brief Setup fixture. Allocates an otherwise empty BSP, holding only the box hulls.
+ */
+void setup(void) {
+  Mem_Init();
+
+  memset(&cm_bsp, 0, sizeof(cm_bsp));
+
+  cm_bsp.planes = Mem_Malloc(sizeof(cm_bsp_plane_t) * 12 * CM_BOX_HULLS);
+  cm_bsp.nodes = Mem_Malloc(sizeof(cm_bsp_node_t) * 6 * CM_BOX_HULLS);
+  cm_bsp.leafs = Mem_Malloc(sizeof(cm_bsp_leaf_t) * CM_BOX_HULLS);
+  cm_bsp.leaf_brushes = Mem_Malloc(sizeof(int32_t) * CM_BOX_HULLS);
+  cm_bsp.brushes = Mem_Malloc(sizeof(cm_bsp_brush_t) * CM_BOX_HULLS);
+  cm_bsp.brush_sides = Mem_Malloc(sizeof(cm_bsp_brush_side_t) * 6 * CM_BOX_HULLS);
+
+  Cm_InitBoxHull(&cm_bsp);
+
+  cm_bsp.num_nodes = 6 * CM_BOX_HULLS; // appear loaded
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+  memset(&cm_bsp, 0, sizeof(cm_bsp));
+
+  Mem_Shutdown();
+}
+
+/**
+ * @return A random transform for the box hull, rotated about all axes.
+ */
+static mat4_t RandomMatrix(GRand *rand) {
+
+  const vec3_t angles = Vec3((float) g_rand_double_range(rand, 0.0, 360.0),
+                             (float) g_rand_double_range(rand, 0.0, 360.0),
+                             (float) g_rand_double_range(rand, 0.0, 360.0));
+
+  const vec3_t origin = Vec3((float) g_rand_double_range(rand, -64.0, 64.0),
+                             (float) g_rand_double_range(rand, -64.0, 64.0),
+                             (float) g_rand_double_range(rand, -64.0, 64.0));
+
+  return Mat4_FromRotationTranslationScale(angles, origin, 1.f);
+}
+
+/**
+ * @return A random point near the box hull.
+ */
+static vec3_t RandomPoint(GRand *rand) {
+  return Vec3((float) g_rand_double_range(rand, -256.0, 256.0),
+              (float) g_rand_double_range(rand, -256.0, 256.0),
+              (float) g_rand_double_range(rand, -256.0, 256.0));
+}
+
+START_TEST(check_Cm_CachedBoxTrace) {
+
+  GRand *rand = g_rand_new_with_seed(1);
+
+  const box3_t hull = Box3(Vec3(-64.f, -32.f, -16.f), Vec3(64.f, 32.f, 16.f));
+  const box3_t bounds = Box3(Vec3(-16.f, -16.f, -24.f), Vec3(16.f, 16.f, 32.f));
+
+  const int32_t head_node = Cm_SetBoxHull(hull, CONTENTS_SOLID);
+
+  cm_plane_cache_t cache = { };
+  int32_t hits = 0;
+
+  for (int32_t i = 0; i < NUM_MATRICES; i++) {
+
+    const mat4_t matrix = RandomMatrix(rand);
+    const mat4_t inverse_matrix = Mat4_Inverse(matrix);
+
+    ck_assert(Cm_UpdatePlaneCache(&cache, head_node, matrix, inverse_matrix));
+    ck_assert(!Cm_UpdatePlaneCache(&cache, head_node, matrix, inverse_matrix));
+
+    ck_assert_int_eq(1, cache.num_brushes);
+    ck_assert_int_eq(6, cache.num_planes);
+
+    for (int32_t j = 0; j < NUM_TRACES; j++) {
+
+      const vec3_t start = RandomPoint(rand);
+      const vec3_t end = (j & 7) ? RandomPoint(rand) : start;
+
+      const cm_trace_t a = Cm_TransformedBoxTrace(start, end, bounds, head_node, CONTENTS_MASK_SOLID, matrix, inverse_matrix);
+      const cm_trace_t b = Cm_CachedBoxTrace(start, end, bounds, CONTENTS_MASK_SOLID, &cache);
+
+      ck_assert_float_eq(a.fraction, b.fraction);
+      ck_assert_int_eq(a.start_solid, b.start_solid);
+      ck_assert_int_eq(a.all_solid, b.all_solid);
+      ck_assert(Vec3_Equal(a.plane.normal, b.plane.normal));
+
+      hits += a.fraction < 1.f;
+    }
+  }
+
+  ck_assert_int_gt(hits, 0);
+
+  Cm_FreePlaneCache(&cache);
+  g_rand_free(rand);
+
+} END_TEST
+
+START_TEST(check_Cm_CachedBoxTrace_Benchmark) {
+
+  GRand *rand = g_rand_new_with_seed(2);
+
+  const box3_t hull = Box3(Vec3(-64.f, -32.f, -16.f), Vec3(64.f, 32.f, 16.f));
+  const box3_t bounds = Box3(Vec3(-16.f, -16.f, -24.f), Vec3(16.f, 16.f, 32.f));
+
+  const int32_t head_node = Cm_SetBoxHull(hull, CONTENTS_SOLID);
+
+  const mat4_t matrix = RandomMatrix(rand);
+  const mat4_t inverse_matrix = Mat4_Inverse(matrix);
+
+  vec3_t points[NUM_TRACES];
+  for (int32_t i = 0; i < NUM_TRACES; i++) {
+    points[i] = RandomPoint(rand);
+  }
+
+  cm_plane_cache_t cache = { };
+  Cm_UpdatePlaneCache(&cache, head_node, matrix, inverse_matrix);
+
+  float transformed = 0.f, cached = 0.f;
+
+  gint64 time = g_get_monotonic_time();
+
+  for (int32_t i = 0; i < NUM_MATRICES; i++) {
+    for (int32_t j = 0; j < NUM_TRACES; j++) {
+      transformed += Cm_TransformedBoxTrace(points[j], points[(j + i + 1) % NUM_TRACES], bounds, head_node,
+                                            CONTENTS_MASK_SOLID, matrix, inverse_matrix).fraction;
+    }
+  }
+
+  const gint64 transformed_time = g_get_monotonic_time() - time;
+  time = g_get_monotonic_time();
+
+  for (int32_t i = 0; i < NUM_MATRICES; i++) {
+    for (int32_t j = 0; j < NUM_TRACES; j++) {
+      cached += Cm_CachedBoxTrace(points[j], points[(j + i + 1) % NUM_TRACES], bounds,
+                                  CONTENTS_MASK_SOLID, &cache).fraction;
+    }
+  }
+
+  const gint64 cached_time = g_get_monotonic_time() - time;
+
+  printf("%d traces: transformed %" G_GINT64_FORMAT "us, cached %" G_GINT64_FORMAT "us\n",
+         NUM_MATRICES * NUM_TRACES, transformed_time, cached_time);
+
+  ck_assert_float_eq(transformed, cached);
+
+  Cm_FreePlaneCache(&cache);
+  g_rand_free(rand);
+
+} END_TEST
+
+START_TEST(check_Cm_BrushVisits) {
+
+  Cm_ResetBrushVisitStats();
+
+  cm_brush_visits_t visits = Cm_BeginBrushVisits(8);
+
+  ck_assert(!Cm_BrushVisited(&visits, 5));
+  ck_assert(Cm_BrushVisited(&visits, 5));
+  ck_assert(!Cm_BrushVisited(&visits, 4));
+
+  // other lanes of the same generation visit independently
+  cm_brush_visits_t lane = Cm_BrushVisitLane(&visits, 3);
+
+  ck_assert(!Cm_BrushVisited(&lane, 5));
+  ck_assert(Cm_BrushVisited(&lane, 5));
+  ck_assert(Cm_BrushVisited(&visits, 5));
+
+  Cm_EndBrushVisits(&visits);
+  Cm_EndBrushVisits(&lane);
+
+  // and a new generation, even with more brushes, starts afresh
+  cm_brush_visits_t next = Cm_BeginBrushVisits(1024);
+
+  ck_assert(!Cm_BrushVisited(&next, 5));
+  ck_assert(!Cm_BrushVisited(&next, 1023));
+  ck_assert(Cm_BrushVisited(&next, 1023));
+
+  Cm_EndBrushVisits(&next);
+
+  const cm_brush_visit_stats_t stats = Cm_BrushVisitStats();
+
+  ck_assert_uint_eq(stats.visited, 5);
+  ck_assert_uint_eq(stats.avoided, 4);
+
+} END_TEST
+
+/**
+ * @brief Map fixture setup. Loads a real map, for batched trace tests.
+ */
+static void setup_map(void) {
+  Mem_Init();
+
+  Fs_Init(FS_AUTO_LOAD_ARCHIVES);
+
+  Cm_LoadBspModel("maps/torn.bsp", NULL);
+}
+
+/**
+ * @brief Map fixture teardown.
+ */
+static void teardown_map(void) {
+  Cm_LoadBspModel(NULL, NULL);
+
+  Fs_Shutdown();
+
+  Mem_Shutdown();
+}
+
+/**
+ * @brief Fills `starts` and `ends` with shotgun-like spreads of traces from random points
+ * within the world, `CM_TRACE_BATCH_SIZE` traces per start point.
+ */
+static void RandomSpreads(GRand *rand, vec3_t *starts, vec3_t *ends, int32_t count) {
+
+  const box3_t world = Cm_Bsp()->models[0].bounds;
+
+  vec3_t start = Vec3_Zero(), dir = Vec3_Zero();
+
+  for (int32_t i = 0; i < count; i++) {
+
+    if (i % CM_TRACE_BATCH_SIZE == 0) {
+      start = Vec3((float) g_rand_double_range(rand, world.mins.x, world.maxs.x),
+                   (float) g_rand_double_range(rand, world.mins.y, world.maxs.y),
+                   (float) g_rand_double_range(rand, world.mins.z, world.maxs.z));
+      dir = Vec3_Normalize(Vec3((float) g_rand_double_range(rand, -1.0, 1.0),
+                                (float) g_rand_double_range(rand, -1.0, 1.0),
+                                (float) g_rand_double_range(rand, -.5, .5)));
+    }
+
+    const vec3_t spread = Vec3((float) g_rand_double_range(rand, -.05, .05),
+                               (float) g_rand_double_range(rand, -.05, .05),
+                               (float) g_rand_double_range(rand, -.05, .05));
+
+    starts[i] = start;
+    ends[i] = Vec3_Fmaf(start, 2048.f, Vec3_Normalize(Vec3_Add(dir, spread)));
+  }
+}
+
+/**
+ * @brief Fills `starts` and `ends` with traces between unrelated random points within the
+ * world, which diverge at the first node.
+ */
+static void RandomTraces(GRand *rand, vec3_t *starts, vec3_t *ends, int32_t count) {
+
+  const box3_t world = Cm_Bsp()->models[0].bounds;
+
+  for (int32_t i = 0; i < count; i++) {
+    starts[i] = Vec3((float) g_rand_double_range(rand, world.mins.x, world.maxs.x),
+                     (float) g_rand_double_range(rand, world.mins.y, world.maxs.y),
+                     (float) g_rand_double_range(rand, world.mins.z, world.maxs.z));
+    ends[i] = Vec3((float) g_rand_double_range(rand, world.mins.x, world.maxs.x),
+                   (float) g_rand_double_range(rand, world.mins.y, world.maxs.y),
+                   (float) g_rand_double_range(rand, world.mins.z, world.maxs.z));
+  }
+}
+
+#define NUM_BATCHED_TRACES (CM_TRACE_BATCH_SIZE * 4096)
+
+START_TEST(check_Cm_BoxTraceBatch) {
+
+  GRand *rand = g_rand_new_with_seed(3);
+
+  static vec3_t starts[NUM_BATCHED_TRACES], ends[NUM_BATCHED_TRACES];
+  static cm_trace_t batched[NUM_BATCHED_TRACES];
+
+  RandomSpreads(rand, starts, ends, NUM_BATCHED_TRACES / 2);
+  RandomTraces(rand, starts + NUM_BATCHED_TRACES / 2, ends + NUM_BATCHED_TRACES / 2, NUM_BATCHED_TRACES / 2);
+
+  const box3_t boxes[] = {
+    Box3_Zero(),
+    Box3f(8.f, 8.f, 8.f),
+    Box3(Vec3(-16.f, -16.f, -24.f), Vec3(16.f, 16.f, 32.f))
+  };
+
+  for (size_t b = 0; b < lengthof(boxes); b++) {
+
+    Cm_ResetBrushVisitStats();
+
+    gint64 time = g_get_monotonic_time();
+
+    Cm_BoxTraceBatch(starts, ends, NUM_BATCHED_TRACES, boxes[b], 0, CONTENTS_MASK_SOLID, batched);
+
+    const gint64 batched_time = g_get_monotonic_time() - time;
+    time = g_get_monotonic_time();
+
+    int32_t hits = 0;
+
+    for (int32_t i = 0; i < NUM_BATCHED_TRACES; i++) {
+      const cm_trace_t trace = Cm_BoxTrace(starts[i], ends[i], boxes[b], 0, CONTENTS_MASK_SOLID);
+
+      ck_assert_float_eq(trace.fraction, batched[i].fraction);
+      ck_assert(memcmp(&trace.end, &batched[i].end, sizeof(vec3_t)) == 0);
+      ck_assert(memcmp(&trace.plane.normal, &batched[i].plane.normal, sizeof(vec3_t)) == 0);
+      ck_assert_int_eq(trace.start_solid, batched[i].start_solid);
+      ck_assert_int_eq(trace.all_solid, batched[i].all_solid);
+      ck_assert_ptr_eq(trace.brush, batched[i].brush);
+
+      hits += trace.fraction < 1.f;
+    }
+
+    const gint64 looped_time = g_get_monotonic_time() - time;
+
+    const cm_brush_visit_stats_t stats = Cm_BrushVisitStats();
+
+    ck_assert_int_gt(hits, 0);
+
+    printf("%d traces of size %g: looped %.0f traces/s, batched %.0f traces/s\n",
+           NUM_BATCHED_TRACES, Box3_Size(boxes[b]).x,
+           NUM_BATCHED_TRACES * 1000000.0 / Maxi(1, (int32_t) looped_time),
+           NUM_BATCHED_TRACES * 1000000.0 / Maxi(1, (int32_t) batched_time));
+
+    printf("%" PRIu64 " brush tests, %" PRIu64 " repeat tests avoided\n", stats.visited, stats.avoided);
+  }
+
+  g_rand_free(rand);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+  Test_Init(argc, argv);
+
+  TCase *tcase = tcase_create("check_cm_trace");
+  tcase_add_checked_fixture(tcase, setup, teardown);
+  tcase_set_timeout(tcase, 60);
+
+  tcase_add_test(tcase, check_Cm_CachedBoxTrace);
+  tcase_add_test(tcase, check_Cm_BrushVisits);
+  tcase_add_test(tcase, check_Cm_CachedBoxTrace_Benchmark);
+
+  TCase *map = tcase_create("check_cm_trace_map");
+  tcase_add_checked_fixture(map, setup_map, teardown_map);
+  tcase_set_timeout(map, 60);
+
+  tcase_add_test(map, check_Cm_BoxTraceBatch);
+
+  Suite *suite = suite_create("check_cm_trace");
+  suite_add_tcase(suite, tcase);
+  suite_add_tcase(suite, map);
+
+  int32_t failed = Test_Run(suite);
+
+  Test_Shutdown();
+  return failed;
+}
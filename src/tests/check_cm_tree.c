@@ -0,0 +1,431 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "collision/cm_tree.h"
+
+#define NUM_ITEMS 2048
+#define NUM_FRAMES 100
+#define NUM_QUERIES 8
+#define NUM_THREADS 4
+#define WORLD_SIZE 4096.f
+
+quetoo_t quetoo;
+
+/**
+ * @brief A simulated entity.
+ */
+typedef struct {
+  box3_t bounds;
+  vec3_t velocity;
+  int32_t leaf;
+  struct legacy_sector_s *sector;
+} item_t;
+
+static item_t items[NUM_ITEMS];
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+  Mem_Init();
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+  Mem_Shutdown();
+}
+
+/**
+ * @return A random box of up to 64 units within the world.
+ */
+static box3_t RandomBox(GRand *rand) {
+
+  const vec3_t center = Vec3((float) g_rand_double_range(rand, -WORLD_SIZE, WORLD_SIZE),
+                             (float) g_rand_double_range(rand, -WORLD_SIZE, WORLD_SIZE),
+                             (float) g_rand_double_range(rand, -WORLD_SIZE * .25, WORLD_SIZE * .25));
+
+  const float size = (float) g_rand_double_range(rand, 8.0, 64.0);
+
+  return Box3_FromCenterSize(center, Vec3(size, size, size));
+}
+
+/**
+ * @brief Initializes all items with random bounds and velocities.
+ */
+static void InitItems(GRand *rand) {
+
+  for (int32_t i = 0; i < NUM_ITEMS; i++) {
+    items[i].bounds = RandomBox(rand);
+    items[i].velocity = Vec3((float) g_rand_double_range(rand, -8.0, 8.0),
+                             (float) g_rand_double_range(rand, -8.0, 8.0),
+                             (float) g_rand_double_range(rand, -2.0, 2.0));
+    items[i].leaf = CM_TREE_NULL;
+    items[i].sector = NULL;
+  }
+}
+
+/**
+ * @brief Query context, collecting item indexes.
+ */
+typedef struct {
+  box3_t bounds;
+  int32_t found[NUM_ITEMS];
+  int32_t num_found;
+} query_t;
+
+/**
+ * @brief Query callback.
+ */
+static bool QueryItem(void *data, void *context) {
+
+  query_t *query = context;
+  const item_t *item = data;
+
+  if (Box3_Intersects(item->bounds, query->bounds)) {
+    query->found[query->num_found++] = (int32_t) (item - items);
+  }
+
+  return true;
+}
+
+START_TEST(check_Cm_Tree_Query) {
+
+  GRand *rand = g_rand_new_with_seed(1);
+
+  InitItems(rand);
+
+  cm_tree_t tree;
+  Cm_InitTree(&tree, 16.f);
+
+  for (int32_t i = 0; i < NUM_ITEMS; i++) {
+    items[i].leaf = Cm_TreeInsert(&tree, items[i].bounds, &items[i]);
+  }
+
+  // move everything, and remove and reinsert some
+  for (int32_t frame = 0; frame < 10; frame++) {
+    for (int32_t i = 0; i < NUM_ITEMS; i++) {
+      items[i].bounds = Box3_Translate(items[i].bounds, items[i].velocity);
+
+      if (g_rand_int_range(rand, 0, 20) == 0) {
+        Cm_TreeRemove(&tree, items[i].leaf);
+        items[i].leaf = Cm_TreeInsert(&tree, items[i].bounds, &items[i]);
+      } else {
+        Cm_TreeMove(&tree, items[i].leaf, items[i].bounds);
+      }
+    }
+  }
+
+  ck_assert_int_eq(NUM_ITEMS * 2 - 1, tree.num_nodes);
+  ck_assert_int_le(Cm_TreeHeight(&tree), 24);
+
+  for (int32_t i = 0; i < 100; i++) {
+
+    query_t query = { .bounds = Box3_Expand(RandomBox(rand), 256.f) };
+    Cm_TreeQuery(&tree, query.bounds, QueryItem, &query);
+
+    int32_t expected = 0;
+    for (int32_t j = 0; j < NUM_ITEMS; j++) {
+      if (Box3_Intersects(items[j].bounds, query.bounds)) {
+        expected++;
+      }
+    }
+
+    ck_assert_int_eq(expected, query.num_found);
+  }
+
+  for (int32_t i = 0; i < NUM_ITEMS; i++) {
+    Cm_TreeRemove(&tree, items[i].leaf);
+  }
+
+  ck_assert_int_eq(0, tree.num_nodes);
+  ck_assert_int_eq(-1, Cm_TreeHeight(&tree));
+
+  Cm_FreeTree(&tree);
+  g_rand_free(rand);
+
+} END_TEST
+
+static cm_tree_t concurrent_tree;
+static box3_t concurrent_queries[1024];
+
+/**
+ * @brief Runs all concurrent queries, summing their results into `data`.
+ */
+static void check_Cm_Tree_Concurrent_Run(void *data) {
+
+  int32_t *total = data;
+
+  for (size_t i = 0; i < lengthof(concurrent_queries); i++) {
+    query_t query = { .bounds = concurrent_queries[i] };
+    Cm_TreeQuery(&concurrent_tree, query.bounds, QueryItem, &query);
+
+    *total += query.num_found;
+  }
+}
+
+START_TEST(check_Cm_Tree_Concurrent) {
+
+  Thread_Init(NUM_THREADS);
+
+  GRand *rand = g_rand_new_with_seed(2);
+
+  InitItems(rand);
+
+  Cm_InitTree(&concurrent_tree, 16.f);
+
+  for (int32_t i = 0; i < NUM_ITEMS; i++) {
+    items[i].leaf = Cm_TreeInsert(&concurrent_tree, items[i].bounds, &items[i]);
+  }
+
+  for (size_t i = 0; i < lengthof(concurrent_queries); i++) {
+    concurrent_queries[i] = Box3_Expand(RandomBox(rand), 128.f);
+  }
+
+  int32_t serial = 0;
+  check_Cm_Tree_Concurrent_Run(&serial);
+
+  ck_assert_int_gt(serial, 0);
+
+  int32_t totals[NUM_THREADS] = { 0 };
+  thread_t *threads[NUM_THREADS];
+
+  for (int32_t i = 0; i < NUM_THREADS; i++) {
+    threads[i] = Thread_Create(check_Cm_Tree_Concurrent_Run, &totals[i], 0);
+  }
+
+  for (int32_t i = 0; i < NUM_THREADS; i++) {
+    Thread_Wait(threads[i]);
+    ck_assert_int_eq(serial, totals[i]);
+  }
+
+  Cm_FreeTree(&concurrent_tree);
+  g_rand_free(rand);
+
+  Thread_Shutdown();
+
+} END_TEST
+
+/**
+ * @brief The sector tree formerly used by `sv_world.c`, for comparison.
+ */
+typedef struct legacy_sector_s {
+  int32_t axis;
+  float dist;
+  struct legacy_sector_s *children[2];
+  GList *items;
+} legacy_sector_t;
+
+static legacy_sector_t legacy_sectors[32];
+static int32_t num_legacy_sectors;
+
+/**
+ * @brief Builds a uniformly subdivided sector tree of depth 4.
+ */
+static legacy_sector_t *Legacy_CreateSector(int32_t depth, const box3_t bounds) {
+
+  legacy_sector_t *sector = &legacy_sectors[num_legacy_sectors++];
+
+  if (depth == 4) {
+    sector->axis = -1;
+    return sector;
+  }
+
+  const vec3_t size = Box3_Size(bounds);
+  sector->axis = size.x > size.y ? 0 : 1;
+  sector->dist = .5f * (bounds.maxs.xyz[sector->axis] + bounds.mins.xyz[sector->axis]);
+
+  box3_t bounds1 = bounds, bounds2 = bounds;
+  bounds1.maxs.xyz[sector->axis] = bounds2.mins.xyz[sector->axis] = sector->dist;
+
+  sector->children[0] = Legacy_CreateSector(depth + 1, bounds2);
+  sector->children[1] = Legacy_CreateSector(depth + 1, bounds1);
+
+  return sector;
+}
+
+/**
+ * @brief Unlinks and relinks the item, as `Sv_LinkEntity` formerly did.
+ */
+static void Legacy_Link(item_t *item) {
+
+  if (item->sector) {
+    item->sector->items = g_list_remove(item->sector->items, item);
+  }
+
+  legacy_sector_t *sector = legacy_sectors;
+  while (sector->axis != -1) {
+    if (item->bounds.mins.xyz[sector->axis] > sector->dist) {
+      sector = sector->children[0];
+    } else if (item->bounds.maxs.xyz[sector->axis] < sector->dist) {
+      sector = sector->children[1];
+    } else {
+      break;
+    }
+  }
+
+  item->sector = sector;
+  sector->items = g_list_prepend(sector->items, item);
+}
+
+/**
+ * @brief Recursively queries the sector tree.
+ */
+static void Legacy_Query_r(const legacy_sector_t *sector, query_t *query) {
+
+  for (const GList *e = sector->items; e; e = e->next) {
+    QueryItem(e->data, query);
+  }
+
+  if (sector->axis == -1) {
+    return;
+  }
+
+  if (query->bounds.maxs.xyz[sector->axis] > sector->dist) {
+    Legacy_Query_r(sector->children[0], query);
+  }
+
+  if (query->bounds.mins.xyz[sector->axis] < sector->dist) {
+    Legacy_Query_r(sector->children[1], query);
+  }
+}
+
+START_TEST(check_Cm_Tree_Benchmark) {
+
+  GRand *rand = g_rand_new_with_seed(3);
+
+  const box3_t world = Box3(Vec3(-WORLD_SIZE, -WORLD_SIZE, -WORLD_SIZE), Vec3(WORLD_SIZE, WORLD_SIZE, WORLD_SIZE));
+
+  // sector tree
+
+  InitItems(rand);
+
+  memset(legacy_sectors, 0, sizeof(legacy_sectors));
+  num_legacy_sectors = 0;
+  Legacy_CreateSector(0, world);
+
+  int32_t legacy_found = 0;
+  gint64 link_time = 0, query_time = 0;
+
+  for (int32_t frame = 0; frame < NUM_FRAMES; frame++) {
+
+    gint64 time = g_get_monotonic_time();
+
+    for (int32_t i = 0; i < NUM_ITEMS; i++) {
+      items[i].bounds = Box3_Translate(items[i].bounds, items[i].velocity);
+      Legacy_Link(&items[i]);
+    }
+
+    link_time += g_get_monotonic_time() - time;
+    time = g_get_monotonic_time();
+
+    for (int32_t i = 0; i < NUM_ITEMS; i++) {
+      for (int32_t j = 0; j < NUM_QUERIES; j++) {
+        query_t query = { .bounds = Box3_Expand(items[i].bounds, 16.f * j) };
+        Legacy_Query_r(legacy_sectors, &query);
+        legacy_found += query.num_found;
+      }
+    }
+
+    query_time += g_get_monotonic_time() - time;
+  }
+
+  for (int32_t i = 0; i < num_legacy_sectors; i++) {
+    g_list_free(legacy_sectors[i].items);
+  }
+
+  printf("sector tree: %d items, %d frames: link %" G_GINT64_FORMAT "us, query %" G_GINT64_FORMAT "us\n",
+         NUM_ITEMS, NUM_FRAMES, link_time, query_time);
+
+  // dynamic tree
+
+  g_rand_set_seed(rand, 3);
+  InitItems(rand);
+
+  cm_tree_t tree;
+  Cm_InitTree(&tree, 16.f);
+
+  int32_t found = 0, reinserted = 0;
+  link_time = query_time = 0;
+
+  for (int32_t frame = 0; frame < NUM_FRAMES; frame++) {
+
+    gint64 time = g_get_monotonic_time();
+
+    for (int32_t i = 0; i < NUM_ITEMS; i++) {
+      items[i].bounds = Box3_Translate(items[i].bounds, items[i].velocity);
+
+      if (items[i].leaf == CM_TREE_NULL) {
+        items[i].leaf = Cm_TreeInsert(&tree, items[i].bounds, &items[i]);
+      } else {
+        reinserted += Cm_TreeMove(&tree, items[i].leaf, items[i].bounds);
+      }
+    }
+
+    link_time += g_get_monotonic_time() - time;
+    time = g_get_monotonic_time();
+
+    for (int32_t i = 0; i < NUM_ITEMS; i++) {
+      for (int32_t j = 0; j < NUM_QUERIES; j++) {
+        query_t query = { .bounds = Box3_Expand(items[i].bounds, 16.f * j) };
+        Cm_TreeQuery(&tree, query.bounds, QueryItem, &query);
+        found += query.num_found;
+      }
+    }
+
+    query_time += g_get_monotonic_time() - time;
+  }
+
+  printf("dynamic tree: %d items, %d frames: link %" G_GINT64_FORMAT "us (%d reinserted), query %" G_GINT64_FORMAT "us, height %d\n",
+         NUM_ITEMS, NUM_FRAMES, link_time, reinserted, query_time, Cm_TreeHeight(&tree));
+
+  ck_assert_int_eq(legacy_found, found);
+
+  Cm_FreeTree(&tree);
+  g_rand_free(rand);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+  Test_Init(argc, argv);
+
+  TCase *tcase = tcase_create("check_cm_tree");
+  tcase_add_checked_fixture(tcase, setup, teardown);
+  tcase_set_timeout(tcase, 60);
+
+  tcase_add_test(tcase, check_Cm_Tree_Query);
+  tcase_add_test(tcase, check_Cm_Tree_Concurrent);
+  tcase_add_test(tcase, check_Cm_Tree_Benchmark);
+
+  Suite *suite = suite_create("check_cm_tree");
+  suite_add_tcase(suite, tcase);
+
+  int32_t failed = Test_Run(suite);
+
+  Test_Shutdown();
+  return failed;
+}
@@ -85,6 +85,27 @@ START_TEST(check_Fs_LoadFile) {
 
 } END_TEST
 
+START_TEST(check_Fs_Map) {
+  void *loaded, *mapped;
+
+  const int64_t loaded_len = Fs_Load("maps/torn.bsp", &loaded);
+  ck_assert_msg(loaded_len > 0, "Failed to load maps/torn.bsp");
+
+  // mapping may fail, e.g. for compressed archive entries, in which case callers load instead
+  const int64_t mapped_len = Fs_Map("maps/torn.bsp", &mapped);
+  if (mapped_len == -1) {
+    ck_assert(mapped == NULL);
+  } else {
+    ck_assert_int_eq(mapped_len, loaded_len);
+    ck_assert(memcmp(mapped, loaded, loaded_len) == 0);
+
+    Fs_Unmap(mapped);
+  }
+
+  Fs_Free(loaded);
+
+} END_TEST
+
 /**
  * @brief Test entry point.
  */
@@ -98,6 +119,7 @@ int32_t main(int32_t argc, char **argv) {
   tcase_add_test(tcase, check_Fs_OpenRead);
   tcase_add_test(tcase, check_Fs_OpenWrite);
   tcase_add_test(tcase, check_Fs_LoadFile);
+  tcase_add_test(tcase, check_Fs_Map);
 
   Suite *suite = suite_create("check_filesystem");
   suite_add_tcase(suite, tcase);
@@ -0,0 +1,369 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+
+// the node graph and link costs are private to the translation unit
+#include "game/default/g_ai_node.c"
+
+#define GRID_SIZE 32
+#define GRID_SPACING 64.f
+#define NUM_NODES (GRID_SIZE * GRID_SIZE)
+#define NUM_STARTS 16
+#define NUM_ENDS 32
+
+quetoo_t quetoo;
+
+g_import_t gi;
+g_export_t ge;
+g_level_t g_level;
+
+cvar_t *g_ai_node_dev;
+cvar_t *g_ai_path_cache_size;
+cvar_t *sv_max_clients;
+cvar_t *sv_max_entities;
+
+static cvar_t node_dev, path_cache_size, max_clients, max_entities;
+
+/**
+ * @brief The fixture graph has no developer tools.
+ */
+bool G_Ai_InDeveloperMode(void) {
+  return false;
+}
+
+/**
+ * @brief The fixture graph has no platforms to drop from.
+ */
+bool G_Ai_ShouldSlowDrop(const ai_node_id_t from_node, const ai_node_id_t to_node) {
+  return false;
+}
+
+/**
+ * @brief The fixture graph lies on an empty plane.
+ */
+static int32_t PointContents(const vec3_t point) {
+  return 0;
+}
+
+/**
+ * @brief Debugging output is disabled.
+ */
+static debug_t DebugMask(void) {
+  return 0;
+}
+
+/**
+ * @brief Debugging output is discarded.
+ */
+static void Debug_(const debug_t debug, const char *func, const char *fmt, ...) { }
+
+/**
+ * @brief Setup fixture. Builds a jittered grid of nodes on a plane, linked to their
+ * neighbors with costs of one to three times their distance, so that the Euclidean
+ * heuristic remains admissible. Some links are one way, some are missing, and the last
+ * node is not linked at all.
+ */
+void setup(void) {
+  Mem_Init();
+
+  memset(&gi, 0, sizeof(gi));
+
+  gi.PointContents = PointContents;
+  gi.DebugMask = DebugMask;
+  gi.Debug_ = Debug_;
+
+  memset(&ge, 0, sizeof(ge));
+  memset(&g_level, 0, sizeof(g_level));
+
+  g_level.gravity = 800;
+
+  g_ai_node_dev = &node_dev;
+  g_ai_path_cache_size = &path_cache_size;
+  sv_max_clients = &max_clients;
+  sv_max_entities = &max_entities;
+
+  GRand *rand = g_rand_new_with_seed(3);
+
+  for (int32_t y = 0; y < GRID_SIZE; y++) {
+    for (int32_t x = 0; x < GRID_SIZE; x++) {
+      const vec3_t position = Vec3(x * GRID_SPACING + (float) g_rand_double_range(rand, -16.0, 16.0),
+                                   y * GRID_SPACING + (float) g_rand_double_range(rand, -16.0, 16.0),
+                                   0.f);
+
+      ck_assert_int_eq(G_Ai_Node_Create(position), y * GRID_SIZE + x);
+    }
+  }
+
+  const int32_t offsets[][2] = { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, -1 } };
+
+  for (int32_t y = 0; y < GRID_SIZE; y++) {
+    for (int32_t x = 0; x < GRID_SIZE; x++) {
+      for (size_t i = 0; i < lengthof(offsets); i++) {
+
+        const int32_t nx = x + offsets[i][0], ny = y + offsets[i][1];
+        if (nx >= GRID_SIZE || ny < 0 || ny >= GRID_SIZE) {
+          continue;
+        }
+
+        const ai_node_id_t a = y * GRID_SIZE + x, b = ny * GRID_SIZE + nx;
+        if (a == NUM_NODES - 1 || b == NUM_NODES - 1) {
+          continue;
+        }
+
+        const double r = g_rand_double(rand);
+        if (r < .15) {
+          continue;
+        }
+
+        const float distance = Vec3_Distance(G_Ai_Node_GetPosition(a), G_Ai_Node_GetPosition(b));
+
+        G_Ai_Node_Link(a, b, distance * (float) g_rand_double_range(rand, 1.0, 3.0));
+
+        if (r > .25) {
+          G_Ai_Node_Link(b, a, distance * (float) g_rand_double_range(rand, 1.0, 3.0));
+        }
+      }
+    }
+  }
+
+  g_rand_free(rand);
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+  G_Ai_ShutdownNodes();
+
+  Mem_Shutdown();
+}
+
+/**
+ * @brief Computes the cost of the cheapest path from `start` to every node by exhaustive
+ * Dijkstra, without a heap, writing `INFINITY` for unreachable nodes.
+ */
+static void Dijkstra(ai_node_id_t start, double *dist) {
+
+  bool done[NUM_NODES] = { false };
+
+  for (int32_t i = 0; i < NUM_NODES; i++) {
+    dist[i] = INFINITY;
+  }
+
+  dist[start] = 0.0;
+
+  while (true) {
+    ai_node_id_t current = AI_NODE_INVALID;
+
+    for (ai_node_id_t i = 0; i < NUM_NODES; i++) {
+      if (!done[i] && isfinite(dist[i]) && (current == AI_NODE_INVALID || dist[i] < dist[current])) {
+        current = i;
+      }
+    }
+
+    if (current == AI_NODE_INVALID) {
+      break;
+    }
+
+    done[current] = true;
+
+    const GArray *links = G_Ai_Node_GetLinks(current);
+    if (links == NULL) {
+      continue;
+    }
+
+    for (guint i = 0; i < links->len; i++) {
+      const ai_link_t *link = &g_array_index(links, ai_link_t, i);
+
+      dist[link->id] = fmin(dist[link->id], dist[current] + link->cost);
+    }
+  }
+}
+
+/**
+ * @brief Asserts that the path is a valid walk from `start` to `end`, whose link costs
+ * sum to `length`.
+ */
+static void AssertPath(const GArray *path, ai_node_id_t start, ai_node_id_t end, float length) {
+
+  ck_assert(path != NULL);
+  ck_assert_uint_gt(path->len, 0);
+
+  ck_assert_uint_eq(g_array_index(path, ai_node_id_t, 0), start);
+  ck_assert_uint_eq(g_array_index(path, ai_node_id_t, path->len - 1), end);
+
+  double sum = 0.0;
+
+  for (guint i = 0; i + 1 < path->len; i++) {
+    const ai_node_id_t a = g_array_index(path, ai_node_id_t, i);
+    const ai_node_id_t b = g_array_index(path, ai_node_id_t, i + 1);
+
+    ck_assert_msg(G_Ai_Node_IsLinked(a, b), "%u -> %u is not linked", a, b);
+
+    sum += G_Ai_LinkCost(a, b);
+  }
+
+  ck_assert_double_eq_tol(sum, length, 1e-3 * fmax(1.0, sum));
+}
+
+/**
+ * @brief Searches many paths with the specified heuristic, comparing each to Dijkstra.
+ * @param exact True if the heuristic is admissible, so that every path must be optimal.
+ */
+static void CheckFindPath(G_Ai_NodeCostFunc heuristic, bool exact) {
+
+  GRand *rand = g_rand_new_with_seed(4);
+
+  double *dist = g_new(double, NUM_NODES);
+
+  int32_t found = 0, unreachable = 0;
+  gint64 time = 0;
+
+  for (int32_t i = 0; i < NUM_STARTS; i++) {
+
+    const ai_node_id_t start = g_rand_int_range(rand, 0, NUM_NODES - 1);
+
+    Dijkstra(start, dist);
+
+    for (int32_t j = 0; j <= NUM_ENDS; j++) {
+
+      const ai_node_id_t end = j == NUM_ENDS ? NUM_NODES - 1 : g_rand_int_range(rand, 0, NUM_NODES);
+
+      float length;
+
+      const gint64 t = g_get_monotonic_time();
+      GArray *path = G_Ai_Node_FindPath(NULL, start, end, heuristic, &length);
+      time += g_get_monotonic_time() - t;
+
+      if (!isfinite(dist[end])) {
+        ck_assert_msg(path == NULL, "%u -> %u is unreachable", start, end);
+        unreachable++;
+        continue;
+      }
+
+      AssertPath(path, start, end, length);
+
+      if (exact) {
+        ck_assert_msg(fabs(length - dist[end]) <= 1e-3 * fmax(1.0, dist[end]),
+                      "%u -> %u: %f, expected %f", start, end, length, dist[end]);
+      } else {
+        ck_assert_msg(length >= dist[end] - 1e-3 * fmax(1.0, dist[end]),
+                      "%u -> %u: %f, cheaper than %f", start, end, length, dist[end]);
+      }
+
+      // a cached search yields the same path
+      if (g_ai_path_cache_size->integer > 0) {
+        float cached_length;
+        GArray *cached = G_Ai_Node_FindPath(NULL, start, end, heuristic, &cached_length);
+
+        ck_assert_uint_eq(cached->len, path->len);
+        ck_assert(memcmp(cached->data, path->data, path->len * sizeof(ai_node_id_t)) == 0);
+        ck_assert_float_eq(cached_length, length);
+
+        g_array_free(cached, true);
+      }
+
+      g_array_free(path, true);
+      found++;
+    }
+  }
+
+  ck_assert_int_gt(found, 0);
+  ck_assert_int_ge(unreachable, NUM_STARTS);
+
+  printf("%d paths found, %d unreachable: %" G_GINT64_FORMAT "us per search\n",
+         found, unreachable, time / (found + unreachable));
+
+  g_free(dist);
+  g_rand_free(rand);
+}
+
+START_TEST(check_G_Ai_Node_FindPath) {
+
+  path_cache_size.integer = 0;
+
+  CheckFindPath(G_Ai_Node_Cost, true);
+
+} END_TEST
+
+START_TEST(check_G_Ai_Node_FindPath_Heuristic) {
+
+  path_cache_size.integer = 0;
+
+  CheckFindPath(G_Ai_Node_Heuristic, false);
+
+} END_TEST
+
+START_TEST(check_G_Ai_Node_FindPath_Cached) {
+
+  path_cache_size.integer = 256;
+
+  CheckFindPath(G_Ai_Node_Cost, true);
+
+  ck_assert_uint_gt(g_ai_path_cache.hits, 0);
+
+} END_TEST
+
+START_TEST(check_G_Ai_Node_FindPath_Invalid) {
+
+  path_cache_size.integer = 0;
+
+  float length = 1.f;
+
+  ck_assert(G_Ai_Node_FindPath(NULL, AI_NODE_INVALID, 0, G_Ai_Node_Cost, &length) == NULL);
+  ck_assert_float_eq(length, 0.f);
+
+  GArray *path = G_Ai_Node_FindPath(NULL, 0, 0, G_Ai_Node_Cost, &length);
+
+  ck_assert(path != NULL);
+  ck_assert_uint_eq(path->len, 1);
+  ck_assert_float_eq(length, 0.f);
+
+  g_array_free(path, true);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+  Test_Init(argc, argv);
+
+  TCase *tcase = tcase_create("check_g_ai_node");
+  tcase_add_checked_fixture(tcase, setup, teardown);
+  tcase_set_timeout(tcase, 60);
+
+  tcase_add_test(tcase, check_G_Ai_Node_FindPath);
+  tcase_add_test(tcase, check_G_Ai_Node_FindPath_Heuristic);
+  tcase_add_test(tcase, check_G_Ai_Node_FindPath_Cached);
+  tcase_add_test(tcase, check_G_Ai_Node_FindPath_Invalid);
+
+  Suite *suite = suite_create("check_g_ai_node");
+  suite_add_tcase(suite, tcase);
+
+  int32_t failed = Test_Run(suite);
+
+  Test_Shutdown();
+  return failed;
+}
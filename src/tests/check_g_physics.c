@@ -0,0 +1,505 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+#include "collision/cm_local.h"
+
+// the parallel physics statistics are private to the translation unit
+#include "game/default/g_physics.c"
+
+#define NUM_THREADS 4
+#define NUM_WALLS 5
+#define NUM_MOVERS 48
+#define NUM_ENTITIES (NUM_WALLS + NUM_MOVERS)
+#define NUM_FRAMES 64
+
+quetoo_t quetoo;
+
+g_import_t gi;
+g_export_t ge;
+g_level_t g_level;
+g_media_t g_media;
+
+cvar_t *g_parallel_physics;
+cvar_t *sv_max_entities;
+
+static cvar_t parallel_physics;
+static cvar_t max_entities;
+
+/**
+ * @brief The entities of the scene, and whether each is linked into the world.
+ */
+static g_entity_t entities[NUM_ENTITIES];
+static bool linked[NUM_ENTITIES];
+
+/**
+ * @brief The state of an entity at the end of a frame.
+ */
+typedef struct {
+  vec3_t origin, angles;
+  vec3_t velocity, avelocity;
+  const void *ground;
+  vec3_t ground_normal;
+} state_t;
+
+static state_t serial[NUM_FRAMES][NUM_ENTITIES];
+static state_t parallel[NUM_FRAMES][NUM_ENTITIES];
+
+/**
+ * @brief The scene has no water or sounds.
+ */
+void G_MulticastSound(const g_play_sound_t *play, multicast_t to) { }
+void G_Ripple(g_entity_t *ent, const vec3_t pos1, const vec3_t pos2, const float size, bool splash) { }
+
+static void Print(const char *fmt, ...) { }
+static debug_t DebugMask(void) { return 0; }
+static void Debug_(const debug_t debug, const char *func, const char *fmt, ...) { }
+static void Warn_(const char *func, const char *fmt, ...) { }
+
+/**
+ * @brief `gi.Error` fails the test.
+ */
+static void __attribute__((noreturn)) Error_(const char *func, const char *fmt, ...) {
+  char msg[MAX_STRING_CHARS];
+
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(msg, sizeof(msg), fmt, args);
+  va_end(args);
+
+  ck_abort_msg("%s: %s", func, msg);
+  abort();
+}
+
+static cmd_t *AddCmd(const char *name, CmdExecuteFunc function, uint32_t flags, const char *desc) {
+  return NULL;
+}
+
+/**
+ * @brief Links the entity as a box at its origin, as `Sv_LinkEntity` does.
+ */
+static void LinkEntity(g_entity_t *ent) {
+
+  ent->abs_bounds = Box3_Translate(ent->bounds, ent->s.origin);
+  linked[ent->s.number] = true;
+}
+
+static void UnlinkEntity(g_entity_t *ent) {
+  linked[ent->s.number] = false;
+}
+
+static void SetModel(g_entity_t *ent, const char *name) { }
+
+static int32_t BoxContents(const box3_t bounds) {
+  return 0;
+}
+
+/**
+ * @brief Gathers the linked entities intersecting the bounds. The scene has no triggers
+ * or projectiles, so only solid entities are ever gathered.
+ */
+static size_t BoxEntities(const box3_t bounds, g_entity_t **list, const size_t len, uint32_t type) {
+
+  size_t count = 0;
+
+  if (!(type & BOX_COLLIDE)) {
+    return count;
+  }
+
+  for (int32_t i = 0; i < NUM_ENTITIES && count < len; i++) {
+    if (linked[i] && Box3_Intersects(bounds, entities[i].abs_bounds)) {
+      list[count++] = &entities[i];
+    }
+  }
+
+  return count;
+}
+
+/**
+ * @brief Clips the trace to the specified entity with the box hull, as `Sv_ClipTraceToEntity`
+ * does. On the thread pool, this exercises each thread's own box hull.
+ */
+static void ClipTraceToEntity(cm_trace_t *trace, const vec3_t start, const vec3_t end, const box3_t bounds,
+                              const g_entity_t *ent, int32_t contents) {
+
+  const int32_t head_node = Cm_SetBoxHull(ent->abs_bounds, CONTENTS_SOLID);
+
+  const cm_trace_t tr = Cm_BoxTrace(start, end, bounds, head_node, contents);
+
+  if (tr.all_solid || tr.fraction < trace->fraction) {
+    *trace = tr;
+    trace->ent = (g_entity_t *) ent;
+  }
+}
+
+/**
+ * @see Sv_SkipTraceEntity
+ */
+static bool SkipTraceEntity(const g_entity_t *skip, const g_entity_t *ent) {
+
+  if (skip) {
+    if (ent == skip || ent->owner == skip) {
+      return true;
+    }
+    if (skip->owner && (ent == skip->owner || ent->owner == skip->owner)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @see Sv_Trace
+ */
+static cm_trace_t Trace(const vec3_t start, const vec3_t end, const box3_t bounds,
+                        const g_entity_t *skip, int32_t contents) {
+
+  cm_trace_t trace = {
+    .fraction = 1.f,
+    .end = end
+  };
+
+  g_entity_t *ents[NUM_ENTITIES];
+
+  const size_t len = BoxEntities(Cm_TraceBounds(start, end, bounds), ents, lengthof(ents), BOX_COLLIDE);
+  for (size_t i = 0; i < len; i++) {
+    if (!SkipTraceEntity(skip, ents[i])) {
+      ClipTraceToEntity(&trace, start, end, bounds, ents[i], contents);
+    }
+  }
+
+  return trace;
+}
+
+/**
+ * @see Sv_Clip
+ */
+static cm_trace_t Clip(const vec3_t start, const vec3_t end, const box3_t bounds,
+                       const g_entity_t *ent, int32_t contents) {
+
+  cm_trace_t trace = {
+    .fraction = 1.f
+  };
+
+  ClipTraceToEntity(&trace, start, end, bounds, ent, contents);
+
+  return trace;
+}
+
+/**
+ * @brief The state of a `Parallel` invocation.
+ */
+typedef struct {
+  void (*func)(int32_t index, void *data);
+  int32_t count;
+  void *data;
+  SDL_AtomicInt next;
+} parallel_t;
+
+/**
+ * @see Sv_Parallel_Run
+ */
+static void Parallel_Run(void *data) {
+
+  parallel_t *p = data;
+
+  while (true) {
+    const int32_t index = SDL_AddAtomicInt(&p->next, 1);
+    if (index >= p->count) {
+      break;
+    }
+    p->func(index, p->data);
+  }
+}
+
+/**
+ * @see Sv_Parallel
+ */
+static void Parallel(void (*func)(int32_t index, void *data), int32_t count, void *data) {
+
+  if (count <= 0) {
+    return;
+  }
+
+  parallel_t p = {
+    .func = func,
+    .count = count,
+    .data = data
+  };
+
+  thread_t *threads[NUM_THREADS];
+
+  for (int32_t i = 0; i < NUM_THREADS; i++) {
+    threads[i] = Thread_Create(Parallel_Run, &p, THREAD_NONE);
+  }
+
+  Parallel_Run(&p);
+
+  for (int32_t i = 0; i < NUM_THREADS; i++) {
+    Thread_Wait(threads[i]);
+  }
+}
+
+/**
+ * @brief Setup fixture. Allocates an otherwise empty BSP, holding only the box hulls, and
+ * wraps the stubbed import functions with the parallel physics functions.
+ */
+void setup(void) {
+  Mem_Init();
+
+  memset(&cm_bsp, 0, sizeof(cm_bsp));
+
+  cm_bsp.planes = Mem_Malloc(sizeof(cm_bsp_plane_t) * 12 * CM_BOX_HULLS);
+  cm_bsp.nodes = Mem_Malloc(sizeof(cm_bsp_node_t) * 6 * CM_BOX_HULLS);
+  cm_bsp.leafs = Mem_Malloc(sizeof(cm_bsp_leaf_t) * CM_BOX_HULLS);
+  cm_bsp.leaf_brushes = Mem_Malloc(sizeof(int32_t) * CM_BOX_HULLS);
+  cm_bsp.brushes = Mem_Malloc(sizeof(cm_bsp_brush_t) * CM_BOX_HULLS);
+  cm_bsp.brush_sides = Mem_Malloc(sizeof(cm_bsp_brush_side_t) * 6 * CM_BOX_HULLS);
+
+  Cm_InitBoxHull(&cm_bsp);
+
+  cm_bsp.num_nodes = 6 * CM_BOX_HULLS; // appear loaded
+
+  Thread_Init(NUM_THREADS);
+
+  memset(&gi, 0, sizeof(gi));
+
+  gi.Print = Print;
+  gi.DebugMask = DebugMask;
+  gi.Debug_ = Debug_;
+  gi.Warn_ = Warn_;
+  gi.Error_ = Error_;
+  gi.AddCmd = AddCmd;
+  gi.LinkEntity = LinkEntity;
+  gi.UnlinkEntity = UnlinkEntity;
+  gi.SetModel = SetModel;
+  gi.BoxContents = BoxContents;
+  gi.BoxEntities = BoxEntities;
+  gi.Trace = Trace;
+  gi.Clip = Clip;
+  gi.Parallel = Parallel;
+
+  g_parallel_physics = &parallel_physics;
+  sv_max_entities = &max_entities;
+
+  max_entities.integer = NUM_ENTITIES;
+
+  memset(&ge, 0, sizeof(ge));
+
+  for (int32_t i = 0; i < NUM_ENTITIES; i++) {
+    ge.entities[i] = &entities[i];
+  }
+
+  G_Physics_Init();
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+  Thread_Shutdown();
+
+  memset(&cm_bsp, 0, sizeof(cm_bsp));
+
+  Mem_Shutdown();
+}
+
+/**
+ * @brief Spawns a closed arena of box walls, crowded with bouncing and flying boxes
+ * which collide with the walls and with one another.
+ */
+static void SpawnScene(void) {
+
+  memset(entities, 0, sizeof(entities));
+  memset(linked, 0, sizeof(linked));
+
+  memset(&g_level, 0, sizeof(g_level));
+  g_level.gravity = 800;
+
+  const box3_t walls[NUM_WALLS] = {
+    Box3(Vec3(-320.f, -320.f, -32.f), Vec3( 320.f,  320.f,   0.f)),
+    Box3(Vec3(-320.f, -320.f,   0.f), Vec3(-256.f,  320.f, 512.f)),
+    Box3(Vec3( 256.f, -320.f,   0.f), Vec3( 320.f,  320.f, 512.f)),
+    Box3(Vec3(-320.f, -320.f,   0.f), Vec3( 320.f, -256.f, 512.f)),
+    Box3(Vec3(-320.f,  256.f,   0.f), Vec3( 320.f,  320.f, 512.f)),
+  };
+
+  GRand *rand = g_rand_new_with_seed(14);
+
+  for (int32_t i = 0; i < NUM_ENTITIES; i++) {
+    g_entity_t *ent = &entities[i];
+
+    ent->s.number = i;
+    ent->in_use = true;
+    ent->classname = "check_g_physics";
+    ent->solid = SOLID_BOX;
+    ent->mass = 10.f;
+
+    if (i < NUM_WALLS) {
+      ent->move_type = MOVE_TYPE_NONE;
+      ent->bounds = walls[i];
+    } else {
+      const int32_t j = i - NUM_WALLS;
+
+      ent->move_type = (j & 3) ? MOVE_TYPE_BOUNCE : MOVE_TYPE_FLY;
+      ent->bounds = Box3f(16.f, 16.f, 16.f);
+
+      ent->s.origin = Vec3(-192.f + (j % 8) * 48.f, -192.f + (j / 8) * 48.f, 32.f + (j % 3) * 24.f);
+
+      ent->velocity = Vec3((float) g_rand_double_range(rand, -400.0, 400.0),
+                           (float) g_rand_double_range(rand, -400.0, 400.0),
+                           (float) g_rand_double_range(rand, -200.0, 400.0));
+
+      ent->avelocity = Vec3(0.f, (float) g_rand_double_range(rand, -360.0, 360.0), 0.f);
+
+      if (j % 5 == 0) { // owned entities skip their owner, and their siblings
+        ent->owner = &entities[NUM_WALLS + j + 1];
+      }
+    }
+
+    gi.LinkEntity(ent);
+  }
+
+  g_rand_free(rand);
+}
+
+/**
+ * @brief Runs the scene for `NUM_FRAMES` frames, as `G_Frame` does, recording the state
+ * of every entity at the end of each frame.
+ */
+static void RunScene(int32_t mode, state_t states[NUM_FRAMES][NUM_ENTITIES]) {
+
+  parallel_physics.integer = mode;
+
+  SpawnScene();
+
+  memset(&g_physics.stats, 0, sizeof(g_physics.stats));
+
+  for (int32_t frame = 0; frame < NUM_FRAMES; frame++) {
+
+    g_level.frame_num++;
+    g_level.time += QUETOO_TICK_MILLIS;
+
+    G_Physics_BeginFrame();
+
+    G_ForEachEntity(ent, {
+      G_RunEntity(ent);
+    });
+
+    G_Physics_EndFrame();
+
+    for (int32_t i = 0; i < NUM_ENTITIES; i++) {
+      const g_entity_t *ent = &entities[i];
+
+      states[frame][i] = (state_t) {
+        .origin = ent->s.origin,
+        .angles = ent->s.angles,
+        .velocity = ent->velocity,
+        .avelocity = ent->avelocity,
+        .ground = ent->ground.ent,
+        .ground_normal = ent->ground.plane.normal
+      };
+    }
+  }
+}
+
+/**
+ * @brief Asserts that the parallel states are exactly those of the serial pass.
+ */
+static void AssertStatesEqual(void) {
+
+  for (int32_t frame = 0; frame < NUM_FRAMES; frame++) {
+    for (int32_t i = 0; i < NUM_ENTITIES; i++) {
+
+      const state_t *a = &serial[frame][i];
+      const state_t *b = &parallel[frame][i];
+
+      ck_assert_msg(G_Physics_Vec3Equal(a->origin, b->origin), "frame %d entity %d origin", frame, i);
+      ck_assert_msg(G_Physics_Vec3Equal(a->angles, b->angles), "frame %d entity %d angles", frame, i);
+      ck_assert_msg(G_Physics_Vec3Equal(a->velocity, b->velocity), "frame %d entity %d velocity", frame, i);
+      ck_assert_msg(G_Physics_Vec3Equal(a->avelocity, b->avelocity), "frame %d entity %d avelocity", frame, i);
+      ck_assert_msg(a->ground == b->ground, "frame %d entity %d ground", frame, i);
+      ck_assert_msg(G_Physics_Vec3Equal(a->ground_normal, b->ground_normal), "frame %d entity %d ground normal", frame, i);
+    }
+  }
+}
+
+START_TEST(check_G_Physics_Parallel) {
+
+  RunScene(0, serial);
+
+  ck_assert_int_eq(0, g_physics.stats.predicted);
+
+  // the entities must actually move and collide for the comparison to mean anything
+  int32_t moved = 0, grounded = 0;
+  for (int32_t i = NUM_WALLS; i < NUM_ENTITIES; i++) {
+    if (!G_Physics_Vec3Equal(serial[0][i].origin, serial[NUM_FRAMES - 1][i].origin)) {
+      moved++;
+    }
+    if (serial[NUM_FRAMES - 1][i].ground) {
+      grounded++;
+    }
+  }
+  ck_assert_int_gt(moved, NUM_MOVERS / 2);
+  ck_assert_int_gt(grounded, 0);
+
+  // consume the predictions, asserting the outcome is that of the serial pass
+  RunScene(1, parallel);
+
+  ck_assert_int_gt(g_physics.stats.predicted, 0);
+  ck_assert_int_gt(g_physics.stats.used, 0);
+  ck_assert_int_gt(g_physics.stats.rejected, 0);
+
+  AssertStatesEqual();
+
+  // re-trace every consumed prediction, asserting each trace is identical
+  RunScene(2, parallel);
+
+  ck_assert_int_gt(g_physics.stats.used, 0);
+  ck_assert_int_eq(0, g_physics.stats.mismatched);
+
+  AssertStatesEqual();
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+  Test_Init(argc, argv);
+
+  TCase *tcase = tcase_create("check_g_physics");
+  tcase_add_checked_fixture(tcase, setup, teardown);
+  tcase_set_timeout(tcase, 60);
+
+  tcase_add_test(tcase, check_G_Physics_Parallel);
+
+  Suite *suite = suite_create("check_g_physics");
+  suite_add_tcase(suite, tcase);
+
+  int32_t failed = Test_Run(suite);
+
+  Test_Shutdown();
+  return failed;
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+
+quetoo_t quetoo;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+  Mem_Init();
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+  Mem_Shutdown();
+}
+
+START_TEST(check_Heap_PushPop) {
+  heap_t heap;
+  Heap_Init(&heap, 1024);
+
+  GRand *rand = g_rand_new_with_seed(1);
+
+  for (int32_t i = 0; i < 1024; i++) {
+    Heap_Push(&heap, i, (float) g_rand_double_range(rand, -1000.0, 1000.0));
+  }
+
+  ck_assert_int_eq(1024, heap.size);
+
+  float last = -FLT_MAX;
+  for (int32_t i = 0; i < 1024; i++) {
+    float priority;
+    const int32_t key = Heap_Pop(&heap, &priority);
+
+    ck_assert_int_ge(key, 0);
+    ck_assert(priority >= last);
+    ck_assert(!Heap_Contains(&heap, key));
+
+    last = priority;
+  }
+
+  ck_assert(Heap_IsEmpty(&heap));
+  ck_assert_int_eq(-1, Heap_Pop(&heap, NULL));
+
+  g_rand_free(rand);
+  Heap_Free(&heap);
+
+} END_TEST
+
+START_TEST(check_Heap_DecreaseKey) {
+  heap_t heap;
+  Heap_Init(&heap, 8);
+
+  Heap_Push(&heap, 0, 3.f);
+  Heap_Push(&heap, 1, 2.f);
+  Heap_Push(&heap, 2, 1.f);
+
+  Heap_Push(&heap, 0, 0.f);
+
+  ck_assert_int_eq(3, heap.size);
+  ck_assert_int_eq(0, Heap_Pop(&heap, NULL));
+  ck_assert_int_eq(2, Heap_Pop(&heap, NULL));
+  ck_assert_int_eq(1, Heap_Pop(&heap, NULL));
+
+  Heap_Push(&heap, 5, 1.f);
+  Heap_Push(&heap, 6, 2.f);
+
+  Heap_Clear(&heap);
+
+  ck_assert(Heap_IsEmpty(&heap));
+  ck_assert(!Heap_Contains(&heap, 5));
+  ck_assert(!Heap_Contains(&heap, 6));
+
+  Heap_Reserve(&heap, 4096);
+  ck_assert_int_eq(4096, heap.capacity);
+
+  Heap_Push(&heap, 4095, 1.f);
+  ck_assert(Heap_Contains(&heap, 4095));
+
+  Heap_Free(&heap);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+  Test_Init(argc, argv);
+
+  TCase *tcase = tcase_create("check_heap");
+  tcase_add_checked_fixture(tcase, setup, teardown);
+  tcase_set_timeout(tcase, 60);
+
+  tcase_add_test(tcase, check_Heap_PushPop);
+  tcase_add_test(tcase, check_Heap_DecreaseKey);
+
+  Suite *suite = suite_create("check_heap");
+  suite_add_tcase(suite, tcase);
+
+  int32_t failed = Test_Run(suite);
+
+  Test_Shutdown();
+  return failed;
+}
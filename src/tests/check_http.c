@@ -22,8 +22,11 @@
 #include "tests.h"
 
 #include "net/net_http.h"
+#include "net/net_http_server.h"
 
+#include <SDL3/SDL_atomic.h>
 #include <SDL3/SDL_thread.h>
+#include <SDL3/SDL_timer.h>
 
 quetoo_t quetoo;
 
@@ -246,6 +249,97 @@ START_TEST(check_Net_HttpFormatResponse_large_content) {
 
 } END_TEST
 
+// -- Net_HttpParseHeader --
+
+START_TEST(check_Net_HttpParseHeader) {
+
+	const char *request = "GET /maps/test.bsp HTTP/1.0\r\n"
+	                      "Range: bytes=0-99\r\n"
+	                      "if-range:  \"1f-2e\" \r\n"
+	                      "\r\n"
+	                      "ETag: \"body\"\r\n";
+
+	char value[64];
+
+	ck_assert(Net_HttpParseHeader(request, "Range", value, sizeof(value)));
+	ck_assert_str_eq(value, "bytes=0-99");
+
+	ck_assert(Net_HttpParseHeader(request, "If-Range", value, sizeof(value)));
+	ck_assert_str_eq(value, "\"1f-2e\"");
+
+	ck_assert(!Net_HttpParseHeader(request, "Ran", value, sizeof(value)));
+	ck_assert(!Net_HttpParseHeader(request, "ETag", value, sizeof(value)));
+	ck_assert(!Net_HttpParseHeader(request, "Range", value, 4));
+
+} END_TEST
+
+// -- Net_HttpParseRange --
+
+START_TEST(check_Net_HttpParseRange) {
+
+	int64_t first, last;
+
+	ck_assert_int_eq(Net_HttpParseRange("bytes=0-99", 1000, &first, &last), 206);
+	ck_assert_int_eq(first, 0);
+	ck_assert_int_eq(last, 99);
+
+	ck_assert_int_eq(Net_HttpParseRange("bytes=500-", 1000, &first, &last), 206);
+	ck_assert_int_eq(first, 500);
+	ck_assert_int_eq(last, 999);
+
+	ck_assert_int_eq(Net_HttpParseRange("bytes=900-2000", 1000, &first, &last), 206);
+	ck_assert_int_eq(first, 900);
+	ck_assert_int_eq(last, 999);
+
+	ck_assert_int_eq(Net_HttpParseRange("bytes=-100", 1000, &first, &last), 206);
+	ck_assert_int_eq(first, 900);
+	ck_assert_int_eq(last, 999);
+
+	ck_assert_int_eq(Net_HttpParseRange("bytes=-2000", 1000, &first, &last), 206);
+	ck_assert_int_eq(first, 0);
+	ck_assert_int_eq(last, 999);
+
+	ck_assert_int_eq(Net_HttpParseRange("bytes=1000-", 1000, &first, &last), 416);
+	ck_assert_int_eq(Net_HttpParseRange("bytes=-0", 1000, &first, &last), 416);
+
+	// ignored ranges leave the outputs untouched, so that the entire file is sent
+	const char *ignored[] = {
+		"bytes=0-99,200-299",
+		"bytes=99-0",
+		"bytes=5-abc",
+		"items=0-99",
+		"bytes=x-",
+		"bytes=-abc",
+		"bytes=5-6x",
+	};
+
+	for (size_t i = 0; i < lengthof(ignored); i++) {
+		first = 0;
+		last = 999;
+
+		ck_assert_msg(Net_HttpParseRange(ignored[i], 1000, &first, &last) == 200, "%s", ignored[i]);
+		ck_assert_int_eq(first, 0);
+		ck_assert_int_eq(last, 999);
+	}
+
+} END_TEST
+
+// -- Net_HttpFormatETag --
+
+START_TEST(check_Net_HttpFormatETag) {
+
+	char a[NET_HTTP_ETAG_SIZE], b[NET_HTTP_ETAG_SIZE], c[NET_HTTP_ETAG_SIZE];
+
+	Net_HttpFormatETag(1024, 1700000000, a, sizeof(a));
+	Net_HttpFormatETag(1024, 1700000001, b, sizeof(b));
+	Net_HttpFormatETag(1025, 1700000000, c, sizeof(c));
+
+	ck_assert(a[0] == '"' && a[strlen(a) - 1] == '"');
+	ck_assert_str_ne(a, b);
+	ck_assert_str_ne(a, c);
+
+} END_TEST
+
 // -- End-to-end round-trip test --
 
 typedef struct {
@@ -356,6 +450,304 @@ START_TEST(check_Net_Http_roundtrip) {
 
 } END_TEST
 
+// -- Net_HttpServer load test --
+
+#define HTTP_LOAD_DOWNLOADS 24
+#define HTTP_LOAD_FILE_SIZE (4 << 20)
+
+typedef struct {
+	const byte *payload;
+	SDL_AtomicInt completed;
+	SDL_AtomicInt failed;
+} http_load_t;
+
+static void http_load_callback(int32_t status, void *body, size_t length, void *user_data) {
+	http_load_t *load = user_data;
+
+	if (status != 200 || length != HTTP_LOAD_FILE_SIZE || memcmp(body, load->payload, length)) {
+		SDL_AddAtomicInt(&load->failed, 1);
+	}
+
+	SDL_AddAtomicInt(&load->completed, 1);
+}
+
+START_TEST(check_Net_HttpServer_load) {
+
+	Net_Init();
+
+	// write a payload to the virtual filesystem for the server to share
+	byte *payload = Mem_Malloc(HTTP_LOAD_FILE_SIZE);
+	for (int32_t i = 0; i < HTTP_LOAD_FILE_SIZE; i++) {
+		payload[i] = (byte) (i * 2654435761u >> 24);
+	}
+
+	file_t *file = Fs_OpenWrite("check_http_load.bin");
+	ck_assert(file != NULL);
+	ck_assert_int_eq(Fs_Write(file, payload, 1, HTTP_LOAD_FILE_SIZE), HTTP_LOAD_FILE_SIZE);
+	ck_assert(Fs_Close(file));
+
+	const in_port_t port = 39982;
+
+	net_http_server_t *server = Net_HttpServerCreate(&(const net_http_server_config_t) {
+		.port = port,
+		.max_connections = HTTP_LOAD_DOWNLOADS,
+		.cache_size = HTTP_LOAD_FILE_SIZE
+	});
+	ck_assert_msg(server != NULL, "Net_HttpServerCreate failed on port %d", port);
+
+	char url[128];
+	g_snprintf(url, sizeof(url), "http://127.0.0.1:%d/check_http_load.bin", port);
+
+	http_load_t load = { .payload = payload };
+
+	const uint64_t start = SDL_GetTicks();
+
+	for (int32_t i = 0; i < HTTP_LOAD_DOWNLOADS; i++) {
+		Net_HttpGetAsync(url, http_load_callback, &load);
+	}
+
+	while (SDL_GetAtomicInt(&load.completed) < HTTP_LOAD_DOWNLOADS) {
+		SDL_Delay(1);
+	}
+
+	const uint64_t millis = Maxi(1, (int32_t) (SDL_GetTicks() - start));
+
+	ck_assert_int_eq(SDL_GetAtomicInt(&load.failed), 0);
+
+	net_http_server_stats_t stats;
+	Net_HttpServerStats(server, &stats);
+
+	ck_assert_int_eq(stats.responses, HTTP_LOAD_DOWNLOADS);
+	ck_assert_int_eq(stats.bytes_sent, (int64_t) HTTP_LOAD_DOWNLOADS * HTTP_LOAD_FILE_SIZE);
+	ck_assert_int_eq(stats.cache_misses, 1);
+
+	printf("%d concurrent downloads of %d bytes in %" PRIu64 "ms (%.1f MB/s)\n",
+	       HTTP_LOAD_DOWNLOADS, HTTP_LOAD_FILE_SIZE, millis,
+	       (double) stats.bytes_sent / (1 << 20) / (millis / 1000.0));
+
+	Net_HttpServerDestroy(server);
+
+	Mem_Free(payload);
+
+	Net_Shutdown();
+
+} END_TEST
+
+// -- Net_HttpServer range test --
+
+#define HTTP_RANGE_FILE_SIZE (256 << 10)
+
+static bool http_range_write(const net_http_response_t *response, const void *data, size_t length, void *user_data) {
+	g_byte_array_append(user_data, data, (guint) length);
+	return true;
+}
+
+/**
+ * @brief Sends the specified raw request, and reads the response until the server closes
+ * the connection, so that a response which never completes times out.
+ */
+static void http_raw_request(const net_addr_t *addr, const char *request, GByteArray *response) {
+
+	const int32_t sock = Net_Connect(addr, 2000);
+	ck_assert(sock != -1);
+
+	ck_assert_int_eq(Net_Send(sock, request, strlen(request)), (ssize_t) strlen(request));
+
+	byte buffer[0x4000];
+	ssize_t received;
+
+	while ((received = Net_Recv(sock, buffer, sizeof(buffer))) > 0) {
+		g_byte_array_append(response, buffer, (guint) received);
+	}
+
+	ck_assert_msg(received == 0, "Response did not complete");
+
+	Net_CloseSocket(sock);
+}
+
+START_TEST(check_Net_HttpServer_range) {
+
+	Net_Init();
+
+	byte *payload = Mem_Malloc(HTTP_RANGE_FILE_SIZE);
+	for (int32_t i = 0; i < HTTP_RANGE_FILE_SIZE; i++) {
+		payload[i] = (byte) (i * 2654435761u >> 24);
+	}
+
+	file_t *file = Fs_OpenWrite("check_http_range.bin");
+	ck_assert(file != NULL);
+	ck_assert_int_eq(Fs_Write(file, payload, 1, HTTP_RANGE_FILE_SIZE), HTTP_RANGE_FILE_SIZE);
+	ck_assert(Fs_Close(file));
+
+	const in_port_t port = 39983;
+
+	net_http_server_t *server = Net_HttpServerCreate(&(const net_http_server_config_t) {
+		.port = port
+	});
+	ck_assert_msg(server != NULL, "Net_HttpServerCreate failed on port %d", port);
+
+	net_addr_t addr;
+	ck_assert(Net_StringToNetaddr(va("127.0.0.1:%d", port), &addr));
+
+	GByteArray *body = g_byte_array_new();
+	net_http_response_t response;
+
+	// a range in the middle of the file
+	int32_t status = Net_HttpGetRange(&addr, "check_http_range.bin", 1000, 5000, NULL, http_range_write, body, &response);
+
+	ck_assert_int_eq(status, 206);
+	ck_assert_int_eq(response.offset, 1000);
+	ck_assert_int_eq(response.length, 5000);
+	ck_assert_int_eq(response.size, HTTP_RANGE_FILE_SIZE);
+	ck_assert(strlen(response.etag) > 2);
+	ck_assert_uint_eq(body->len, 5000);
+	ck_assert(memcmp(body->data, payload + 1000, 5000) == 0);
+
+	char etag[NET_HTTP_ETAG_SIZE];
+	g_strlcpy(etag, response.etag, sizeof(etag));
+
+	// resuming with a matching entity tag yields the remainder of the file
+	g_byte_array_set_size(body, 0);
+	status = Net_HttpGetRange(&addr, "check_http_range.bin", 6000, 0, etag, http_range_write, body, &response);
+
+	ck_assert_int_eq(status, 206);
+	ck_assert_int_eq(response.offset, 6000);
+	ck_assert_str_eq(response.etag, etag);
+	ck_assert_uint_eq(body->len, HTTP_RANGE_FILE_SIZE - 6000);
+	ck_assert(memcmp(body->data, payload + 6000, body->len) == 0);
+
+	// resuming with a stale entity tag yields the entire file
+	g_byte_array_set_size(body, 0);
+	status = Net_HttpGetRange(&addr, "check_http_range.bin", 6000, 0, "\"stale\"", http_range_write, body, &response);
+
+	ck_assert_int_eq(status, 200);
+	ck_assert_int_eq(response.offset, 0);
+	ck_assert_uint_eq(body->len, HTTP_RANGE_FILE_SIZE);
+	ck_assert(memcmp(body->data, payload, body->len) == 0);
+
+	// a range beyond the end of the file is not satisfiable
+	g_byte_array_set_size(body, 0);
+	status = Net_HttpGetRange(&addr, "check_http_range.bin", HTTP_RANGE_FILE_SIZE, 0, NULL, http_range_write, body, &response);
+
+	ck_assert_int_eq(status, 416);
+	ck_assert_uint_eq(body->len, 0);
+
+	// malformed ranges are ignored, and the entire file is sent
+	const char *malformed[] = { "bytes=99-0", "bytes=5-abc" };
+
+	for (size_t i = 0; i < lengthof(malformed); i++) {
+		g_byte_array_set_size(body, 0);
+
+		http_raw_request(&addr, va("GET /check_http_range.bin HTTP/1.0\r\nRange: %s\r\n\r\n", malformed[i]), body);
+		g_byte_array_append(body, (const guint8 *) "", 1);
+
+		const char *header_end = strstr((const char *) body->data, "\r\n\r\n");
+		ck_assert(header_end != NULL);
+
+		ck_assert(g_str_has_prefix((const char *) body->data, "HTTP/1.0 200 "));
+		ck_assert(strstr((const char *) body->data, va("Content-Length: %d\r\n", HTTP_RANGE_FILE_SIZE)));
+
+		const byte *content = (const byte *) header_end + 4;
+		ck_assert_int_eq(body->data + body->len - 1 - content, HTTP_RANGE_FILE_SIZE);
+		ck_assert(memcmp(content, payload, HTTP_RANGE_FILE_SIZE) == 0);
+	}
+
+	g_byte_array_free(body, true);
+
+	Net_HttpServerDestroy(server);
+
+	Mem_Free(payload);
+
+	Net_Shutdown();
+
+} END_TEST
+
+// -- Net_HttpServer truncate test --
+
+#define HTTP_TRUNCATE_FILE_SIZE (16 << 20)
+
+START_TEST(check_Net_HttpServer_truncate) {
+
+	Net_Init();
+
+	byte *payload = Mem_Malloc(HTTP_TRUNCATE_FILE_SIZE);
+	for (int32_t i = 0; i < HTTP_TRUNCATE_FILE_SIZE; i++) {
+		payload[i] = (byte) (i * 2654435761u >> 24);
+	}
+
+	file_t *file = Fs_OpenWrite("check_http_truncate.bin");
+	ck_assert(file != NULL);
+	ck_assert_int_eq(Fs_Write(file, payload, 1, HTTP_TRUNCATE_FILE_SIZE), HTTP_TRUNCATE_FILE_SIZE);
+	ck_assert(Fs_Close(file));
+
+	const in_port_t port = 39984;
+
+	net_http_server_t *server = Net_HttpServerCreate(&(const net_http_server_config_t) {
+		.port = port
+	});
+	ck_assert_msg(server != NULL, "Net_HttpServerCreate failed on port %d", port);
+
+	net_addr_t addr;
+	ck_assert(Net_StringToNetaddr(va("127.0.0.1:%d", port), &addr));
+
+	const char *request = "GET /check_http_truncate.bin HTTP/1.0\r\n\r\n";
+
+	const int32_t sock = Net_Connect(&addr, 2000);
+	ck_assert(sock != -1);
+
+	ck_assert_int_eq(Net_Send(sock, request, strlen(request)), (ssize_t) strlen(request));
+
+	GByteArray *response = g_byte_array_new();
+
+	byte buffer[0x4000];
+	ssize_t received = Net_Recv(sock, buffer, sizeof(buffer));
+	ck_assert(received > 0);
+
+	g_byte_array_append(response, buffer, (guint) received);
+
+	// truncate and rewrite the file in place while it is being served
+	file = Fs_OpenWrite("check_http_truncate.bin");
+	ck_assert(file != NULL);
+	ck_assert_int_eq(Fs_Write(file, "truncated", 1, 9), 9);
+	ck_assert(Fs_Close(file));
+
+	while ((received = Net_Recv(sock, buffer, sizeof(buffer))) > 0) {
+		g_byte_array_append(response, buffer, (guint) received);
+	}
+
+	ck_assert_msg(received == 0, "Response did not complete");
+
+	Net_CloseSocket(sock);
+
+	// the response in flight completes with the contents the file had when it was requested
+	g_byte_array_append(response, (const guint8 *) "", 1);
+
+	const char *header_end = strstr((const char *) response->data, "\r\n\r\n");
+	ck_assert(header_end != NULL);
+
+	const byte *content = (const byte *) header_end + 4;
+	ck_assert_int_eq(response->data + response->len - 1 - content, HTTP_TRUNCATE_FILE_SIZE);
+	ck_assert(memcmp(content, payload, HTTP_TRUNCATE_FILE_SIZE) == 0);
+
+	// and the next request is served the rewritten file
+	g_byte_array_set_size(response, 0);
+
+	http_raw_request(&addr, request, response);
+	g_byte_array_append(response, (const guint8 *) "", 1);
+
+	ck_assert(g_str_has_prefix((const char *) response->data, "HTTP/1.0 200 "));
+	ck_assert(g_str_has_suffix((const char *) response->data, "\r\n\r\ntruncated"));
+
+	g_byte_array_free(response, true);
+
+	Net_HttpServerDestroy(server);
+
+	Mem_Free(payload);
+
+	Net_Shutdown();
+
+} END_TEST
+
 /**
  * @brief Test entry point.
  */
@@ -384,6 +776,10 @@ int32_t main(int32_t argc, char **argv) {
 	tcase_add_test(tcase, check_Net_HttpFormatResponse_no_content);
 	tcase_add_test(tcase, check_Net_HttpFormatResponse_large_content);
 
+	tcase_add_test(tcase, check_Net_HttpParseHeader);
+	tcase_add_test(tcase, check_Net_HttpParseRange);
+	tcase_add_test(tcase, check_Net_HttpFormatETag);
+
 	Suite *suite = suite_create("check_http");
 	suite_add_tcase(suite, tcase);
 
@@ -391,6 +787,9 @@ int32_t main(int32_t argc, char **argv) {
 	tcase_add_checked_fixture(tcase, setup, teardown);
 	tcase_set_timeout(tcase, 10);
 	tcase_add_test(tcase, check_Net_Http_roundtrip);
+	tcase_add_test(tcase, check_Net_HttpServer_load);
+	tcase_add_test(tcase, check_Net_HttpServer_range);
+	tcase_add_test(tcase, check_Net_HttpServer_truncate);
 	suite_add_tcase(suite, tcase);
 
 	// Run with CK_NOFORK because Net_HttpGet uses libcurl, which is not fork-safe
@@ -19,6 +19,8 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <sys/resource.h>
+
 #include "tests.h"
 
 #define main Ms_Main
@@ -33,6 +35,8 @@ void setup(void) {
   Mem_Init();
 
   Fs_Init(FS_NONE);
+
+  Ms_Init();
 }
 
 /**
@@ -40,13 +44,15 @@ void setup(void) {
  */
 void teardown(void) {
 
+  Ms_Shutdown();
+
   Fs_Shutdown();
 
   Mem_Shutdown();
 }
 
 START_TEST(check_Ms_AddServer) {
-  ck_assert_int_eq(g_list_length(ms_servers), 0);
+  ck_assert_int_eq(g_hash_table_size(ms_servers), 0);
 
   struct sockaddr_in addr;
   memset(&addr, 0, sizeof(addr));
@@ -56,21 +62,22 @@ START_TEST(check_Ms_AddServer) {
   addr.sin_port = htons(PORT_SERVER);
 
   Ms_AddServer(&addr);
-  ck_assert_int_eq(g_list_length(ms_servers), 1);
+  ck_assert_int_eq(g_hash_table_size(ms_servers), 1);
 
-  ms_server_t *server = g_list_nth_data(ms_servers, 0);
+  ms_server_t *server = Ms_GetServer(&addr);
+  ck_assert_msg(server != NULL, "Server was NULL");
   ck_assert_msg(server->addr.sin_addr.s_addr == addr.sin_addr.s_addr, "Corrupt server address");
 
   Ms_AddServer(&addr);
-  ck_assert_int_eq(g_list_length(ms_servers), 1);
+  ck_assert_int_eq(g_hash_table_size(ms_servers), 1);
 
   *(in_addr_t *) &addr.sin_addr = inet_addr("192.168.1.2");
 
   Ms_AddServer(&addr);
-  ck_assert_int_eq(g_list_length(ms_servers), 2);
+  ck_assert_int_eq(g_hash_table_size(ms_servers), 2);
 
   Ms_RemoveServer(&addr);
-  ck_assert_int_eq(g_list_length(ms_servers), 1);
+  ck_assert_int_eq(g_hash_table_size(ms_servers), 1);
 
   ms_server_t *s = Ms_GetServer(&addr);
   ck_assert_msg(!s, "Server was not NULL");
@@ -102,6 +109,366 @@ START_TEST(check_Ms_BlacklistServer) {
 
 } END_TEST
 
+/**
+ * @brief Dispatches a message from the specified address, as the receive loop would.
+ */
+static void Ms_TestMessage(struct sockaddr_in *from, const char *fmt, ...) {
+  char buffer[1024] = "\xFF\xFF\xFF\xFF";
+
+  va_list args;
+  va_start(args, fmt);
+  g_vsnprintf(buffer + 4, sizeof(buffer) - 4, fmt, args);
+  va_end(args);
+
+  Ms_ParseMessage(from, buffer);
+}
+
+/**
+ * @brief Initializes a loopback address with the specified port.
+ */
+static void Ms_TestAddress(struct sockaddr_in *addr, in_port_t port) {
+
+  memset(addr, 0, sizeof(*addr));
+
+  addr->sin_family = AF_INET;
+  addr->sin_addr.s_addr = inet_addr("127.0.0.1");
+  addr->sin_port = htons(port);
+}
+
+START_TEST(check_Ms_Frame) {
+  struct sockaddr_in addr;
+
+  Ms_TestAddress(&addr, PORT_SERVER);
+  Ms_TestMessage(&addr, "ping\n");
+  Ms_TestMessage(&addr, "ack\n");
+
+  ms_server_t *server = Ms_GetServer(&addr);
+  ck_assert(server != NULL);
+  ck_assert(server->validated);
+
+  const time_t now = server->last_heartbeat;
+
+  // within the heartbeat timeout, the server is left alone
+  Ms_Frame(now + MS_HEARTBEAT_TIMEOUT);
+  ck_assert_int_eq(server->queued_pings, 0);
+
+  // a heartbeat defers the timeout
+  server->last_heartbeat = now + 10;
+  Ms_Frame(now + MS_HEARTBEAT_TIMEOUT + 1);
+  ck_assert_int_eq(server->queued_pings, 0);
+
+  // once it expires, the server is pinged at regular intervals
+  time_t frame = now + 10 + MS_HEARTBEAT_TIMEOUT + 1;
+  Ms_Frame(frame);
+  ck_assert_int_eq(server->queued_pings, 1);
+
+  Ms_Frame(frame + MS_PING_INTERVAL - 1);
+  ck_assert_int_eq(server->queued_pings, 1);
+
+  for (int32_t i = 2; i <= MS_MAX_QUEUED_PINGS + 1; i++) {
+    frame += MS_PING_INTERVAL;
+    Ms_Frame(frame);
+    ck_assert_int_eq(server->queued_pings, i);
+  }
+
+  // until it is dropped
+  Ms_Frame(frame + MS_PING_INTERVAL);
+  ck_assert(Ms_GetServer(&addr) == NULL);
+  ck_assert_int_eq(g_hash_table_size(ms_servers), 0);
+
+} END_TEST
+
+#define MS_LOAD_SERVERS 2000
+#define MS_LOAD_CLIENTS 16
+#define MS_LOAD_QUERIES 20000
+
+/**
+ * @brief The master reads its socket after this many messages are sent to it, as it would
+ * once `select` returns, so that its receive buffer does not overflow.
+ */
+#define MS_LOAD_BATCH 64
+
+/**
+ * @brief The load generator's simulated servers and clients, each with its own socket.
+ */
+static struct {
+  struct sockaddr_in master;
+
+  int32_t servers[MS_LOAD_SERVERS];
+  struct sockaddr_in server_addrs[MS_LOAD_SERVERS];
+  int32_t num_servers;
+
+  int32_t clients[MS_LOAD_CLIENTS];
+
+  /**
+   * @brief The number of messages sent since the master last read its socket.
+   */
+  int32_t pending;
+} ms_load;
+
+/**
+ * @brief Opens a nonblocking UDP socket on an ephemeral loopback port.
+ */
+static int32_t Ms_LoadSocket(struct sockaddr_in *addr) {
+
+  const int32_t sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  ck_assert_int_ne(sock, -1);
+
+  Ms_TestAddress(addr, 0);
+  ck_assert_int_eq(bind(sock, (struct sockaddr *) addr, sizeof(*addr)), 0);
+
+  socklen_t len = sizeof(*addr);
+  ck_assert_int_eq(getsockname(sock, (struct sockaddr *) addr, &len), 0);
+
+  Net_SetNonBlocking(sock, true);
+  return sock;
+}
+
+/**
+ * @brief Reads and dispatches the messages sent to the master.
+ */
+static void Ms_LoadFlush(void) {
+
+  Ms_ReadPackets();
+
+  ms_load.pending = 0;
+}
+
+/**
+ * @brief Sends a message to the master from the specified socket.
+ */
+static void Ms_LoadSend(int32_t sock, const char *fmt, ...) {
+  char buffer[1024] = "\xFF\xFF\xFF\xFF";
+
+  va_list args;
+  va_start(args, fmt);
+  const size_t len = 4 + g_vsnprintf(buffer + 4, sizeof(buffer) - 4, fmt, args);
+  va_end(args);
+
+  const ssize_t sent = sendto(sock, buffer, len, 0, (struct sockaddr *) &ms_load.master, sizeof(ms_load.master));
+  ck_assert_int_eq(sent, len);
+
+  if (++ms_load.pending == MS_LOAD_BATCH) {
+    Ms_LoadFlush();
+  }
+}
+
+/**
+ * @brief Reads all messages pending on the specified socket.
+ * @param command The command which every message must hold.
+ * @param size The size which every message must be, or 0.
+ * @return The number of messages read.
+ */
+static int32_t Ms_LoadReceive(int32_t sock, const char *command, size_t size) {
+  static char buffer[0x10000];
+
+  int32_t count = 0;
+  ssize_t len;
+
+  while ((len = recv(sock, buffer, sizeof(buffer), 0)) != -1) {
+
+    ck_assert_int_gt(len, 4);
+    ck_assert(!strncmp(buffer + 4, command, strlen(command)));
+
+    if (size) {
+      ck_assert_int_eq(len, size);
+    }
+
+    count++;
+  }
+
+  return count;
+}
+
+/**
+ * @brief A load generator, which registers thousands of simulated servers over loopback
+ * sockets, issues heartbeats and server list queries, and then lets the servers go quiet,
+ * so that the timer wheel pings them, and drops the half which do not answer.
+ */
+START_TEST(check_Ms_Load) {
+
+  // every simulated server needs a socket, since servers are keyed by address and port
+  struct rlimit limit;
+  ck_assert_int_eq(getrlimit(RLIMIT_NOFILE, &limit), 0);
+
+  limit.rlim_cur = limit.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &limit);
+  ck_assert_int_eq(getrlimit(RLIMIT_NOFILE, &limit), 0);
+
+  const rlim_t reserved = MS_LOAD_CLIENTS + 64;
+
+  if (limit.rlim_cur < MS_LOAD_SERVERS + reserved) {
+    ck_assert_int_gt(limit.rlim_cur, reserved + 2);
+    ms_load.num_servers = (int32_t) (limit.rlim_cur - reserved) & ~1;
+    printf("Limited to %d servers by RLIMIT_NOFILE\n", ms_load.num_servers);
+  } else {
+    ms_load.num_servers = MS_LOAD_SERVERS;
+  }
+
+  const int32_t num_servers = ms_load.num_servers;
+
+  ms_sock = Ms_LoadSocket(&ms_load.master);
+
+  for (int32_t i = 0; i < num_servers; i++) {
+    ms_load.servers[i] = Ms_LoadSocket(&ms_load.server_addrs[i]);
+  }
+
+  for (int32_t i = 0; i < MS_LOAD_CLIENTS; i++) {
+    struct sockaddr_in addr;
+    ms_load.clients[i] = Ms_LoadSocket(&addr);
+  }
+
+  // half of the servers speak the current protocol
+  const char *status = "\\sv_hostname\\Load\\sv_protocol\\%d\\sv_max_clients\\16\\sv_map\\edge\n";
+
+  #define PROTOCOL(i) ((i) & 1 ? PROTOCOL_MAJOR : PROTOCOL_MAJOR + 1)
+
+  gint64 start = g_get_monotonic_time();
+
+  for (int32_t i = 0; i < num_servers; i++) {
+    Ms_LoadSend(ms_load.servers[i], "ping\n");
+    Ms_LoadSend(ms_load.servers[i], "heartbeat\n%s", va(status, PROTOCOL(i)));
+    Ms_LoadSend(ms_load.servers[i], "ack\n");
+  }
+
+  Ms_LoadFlush();
+
+  const gint64 register_time = g_get_monotonic_time() - start;
+
+  ck_assert_int_eq(g_hash_table_size(ms_servers), num_servers);
+
+  for (int32_t i = 0; i < num_servers; i++) {
+    const ms_server_t *server = Ms_GetServer(&ms_load.server_addrs[i]);
+    ck_assert(server != NULL);
+    ck_assert(server->validated);
+    ck_assert_int_eq(server->protocol, PROTOCOL(i));
+
+    // the ping and the heartbeat are acknowledged
+    ck_assert_int_eq(Ms_LoadReceive(ms_load.servers[i], "ack", 7), 2);
+  }
+
+  start = g_get_monotonic_time();
+
+  for (int32_t i = 0; i < num_servers; i++) {
+    Ms_LoadSend(ms_load.servers[i], "heartbeat\n%s", va(status, PROTOCOL(i)));
+  }
+
+  Ms_LoadFlush();
+
+  const gint64 heartbeat_time = g_get_monotonic_time() - start;
+
+  for (int32_t i = 0; i < num_servers; i++) {
+    ck_assert_int_eq(Ms_LoadReceive(ms_load.servers[i], "ack", 7), 1);
+  }
+
+  // each client receives its protocol's list, which holds half of the servers
+  const size_t list_size = strlen(MS_SERVERS_HEADER) + num_servers / 2 * 6;
+
+  int32_t responses = 0;
+
+  start = g_get_monotonic_time();
+
+  for (int32_t i = 0; i < MS_LOAD_QUERIES; i++) {
+    Ms_LoadSend(ms_load.clients[i % MS_LOAD_CLIENTS], "getservers %d\n", PROTOCOL(i));
+
+    if (i % MS_LOAD_CLIENTS == MS_LOAD_CLIENTS - 1) {
+      Ms_LoadFlush();
+
+      for (int32_t j = 0; j < MS_LOAD_CLIENTS; j++) {
+        responses += Ms_LoadReceive(ms_load.clients[j], "servers", list_size);
+      }
+    }
+  }
+
+  const gint64 query_time = g_get_monotonic_time() - start;
+
+  ck_assert_int_eq(responses, MS_LOAD_QUERIES);
+
+  // and each protocol's list was built once
+  ck_assert_int_eq(g_hash_table_size(ms_server_lists), 2);
+
+  // the servers go quiet, so once their heartbeats time out, the timer wheel pings them
+  time_t now = time(NULL) + MS_HEARTBEAT_TIMEOUT + 1;
+
+  gint64 frame_time = 0;
+
+  for (int32_t i = 0; i <= MS_MAX_QUEUED_PINGS + 1; i++, now += MS_PING_INTERVAL) {
+
+    start = g_get_monotonic_time();
+    Ms_Frame(now);
+    frame_time += g_get_monotonic_time() - start;
+
+    // half of the servers answer, and the others are dropped after too many pings
+    for (int32_t j = 0; j < num_servers; j++) {
+      const bool answers = (j & 1) == 0;
+
+      const int32_t pings = Ms_LoadReceive(ms_load.servers[j], "ping", 8);
+      ck_assert_int_eq(pings, (answers || i <= MS_MAX_QUEUED_PINGS) ? 1 : 0);
+
+      if (answers) {
+        Ms_LoadSend(ms_load.servers[j], "ack\n");
+      }
+    }
+
+    Ms_LoadFlush();
+  }
+
+  ck_assert_int_eq(g_hash_table_size(ms_servers), num_servers / 2);
+
+  for (int32_t i = 0; i < num_servers; i++) {
+    const ms_server_t *server = Ms_GetServer(&ms_load.server_addrs[i]);
+    if (i & 1) {
+      ck_assert(server == NULL);
+    } else {
+      ck_assert(server != NULL);
+      ck_assert_int_eq(server->queued_pings, 0);
+    }
+  }
+
+  // dropping the servers invalidated the lists, and the current protocol's is now empty
+  ck_assert_int_eq(g_hash_table_size(ms_server_lists), 0);
+
+  Ms_LoadSend(ms_load.clients[0], "getservers %d\n", PROTOCOL_MAJOR);
+  Ms_LoadSend(ms_load.clients[1], "getservers %d\n", PROTOCOL_MAJOR + 1);
+  Ms_LoadFlush();
+
+  ck_assert_int_eq(Ms_LoadReceive(ms_load.clients[0], "servers", strlen(MS_SERVERS_HEADER)), 1);
+  ck_assert_int_eq(Ms_LoadReceive(ms_load.clients[1], "servers", list_size), 1);
+
+  // frames between timers only advance the wheel
+  start = g_get_monotonic_time();
+
+  for (int32_t i = 1; i < MS_PING_INTERVAL; i++) {
+    Ms_Frame(now - MS_PING_INTERVAL + i);
+  }
+
+  const gint64 idle_time = g_get_monotonic_time() - start;
+
+  for (int32_t i = 0; i < num_servers; i++) {
+    ck_assert_int_eq(Ms_LoadReceive(ms_load.servers[i], "ping", 8), 0);
+  }
+
+  printf("%d servers: registered in %" G_GINT64_FORMAT "us, heartbeats at %.0f/s; "
+         "%d queries at %.0f/s; %" G_GINT64_FORMAT "us per ping frame, %" G_GINT64_FORMAT "us per idle frame\n",
+         num_servers, register_time, num_servers * 1000000.0 / MAX(heartbeat_time, 1),
+         MS_LOAD_QUERIES, MS_LOAD_QUERIES * 1000000.0 / MAX(query_time, 1),
+         frame_time / (MS_MAX_QUEUED_PINGS + 2), idle_time / (MS_PING_INTERVAL - 1));
+
+  #undef PROTOCOL
+
+  for (int32_t i = 0; i < num_servers; i++) {
+    close(ms_load.servers[i]);
+  }
+
+  for (int32_t i = 0; i < MS_LOAD_CLIENTS; i++) {
+    close(ms_load.clients[i]);
+  }
+
+  close(ms_sock);
+  ms_sock = 0;
+
+} END_TEST
+
 /**
  * @brief Test entry point.
  */
@@ -111,9 +478,12 @@ int32_t main(int32_t argc, char **argv) {
 
   TCase *tcase = tcase_create("check_master");
   tcase_add_checked_fixture(tcase, setup, teardown);
+  tcase_set_timeout(tcase, 60);
 
   tcase_add_test(tcase, check_Ms_AddServer);
   tcase_add_test(tcase, check_Ms_BlacklistServer);
+  tcase_add_test(tcase, check_Ms_Frame);
+  tcase_add_test(tcase, check_Ms_Load);
 
   Suite *suite = suite_create("check_master");
   suite_add_tcase(suite, tcase);
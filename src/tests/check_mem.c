@@ -194,6 +194,152 @@ START_TEST(check_Mem_CopyString) {
   ck_assert(Mem_Size() == 0);
 } END_TEST
 
+#define BENCHMARK_THREADS 4
+#define BENCHMARK_ITERATIONS 100000
+
+/**
+ * @brief Allocates, links, reallocates and frees blocks in a tight loop.
+ */
+static void check_Mem_Benchmark_Run(void *data) {
+
+  void *blocks[64] = { NULL };
+
+  for (int32_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+    const int32_t j = i % lengthof(blocks);
+
+    if (blocks[j]) {
+      Mem_Free(blocks[j]);
+    }
+
+    blocks[j] = Mem_TagMalloc(16 + (i % 256), TAG);
+
+    if (i % 4 == 0) {
+      Mem_LinkMalloc(32, blocks[j]);
+    }
+
+    if (i % 16 == 0) {
+      blocks[j] = Mem_Realloc(blocks[j], 512);
+    }
+  }
+
+  for (size_t i = 0; i < lengthof(blocks); i++) {
+    Mem_Free(blocks[i]);
+  }
+
+  Mem_TagMalloc(1024, TAG);
+}
+
+START_TEST(check_Mem_Benchmark) {
+
+  Thread_Init(BENCHMARK_THREADS);
+
+  const size_t size = Mem_Size();
+
+  gint64 time = g_get_monotonic_time();
+
+  check_Mem_Benchmark_Run(NULL);
+
+  const gint64 single = g_get_monotonic_time() - time;
+
+  ck_assert_int_eq(size + 1024, Mem_Size());
+
+  time = g_get_monotonic_time();
+
+  thread_t *threads[BENCHMARK_THREADS];
+  for (int32_t i = 0; i < BENCHMARK_THREADS; i++) {
+    threads[i] = Thread_Create(check_Mem_Benchmark_Run, NULL, 0);
+  }
+
+  for (int32_t i = 0; i < BENCHMARK_THREADS; i++) {
+    Thread_Wait(threads[i]);
+  }
+
+  const gint64 multi = g_get_monotonic_time() - time;
+
+  printf("%d iterations: 1 thread %" G_GINT64_FORMAT "us, %d threads %" G_GINT64_FORMAT "us\n",
+         BENCHMARK_ITERATIONS, single, BENCHMARK_THREADS, multi);
+
+  ck_assert_int_eq(size + 1024 * (BENCHMARK_THREADS + 1), Mem_Size());
+
+  // blocks allocated by other threads are freed by tag as well
+  Mem_FreeTag(TAG);
+
+  ck_assert_int_eq(size, Mem_Size());
+
+  Thread_Shutdown();
+
+} END_TEST
+
+#define CONCURRENT_BLOCKS 8
+#define CONCURRENT_ITERATIONS 100000
+
+static void *concurrent_parents[2];
+static void *concurrent_blocks[CONCURRENT_BLOCKS];
+
+/**
+ * @brief Allocates the second parent, in the calling thread's shard.
+ */
+static void check_Mem_Link_Concurrent_Parent(void *data) {
+  concurrent_parents[1] = Mem_TagMalloc(64, TAG);
+}
+
+/**
+ * @brief Moves the shared blocks back and forth between parents in different shards.
+ */
+static void check_Mem_Link_Concurrent_Move(void *data) {
+
+  for (int32_t i = 0; i < CONCURRENT_ITERATIONS; i++) {
+    Mem_Link(concurrent_blocks[i % CONCURRENT_BLOCKS], concurrent_parents[i & 1]);
+  }
+}
+
+/**
+ * @brief Allocates and frees children of the shared blocks while they are being moved.
+ */
+static void check_Mem_Link_Concurrent_Alloc(void *data) {
+
+  for (int32_t i = 0; i < CONCURRENT_ITERATIONS; i++) {
+    void *child = Mem_LinkMalloc(16, concurrent_blocks[i % CONCURRENT_BLOCKS]);
+    child = Mem_Realloc(child, 32);
+    Mem_Free(child);
+  }
+}
+
+START_TEST(check_Mem_Link_Concurrent) {
+
+  Thread_Init(BENCHMARK_THREADS);
+
+  const size_t size = Mem_Size();
+
+  // the first parent is in this thread's shard, the second in another thread's
+  concurrent_parents[0] = Mem_TagMalloc(64, TAG);
+  Thread_Wait(Thread_Create(check_Mem_Link_Concurrent_Parent, NULL, 0));
+
+  for (int32_t i = 0; i < CONCURRENT_BLOCKS; i++) {
+    concurrent_blocks[i] = Mem_LinkMalloc(8, concurrent_parents[0]);
+  }
+
+  thread_t *threads[BENCHMARK_THREADS];
+
+  threads[0] = Thread_Create(check_Mem_Link_Concurrent_Move, NULL, 0);
+  for (int32_t i = 1; i < BENCHMARK_THREADS; i++) {
+    threads[i] = Thread_Create(check_Mem_Link_Concurrent_Alloc, NULL, 0);
+  }
+
+  for (int32_t i = 0; i < BENCHMARK_THREADS; i++) {
+    Thread_Wait(threads[i]);
+  }
+
+  ck_assert_int_eq(size + 64 * 2 + 8 * CONCURRENT_BLOCKS, Mem_Size());
+
+  Mem_FreeTag(TAG);
+
+  ck_assert_int_eq(size, Mem_Size());
+
+  Thread_Shutdown();
+
+} END_TEST
+
 /**
  * @brief Test entry point.
  */
@@ -212,6 +358,8 @@ int32_t main(int32_t argc, char **argv) {
   tcase_add_test(tcase, check_Mem_Realloc_PreservesLinks);
   tcase_add_test(tcase, check_Mem_Link_Reparenting);
   tcase_add_test(tcase, check_Mem_CopyString);
+  tcase_add_test(tcase, check_Mem_Link_Concurrent);
+  tcase_add_test(tcase, check_Mem_Benchmark);
 
   Suite *suite = suite_create("check_mem");
   suite_add_tcase(suite, tcase);
@@ -0,0 +1,541 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+
+#include "net/net_message.h"
+
+quetoo_t quetoo;
+
+static byte buffer[MAX_MSG_SIZE];
+static mem_buf_t msg;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+  Mem_Init();
+
+  Mem_InitBuffer(&msg, buffer, sizeof(buffer));
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+  Mem_Shutdown();
+}
+
+/**
+ * @return A position as it is received by the client.
+ */
+static vec3_t quantized(const vec3_t v) {
+  return Vec3(floorf(v.x * NET_POSITION_SCALE + .5f) / NET_POSITION_SCALE,
+              floorf(v.y * NET_POSITION_SCALE + .5f) / NET_POSITION_SCALE,
+              floorf(v.z * NET_POSITION_SCALE + .5f) / NET_POSITION_SCALE);
+}
+
+START_TEST(check_Net_VarInt) {
+
+  const uint32_t values[] = { 0, 1, 127, 128, 255, 16383, 16384, 1 << 20, INT32_MAX, UINT32_MAX };
+
+  for (size_t i = 0; i < lengthof(values); i++) {
+    Net_WriteVarInt(&msg, values[i]);
+  }
+
+  Net_WriteEntityNumber(&msg, 0);
+  Net_WriteEntityNumber(&msg, MAX_ENTITIES - 1);
+  Net_WriteEntityNumber(&msg, -1);
+
+  Net_BeginReading(&msg);
+
+  for (size_t i = 0; i < lengthof(values); i++) {
+    ck_assert_uint_eq(values[i], Net_ReadVarInt(&msg));
+  }
+
+  ck_assert_int_eq(0, Net_ReadEntityNumber(&msg));
+  ck_assert_int_eq(MAX_ENTITIES - 1, Net_ReadEntityNumber(&msg));
+  ck_assert_int_eq(-1, Net_ReadEntityNumber(&msg));
+
+  ck_assert_uint_eq(msg.read, msg.size);
+
+} END_TEST
+
+START_TEST(check_Net_Bits) {
+
+  net_bits_t bits;
+  Net_BeginBits(&bits, &msg);
+
+  for (int32_t i = 0; i <= 32; i++) {
+    Net_WriteBits(&bits, 0xdeadbeef, i);
+    Net_WriteBitsVarInt(&bits, (uint32_t) i * 1000003u);
+    Net_WriteBitsSignedVarInt(&bits, (i & 1) ? -i * 7919 : i * 7919);
+  }
+
+  Net_WriteBitsSignedVarInt(&bits, INT32_MIN);
+  Net_WriteBitsSignedVarInt(&bits, INT32_MAX);
+
+  Net_FlushBits(&bits);
+
+  Net_WriteByte(&msg, 0x55);
+
+  Net_BeginReading(&msg);
+  Net_BeginBits(&bits, &msg);
+
+  for (int32_t i = 0; i <= 32; i++) {
+    const uint32_t mask = i == 32 ? UINT32_MAX : (1u << i) - 1;
+    ck_assert_uint_eq(0xdeadbeef & mask, Net_ReadBits(&bits, i));
+    ck_assert_uint_eq((uint32_t) i * 1000003u, Net_ReadBitsVarInt(&bits));
+    ck_assert_int_eq((i & 1) ? -i * 7919 : i * 7919, Net_ReadBitsSignedVarInt(&bits));
+  }
+
+  ck_assert_int_eq(INT32_MIN, Net_ReadBitsSignedVarInt(&bits));
+  ck_assert_int_eq(INT32_MAX, Net_ReadBitsSignedVarInt(&bits));
+
+  // the bit stream is padded to a whole byte, so byte aligned reads may follow
+  ck_assert_int_eq(0x55, Net_ReadByte(&msg));
+
+  ck_assert_uint_eq(msg.read, msg.size);
+
+} END_TEST
+
+/**
+ * @brief Populates an entity state with random values.
+ */
+static void random_entity_state(GRand *rand, entity_state_t *s) {
+
+  memset(s, 0, sizeof(*s));
+
+  s->number = g_rand_int_range(rand, 0, MAX_ENTITIES);
+  s->spawn_id = g_rand_int_range(rand, 0, 256);
+  s->origin = Vec3(g_rand_double_range(rand, -MAX_WORLD_DIST, MAX_WORLD_DIST),
+                   g_rand_double_range(rand, -MAX_WORLD_DIST, MAX_WORLD_DIST),
+                   g_rand_double_range(rand, -MAX_WORLD_DIST, MAX_WORLD_DIST));
+  s->termination = Vec3_Add(s->origin, Vec3(g_rand_double_range(rand, -512.0, 512.0), 0.f, 0.f));
+  s->angles = Vec3(g_rand_int_range(rand, 0, 360), g_rand_int_range(rand, 0, 360), 0.f);
+  s->animation1 = g_rand_int_range(rand, 0, 256);
+  s->animation2 = g_rand_int_range(rand, 0, 256);
+  s->event = g_rand_int_range(rand, 0, 256);
+  s->event_data = g_rand_int_range(rand, 0, 256);
+  s->effects = g_rand_int(rand);
+  s->trail = g_rand_int_range(rand, 0, 256);
+  s->model1 = g_rand_int_range(rand, 0, 256);
+  s->model4 = g_rand_int_range(rand, 0, 256);
+  s->color.r = g_rand_int_range(rand, 0, 256);
+  s->color.a = g_rand_int_range(rand, 0, 256);
+  s->client = g_rand_int_range(rand, 0, 256);
+  s->sound = g_rand_int_range(rand, 0, 256);
+  s->solid = g_rand_int_range(rand, 0, 8);
+  s->bounds = Box3(Vec3(-16.f, -16.f, -24.f), Vec3(16.f, 16.f, 32.f));
+  s->step_offset = g_rand_int_range(rand, -128, 128);
+}
+
+/**
+ * @brief Asserts that `b` is `a` as it is received by the client.
+ */
+static void assert_entity_state(const entity_state_t *a, const entity_state_t *b) {
+
+  ck_assert_int_eq(a->number, b->number);
+  ck_assert_int_eq(a->spawn_id, b->spawn_id);
+  ck_assert(Vec3_Equal(quantized(a->origin), b->origin));
+  ck_assert(Vec3_Equal(quantized(a->termination), b->termination));
+  for (int32_t i = 0; i < 3; i++) {
+    ck_assert_float_eq_tol(a->angles.xyz[i], b->angles.xyz[i] < 0.f ? b->angles.xyz[i] + 360.f : b->angles.xyz[i], .01f);
+  }
+  ck_assert_int_eq(a->animation1, b->animation1);
+  ck_assert_int_eq(a->animation2, b->animation2);
+  ck_assert_int_eq(a->event, b->event);
+  ck_assert_int_eq(a->event_data, b->event_data);
+  ck_assert_uint_eq(a->effects, b->effects);
+  ck_assert_int_eq(a->trail, b->trail);
+  ck_assert_int_eq(a->model1, b->model1);
+  ck_assert_int_eq(a->model2, b->model2);
+  ck_assert_int_eq(a->model3, b->model3);
+  ck_assert_int_eq(a->model4, b->model4);
+  ck_assert_int_eq(a->color.rgba, b->color.rgba);
+  ck_assert_int_eq(a->client, b->client);
+  ck_assert_int_eq(a->sound, b->sound);
+  ck_assert_int_eq(a->solid, b->solid);
+  ck_assert(Box3_Equal(a->bounds, b->bounds));
+  ck_assert_int_eq(a->step_offset, b->step_offset);
+}
+
+/**
+ * @brief Reads an entity delta as the client does.
+ */
+static void read_delta_entity(const entity_state_t *from, entity_state_t *to) {
+
+  const int32_t number = Net_ReadEntityNumber(&msg);
+  const uint16_t bits = Net_ReadVarInt(&msg);
+
+  Net_ReadDeltaEntity(&msg, from, to, number, bits);
+}
+
+START_TEST(check_Net_DeltaEntity) {
+
+  GRand *rand = g_rand_new_with_seed(1);
+
+  const entity_state_t null_state = { 0 };
+
+  for (int32_t i = 0; i < 1000; i++) {
+
+    entity_state_t from, to, out;
+
+    random_entity_state(rand, &from);
+    random_entity_state(rand, &to);
+    to.number = from.number;
+
+    Mem_ClearBuffer(&msg);
+
+    Net_WriteDeltaEntity(&msg, &null_state, &from, true);
+    Net_WriteDeltaEntity(&msg, &from, &to, true);
+
+    Net_BeginReading(&msg);
+
+    entity_state_t baseline;
+    read_delta_entity(&null_state, &baseline);
+    assert_entity_state(&from, &baseline);
+
+    read_delta_entity(&baseline, &out);
+    assert_entity_state(&to, &out);
+
+    ck_assert_uint_eq(msg.read, msg.size);
+  }
+
+  g_rand_free(rand);
+
+} END_TEST
+
+START_TEST(check_Net_DeltaEntity_Chain) {
+
+  GRand *rand = g_rand_new_with_seed(2);
+
+  entity_state_t server, client;
+
+  random_entity_state(rand, &server);
+  server.event = server.event_data = 0;
+
+  const entity_state_t null_state = { 0 };
+
+  Mem_ClearBuffer(&msg);
+  Net_WriteDeltaEntity(&msg, &null_state, &server, true);
+  Net_BeginReading(&msg);
+  read_delta_entity(&null_state, &client);
+
+  // small movements below the grid must not accumulate error on the client
+
+  for (int32_t i = 0; i < 1000; i++) {
+
+    entity_state_t next = server;
+    next.origin = Vec3_Add(server.origin, Vec3(g_rand_double_range(rand, -.05, .05),
+                                               g_rand_double_range(rand, -.05, .05),
+                                               g_rand_double_range(rand, -8.0, 8.0)));
+
+    Mem_ClearBuffer(&msg);
+    Net_WriteDeltaEntity(&msg, &server, &next, false);
+
+    entity_state_t out = client;
+    if (msg.size) {
+      Net_BeginReading(&msg);
+      read_delta_entity(&client, &out);
+      ck_assert_uint_eq(msg.read, msg.size);
+    }
+
+    ck_assert(Vec3_Equal(quantized(next.origin), out.origin));
+
+    server = next;
+    client = out;
+  }
+
+  g_rand_free(rand);
+
+} END_TEST
+
+/**
+ * @brief Populates a player state with random values.
+ */
+static void random_player_state(GRand *rand, player_state_t *ps) {
+
+  ps->client = g_rand_int_range(rand, 0, 256);
+  ps->entity = g_rand_int_range(rand, 0, MAX_ENTITIES);
+  ps->pm_state.type = g_rand_int_range(rand, PM_NORMAL, PM_FREEZE + 1);
+  ps->pm_state.origin = Vec3(g_rand_double(rand) * 4096.0, g_rand_double(rand) * -4096.0, g_rand_double(rand));
+  ps->pm_state.velocity = Vec3(g_rand_double(rand) * 300.0, g_rand_double(rand) * 300.0, -800.f);
+  ps->pm_state.flags = g_rand_int_range(rand, 0, UINT16_MAX + 1);
+  ps->pm_state.time = g_rand_int_range(rand, 0, UINT16_MAX + 1);
+  ps->pm_state.gravity = g_rand_int_range(rand, INT16_MIN, INT16_MAX + 1);
+  ps->pm_state.view_offset = Vec3(0.f, 0.f, g_rand_double(rand) * 32.0);
+  ps->pm_state.step_offset = g_rand_double(rand) * 16.0;
+  ps->pm_state.view_angles = Vec3(g_rand_int_range(rand, 0, 360), g_rand_int_range(rand, 0, 360), 0.f);
+  ps->pm_state.hook_position = Vec3(g_rand_double(rand), g_rand_double(rand), g_rand_double(rand));
+  ps->pm_state.hook_length = g_rand_int_range(rand, 0, UINT16_MAX + 1);
+
+  for (int32_t i = 0; i < MAX_STATS; i++) {
+    if (g_rand_boolean(rand)) {
+      ps->stats[i] = g_rand_int_range(rand, INT16_MIN, INT16_MAX + 1);
+    }
+  }
+
+  for (int32_t i = 0; i < MAX_INVENTORY; i++) {
+    if (g_rand_int_range(rand, 0, 8) == 0) {
+      ps->inventory[i] = g_rand_int_range(rand, 0, 200);
+    }
+  }
+}
+
+START_TEST(check_Net_DeltaPlayerState) {
+
+  GRand *rand = g_rand_new_with_seed(3);
+
+  player_state_t from = { 0 }, to = { 0 }, out;
+
+  for (int32_t i = 0; i < 1000; i++) {
+
+    from = to;
+    random_player_state(rand, &to);
+
+    Mem_ClearBuffer(&msg);
+    Net_WriteDeltaPlayerState(&msg, &from, &to);
+    Net_WriteByte(&msg, 0x55);
+
+    Net_BeginReading(&msg);
+    Net_ReadDeltaPlayerState(&msg, &from, &out);
+
+    ck_assert_int_eq(0x55, Net_ReadByte(&msg));
+    ck_assert_uint_eq(msg.read, msg.size);
+
+    // movement state is lossless, aside from angles
+    ck_assert(Vec3_Equal(to.pm_state.origin, out.pm_state.origin));
+    ck_assert(Vec3_Equal(to.pm_state.velocity, out.pm_state.velocity));
+    ck_assert(Vec3_Equal(to.pm_state.view_offset, out.pm_state.view_offset));
+    ck_assert(Vec3_Equal(to.pm_state.hook_position, out.pm_state.hook_position));
+    ck_assert(to.pm_state.step_offset == out.pm_state.step_offset);
+
+    ck_assert_int_eq(to.client, out.client);
+    ck_assert_int_eq(to.entity, out.entity);
+    ck_assert_int_eq(to.pm_state.type, out.pm_state.type);
+    ck_assert_int_eq(to.pm_state.flags, out.pm_state.flags);
+    ck_assert_int_eq(to.pm_state.time, out.pm_state.time);
+    ck_assert_int_eq(to.pm_state.gravity, out.pm_state.gravity);
+    ck_assert_int_eq(to.pm_state.hook_length, out.pm_state.hook_length);
+
+    ck_assert_mem_eq(to.stats, out.stats, sizeof(to.stats));
+    ck_assert_mem_eq(to.inventory, out.inventory, sizeof(to.inventory));
+
+    to = out;
+  }
+
+  g_rand_free(rand);
+
+} END_TEST
+
+/**
+ * @return The size of an entity delta in the previous, byte aligned, protocol.
+ */
+static size_t legacy_delta_entity_size(const entity_state_t *from, const entity_state_t *to, bool force) {
+
+  size_t size = 0;
+
+  size += to->step_offset != from->step_offset ? 1 : 0;
+  size += to->spawn_id != from->spawn_id ? 1 : 0;
+  size += !Vec3_Equal(to->origin, from->origin) ? 12 : 0;
+  size += !Vec3_Equal(to->termination, from->termination) ? 12 : 0;
+  size += !Vec3_Equal(to->angles, from->angles) ? 6 : 0;
+  size += to->animation1 != from->animation1 || to->animation2 != from->animation2 ? 2 : 0;
+  size += to->event ? 2 : 0;
+  size += to->effects != from->effects ? 4 : 0;
+  size += to->trail != from->trail ? 1 : 0;
+  size += to->model1 != from->model1 || to->model2 != from->model2 ||
+          to->model3 != from->model3 || to->model4 != from->model4 ? 4 : 0;
+  size += to->color.rgba != from->color.rgba ? 4 : 0;
+  size += to->client != from->client ? 1 : 0;
+  size += to->sound != from->sound ? 1 : 0;
+  size += to->solid != from->solid ? 1 : 0;
+  size += !Box3_Equal(to->bounds, from->bounds) ? 12 : 0;
+
+  if (size || force) {
+    size += 4; // number and bits
+  }
+
+  return size;
+}
+
+/**
+ * @return The size of a player state delta in the previous, byte aligned, protocol.
+ */
+static size_t legacy_delta_player_state_size(const player_state_t *from, const player_state_t *to) {
+
+  size_t size = 2 + 4 + 8; // bits, stat bits and inventory bits
+
+  const pm_state_t *a = &from->pm_state, *b = &to->pm_state;
+
+  size += to->client != from->client ? 1 : 0;
+  size += to->entity != from->entity ? 2 : 0;
+  size += a->type != b->type ? 1 : 0;
+  size += !Vec3_Equal(a->origin, b->origin) ? 12 : 0;
+  size += !Vec3_Equal(a->velocity, b->velocity) ? 12 : 0;
+  size += a->flags != b->flags ? 2 : 0;
+  size += a->time != b->time ? 2 : 0;
+  size += a->gravity != b->gravity ? 2 : 0;
+  size += !Vec3_Equal(a->view_offset, b->view_offset) ? 12 : 0;
+  size += !Vec3_Equal(a->view_angles, b->view_angles) ? 6 : 0;
+  size += !Vec3_Equal(a->delta_angles, b->delta_angles) ? 6 : 0;
+  size += !Vec3_Equal(a->hook_position, b->hook_position) ? 12 : 0;
+  size += a->hook_length != b->hook_length ? 2 : 0;
+  size += a->step_offset != b->step_offset ? 4 : 0;
+
+  for (int32_t i = 0; i < MAX_STATS; i++) {
+    size += to->stats[i] != from->stats[i] ? 2 : 0;
+  }
+
+  for (int32_t i = 0; i < MAX_INVENTORY; i++) {
+    size += to->inventory[i] != from->inventory[i] ? 2 : 0;
+  }
+
+  return size;
+}
+
+#define CORPUS_PLAYERS 32
+#define CORPUS_PROJECTILES 96
+#define CORPUS_ITEMS 64
+#define CORPUS_FRAMES 400
+
+START_TEST(check_Net_Corpus) {
+
+  GRand *rand = g_rand_new_with_seed(4);
+
+  static entity_state_t states[2][CORPUS_PLAYERS + CORPUS_PROJECTILES + CORPUS_ITEMS];
+  static vec3_t velocities[lengthof(states[0])];
+
+  player_state_t ps[2] = { 0 };
+
+  // a crowded map: running players, flying projectiles and bobbing items
+
+  for (int32_t i = 0; i < (int32_t) lengthof(states[0]); i++) {
+    entity_state_t *s = &states[0][i];
+
+    s->number = i + 1;
+    s->origin = Vec3(g_rand_double_range(rand, -2048.0, 2048.0),
+                     g_rand_double_range(rand, -2048.0, 2048.0),
+                     g_rand_double_range(rand, -256.0, 256.0));
+
+    if (i < CORPUS_PLAYERS) {
+      s->model1 = 255;
+      s->client = i;
+      s->solid = SOLID_BOX;
+      s->bounds = Box3(Vec3(-16.f, -16.f, -24.f), Vec3(16.f, 16.f, 32.f));
+      velocities[i] = Vec3(g_rand_double_range(rand, -300.0, 300.0), g_rand_double_range(rand, -300.0, 300.0), 0.f);
+    } else if (i < CORPUS_PLAYERS + CORPUS_PROJECTILES) {
+      s->model1 = 32;
+      s->trail = 1;
+      s->effects = EF_GAME;
+      velocities[i] = Vec3(g_rand_double_range(rand, -1000.0, 1000.0), g_rand_double_range(rand, -1000.0, 1000.0), 0.f);
+    } else {
+      s->model1 = 64;
+      s->effects = EF_GAME << 1;
+      s->solid = SOLID_TRIGGER;
+      velocities[i] = Vec3_Zero();
+    }
+  }
+
+  size_t legacy_bytes = 0, bytes = 0;
+
+  for (int32_t frame = 1; frame < CORPUS_FRAMES; frame++) {
+
+    const entity_state_t *from = states[(frame - 1) & 1];
+    entity_state_t *to = states[frame & 1];
+
+    const player_state_t *ps_from = &ps[(frame - 1) & 1];
+    player_state_t *ps_to = &ps[frame & 1];
+
+    *ps_to = *ps_from;
+    ps_to->pm_state.origin = from[0].origin;
+    ps_to->pm_state.velocity = velocities[0];
+    ps_to->pm_state.view_angles.y = frame % 360;
+    ps_to->stats[frame % MAX_STATS] = frame;
+
+    Mem_ClearBuffer(&msg);
+
+    Net_WriteDeltaPlayerState(&msg, ps_from, ps_to);
+    legacy_bytes += legacy_delta_player_state_size(ps_from, ps_to);
+
+    for (int32_t i = 0; i < (int32_t) lengthof(states[0]); i++) {
+
+      to[i] = from[i];
+      to[i].event = 0;
+
+      if (i < CORPUS_PLAYERS) {
+        to[i].angles.y = (float) ((frame + i) % 360);
+        to[i].animation1 = (frame / 10) % 8;
+        if (g_rand_int_range(rand, 0, 20) == 0) {
+          to[i].event = 1; // footstep
+        }
+      } else if (i >= CORPUS_PLAYERS + CORPUS_PROJECTILES) {
+        to[i].origin.z = from[i].origin.z + sinf(frame * .1f) * .5f;
+      }
+
+      to[i].origin = Vec3_Fmaf(to[i].origin, QUETOO_TICK_SECONDS, velocities[i]);
+
+      Net_WriteDeltaEntity(&msg, &from[i], &to[i], false);
+      legacy_bytes += legacy_delta_entity_size(&from[i], &to[i], false);
+    }
+
+    Net_WriteEntityNumber(&msg, -1);
+    legacy_bytes += 2;
+
+    bytes += msg.size;
+  }
+
+  printf("%d entities: %.1f bytes per frame before, %.1f after\n", (int32_t) lengthof(states[0]),
+         legacy_bytes / (double) (CORPUS_FRAMES - 1), bytes / (double) (CORPUS_FRAMES - 1));
+
+  ck_assert_uint_lt(bytes, legacy_bytes);
+
+  g_rand_free(rand);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+  Test_Init(argc, argv);
+
+  TCase *tcase = tcase_create("check_net_message");
+  tcase_add_checked_fixture(tcase, setup, teardown);
+
+  tcase_add_test(tcase, check_Net_VarInt);
+  tcase_add_test(tcase, check_Net_Bits);
+  tcase_add_test(tcase, check_Net_DeltaEntity);
+  tcase_add_test(tcase, check_Net_DeltaEntity_Chain);
+  tcase_add_test(tcase, check_Net_DeltaPlayerState);
+  tcase_add_test(tcase, check_Net_Corpus);
+
+  Suite *suite = suite_create("check_net_message");
+  suite_add_tcase(suite, tcase);
+
+  int32_t failed = Test_Run(suite);
+
+  Test_Shutdown();
+  return failed;
+}
@@ -0,0 +1,421 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "tests.h"
+
+#include "net/net_udp.h"
+
+#if !defined(_WIN32)
+  #include <sys/select.h>
+#endif
+
+quetoo_t quetoo;
+
+#define CLIENTS 64
+#define FRAMES 2000
+
+#define USERCMD_SIZE 48
+#define FRAME_SIZE 1200
+
+static int32_t server;
+static int32_t clients[CLIENTS];
+
+static net_datagram_t datagrams[CLIENTS + NET_DATAGRAM_BATCH];
+
+/**
+ * @brief Opens a datagram socket on an ephemeral loopback port, resolving its address.
+ */
+static int32_t Test_Socket(net_addr_t *addr) {
+
+  const int32_t sock = Net_Socket(NA_DATAGRAM, "127.0.0.1", 0);
+
+  net_sockaddr saddr;
+  socklen_t len = sizeof(saddr);
+
+  ck_assert_int_eq(getsockname(sock, (struct sockaddr *) &saddr, &len), 0);
+
+  if (addr) {
+    addr->type = NA_DATAGRAM;
+    addr->addr = saddr.sin_addr.s_addr;
+    addr->port = saddr.sin_port;
+  }
+
+  return sock;
+}
+
+/**
+ * @brief Waits up to one second for the specified socket to become readable.
+ */
+static bool Test_Wait(int32_t sock) {
+  fd_set set;
+
+  FD_ZERO(&set);
+  FD_SET(sock, &set);
+
+  struct timeval timeout = { .tv_sec = 1 };
+
+  return select(sock + 1, &set, NULL, NULL, &timeout) > 0;
+}
+
+/**
+ * @brief Waits for and receives one datagram on the specified socket.
+ */
+static void Test_Recv(int32_t sock, net_datagram_t *datagram) {
+
+  while (Net_RecvDatagrams(sock, datagram, 1) != 1) {
+    ck_assert(Test_Wait(sock));
+  }
+}
+
+/**
+ * @brief Fills the specified datagram with `size` bytes of `c`, addressed to `to`.
+ */
+static void Test_Fill(net_datagram_t *datagram, const net_addr_t *to, size_t size, int32_t c) {
+
+  datagram->addr = *to;
+  datagram->size = size;
+  memset(datagram->data, c, size);
+}
+
+/**
+ * @brief Opens the managed server socket with `Net_Config`, on a free loopback port.
+ */
+static void Test_Config(net_addr_t *addr) {
+
+  Net_CloseSocket(Test_Socket(addr));
+
+  Cvar_Add("net_port", va("%d", ntohs(addr->port)), 0, NULL);
+
+  Net_Config(NS_UDP_SERVER, true);
+}
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+  Mem_Init();
+
+  Cmd_Init();
+
+  Cvar_Init();
+
+  Net_Init();
+
+  server = Test_Socket(NULL);
+
+  for (int32_t i = 0; i < CLIENTS; i++) {
+    clients[i] = Test_Socket(NULL);
+  }
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+  for (int32_t i = 0; i < CLIENTS; i++) {
+    Net_CloseSocket(clients[i]);
+  }
+
+  Net_CloseSocket(server);
+
+  Net_Config(NS_UDP_SERVER, false);
+
+  Net_Shutdown();
+
+  Cvar_Shutdown();
+
+  Cmd_Shutdown();
+
+  Mem_Shutdown();
+}
+
+START_TEST(check_Net_Datagrams) {
+  net_addr_t server_addr, client_addr;
+
+  Net_CloseSocket(server);
+  server = Test_Socket(&server_addr);
+
+  Net_CloseSocket(clients[0]);
+  clients[0] = Test_Socket(&client_addr);
+
+  for (size_t i = 0; i < 3; i++) {
+    datagrams[i].addr = server_addr;
+    datagrams[i].size = 100 * (i + 1);
+    memset(datagrams[i].data, 'a' + (int32_t) i, datagrams[i].size);
+  }
+
+  ck_assert_int_eq(Net_SendDatagrams(clients[0], datagrams, 3), 3);
+
+  memset(datagrams, 0, sizeof(datagrams));
+
+  ck_assert(Test_Wait(server));
+
+  size_t received = 0;
+  while (received < 3) {
+    const ssize_t count = Net_RecvDatagrams(server, datagrams + received, lengthof(datagrams) - received);
+    if (count == -1) {
+      ck_assert(Test_Wait(server));
+    } else {
+      received += count;
+    }
+  }
+
+  for (size_t i = 0; i < 3; i++) {
+    ck_assert_int_eq(datagrams[i].addr.type, NA_DATAGRAM);
+    ck_assert_int_eq(datagrams[i].addr.addr, client_addr.addr);
+    ck_assert_int_eq(datagrams[i].addr.port, client_addr.port);
+    ck_assert_int_eq(datagrams[i].size, 100 * (i + 1));
+    ck_assert_int_eq(datagrams[i].data[0], 'a' + (int32_t) i);
+    ck_assert_int_eq(datagrams[i].data[datagrams[i].size - 1], 'a' + (int32_t) i);
+  }
+
+  // the socket is drained
+  ck_assert_int_eq(Net_RecvDatagrams(server, datagrams, lengthof(datagrams)), -1);
+
+  const int32_t err = Net_GetError();
+  ck_assert(err == EWOULDBLOCK || err == EAGAIN);
+
+} END_TEST
+
+START_TEST(check_Net_ReceiveDatagrams) {
+  net_addr_t server_addr;
+
+  Test_Config(&server_addr);
+
+  // a loopback datagram, which is received before those on the socket
+  const net_addr_t loop = { .type = NA_LOOP };
+  ck_assert(Net_SendDatagram(NS_UDP_CLIENT, &loop, "loop", 5));
+
+  // an oversized datagram, followed by two more, each to be compacted over it
+  Test_Fill(&datagrams[0], &server_addr, 100, 'a');
+  Test_Fill(&datagrams[1], &server_addr, sizeof(datagrams[1].data), 'x');
+  Test_Fill(&datagrams[2], &server_addr, 200, 'b');
+  Test_Fill(&datagrams[3], &server_addr, 300, 'c');
+
+  ck_assert_int_eq(Net_SendDatagrams(clients[0], datagrams, 4), 4);
+
+  memset(datagrams, 0, sizeof(datagrams));
+
+  ck_assert(Test_Wait(server));
+
+  // the oversized datagram fills a batch, but must not end it
+  ck_assert_int_eq(Net_ReceiveDatagrams(NS_UDP_SERVER, datagrams, 3), 3);
+
+  ck_assert_int_eq(datagrams[0].addr.type, NA_LOOP);
+  ck_assert_int_eq(datagrams[0].size, 5);
+  ck_assert_str_eq((const char *) datagrams[0].data, "loop");
+
+  ck_assert_int_eq(datagrams[1].addr.type, NA_DATAGRAM);
+  ck_assert_int_eq(datagrams[1].size, 100);
+  ck_assert_int_eq(datagrams[1].data[99], 'a');
+
+  ck_assert_int_eq(datagrams[2].addr.type, NA_DATAGRAM);
+  ck_assert_int_eq(datagrams[2].size, 200);
+  ck_assert_int_eq(datagrams[2].data[199], 'b');
+
+  // a partial batch means the socket has been drained
+  ck_assert_int_eq(Net_ReceiveDatagrams(NS_UDP_SERVER, datagrams, 3), 1);
+
+  ck_assert_int_eq(datagrams[0].size, 300);
+  ck_assert_int_eq(datagrams[0].data[299], 'c');
+
+  ck_assert_int_eq(Net_ReceiveDatagrams(NS_UDP_SERVER, datagrams, 3), 0);
+
+} END_TEST
+
+START_TEST(check_Net_FlushDatagrams) {
+  net_addr_t server_addr, client_addr;
+
+  Test_Config(&server_addr);
+
+  Net_CloseSocket(clients[0]);
+  clients[0] = Test_Socket(&client_addr);
+
+  net_datagram_t *datagram = &datagrams[0];
+
+  Net_BeginDatagrams(NS_UDP_SERVER);
+
+  // datagrams are queued until the batch is flushed
+  for (int32_t i = 0; i < 3; i++) {
+    Test_Fill(datagram, &client_addr, 10, 'a' + i);
+    ck_assert(Net_SendDatagram(NS_UDP_SERVER, &client_addr, datagram->data, datagram->size));
+  }
+
+  ck_assert_int_eq(Net_RecvDatagrams(clients[0], datagram, 1), -1);
+
+  Net_FlushDatagrams(NS_UDP_SERVER);
+
+  for (int32_t i = 0; i < 3; i++) {
+    Test_Recv(clients[0], datagram);
+    ck_assert_int_eq(datagram->size, 10);
+    ck_assert_int_eq(datagram->data[0], 'a' + i);
+  }
+
+  // a full queue is sent without waiting for the flush
+  Net_BeginDatagrams(NS_UDP_SERVER);
+
+  for (int32_t i = 0; i < NET_DATAGRAM_BATCH + 1; i++) {
+    Test_Fill(datagram, &client_addr, 20, i);
+    ck_assert(Net_SendDatagram(NS_UDP_SERVER, &client_addr, datagram->data, datagram->size));
+  }
+
+  for (int32_t i = 0; i < NET_DATAGRAM_BATCH; i++) {
+    Test_Recv(clients[0], datagram);
+    ck_assert_int_eq(datagram->data[0], i);
+  }
+
+  ck_assert_int_eq(Net_RecvDatagrams(clients[0], datagram, 1), -1);
+
+  Net_FlushDatagrams(NS_UDP_SERVER);
+
+  Test_Recv(clients[0], datagram);
+  ck_assert_int_eq(datagram->data[0], NET_DATAGRAM_BATCH);
+
+  // and once the batch has ended, datagrams are sent immediately
+  Test_Fill(datagram, &client_addr, 30, 'z');
+  ck_assert(Net_SendDatagram(NS_UDP_SERVER, &client_addr, datagram->data, datagram->size));
+
+  Test_Recv(clients[0], datagram);
+  ck_assert_int_eq(datagram->size, 30);
+  ck_assert_int_eq(datagram->data[0], 'z');
+
+} END_TEST
+
+/**
+ * @brief Simulates `FRAMES` server frames at `CLIENTS` clients, transferring at most `batch`
+ * datagrams per call. Each client sends a command, and the server drains its socket and
+ * replies to each client with a frame.
+ * @return The number of server socket calls per frame.
+ */
+static double Test_Frames(size_t batch) {
+  net_addr_t server_addr;
+
+  Net_CloseSocket(server);
+  server = Test_Socket(&server_addr);
+
+  net_datagram_t cmd = {
+    .addr = server_addr,
+    .size = USERCMD_SIZE
+  };
+
+  size_t calls = 0, server_packets = 0, client_packets = 0;
+
+  const gint64 start = g_get_monotonic_time();
+
+  for (int32_t frame = 0; frame < FRAMES; frame++) {
+
+    for (int32_t i = 0; i < CLIENTS; i++) {
+      ck_assert_int_eq(Net_SendDatagrams(clients[i], &cmd, 1), 1);
+    }
+
+    // receive the commands until a partial batch, as Sv_ReadPackets would
+    size_t received = 0;
+    ssize_t count;
+    do {
+      count = Net_RecvDatagrams(server, datagrams + received, batch);
+      calls++;
+
+      if (count > 0) {
+        received += count;
+      } else if (received < CLIENTS) {
+        ck_assert(Test_Wait(server));
+      }
+    } while (received < CLIENTS || count == (ssize_t) batch);
+
+    ck_assert_int_eq(received, CLIENTS);
+    server_packets += received;
+
+    // and reply to each client with a frame, as Sv_SendClientPackets would
+    for (size_t i = 0; i < received; i++) {
+      datagrams[i].size = FRAME_SIZE;
+    }
+
+    for (size_t sent = 0; sent < received; calls++) {
+      count = Net_SendDatagrams(server, datagrams + sent, MIN(batch, received - sent));
+      ck_assert_int_gt(count, 0);
+      sent += count;
+    }
+
+    for (int32_t i = 0; i < CLIENTS; i++) {
+      net_datagram_t *reply = &datagrams[0];
+      while (Net_RecvDatagrams(clients[i], reply, 1) != 1) {
+        ck_assert(Test_Wait(clients[i]));
+      }
+      ck_assert_int_eq(reply->size, FRAME_SIZE);
+      client_packets++;
+    }
+  }
+
+  const gint64 elapsed = MAX(g_get_monotonic_time() - start, 1);
+
+  ck_assert_int_eq(server_packets, FRAMES * CLIENTS);
+  ck_assert_int_eq(client_packets, FRAMES * CLIENTS);
+
+  const double calls_per_frame = calls / (double) FRAMES;
+
+  printf("%d clients, batch %2zu: %.0f packets/s, %.1f server socket calls per frame\n",
+         CLIENTS, batch, (server_packets + client_packets) * 1000000.0 / elapsed, calls_per_frame);
+
+  return calls_per_frame;
+}
+
+START_TEST(check_Net_Datagrams_Benchmark) {
+
+  const double unbatched = Test_Frames(1);
+  const double batched = Test_Frames(NET_DATAGRAM_BATCH);
+
+  // draining takes one call per datagram, and one more for the empty socket
+  ck_assert(unbatched >= CLIENTS + 1 + CLIENTS);
+
+#if defined(__linux__)
+  ck_assert(batched <= 3);
+#else
+  ck_assert(batched <= unbatched);
+#endif
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+  Test_Init(argc, argv);
+
+  TCase *tcase = tcase_create("check_net_udp");
+  tcase_add_checked_fixture(tcase, setup, teardown);
+
+  tcase_add_test(tcase, check_Net_Datagrams);
+  tcase_add_test(tcase, check_Net_ReceiveDatagrams);
+  tcase_add_test(tcase, check_Net_FlushDatagrams);
+  tcase_add_test(tcase, check_Net_Datagrams_Benchmark);
+
+  Suite *suite = suite_create("check_net_udp");
+  suite_add_tcase(suite, tcase);
+
+  int32_t failed = Test_Run(suite);
+
+  Test_Shutdown();
+  return failed;
+}
@@ -0,0 +1,309 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+
+// the disk cache is private to the translation unit
+#include "client/sound/s_sample.c"
+
+#define SOURCE_PATH "sounds/check_s_sample.wav"
+#define REMOVED_PATH "sounds/check_s_sample_removed.wav"
+#define CORRUPT_PATH "cache/sounds/check_s_sample_corrupt.pcm"
+#define OTHER_PATH "cache/sounds/check_s_sample.txt"
+
+#define TONE_AMPLITUDE .5
+
+quetoo_t quetoo;
+
+static cvar_t get_error, rate, resample, resample_cache;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+  Mem_Init();
+  Fs_Init(FS_NONE);
+
+  memset(&s_context, 0, sizeof(s_context));
+
+  rate.integer = 44100;
+  resample.integer = S_RESAMPLE_SINC;
+  resample_cache.integer = 1;
+
+  s_get_error = &get_error;
+  s_rate = &rate;
+  s_resample = &resample;
+  s_resample_cache = &resample_cache;
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+  Mem_Free(s_context.sinc.weights);
+
+  Fs_Shutdown();
+  Mem_Shutdown();
+}
+
+/**
+ * @return The sample of a sine tone at the given frame and rate, whose phase is offset by a
+ * quarter turn in each successive channel, so that the channels are distinguishable.
+ */
+static double Tone(double frequency, int32_t rate, size_t frame, int32_t channel) {
+  return TONE_AMPLITUDE * sin(2.0 * M_PI * frequency * frame / rate + channel * M_PI_2);
+}
+
+/**
+ * @brief Resamples one second of a tone.
+ * @return The resampled frames, which the caller must free.
+ */
+static float *ResampleTone(int32_t channels, int32_t source_rate, int32_t dest_rate, s_resample_t quality,
+                           double frequency, size_t *out_frames) {
+
+  float *in = Mem_Malloc(sizeof(float) * source_rate * channels);
+
+  for (int32_t i = 0; i < source_rate; i++) {
+    for (int32_t c = 0; c < channels; c++) {
+      in[i * channels + c] = (float) Tone(frequency, source_rate, i, c);
+    }
+  }
+
+  float *out = NULL;
+  size_t size = 0;
+
+  const size_t count = S_Resample(channels, source_rate, dest_rate, quality, source_rate * channels, in, &out, &size);
+
+  ck_assert_uint_eq(count, (size_t) dest_rate * channels);
+  ck_assert_uint_ge(size, count * sizeof(float));
+
+  Mem_Free(in);
+
+  *out_frames = count / channels;
+  return out;
+}
+
+/**
+ * @return The signal to noise ratio in dB of a tone resampled from `source_rate` to
+ * `dest_rate`, measured against the ideal tone at `dest_rate`. The first and last eighths
+ * of the output, where the filter reaches into the silence around the tone, are excluded.
+ */
+static double ResampleSNR(int32_t channels, int32_t source_rate, int32_t dest_rate, s_resample_t quality, double frequency) {
+
+  size_t frames;
+  float *out = ResampleTone(channels, source_rate, dest_rate, quality, frequency, &frames);
+
+  double signal = 0.0, noise = 0.0;
+
+  for (size_t i = frames / 8; i < frames - frames / 8; i++) {
+    for (int32_t c = 0; c < channels; c++) {
+      const double expected = Tone(frequency, dest_rate, i, c);
+      const double error = out[i * channels + c] - expected;
+
+      signal += expected * expected;
+      noise += error * error;
+    }
+  }
+
+  Mem_Free(out);
+
+  return 10.0 * log10(signal / fmax(noise, 1e-30));
+}
+
+/**
+ * @return The power in dB, relative to the input, of a tone resampled from `source_rate`
+ * to `dest_rate`. A tone above the destination's Nyquist frequency can not be represented,
+ * so whatever remains of it is aliasing.
+ */
+static double ResamplePower(int32_t source_rate, int32_t dest_rate, s_resample_t quality, double frequency) {
+
+  size_t frames;
+  float *out = ResampleTone(1, source_rate, dest_rate, quality, frequency, &frames);
+
+  double power = 0.0;
+  size_t count = 0;
+
+  for (size_t i = frames / 8; i < frames - frames / 8; i++, count++) {
+    power += out[i] * out[i];
+  }
+
+  Mem_Free(out);
+
+  return 10.0 * log10(fmax(power / count, 1e-30) / (TONE_AMPLITUDE * TONE_AMPLITUDE / 2.0));
+}
+
+START_TEST(check_S_Resample_SNR) {
+
+  const int32_t rates[][2] = {
+    { 11025, 44100 },
+    { 22050, 44100 },
+    { 22050, 48000 },
+    { 44100, 48000 },
+    { 48000, 44100 },
+    { 44100, 22050 },
+    { 48000, 22050 },
+  };
+
+  for (size_t i = 0; i < lengthof(rates); i++) {
+    const int32_t source_rate = rates[i][0], dest_rate = rates[i][1];
+
+    const double nearest = ResampleSNR(2, source_rate, dest_rate, S_RESAMPLE_NEAREST, 1000.0);
+    const double linear = ResampleSNR(2, source_rate, dest_rate, S_RESAMPLE_LINEAR, 1000.0);
+    const double sinc = ResampleSNR(2, source_rate, dest_rate, S_RESAMPLE_SINC, 1000.0);
+
+    printf("%d -> %d: 1 kHz SNR nearest %.1f dB, linear %.1f dB, sinc %.1f dB\n",
+           source_rate, dest_rate, nearest, linear, sinc);
+
+    ck_assert_msg(sinc >= 60.0, "%d -> %d: sinc SNR %.1f dB", source_rate, dest_rate, sinc);
+
+    // decimating by a whole factor reads source frames exactly, so only the sinc filter errs
+    if (source_rate % dest_rate) {
+      ck_assert_msg(linear >= 25.0, "%d -> %d: linear SNR %.1f dB", source_rate, dest_rate, linear);
+
+      ck_assert(nearest < linear);
+      ck_assert(linear < sinc);
+    }
+  }
+
+} END_TEST
+
+START_TEST(check_S_Resample_Aliasing) {
+
+  const struct {
+    int32_t source_rate, dest_rate;
+    double frequency;
+  } tones[] = {
+    { 44100, 22050, 16000.0 },
+    { 48000, 22050, 18000.0 },
+  };
+
+  for (size_t i = 0; i < lengthof(tones); i++) {
+
+    const double nearest = ResamplePower(tones[i].source_rate, tones[i].dest_rate, S_RESAMPLE_NEAREST, tones[i].frequency);
+    const double sinc = ResamplePower(tones[i].source_rate, tones[i].dest_rate, S_RESAMPLE_SINC, tones[i].frequency);
+
+    printf("%d -> %d: %.0f Hz aliasing nearest %.1f dB, sinc %.1f dB\n",
+           tones[i].source_rate, tones[i].dest_rate, tones[i].frequency, nearest, sinc);
+
+    // without a filter the tone folds back almost entirely
+    ck_assert(nearest > -10.0);
+
+    ck_assert_msg(sinc <= -70.0, "%.0f Hz: sinc aliasing %.1f dB", tones[i].frequency, sinc);
+  }
+
+  // and tones below the destination's Nyquist frequency pass through the filter
+  const double passband = ResamplePower(48000, 22050, S_RESAMPLE_SINC, 4000.0);
+  ck_assert_msg(fabs(passband) < .05, "4000 Hz: sinc gain %.2f dB", passband);
+
+} END_TEST
+
+/**
+ * @brief Writes a file to the write directory.
+ */
+static void WriteFile(const char *path, const void *data, size_t len) {
+
+  file_t *file = Fs_OpenWrite(path);
+  ck_assert_msg(file != NULL, "Failed to open %s", path);
+
+  ck_assert_int_eq(Fs_Write(file, data, 1, len), len);
+  ck_assert(Fs_Close(file));
+}
+
+START_TEST(check_S_PruneSampleCache) {
+
+  const int16_t samples[64] = { 0 };
+
+  char current[MAX_OS_PATH], removed[MAX_OS_PATH], other_rate[MAX_OS_PATH];
+
+  S_SampleCachePath(SOURCE_PATH, current, sizeof(current));
+  S_SampleCachePath(REMOVED_PATH, removed, sizeof(removed));
+
+  WriteFile(SOURCE_PATH, "RIFF", 4);
+  S_WriteCachedSample(SOURCE_PATH, 1, samples, lengthof(samples));
+
+  // a cache for another rate
+  rate.integer = 22050;
+  S_SampleCachePath(SOURCE_PATH, other_rate, sizeof(other_rate));
+  S_WriteCachedSample(SOURCE_PATH, 1, samples, lengthof(samples));
+  rate.integer = 44100;
+
+  // a cache whose source is removed
+  WriteFile(REMOVED_PATH, "RIFF", 4);
+  S_WriteCachedSample(REMOVED_PATH, 1, samples, lengthof(samples));
+  Fs_Delete(REMOVED_PATH);
+
+  // and a truncated cache, beside a file which is not a cache at all
+  WriteFile(CORRUPT_PATH, "QSCM", 4);
+  WriteFile(OTHER_PATH, "QSCM", 4);
+
+  ck_assert(Fs_Exists(current));
+  ck_assert(Fs_Exists(other_rate));
+  ck_assert(Fs_Exists(removed));
+  ck_assert(!Fs_Exists(REMOVED_PATH));
+
+  resample_cache.integer = 0;
+  S_PruneSampleCache();
+
+  ck_assert(Fs_Exists(other_rate));
+
+  resample_cache.integer = 1;
+  S_PruneSampleCache();
+
+  ck_assert(Fs_Exists(current));
+  ck_assert(!Fs_Exists(other_rate));
+  ck_assert(!Fs_Exists(removed));
+  ck_assert(!Fs_Exists(CORRUPT_PATH));
+  ck_assert(Fs_Exists(OTHER_PATH));
+
+  // changing the resampling quality invalidates the rest
+  resample.integer = S_RESAMPLE_LINEAR;
+  S_PruneSampleCache();
+  ck_assert(!Fs_Exists(current));
+
+  Fs_Delete(SOURCE_PATH);
+  Fs_Delete(OTHER_PATH);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+  Test_Init(argc, argv);
+
+  TCase *tcase = tcase_create("check_s_sample");
+  tcase_add_checked_fixture(tcase, setup, teardown);
+  tcase_set_timeout(tcase, 60);
+
+  tcase_add_test(tcase, check_S_Resample_SNR);
+  tcase_add_test(tcase, check_S_Resample_Aliasing);
+  tcase_add_test(tcase, check_S_PruneSampleCache);
+
+  Suite *suite = suite_create("check_s_sample");
+  suite_add_tcase(suite, tcase);
+
+  int32_t failed = Test_Run(suite);
+
+  Test_Shutdown();
+  return failed;
+}
@@ -0,0 +1,564 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "tests.h"
+
+// the index loading and rebuilding is private to the translation unit
+#include "server/sv_demo.c"
+
+#define DEMO_NAME "check_sv_demo"
+#define DEMO_PATH "demos/" DEMO_NAME ".demo"
+#define DEMO_INDEX_PATH "demos/" DEMO_NAME ".demo.idx"
+
+#define DEMO_LEVELS 2
+#define DEMO_LEVEL_FRAMES 200
+#define DEMO_KEYFRAME_FRAMES 40
+
+quetoo_t quetoo;
+
+sv_server_t sv;
+cvar_t *sv_demo_list;
+
+static cvar_t demo_list = { .string = "" };
+
+static int32_t demos_completed;
+
+/**
+ * @brief Demo playback ends by shutting down the server.
+ */
+void Sv_ShutdownServer(const char *msg) {
+  demos_completed++;
+}
+
+/**
+ * @brief The playlist is empty, so no other demo is started.
+ */
+void Sv_InitServer(const char *name, sv_state_t state) {
+  ck_abort_msg("Unexpected demo %s", name);
+}
+
+/**
+ * @brief A keyframe written to the synthetic demo.
+ */
+typedef struct {
+  uint32_t time;
+
+  /**
+   * @brief The offsets of the keyframe's first record, and of the end of it.
+   */
+  int64_t offset, end;
+} demo_keyframe_t;
+
+/**
+ * @brief The synthetic demo, and what playing it back should yield.
+ */
+static struct {
+  GByteArray *data;
+
+  /**
+   * @brief The keyframes, as `demo_keyframe_t`.
+   */
+  GArray *keyframes;
+
+  /**
+   * @brief The identifiers of the records which are not keyframe records, in order.
+   */
+  GArray *records;
+
+  int32_t num_records;
+} demo;
+
+/**
+ * @brief Appends a little endian long to the synthetic demo.
+ */
+static void WriteLong(int32_t value) {
+  value = LittleLong(value);
+  g_byte_array_append(demo.data, (guint8 *) &value, sizeof(value));
+}
+
+/**
+ * @brief Appends a record, framed as `Cl_WriteDemoRecord` does, whose payload begins with
+ * its identifier.
+ */
+static void WriteRecord(bool keyframe, uint32_t time) {
+
+  const int32_t id = demo.num_records++;
+
+  if (keyframe) {
+    WriteLong(DEMO_KEYFRAME);
+    WriteLong((int32_t) time);
+  } else {
+    g_array_append_val(demo.records, id);
+  }
+
+  const int32_t size = sizeof(id) + (id * 37) % 200;
+
+  WriteLong(size);
+  WriteLong(id);
+
+  for (int32_t i = sizeof(id); i < size; i++) {
+    const guint8 b = id & 0xff;
+    g_byte_array_append(demo.data, &b, 1);
+  }
+}
+
+/**
+ * @brief Appends a level, whose server time starts over, with keyframes at regular
+ * intervals if `keyframes` is set. Like the recorder, each keyframe follows the frame
+ * it was taken from, and spans two records.
+ */
+static void WriteLevel(bool keyframes) {
+
+  WriteRecord(false, 0); // server data, config strings and baselines
+
+  for (int32_t i = 0; i < DEMO_LEVEL_FRAMES; i++) {
+    const uint32_t time = (i + 1) * QUETOO_TICK_MILLIS;
+
+    WriteRecord(false, time);
+
+    if (keyframes && i % DEMO_KEYFRAME_FRAMES == 0) {
+      demo_keyframe_t keyframe = {
+        .time = time,
+        .offset = demo.data->len
+      };
+
+      WriteRecord(true, time);
+      keyframe.end = demo.data->len;
+      WriteRecord(true, time);
+
+      g_array_append_val(demo.keyframes, keyframe);
+    }
+  }
+}
+
+/**
+ * @brief Builds a synthetic demo of two levels, terminated and followed by a trailing
+ * index as written by `Cl_Stop_f` if `trailer` is set.
+ */
+static void BuildDemo(bool keyframes, bool trailer) {
+
+  for (int32_t i = 0; i < DEMO_LEVELS; i++) {
+    WriteLevel(keyframes);
+  }
+
+  WriteLong(-1);
+
+  if (trailer) {
+    const int32_t offset = demo.data->len;
+
+    WriteLong(demo.keyframes->len);
+
+    for (guint i = 0; i < demo.keyframes->len; i++) {
+      const demo_keyframe_t *keyframe = &g_array_index(demo.keyframes, demo_keyframe_t, i);
+      WriteLong((int32_t) keyframe->time);
+      WriteLong((int32_t) keyframe->offset);
+    }
+
+    WriteLong(offset);
+    WriteLong(DEMO_INDEX_MAGIC);
+  }
+}
+
+/**
+ * @brief Writes the first `len` bytes of the synthetic demo to its file.
+ */
+static void WriteDemo(size_t len) {
+
+  file_t *file = Fs_OpenWrite(DEMO_PATH);
+  ck_assert_msg(file != NULL, "Failed to open %s for writing", DEMO_PATH);
+
+  ck_assert_int_eq(Fs_Write(file, demo.data->data, 1, len), len);
+  Fs_Close(file);
+}
+
+/**
+ * @brief Opens the demo file for playback, as `Sv_LoadMedia` does.
+ */
+static void OpenDemo(void) {
+
+  g_strlcpy(sv.name, DEMO_NAME, sizeof(sv.name));
+
+  sv.demo_file = Fs_OpenRead(DEMO_PATH);
+  ck_assert_msg(sv.demo_file != NULL, "Failed to open %s", DEMO_PATH);
+
+  Sv_OpenDemo();
+}
+
+/**
+ * @brief Asserts that the loaded keyframe index holds the first `count` keyframes written.
+ */
+static void AssertKeyframes(guint count) {
+
+  ck_assert_uint_eq(sv.demo_keyframes->len, count);
+
+  for (guint i = 0; i < count; i++) {
+    const demo_keyframe_t *expected = &g_array_index(demo.keyframes, demo_keyframe_t, i);
+    const sv_demo_keyframe_t *keyframe = &g_array_index(sv.demo_keyframes, sv_demo_keyframe_t, i);
+
+    ck_assert_uint_eq(keyframe->time, expected->time);
+    ck_assert_int_eq(keyframe->offset, expected->offset);
+  }
+}
+
+/**
+ * @brief Reads the next message, returning its identifier, or -1 if playback ended.
+ */
+static int32_t ReadMessage(void) {
+  static byte buffer[MAX_MSG_SIZE];
+
+  const size_t size = Sv_ReadDemoMessage(buffer);
+  if (size == 0) {
+    return -1;
+  }
+
+  int32_t id;
+  memcpy(&id, buffer, sizeof(id));
+  id = LittleLong(id);
+
+  ck_assert_uint_eq(size, sizeof(id) + (id * 37) % 200);
+
+  for (size_t i = sizeof(id); i < size; i++) {
+    ck_assert_uint_eq(buffer[i], id & 0xff);
+  }
+
+  return id;
+}
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+  Mem_Init();
+  Fs_Init(FS_NONE);
+
+  Fs_Delete(DEMO_PATH);
+  Fs_Delete(DEMO_INDEX_PATH);
+
+  memset(&sv, 0, sizeof(sv));
+  sv_demo_list = &demo_list;
+  demos_completed = 0;
+
+  memset(&demo, 0, sizeof(demo));
+  demo.data = g_byte_array_new();
+  demo.keyframes = g_array_new(false, false, sizeof(demo_keyframe_t));
+  demo.records = g_array_new(false, false, sizeof(int32_t));
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+  Sv_CloseDemo();
+
+  g_byte_array_free(demo.data, true);
+  g_array_free(demo.keyframes, true);
+  g_array_free(demo.records, true);
+
+  Fs_Delete(DEMO_PATH);
+  Fs_Delete(DEMO_INDEX_PATH);
+
+  Fs_Shutdown();
+  Mem_Shutdown();
+}
+
+START_TEST(check_Sv_ReadDemoMessage) {
+
+  BuildDemo(true, true);
+  WriteDemo(demo.data->len);
+
+  OpenDemo();
+
+  AssertKeyframes(demo.keyframes->len);
+  ck_assert(!Fs_Exists(DEMO_INDEX_PATH));
+
+  // keyframe records are skipped, and every other record is read in order
+  for (guint i = 0; i < demo.records->len; i++) {
+    ck_assert_int_eq(ReadMessage(), g_array_index(demo.records, int32_t, i));
+    ck_assert(!sv.demo_seek);
+  }
+
+  ck_assert_int_eq(ReadMessage(), -1);
+  ck_assert_int_eq(demos_completed, 1);
+
+} END_TEST
+
+START_TEST(check_Sv_LoadDemoIndex_invalid) {
+
+  BuildDemo(true, true);
+
+  const size_t len = demo.data->len;
+  const int32_t offset = len - sizeof(int32_t) * 2;
+
+  // a bad magic, an index offset outside of the file, and an index of the wrong size
+  const struct {
+    int32_t at, value;
+  } corruptions[] = {
+    { offset + sizeof(int32_t), LittleLong(DEMO_INDEX_MAGIC + 1) },
+    { offset, LittleLong((int32_t) len) },
+    { offset, LittleLong(0) },
+    { offset, LittleLong(offset - (int32_t) sizeof(int32_t) * 4) },
+  };
+
+  for (size_t i = 0; i < lengthof(corruptions); i++) {
+    GByteArray *data = g_byte_array_new();
+    g_byte_array_append(data, demo.data->data, demo.data->len);
+
+    memcpy(demo.data->data + corruptions[i].at, &corruptions[i].value, sizeof(int32_t));
+    WriteDemo(len);
+
+    g_byte_array_free(demo.data, true);
+    demo.data = data;
+
+    Fs_Delete(DEMO_INDEX_PATH);
+
+    OpenDemo();
+
+    // the index is rebuilt from the records, which are intact
+    AssertKeyframes(demo.keyframes->len);
+    ck_assert(Fs_Exists(DEMO_INDEX_PATH));
+
+    ck_assert_int_eq(ReadMessage(), g_array_index(demo.records, int32_t, 0));
+
+    Sv_CloseDemo();
+  }
+
+} END_TEST
+
+START_TEST(check_Sv_BuildDemoIndex_truncated) {
+
+  BuildDemo(true, false);
+
+  const demo_keyframe_t *keyframes = (demo_keyframe_t *) demo.keyframes->data;
+  const guint count = demo.keyframes->len;
+
+  ck_assert_uint_gt(count, 4);
+
+  // truncate within a record after a keyframe, and within a keyframe's first record
+  const int64_t truncations[] = {
+    keyframes[count / 2].end + 16,
+    keyframes[count / 2].end - 1,
+    keyframes[count / 2].offset + 6,
+    keyframes[0].offset,
+  };
+
+  for (size_t i = 0; i < lengthof(truncations); i++) {
+
+    WriteDemo(truncations[i]);
+
+    Fs_Delete(DEMO_INDEX_PATH);
+
+    OpenDemo();
+
+    guint expected = 0;
+    while (expected < count && keyframes[expected].end <= truncations[i]) {
+      expected++;
+    }
+
+    AssertKeyframes(expected);
+
+    // playback resumes from the last complete keyframe, and then stops cleanly
+    if (expected) {
+      ck_assert(Sv_SeekDemo(UINT32_MAX));
+      ck_assert_int_eq(Fs_Tell(sv.demo_file), keyframes[expected - 1].offset);
+      ck_assert_int_ne(ReadMessage(), -1);
+    } else {
+      ck_assert(!Sv_SeekDemo(UINT32_MAX));
+    }
+
+    while (ReadMessage() != -1) {
+      ;
+    }
+
+    ck_assert_int_eq(demos_completed, (int32_t) i + 1);
+
+    Sv_CloseDemo();
+  }
+
+} END_TEST
+
+START_TEST(check_Sv_OpenDemo_index_file) {
+
+  BuildDemo(true, false);
+  WriteDemo(demo.data->len);
+
+  OpenDemo();
+  AssertKeyframes(demo.keyframes->len);
+  Sv_CloseDemo();
+
+  ck_assert(Fs_Exists(DEMO_INDEX_PATH));
+
+  // rewrite the index file with a different keyframe, which must then be loaded
+  int32_t *index;
+  const int64_t len = Fs_Load(DEMO_INDEX_PATH, (void **) &index);
+
+  ck_assert_int_eq(len, sizeof(int32_t) * (4 + demo.keyframes->len * 2));
+
+  ck_assert_int_eq(LittleLong(index[0]), DEMO_INDEX_MAGIC);
+  ck_assert_int_eq(LittleLong(index[1]), demo.data->len);
+  ck_assert_int_eq(LittleLong(index[3]), demo.keyframes->len);
+
+  index[4] = LittleLong(123456);
+
+  file_t *file = Fs_OpenWrite(DEMO_INDEX_PATH);
+  ck_assert_int_eq(Fs_Write(file, index, len, 1), 1);
+  Fs_Close(file);
+
+  OpenDemo();
+  ck_assert_uint_eq(g_array_index(sv.demo_keyframes, sv_demo_keyframe_t, 0).time, 123456);
+  Sv_CloseDemo();
+
+  // the index file is invalidated when the demo changes
+  const demo_keyframe_t *last = &g_array_index(demo.keyframes, demo_keyframe_t, demo.keyframes->len - 1);
+  WriteDemo(last->offset);
+
+  OpenDemo();
+  AssertKeyframes(demo.keyframes->len - 1);
+  Sv_CloseDemo();
+
+  void *buffer;
+  ck_assert_int_eq(Fs_Load(DEMO_INDEX_PATH, &buffer), sizeof(int32_t) * (4 + (demo.keyframes->len - 1) * 2));
+  ck_assert_int_eq(LittleLong(((int32_t *) buffer)[1]), last->offset);
+  Fs_Free(buffer);
+
+  // and with an index file of the wrong magic, it is rebuilt
+  index[0] = 0;
+  index[1] = LittleLong((int32_t) last->offset);
+
+  file = Fs_OpenWrite(DEMO_INDEX_PATH);
+  ck_assert_int_eq(Fs_Write(file, index, len, 1), 1);
+  Fs_Close(file);
+
+  OpenDemo();
+  AssertKeyframes(demo.keyframes->len - 1);
+
+  Fs_Free(index);
+
+} END_TEST
+
+START_TEST(check_Sv_OpenDemo_no_keyframes) {
+
+  BuildDemo(false, false);
+  WriteDemo(demo.data->len);
+
+  OpenDemo();
+
+  // demos recorded before keyframes get an empty index file, and can not be seeked
+  AssertKeyframes(0);
+  ck_assert_int_eq(Fs_FileSize(DEMO_INDEX_PATH), sizeof(int32_t) * 4);
+
+  ck_assert(!Sv_SeekDemo(0));
+
+  // but they play back as before
+  for (guint i = 0; i < demo.records->len; i++) {
+    ck_assert_int_eq(ReadMessage(), g_array_index(demo.records, int32_t, i));
+  }
+
+  ck_assert_int_eq(ReadMessage(), -1);
+
+} END_TEST
+
+START_TEST(check_Sv_SeekDemo) {
+
+  BuildDemo(true, true);
+  WriteDemo(demo.data->len);
+
+  OpenDemo();
+
+  const demo_keyframe_t *keyframes = (demo_keyframe_t *) demo.keyframes->data;
+  const guint count = demo.keyframes->len;
+  const guint per_level = count / DEMO_LEVELS;
+
+  ck_assert_uint_eq(per_level * DEMO_LEVELS, count);
+
+  for (guint level = 0; level < DEMO_LEVELS; level++) {
+    const demo_keyframe_t *first = &keyframes[level * per_level];
+    const demo_keyframe_t *last = &keyframes[level * per_level + per_level - 1];
+
+    const struct {
+      uint32_t time;
+      const demo_keyframe_t *keyframe;
+    } seeks[] = {
+      { 0, first },
+      { first[1].time - 1, first },
+      { first[1].time, first + 1 },
+      { last->time + 1, last },
+      { UINT32_MAX, last },
+    };
+
+    for (size_t i = 0; i < lengthof(seeks); i++) {
+
+      // seek from anywhere within the level, after its first keyframe, which the
+      // recorder writes along with the level's first frame
+      const int64_t positions[] = { first->end, last->end };
+
+      for (size_t j = 0; j < lengthof(positions); j++) {
+        ck_assert(Fs_Seek(sv.demo_file, positions[j]));
+
+        ck_assert(Sv_SeekDemo(seeks[i].time));
+        ck_assert_int_eq(Fs_Tell(sv.demo_file), seeks[i].keyframe->offset);
+        ck_assert_uint_eq(sv.demo_time, seeks[i].keyframe->time);
+        ck_assert(sv.demo_seek);
+      }
+    }
+
+    // after seeking, both keyframe records are sent, and then playback continues
+    ck_assert(Fs_Seek(sv.demo_file, first->end));
+    ck_assert(Sv_SeekDemo(first[1].time));
+
+    const int32_t id = ReadMessage();
+    ck_assert_int_eq(ReadMessage(), id + 1);
+    ck_assert(sv.demo_seek);
+    ck_assert_uint_eq(sv.demo_time, first[1].time);
+
+    ck_assert_int_eq(ReadMessage(), id + 2);
+    ck_assert(!sv.demo_seek);
+    ck_assert_uint_eq(sv.demo_time, first[1].time + QUETOO_TICK_MILLIS);
+  }
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+  Test_Init(argc, argv);
+
+  TCase *tcase = tcase_create("check_sv_demo");
+  tcase_add_checked_fixture(tcase, setup, teardown);
+  tcase_set_timeout(tcase, 60);
+
+  tcase_add_test(tcase, check_Sv_ReadDemoMessage);
+  tcase_add_test(tcase, check_Sv_LoadDemoIndex_invalid);
+  tcase_add_test(tcase, check_Sv_BuildDemoIndex_truncated);
+  tcase_add_test(tcase, check_Sv_OpenDemo_index_file);
+  tcase_add_test(tcase, check_Sv_OpenDemo_no_keyframes);
+  tcase_add_test(tcase, check_Sv_SeekDemo);
+
+  Suite *suite = suite_create("check_sv_demo");
+  suite_add_tcase(suite, tcase);
+
+  int32_t failed = Test_Run(suite);
+
+  Test_Shutdown();
+  return failed;
+}